@@ -0,0 +1,395 @@
+#include "chsql_extension.hpp"
+#include "chsql_compression.hpp"
+#include "chsql_metrics.hpp"
+#include "chsql_query_log.hpp"
+#include "chsql_pool.hpp"
+#include "chsql_query_cache.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/prepared_statement.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+
+namespace duckdb {
+
+// Local reader used for each ClickHouse/URL output format
+static string RemoteReaderFunction(const string &format) {
+    auto lformat = StringUtil::Lower(format);
+    if (StringUtil::StartsWith(lformat, "json")) {
+        return "read_json_auto";
+    }
+    if (StringUtil::StartsWith(lformat, "csv")) {
+        return "read_csv_auto";
+    }
+    if (lformat == "parquet") {
+        return "read_parquet";
+    }
+    if (lformat == "blob") {
+        return "read_blob";
+    }
+    if (lformat == "text") {
+        return "read_text";
+    }
+    return "read_json_auto";
+}
+
+// ClickHouse default_format matching the local reader
+static string RemoteDefaultFormat(const string &format) {
+    auto reader = RemoteReaderFunction(format);
+    if (reader == "read_json_auto") {
+        return "jsoneachrow";
+    }
+    if (reader == "read_csv_auto") {
+        return "csv";
+    }
+    if (reader == "read_parquet") {
+        return "parquet";
+    }
+    return StringUtil::Lower(format);
+}
+
+// Reads a URL with the local reader of its format, detecting the schema;
+// ClickHouse's CSV output has no header row
+static string RemoteReaderStatement(const string &format, bool clickhouse) {
+    auto reader = RemoteReaderFunction(format);
+    auto header = clickhouse && reader == "read_csv_auto" ? ", header=false" : "";
+    return "SELECT * FROM " + reader + "($1::VARCHAR" + header + ")";
+}
+
+// Statement used for the slices of a ClickHouse scan: text formats get the
+// column types bound on the first slice, so that every slice produces the
+// same schema whatever rows it happens to contain.
+static string RemoteSliceStatement(const string &format, const vector<string> &names,
+                                   const vector<LogicalType> &types) {
+    auto reader = RemoteReaderFunction(format);
+    if (reader != "read_json_auto" && reader != "read_csv_auto") {
+        return RemoteReaderStatement(format, true);
+    }
+    string columns;
+    for (idx_t i = 0; i < names.size(); i++) {
+        columns += (i == 0 ? "" : ", ") + KeywordHelper::WriteQuoted(names[i], '\'') + ": " +
+                   KeywordHelper::WriteQuoted(types[i].ToString(), '\'');
+    }
+    if (reader == "read_json_auto") {
+        return "SELECT * FROM read_json($1::VARCHAR, format='newline_delimited', columns={" + columns + "})";
+    }
+    return "SELECT * FROM read_csv($1::VARCHAR, header=false, columns={" + columns + "})";
+}
+
+// Only what the request needs: every execution of the scan, e.g. of a
+// prepared statement, sends its own request or reads the cache anew.
+struct RemoteScanData : public TableFunctionData {
+    string cache_key;
+    string query;
+    string server;
+    string format;
+    string compression;
+    // one URL per slice, a single one unless the scan is split
+    vector<string> slice_urls;
+    // reads every slice with the types bound on the first one
+    string slice_statement;
+    vector<string> names;
+    vector<LogicalType> types;
+    // the first slice requested to bind the schema, which an execution in
+    // the same query goes on reading instead of requesting it again;
+    // EXECUTE of a prepared scan is a later query and requests it anew
+    transaction_t bind_query = 0;
+    mutable mutex bind_result_lock;
+    mutable unique_ptr<RemoteConnectionLease> bind_conn;
+    mutable shared_ptr<RemoteStream> bind_stream;
+    mutable unique_ptr<QueryResult> bind_result;
+};
+
+struct RemoteScanState : public GlobalTableFunctionState {
+    shared_ptr<CachedRemoteResult> cached;
+    ColumnDataScanState cache_scan;
+    mutex lock;
+    unique_ptr<ColumnDataCollection> collection;
+    idx_t slices = 1;
+    atomic<idx_t> next_slice {0};
+    atomic<idx_t> finished_slices {0};
+
+    idx_t MaxThreads() const override {
+        return slices;
+    }
+};
+
+struct RemoteScanLocalState : public LocalTableFunctionState {
+    unique_ptr<RemoteConnectionLease> conn;
+    // the compressed response the result reads, if compression was negotiated
+    shared_ptr<RemoteStream> stream;
+    unique_ptr<QueryResult> result;
+};
+
+// Runs statement over the URL, or over its response streamed with the
+// negotiated Content-Encoding, which then has to outlive the result
+static unique_ptr<QueryResult> ExecuteRemote(ClientContext &context, const RemoteScanData &data,
+                                             RemoteConnectionLease &conn, const string &statement, const string &url,
+                                             shared_ptr<RemoteStream> &stream) {
+    if (!RemoteCompression::Streamed(data.compression, data.format)) {
+        return conn.Prepare(statement).Execute(url);
+    }
+    stream = RemoteCompression::Open(context, url, data.compression);
+    return conn.Prepare(statement).Execute(stream->GetPath());
+}
+
+// Binds the schema of a cached result, else the schema the reader detects on
+// the first slice, whose result is kept for the scan to read. The other
+// slices are requested once the scan starts, for ClickHouse with the bound
+// types and otherwise with the reader's detection.
+static void BindRemoteScan(ClientContext &context, RemoteScanData &data, bool typed, vector<LogicalType> &return_types,
+                           vector<string> &names) {
+    shared_ptr<CachedRemoteResult> cached;
+    if (RemoteResultCache::Enabled(context)) {
+        cached = RemoteResultCache::Get(context).Peek(data.cache_key);
+    }
+    if (cached) {
+        return_types = cached->types;
+        names = cached->names;
+    } else {
+        auto &url = data.slice_urls[0];
+        auto conn = RemoteConnectionPool::Get(context)->Acquire(context, url);
+        shared_ptr<RemoteStream> stream;
+        auto result = ExecuteRemote(context, data, *conn, RemoteReaderStatement(data.format, typed), url, stream);
+        ChMetrics::Increment(ChEvent::REMOTE_SCAN_REQUESTS);
+        if (result->HasError()) {
+            result->ThrowError();
+        }
+        return_types = result->types;
+        names = result->names;
+        data.bind_query = context.transaction.GetActiveQuery();
+        data.bind_conn = std::move(conn);
+        data.bind_stream = std::move(stream);
+        data.bind_result = std::move(result);
+    }
+    data.types = return_types;
+    data.names = names;
+    data.slice_statement =
+        typed ? RemoteSliceStatement(data.format, names, return_types) : RemoteReaderStatement(data.format, false);
+}
+
+static string ChScanUrl(const string &server, const string &format, const string &compression, const string &user,
+                        const string &query) {
+    return server + "/?" + RemoteCompression::UrlParameters(compression, format) +
+           "default_format=" + RemoteDefaultFormat(format) + "&user=" + StringUtil::URLEncode(user) +
+           "&query=" + StringUtil::URLEncode(query);
+}
+
+static unique_ptr<FunctionData> ChScanBind(ClientContext &context, TableFunctionBindInput &input,
+                                           vector<LogicalType> &return_types, vector<string> &names) {
+    auto data = make_uniq<RemoteScanData>();
+    data->query = input.inputs[0].GetValue<string>();
+    data->server = input.inputs[1].GetValue<string>();
+    data->format = "JSONEachRow";
+    string user = "play";
+    string split_column;
+    idx_t slices = 0;
+    for (auto &kv : input.named_parameters) {
+        if (kv.first == "format") {
+            data->format = kv.second.GetValue<string>();
+        } else if (kv.first == "user") {
+            user = kv.second.GetValue<string>();
+        } else if (kv.first == "split_column") {
+            split_column = kv.second.GetValue<string>();
+        } else if (kv.first == "parallel") {
+            slices = kv.second.GetValue<idx_t>();
+        } else if (kv.first == "compression") {
+            data->compression = kv.second.GetValue<string>();
+        }
+    }
+    data->compression = RemoteCompression::Validate(data->compression, data->format);
+
+    // Parallel mode: either split the rows on a column hash, or let the query
+    // slice itself through the {slice:UInt32}/{slices:UInt32} query parameters
+    // (e.g. on _part or with SAMPLE ... OFFSET).
+    bool has_slice_parameter = data->query.find("{slice:") != string::npos;
+    if (slices == 0 && (!split_column.empty() || has_slice_parameter)) {
+        slices = TaskScheduler::GetScheduler(context).NumberOfThreads();
+    }
+    // a query with {slice:UInt32} is rejected by ClickHouse unless both
+    // parameters are set, even when it is read in one slice
+    if (slices > 1 || has_slice_parameter) {
+        slices = MaxValue<idx_t>(slices, 1);
+        auto query = RemoteResultCache::NormalizeQuery(data->query);
+        for (idx_t slice = 0; slice < slices; slice++) {
+            if (has_slice_parameter) {
+                data->slice_urls.push_back(ChScanUrl(data->server, data->format, data->compression, user, query) +
+                                           "&param_slice=" + std::to_string(slice) +
+                                           "&param_slices=" + std::to_string(slices));
+            } else if (!split_column.empty()) {
+                auto slice_query = "SELECT * FROM (" + query + ") WHERE cityHash64(" +
+                                   KeywordHelper::WriteQuoted(split_column, '`') + ") % " + std::to_string(slices) +
+                                   " = " + std::to_string(slice);
+                data->slice_urls.push_back(ChScanUrl(data->server, data->format, data->compression, user, slice_query));
+            } else {
+                throw InvalidInputException("ch_scan: parallel requires split_column or a {slice:UInt32} query parameter");
+            }
+        }
+    }
+
+    if (data->slice_urls.empty()) {
+        data->slice_urls.push_back(ChScanUrl(data->server, data->format, data->compression, user, data->query));
+    }
+    data->cache_key = RemoteResultCache::MakeKey(context, data->query, {data->server + "?user=" + user}, data->format);
+    BindRemoteScan(context, *data, true, return_types, names);
+    return std::move(data);
+}
+
+static unique_ptr<FunctionData> UrlBind(ClientContext &context, TableFunctionBindInput &input,
+                                        vector<LogicalType> &return_types, vector<string> &names) {
+    auto data = make_uniq<RemoteScanData>();
+    data->server = input.inputs[0].GetValue<string>();
+    data->format = input.inputs[1].GetValue<string>();
+    data->slice_urls.push_back(data->server);
+    data->cache_key = RemoteResultCache::MakeKey(context, "", {data->server}, data->format);
+    BindRemoteScan(context, *data, false, return_types, names);
+    return std::move(data);
+}
+
+static unique_ptr<GlobalTableFunctionState> RemoteScanInitGlobal(ClientContext &context,
+                                                                 TableFunctionInitInput &input) {
+    auto &data = input.bind_data->Cast<RemoteScanData>();
+    auto state = make_uniq<RemoteScanState>();
+    state->slices = data.slice_urls.size();
+    if (!RemoteResultCache::Enabled(context)) {
+        return std::move(state);
+    }
+    // the TTL is checked on every execution, not only when binding
+    auto cached = RemoteResultCache::Get(context).Lookup(context, data.cache_key);
+    if (cached && cached->types == data.types) {
+        state->cached = std::move(cached);
+        state->cached->data->InitializeScan(state->cache_scan);
+        state->slices = 1;
+    } else {
+        state->collection = make_uniq<ColumnDataCollection>(Allocator::DefaultAllocator(), data.types);
+    }
+    return std::move(state);
+}
+
+static unique_ptr<LocalTableFunctionState> RemoteScanInitLocal(ExecutionContext &context,
+                                                               TableFunctionInitInput &input,
+                                                               GlobalTableFunctionState *global_state) {
+    return make_uniq<RemoteScanLocalState>();
+}
+
+// Claims the next slice that no thread is reading yet
+static bool OpenNextSlice(ClientContext &context, const RemoteScanData &data, RemoteScanState &state,
+                          RemoteScanLocalState &local) {
+    auto slice = state.next_slice++;
+    if (slice >= state.slices) {
+        return false;
+    }
+    auto &url = data.slice_urls[slice];
+    if (slice == 0) {
+        lock_guard<mutex> guard(data.bind_result_lock);
+        if (data.bind_result && data.bind_query == context.transaction.GetActiveQuery()) {
+            local.conn = std::move(data.bind_conn);
+            local.stream = std::move(data.bind_stream);
+            local.result = std::move(data.bind_result);
+            return true;
+        }
+        data.bind_result.reset();
+        data.bind_stream.reset();
+        data.bind_conn.reset();
+    }
+    ChMetrics::Increment(ChEvent::REMOTE_SCAN_REQUESTS);
+    local.conn = RemoteConnectionPool::Get(context)->Acquire(context, url);
+    local.result = ExecuteRemote(context, data, *local.conn, data.slice_statement, url, local.stream);
+    if (local.result->HasError()) {
+        local.result->ThrowError();
+    }
+    return true;
+}
+
+static void FinishSlice(ClientContext &context, const RemoteScanData &data, RemoteScanState &state,
+                        RemoteScanLocalState &local) {
+    local.result.reset();
+    local.stream.reset();
+    local.conn.reset();
+    if (++state.finished_slices < state.slices) {
+        return;
+    }
+    lock_guard<mutex> guard(state.lock);
+    if (!state.collection) {
+        return;
+    }
+    auto entry = make_shared_ptr<CachedRemoteResult>();
+    entry->query = data.query;
+    entry->server = data.server;
+    entry->format = data.format;
+    entry->names = data.names;
+    entry->types = data.types;
+    entry->rows = state.collection->Count();
+    entry->bytes = state.collection->SizeInBytes();
+    entry->data = std::move(state.collection);
+    RemoteResultCache::Get(context).Insert(context, data.cache_key, std::move(entry));
+}
+
+static void RemoteScanFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<RemoteScanData>();
+    auto &state = data_p.global_state->Cast<RemoteScanState>();
+    auto &local = data_p.local_state->Cast<RemoteScanLocalState>();
+    if (state.cached) {
+        state.cached->data->Scan(state.cache_scan, output);
+        return;
+    }
+    while (true) {
+        if (!local.result && !OpenNextSlice(context, data, state, local)) {
+            return;
+        }
+        auto chunk = local.result->Fetch();
+        if (local.result->HasError()) {
+            local.result->ThrowError();
+        }
+        if (!chunk || chunk->size() == 0) {
+            FinishSlice(context, data, state, local);
+            continue;
+        }
+        ChMetrics::Increment(ChEvent::REMOTE_SCAN_ROWS_READ, chunk->size());
+        ChMetrics::Increment(ChEvent::REMOTE_SCAN_BYTES_READ, chunk->GetAllocationSize());
+        QueryLog::AddReadBytes(context, chunk->GetAllocationSize());
+        if (chunk->ColumnCount() != output.ColumnCount()) {
+            throw InvalidInputException("%s returned %d columns where %d were bound, the remote schema changed",
+                                        data.server, chunk->ColumnCount(), output.ColumnCount());
+        }
+        if (chunk->GetTypes() == output.GetTypes()) {
+            output.Reference(*chunk);
+        } else {
+            for (idx_t col = 0; col < output.ColumnCount(); col++) {
+                VectorOperations::Cast(context, chunk->data[col], output.data[col], chunk->size());
+            }
+            output.SetCardinality(chunk->size());
+        }
+        if (state.collection) {
+            lock_guard<mutex> guard(state.lock);
+            if (state.collection) {
+                state.collection->Append(output);
+                // results larger than the whole cache are never kept
+                if (state.collection->SizeInBytes() > RemoteResultCache::Get(context).MemoryLimit(context)) {
+                    state.collection.reset();
+                }
+            }
+        }
+        return;
+    }
+}
+
+TableFunction ChScanTableFunction() {
+    TableFunction f("ch_scan", {LogicalType::VARCHAR, LogicalType::VARCHAR}, RemoteScanFunction, ChScanBind,
+                    RemoteScanInitGlobal, RemoteScanInitLocal);
+    f.named_parameters["format"] = LogicalType::VARCHAR;
+    f.named_parameters["user"] = LogicalType::VARCHAR;
+    f.named_parameters["split_column"] = LogicalType::VARCHAR;
+    f.named_parameters["parallel"] = LogicalType::UBIGINT;
+    f.named_parameters["compression"] = LogicalType::VARCHAR;
+    return f;
+}
+
+TableFunction UrlTableFunction() {
+    TableFunction f("url", {LogicalType::VARCHAR, LogicalType::VARCHAR}, RemoteScanFunction, UrlBind,
+                    RemoteScanInitGlobal, RemoteScanInitLocal);
+    return f;
+}
+
+} // namespace duckdb
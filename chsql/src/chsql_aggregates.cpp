@@ -0,0 +1,1320 @@
+#include "chsql_aggregates.hpp"
+#include "duckdb/common/bit_utils.hpp"
+#include "duckdb/common/types/hugeint.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace duckdb {
+
+// -- uniq, uniqCombined: an exact set of hashes that turns into a HyperLogLog
+// sketch with 2^P one byte registers once it holds SMALL hashes. Both are
+// bounded and merge by union, so partial aggregates combine in any order.
+
+template <uint8_t P, idx_t SMALL>
+struct UniqState {
+    static constexpr idx_t REGISTERS = idx_t(1) << P;
+    // open addressing on the low hash bits, 0 marks an empty slot
+    static constexpr idx_t SMALL_CAPACITY = SMALL * 2;
+
+    hash_t *small;
+    uint32_t small_count;
+    uint8_t *registers;
+
+    static void AddToRegisters(uint8_t *registers, hash_t hash) {
+        auto index = hash >> (64 - P);
+        // the sentinel bit caps the rank at 64 - P + 1 for an all-zero remainder
+        auto rest = (hash << P) | (hash_t(1) << (P - 1));
+        auto rank = uint8_t(CountZeros<uint64_t>::Leading(rest) + 1);
+        registers[index] = MaxValue(registers[index], rank);
+    }
+
+    void ToRegisters() {
+        registers = new uint8_t[REGISTERS]();
+        if (!small) {
+            return;
+        }
+        for (idx_t i = 0; i < SMALL_CAPACITY; i++) {
+            if (small[i]) {
+                AddToRegisters(registers, small[i]);
+            }
+        }
+        delete[] small;
+        small = nullptr;
+        small_count = 0;
+    }
+
+    void Add(hash_t hash) {
+        if (registers) {
+            AddToRegisters(registers, hash);
+            return;
+        }
+        if (!small) {
+            small = new hash_t[SMALL_CAPACITY]();
+        }
+        hash = hash ? hash : 1;
+        auto slot = hash & (SMALL_CAPACITY - 1);
+        while (small[slot]) {
+            if (small[slot] == hash) {
+                return;
+            }
+            slot = (slot + 1) & (SMALL_CAPACITY - 1);
+        }
+        if (small_count < SMALL) {
+            small[slot] = hash;
+            small_count++;
+            return;
+        }
+        ToRegisters();
+        AddToRegisters(registers, hash);
+    }
+
+    idx_t Estimate() const {
+        if (!registers) {
+            return small_count;
+        }
+        double m = double(REGISTERS);
+        double sum = 0;
+        idx_t zeros = 0;
+        for (idx_t i = 0; i < REGISTERS; i++) {
+            sum += std::ldexp(1.0, -int(registers[i]));
+            zeros += registers[i] == 0;
+        }
+        double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+        if (estimate <= 2.5 * m && zeros > 0) {
+            // linear counting is more accurate while many registers are empty
+            estimate = m * std::log(m / double(zeros));
+        }
+        return idx_t(estimate + 0.5);
+    }
+};
+
+struct UniqFunction {
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.small = nullptr;
+        state.small_count = 0;
+        state.registers = nullptr;
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        if (source.registers) {
+            if (!target.registers) {
+                target.ToRegisters();
+            }
+            for (idx_t i = 0; i < STATE::REGISTERS; i++) {
+                target.registers[i] = MaxValue(target.registers[i], source.registers[i]);
+            }
+        }
+        if (source.small) {
+            for (idx_t i = 0; i < STATE::SMALL_CAPACITY; i++) {
+                if (source.small[i]) {
+                    target.Add(source.small[i]);
+                }
+            }
+        }
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        target = T(state.Estimate());
+    }
+
+    template <class STATE>
+    static void Destroy(STATE &state, AggregateInputData &) {
+        delete[] state.small;
+        delete[] state.registers;
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+// All arguments are hashed together, rows with a NULL argument are not counted
+template <class STATE>
+static void UniqUpdate(Vector inputs[], AggregateInputData &, idx_t input_count, Vector &state_vector, idx_t count) {
+    Vector hashes(LogicalType::HASH, count);
+    VectorOperations::Hash(inputs[0], hashes, count);
+    for (idx_t c = 1; c < input_count; c++) {
+        VectorOperations::CombineHash(hashes, inputs[c], count);
+    }
+    vector<UnifiedVectorFormat> formats(input_count);
+    for (idx_t c = 0; c < input_count; c++) {
+        inputs[c].ToUnifiedFormat(count, formats[c]);
+    }
+    UnifiedVectorFormat hash_format, state_format;
+    hashes.ToUnifiedFormat(count, hash_format);
+    state_vector.ToUnifiedFormat(count, state_format);
+    auto hash_data = UnifiedVectorFormat::GetData<hash_t>(hash_format);
+    auto states = UnifiedVectorFormat::GetData<STATE *>(state_format);
+    for (idx_t i = 0; i < count; i++) {
+        bool valid = true;
+        for (auto &format : formats) {
+            valid = valid && format.validity.RowIsValid(format.sel->get_index(i));
+        }
+        if (valid) {
+            states[state_format.sel->get_index(i)]->Add(hash_data[hash_format.sel->get_index(i)]);
+        }
+    }
+}
+
+template <uint8_t P, idx_t SMALL>
+static AggregateFunction GetUniqFunction(const string &name) {
+    using STATE = UniqState<P, SMALL>;
+    AggregateFunction function(name, {LogicalType::ANY}, LogicalType::UBIGINT, AggregateFunction::StateSize<STATE>,
+                               AggregateFunction::StateInitialize<STATE, UniqFunction>, UniqUpdate<STATE>,
+                               AggregateFunction::StateCombine<STATE, UniqFunction>,
+                               AggregateFunction::StateFinalize<STATE, uint64_t, UniqFunction>,
+                               FunctionNullHandling::DEFAULT_NULL_HANDLING, nullptr, nullptr,
+                               AggregateFunction::StateDestroy<STATE, UniqFunction>);
+    function.varargs = LogicalType::ANY;
+    return function;
+}
+
+// -- Quantile levels, a constant level or list of levels bound away from the arguments
+
+struct QuantileLevelsData : public FunctionData {
+    vector<double> levels;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<QuantileLevelsData>();
+        result->levels = levels;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        return levels == other_p.Cast<QuantileLevelsData>().levels;
+    }
+};
+
+static double CheckLevel(const string &function, const Value &level) {
+    if (level.IsNull()) {
+        throw BinderException("%s: the level cannot be NULL", function);
+    }
+    auto result = level.GetValue<double>();
+    if (result < 0 || result > 1) {
+        throw BinderException("%s: the level must be between 0 and 1", function);
+    }
+    return result;
+}
+
+static unique_ptr<FunctionData> QuantileLevelsBind(ClientContext &context, AggregateFunction &function,
+                                                   vector<unique_ptr<Expression>> &arguments) {
+    auto result = make_uniq<QuantileLevelsData>();
+    if (arguments.size() < 2) {
+        // ClickHouse's default level is the median
+        result->levels.push_back(0.5);
+        return std::move(result);
+    }
+    if (!arguments[1]->IsFoldable()) {
+        throw BinderException("%s: the level must be a constant", function.name);
+    }
+    auto level = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+    if (level.type().id() == LogicalTypeId::LIST) {
+        for (auto &child : ListValue::GetChildren(level)) {
+            result->levels.push_back(CheckLevel(function.name, child));
+        }
+    } else {
+        result->levels.push_back(CheckLevel(function.name, level));
+    }
+    Function::EraseArgument(function, arguments, 1);
+    return std::move(result);
+}
+
+// One value per level for the quantiles variants, a scalar otherwise
+template <class STATE, class OUT>
+static void FinalizeQuantiles(STATE &state, AggregateFinalizeInput &finalize_data, const vector<double> &levels,
+                              list_entry_t &target) {
+    auto &result = finalize_data.result;
+    auto offset = ListVector::GetListSize(result);
+    ListVector::Reserve(result, offset + levels.size());
+    auto child = FlatVector::GetData<OUT>(ListVector::GetEntry(result));
+    for (idx_t i = 0; i < levels.size(); i++) {
+        child[offset + i] = OUT(state.Quantile(levels[i]));
+    }
+    target.offset = offset;
+    target.length = levels.size();
+    ListVector::SetListSize(result, offset + levels.size());
+}
+
+// -- quantileTDigest: a merging t-digest. Points are buffered and merged into
+// centroids whose size is bounded by 4 * n * q * (1 - q) / COMPRESSION, so the
+// tails stay precise and the digest keeps O(COMPRESSION) centroids.
+
+struct TDigestCentroid {
+    double mean;
+    double count;
+};
+
+struct TDigest {
+    static constexpr double COMPRESSION = 100;
+    static constexpr idx_t BUFFER = 512;
+
+    vector<TDigestCentroid> centroids;
+    vector<TDigestCentroid> buffer;
+    double total = 0;
+    double min = NumericLimits<double>::Maximum();
+    double max = NumericLimits<double>::Minimum();
+
+    void Add(double value, double count) {
+        buffer.push_back({value, count});
+        min = MinValue(min, value);
+        max = MaxValue(max, value);
+        if (buffer.size() >= BUFFER) {
+            Compress();
+        }
+    }
+
+    void Merge(const TDigest &other) {
+        for (auto &centroid : other.centroids) {
+            buffer.push_back(centroid);
+        }
+        for (auto &centroid : other.buffer) {
+            buffer.push_back(centroid);
+        }
+        min = MinValue(min, other.min);
+        max = MaxValue(max, other.max);
+        Compress();
+    }
+
+    void Compress() {
+        if (buffer.empty()) {
+            return;
+        }
+        for (auto &centroid : centroids) {
+            buffer.push_back(centroid);
+        }
+        std::sort(buffer.begin(), buffer.end(),
+                  [](const TDigestCentroid &a, const TDigestCentroid &b) { return a.mean < b.mean; });
+        total = 0;
+        for (auto &centroid : buffer) {
+            total += centroid.count;
+        }
+        centroids.clear();
+        auto current = buffer[0];
+        double before = 0;
+        for (idx_t i = 1; i < buffer.size(); i++) {
+            auto &next = buffer[i];
+            auto proposed = current.count + next.count;
+            auto q = (before + proposed / 2) / total;
+            if (proposed <= 4 * total * q * (1 - q) / COMPRESSION) {
+                current.mean += (next.mean - current.mean) * next.count / proposed;
+                current.count = proposed;
+            } else {
+                before += current.count;
+                centroids.push_back(current);
+                current = next;
+            }
+        }
+        centroids.push_back(current);
+        buffer.clear();
+    }
+
+    double Quantile(double level) {
+        Compress();
+        if (centroids.size() == 1 || level <= 0) {
+            return level <= 0 ? min : centroids[0].mean;
+        }
+        if (level >= 1) {
+            return max;
+        }
+        // interpolate between the centres of the two centroids around the rank
+        auto rank = level * total;
+        double before = 0;
+        for (idx_t i = 0; i < centroids.size(); i++) {
+            auto centre = before + centroids[i].count / 2;
+            if (rank < centre) {
+                if (i == 0) {
+                    return min + (centroids[0].mean - min) * rank / centre;
+                }
+                auto previous = before - centroids[i - 1].count / 2;
+                return centroids[i - 1].mean +
+                       (centroids[i].mean - centroids[i - 1].mean) * (rank - previous) / (centre - previous);
+            }
+            before += centroids[i].count;
+        }
+        auto last = before - centroids.back().count / 2;
+        return centroids.back().mean + (max - centroids.back().mean) * (rank - last) / (total - last);
+    }
+};
+
+struct TDigestState {
+    TDigest *digest;
+};
+
+struct TDigestFunction {
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.digest = nullptr;
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &) {
+        if (!state.digest) {
+            state.digest = new TDigest();
+        }
+        state.digest->Add(double(input), 1);
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void ConstantOperation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &unary_input,
+                                  idx_t count) {
+        if (!state.digest) {
+            state.digest = new TDigest();
+        }
+        state.digest->Add(double(input), double(count));
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        if (!source.digest) {
+            return;
+        }
+        if (!target.digest) {
+            target.digest = new TDigest();
+        }
+        target.digest->Merge(*source.digest);
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (!state.digest) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        auto &levels = finalize_data.input.bind_data->Cast<QuantileLevelsData>().levels;
+        target = T(state.digest->Quantile(levels[0]));
+    }
+
+    template <class STATE>
+    static void Destroy(STATE &state, AggregateInputData &) {
+        delete state.digest;
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+struct TDigestListFunction : public TDigestFunction {
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (!state.digest) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        auto &levels = finalize_data.input.bind_data->Cast<QuantileLevelsData>().levels;
+        FinalizeQuantiles<TDigest, double>(*state.digest, finalize_data, levels, target);
+    }
+};
+
+// -- quantileTiming: ClickHouse's timing histogram. Up to SMALL values are kept
+// exactly, then values are counted in 1 ms buckets below 1024 ms and 16 ms
+// buckets up to 30000 ms; larger values count as 30000 ms.
+
+struct TimingState {
+    static constexpr idx_t SMALL = 32;
+    static constexpr uint16_t MAX_VALUE = 30000;
+    static constexpr uint16_t PRECISE = 1024;
+    static constexpr uint16_t STEP = 16;
+    static constexpr idx_t BUCKETS = PRECISE + (MAX_VALUE - PRECISE) / STEP + 1;
+
+    uint16_t small[SMALL];
+    uint32_t small_count;
+    uint64_t *histogram;
+    uint64_t count;
+
+    static idx_t Bucket(uint16_t value) {
+        return value < PRECISE ? value : PRECISE + (value - PRECISE) / STEP;
+    }
+    static uint16_t BucketValue(idx_t bucket) {
+        return uint16_t(bucket < PRECISE ? bucket : PRECISE + (bucket - PRECISE) * STEP);
+    }
+
+    void ToHistogram() {
+        histogram = new uint64_t[BUCKETS]();
+        for (idx_t i = 0; i < small_count; i++) {
+            histogram[Bucket(small[i])]++;
+        }
+        small_count = 0;
+    }
+
+    void Add(uint16_t value, uint64_t n) {
+        count += n;
+        if (!histogram && small_count + n <= SMALL) {
+            for (idx_t i = 0; i < n; i++) {
+                small[small_count++] = value;
+            }
+            return;
+        }
+        if (!histogram) {
+            ToHistogram();
+        }
+        histogram[Bucket(value)] += n;
+    }
+
+    double Quantile(double level) {
+        auto position = MinValue<uint64_t>(uint64_t(level * double(count)), count - 1);
+        if (!histogram) {
+            std::nth_element(small, small + position, small + small_count);
+            return small[position];
+        }
+        uint64_t seen = 0;
+        for (idx_t bucket = 0; bucket < BUCKETS; bucket++) {
+            seen += histogram[bucket];
+            if (seen > position) {
+                return BucketValue(bucket);
+            }
+        }
+        return MAX_VALUE;
+    }
+};
+
+struct TimingFunction {
+    static uint16_t Clamp(double value) {
+        if (!(value > 0)) {
+            return 0;
+        }
+        if (value >= TimingState::MAX_VALUE) {
+            return TimingState::MAX_VALUE;
+        }
+        return uint16_t(value);
+    }
+
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.small_count = 0;
+        state.histogram = nullptr;
+        state.count = 0;
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &) {
+        state.Add(Clamp(double(input)), 1);
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void ConstantOperation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &unary_input,
+                                  idx_t count) {
+        state.Add(Clamp(double(input)), count);
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        for (idx_t i = 0; i < source.small_count; i++) {
+            target.Add(source.small[i], 1);
+        }
+        if (!source.histogram) {
+            return;
+        }
+        if (!target.histogram) {
+            target.ToHistogram();
+        }
+        for (idx_t bucket = 0; bucket < TimingState::BUCKETS; bucket++) {
+            target.histogram[bucket] += source.histogram[bucket];
+        }
+        target.count += source.count - source.small_count;
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (state.count == 0) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        auto &levels = finalize_data.input.bind_data->Cast<QuantileLevelsData>().levels;
+        target = T(state.Quantile(levels[0]));
+    }
+
+    template <class STATE>
+    static void Destroy(STATE &state, AggregateInputData &) {
+        delete[] state.histogram;
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+struct TimingListFunction : public TimingFunction {
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (state.count == 0) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        auto &levels = finalize_data.input.bind_data->Cast<QuantileLevelsData>().levels;
+        FinalizeQuantiles<TimingState, float>(state, finalize_data, levels, target);
+    }
+};
+
+template <class STATE, class OP, class RESULT>
+static AggregateFunctionSet GetQuantileFunctions(const string &name, const LogicalType &result_type, bool list) {
+    AggregateFunctionSet set(name);
+    auto function = AggregateFunction::UnaryAggregateDestructor<STATE, double, RESULT, OP>(
+        LogicalType::DOUBLE, list ? LogicalType::LIST(result_type) : result_type);
+    function.bind = QuantileLevelsBind;
+    if (!list) {
+        set.AddFunction(function);
+    }
+    function.arguments.push_back(list ? LogicalType::LIST(LogicalType::DOUBLE) : LogicalType::DOUBLE);
+    set.AddFunction(function);
+    return set;
+}
+
+// -- topK: Space-Saving. At most 3 * k counters are kept; a value without a
+// counter replaces the smallest one and inherits its count as the error bound.
+
+struct TopKCounter {
+    hash_t hash;
+    Value value;
+    uint64_t count;
+    uint64_t error;
+};
+
+struct TopKSummary {
+    idx_t capacity;
+    // hashes may collide, so every counter with the same hash is chained here
+    // and the stored value decides which one a row belongs to
+    std::unordered_multimap<hash_t, idx_t> index;
+    vector<TopKCounter> counters;
+
+    idx_t Find(hash_t hash, const Value &value) const {
+        auto range = index.equal_range(hash);
+        for (auto entry = range.first; entry != range.second; ++entry) {
+            if (Value::NotDistinctFrom(counters[entry->second].value, value)) {
+                return entry->second;
+            }
+        }
+        return DConstants::INVALID_INDEX;
+    }
+
+    void Unlink(idx_t counter_idx) {
+        auto range = index.equal_range(counters[counter_idx].hash);
+        for (auto entry = range.first; entry != range.second; ++entry) {
+            if (entry->second == counter_idx) {
+                index.erase(entry);
+                return;
+            }
+        }
+    }
+
+    void Add(hash_t hash, Vector &input, idx_t row) {
+        auto value = input.GetValue(row);
+        auto found = Find(hash, value);
+        if (found != DConstants::INVALID_INDEX) {
+            counters[found].count++;
+            return;
+        }
+        if (counters.size() < capacity) {
+            index.emplace(hash, counters.size());
+            counters.push_back({hash, std::move(value), 1, 0});
+            return;
+        }
+        idx_t smallest = 0;
+        for (idx_t i = 1; i < counters.size(); i++) {
+            if (counters[i].count < counters[smallest].count) {
+                smallest = i;
+            }
+        }
+        Unlink(smallest);
+        index.emplace(hash, smallest);
+        auto &counter = counters[smallest];
+        counter.hash = hash;
+        counter.value = std::move(value);
+        counter.error = counter.count;
+        counter.count++;
+    }
+
+    void Merge(const TopKSummary &other) {
+        for (auto &counter : other.counters) {
+            auto found = Find(counter.hash, counter.value);
+            if (found != DConstants::INVALID_INDEX) {
+                counters[found].count += counter.count;
+                counters[found].error += counter.error;
+            } else {
+                index.emplace(counter.hash, counters.size());
+                counters.push_back(counter);
+            }
+        }
+        if (counters.size() <= capacity) {
+            return;
+        }
+        SortCounters();
+        counters.resize(capacity);
+        index.clear();
+        for (idx_t i = 0; i < counters.size(); i++) {
+            index.emplace(counters[i].hash, i);
+        }
+    }
+
+    void SortCounters() {
+        std::stable_sort(counters.begin(), counters.end(),
+                         [](const TopKCounter &a, const TopKCounter &b) { return a.count > b.count; });
+    }
+};
+
+struct TopKState {
+    TopKSummary *summary;
+};
+
+struct TopKBindData : public FunctionData {
+    idx_t k = 10;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<TopKBindData>();
+        result->k = k;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        return k == other_p.Cast<TopKBindData>().k;
+    }
+};
+
+static unique_ptr<FunctionData> TopKBind(ClientContext &context, AggregateFunction &function,
+                                         vector<unique_ptr<Expression>> &arguments) {
+    auto result = make_uniq<TopKBindData>();
+    if (arguments.size() > 1) {
+        if (!arguments[1]->IsFoldable()) {
+            throw BinderException("topK: k must be a constant");
+        }
+        auto k = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+        if (k.IsNull() || k.GetValue<int64_t>() <= 0) {
+            throw BinderException("topK: k must be a positive integer");
+        }
+        result->k = k.GetValue<idx_t>();
+        Function::EraseArgument(function, arguments, 1);
+    }
+    function.arguments[0] = arguments[0]->return_type;
+    function.return_type = LogicalType::LIST(arguments[0]->return_type);
+    return std::move(result);
+}
+
+static void TopKUpdate(Vector inputs[], AggregateInputData &aggr_input_data, idx_t input_count, Vector &state_vector,
+                       idx_t count) {
+    auto &input = inputs[0];
+    auto capacity = aggr_input_data.bind_data->Cast<TopKBindData>().k * 3;
+    Vector hashes(LogicalType::HASH, count);
+    VectorOperations::Hash(input, hashes, count);
+    UnifiedVectorFormat input_format, hash_format, state_format;
+    input.ToUnifiedFormat(count, input_format);
+    hashes.ToUnifiedFormat(count, hash_format);
+    state_vector.ToUnifiedFormat(count, state_format);
+    auto hash_data = UnifiedVectorFormat::GetData<hash_t>(hash_format);
+    auto states = UnifiedVectorFormat::GetData<TopKState *>(state_format);
+    for (idx_t i = 0; i < count; i++) {
+        if (!input_format.validity.RowIsValid(input_format.sel->get_index(i))) {
+            continue;
+        }
+        auto &state = *states[state_format.sel->get_index(i)];
+        if (!state.summary) {
+            state.summary = new TopKSummary();
+            state.summary->capacity = capacity;
+        }
+        state.summary->Add(hash_data[hash_format.sel->get_index(i)], input, i);
+    }
+}
+
+struct TopKFunction {
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.summary = nullptr;
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        if (!source.summary) {
+            return;
+        }
+        if (!target.summary) {
+            target.summary = new TopKSummary(*source.summary);
+            return;
+        }
+        target.summary->Merge(*source.summary);
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (!state.summary) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        auto k = finalize_data.input.bind_data->Cast<TopKBindData>().k;
+        auto &summary = *state.summary;
+        summary.SortCounters();
+        auto &result = finalize_data.result;
+        auto offset = ListVector::GetListSize(result);
+        auto length = MinValue<idx_t>(k, summary.counters.size());
+        for (idx_t i = 0; i < length; i++) {
+            ListVector::PushBack(result, summary.counters[i].value);
+        }
+        target.offset = offset;
+        target.length = length;
+    }
+
+    template <class STATE>
+    static void Destroy(STATE &state, AggregateInputData &) {
+        delete state.summary;
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+static AggregateFunctionSet GetTopKFunctions() {
+    AggregateFunctionSet set("topK");
+    AggregateFunction function({LogicalType::ANY}, LogicalType::LIST(LogicalType::ANY),
+                               AggregateFunction::StateSize<TopKState>,
+                               AggregateFunction::StateInitialize<TopKState, TopKFunction>, TopKUpdate,
+                               AggregateFunction::StateCombine<TopKState, TopKFunction>,
+                               AggregateFunction::StateFinalize<TopKState, list_entry_t, TopKFunction>,
+                               FunctionNullHandling::DEFAULT_NULL_HANDLING, nullptr, TopKBind,
+                               AggregateFunction::StateDestroy<TopKState, TopKFunction>);
+    set.AddFunction(function);
+    function.arguments.push_back(LogicalType::BIGINT);
+    set.AddFunction(function);
+    return set;
+}
+
+// -- count, sum, avg, min and max for -State and -Merge. DuckDB's own states
+// are internal structs whose layout may change with any release, so the
+// serialized combinators bind these instead, which keep the same fields and
+// results and are written field by field by the codecs below.
+
+struct CountState {
+    int64_t count;
+};
+
+// sum, min and max
+template <class T>
+struct ValueState {
+    bool isset;
+    T value;
+};
+
+template <class T>
+struct AverageState {
+    uint64_t count;
+    T sum;
+};
+
+// count() counts rows, count(x) the rows where x is not NULL
+static void CountUpdate(Vector inputs[], AggregateInputData &, idx_t input_count, Vector &state_vector, idx_t count) {
+    UnifiedVectorFormat states;
+    state_vector.ToUnifiedFormat(count, states);
+    auto state_data = UnifiedVectorFormat::GetData<CountState *>(states);
+    UnifiedVectorFormat input;
+    if (input_count > 0) {
+        inputs[0].ToUnifiedFormat(count, input);
+    }
+    for (idx_t i = 0; i < count; i++) {
+        if (input_count == 0 || input.validity.RowIsValid(input.sel->get_index(i))) {
+            state_data[states.sel->get_index(i)]->count++;
+        }
+    }
+}
+
+struct CountFunction {
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.count = 0;
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        target.count += source.count;
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &) {
+        target = state.count;
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+struct SumFunction {
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.isset = false;
+        state.value = 0;
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &) {
+        state.isset = true;
+        state.value += decltype(state.value)(input);
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void ConstantOperation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &, idx_t count) {
+        state.isset = true;
+        state.value += decltype(state.value)(input) * decltype(state.value)(int64_t(count));
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        if (source.isset) {
+            target.isset = true;
+            target.value += source.value;
+        }
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (!state.isset) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        target = state.value;
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+static double AverageValue(double sum) {
+    return sum;
+}
+
+static double AverageValue(hugeint_t sum) {
+    return Hugeint::Cast<double>(sum);
+}
+
+struct AverageFunction {
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.count = 0;
+        state.sum = 0;
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &) {
+        state.count++;
+        state.sum += decltype(state.sum)(input);
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void ConstantOperation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &, idx_t count) {
+        state.count += count;
+        state.sum += decltype(state.sum)(input) * decltype(state.sum)(int64_t(count));
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        target.count += source.count;
+        target.sum += source.sum;
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (state.count == 0) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        target = AverageValue(state.sum) / double(state.count);
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+template <bool MAX>
+struct ExtremeFunction {
+    template <class STATE>
+    static void Initialize(STATE &state) {
+        state.isset = false;
+    }
+
+    template <class T>
+    static void Assign(ValueState<T> &state, const T &input) {
+        if (!state.isset || (MAX ? state.value < input : input < state.value)) {
+            state.isset = true;
+            state.value = input;
+        }
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void Operation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &) {
+        Assign(state, input);
+    }
+
+    template <class INPUT_TYPE, class STATE, class OP>
+    static void ConstantOperation(STATE &state, const INPUT_TYPE &input, AggregateUnaryInput &, idx_t) {
+        Assign(state, input);
+    }
+
+    template <class STATE, class OP>
+    static void Combine(const STATE &source, STATE &target, AggregateInputData &) {
+        if (source.isset) {
+            Assign(target, source.value);
+        }
+    }
+
+    template <class T, class STATE>
+    static void Finalize(STATE &state, T &target, AggregateFinalizeInput &finalize_data) {
+        if (!state.isset) {
+            finalize_data.ReturnNull();
+            return;
+        }
+        target = state.value;
+    }
+
+    static bool IgnoreNull() {
+        return true;
+    }
+};
+
+// -- State codecs for -State and -Merge
+
+template <class T>
+static void WriteValue(string &target, T value) {
+    target.append(const_char_ptr_cast(&value), sizeof(T));
+}
+
+struct StateReader {
+    const char *data;
+    idx_t size;
+    idx_t position = 0;
+
+    StateReader(const char *data, idx_t size) : data(data), size(size) {
+    }
+
+    template <class T>
+    T Read() {
+        T value;
+        ReadBytes(&value, sizeof(T));
+        return value;
+    }
+    void ReadBytes(void *target, idx_t count) {
+        if (position + count > size) {
+            throw InvalidInputException("Corrupt aggregate state: %llu bytes, expected more", size);
+        }
+        memcpy(target, data + position, count);
+        position += count;
+    }
+};
+
+template <class STATE>
+static void SerializeUniq(const_data_ptr_t state_p, string &target) {
+    auto &state = *reinterpret_cast<const STATE *>(state_p);
+    if (state.registers) {
+        WriteValue<uint8_t>(target, 1);
+        target.append(const_char_ptr_cast(state.registers), STATE::REGISTERS);
+        return;
+    }
+    WriteValue<uint8_t>(target, 0);
+    WriteValue<uint32_t>(target, state.small_count);
+    for (idx_t i = 0; state.small && i < STATE::SMALL_CAPACITY; i++) {
+        if (state.small[i]) {
+            WriteValue<hash_t>(target, state.small[i]);
+        }
+    }
+}
+
+template <class STATE>
+static void DeserializeUniq(const char *data, idx_t size, data_ptr_t state_p) {
+    auto &state = *reinterpret_cast<STATE *>(state_p);
+    StateReader reader(data, size);
+    if (reader.Read<uint8_t>()) {
+        state.ToRegisters();
+        reader.ReadBytes(state.registers, STATE::REGISTERS);
+        return;
+    }
+    auto count = reader.Read<uint32_t>();
+    for (idx_t i = 0; i < count; i++) {
+        state.Add(reader.Read<hash_t>());
+    }
+}
+
+static void SerializeTDigest(const_data_ptr_t state_p, string &target) {
+    auto digest = reinterpret_cast<const TDigestState *>(state_p)->digest;
+    if (!digest) {
+        WriteValue<uint64_t>(target, 0);
+        return;
+    }
+    digest->Compress();
+    WriteValue<uint64_t>(target, digest->centroids.size());
+    WriteValue<double>(target, digest->min);
+    WriteValue<double>(target, digest->max);
+    for (auto &centroid : digest->centroids) {
+        WriteValue<double>(target, centroid.mean);
+        WriteValue<double>(target, centroid.count);
+    }
+}
+
+static void DeserializeTDigest(const char *data, idx_t size, data_ptr_t state_p) {
+    auto &state = *reinterpret_cast<TDigestState *>(state_p);
+    StateReader reader(data, size);
+    auto count = reader.Read<uint64_t>();
+    if (count == 0) {
+        return;
+    }
+    state.digest = new TDigest();
+    state.digest->min = reader.Read<double>();
+    state.digest->max = reader.Read<double>();
+    for (idx_t i = 0; i < count; i++) {
+        auto mean = reader.Read<double>();
+        auto weight = reader.Read<double>();
+        state.digest->centroids.push_back({mean, weight});
+        state.digest->total += weight;
+    }
+}
+
+static void SerializeTiming(const_data_ptr_t state_p, string &target) {
+    auto &state = *reinterpret_cast<const TimingState *>(state_p);
+    WriteValue<uint64_t>(target, state.count);
+    if (state.histogram) {
+        WriteValue<uint8_t>(target, 1);
+        target.append(const_char_ptr_cast(state.histogram), TimingState::BUCKETS * sizeof(uint64_t));
+        return;
+    }
+    WriteValue<uint8_t>(target, 0);
+    WriteValue<uint32_t>(target, state.small_count);
+    target.append(const_char_ptr_cast(state.small), state.small_count * sizeof(uint16_t));
+}
+
+static void DeserializeTiming(const char *data, idx_t size, data_ptr_t state_p) {
+    auto &state = *reinterpret_cast<TimingState *>(state_p);
+    StateReader reader(data, size);
+    state.count = reader.Read<uint64_t>();
+    if (reader.Read<uint8_t>()) {
+        state.histogram = new uint64_t[TimingState::BUCKETS];
+        reader.ReadBytes(state.histogram, TimingState::BUCKETS * sizeof(uint64_t));
+        return;
+    }
+    state.small_count = reader.Read<uint32_t>();
+    if (state.small_count > TimingState::SMALL) {
+        throw InvalidInputException("Corrupt aggregate state: %u timing values", state.small_count);
+    }
+    reader.ReadBytes(state.small, state.small_count * sizeof(uint16_t));
+}
+
+// Fixed-width fields of the states above, hugeint as its two halves
+static void WriteField(string &target, int64_t value) {
+    WriteValue<int64_t>(target, value);
+}
+
+static void WriteField(string &target, uint64_t value) {
+    WriteValue<uint64_t>(target, value);
+}
+
+static void WriteField(string &target, double value) {
+    WriteValue<double>(target, value);
+}
+
+static void WriteField(string &target, hugeint_t value) {
+    WriteValue<uint64_t>(target, value.lower);
+    WriteValue<int64_t>(target, value.upper);
+}
+
+static void WriteField(string &target, date_t value) {
+    WriteValue<int32_t>(target, value.days);
+}
+
+static void WriteField(string &target, timestamp_t value) {
+    WriteValue<int64_t>(target, value.value);
+}
+
+static void ReadField(StateReader &reader, int64_t &value) {
+    value = reader.Read<int64_t>();
+}
+
+static void ReadField(StateReader &reader, uint64_t &value) {
+    value = reader.Read<uint64_t>();
+}
+
+static void ReadField(StateReader &reader, double &value) {
+    value = reader.Read<double>();
+}
+
+static void ReadField(StateReader &reader, hugeint_t &value) {
+    value.lower = reader.Read<uint64_t>();
+    value.upper = reader.Read<int64_t>();
+}
+
+static void ReadField(StateReader &reader, date_t &value) {
+    value.days = reader.Read<int32_t>();
+}
+
+static void ReadField(StateReader &reader, timestamp_t &value) {
+    value.value = reader.Read<int64_t>();
+}
+
+static void CheckRead(const StateReader &reader) {
+    if (reader.position != reader.size) {
+        throw InvalidInputException("Corrupt aggregate state: %llu bytes, expected %llu", reader.size, reader.position);
+    }
+}
+
+static void SerializeCount(const_data_ptr_t state_p, string &target) {
+    WriteField(target, reinterpret_cast<const CountState *>(state_p)->count);
+}
+
+static void DeserializeCount(const char *data, idx_t size, data_ptr_t state_p) {
+    StateReader reader(data, size);
+    ReadField(reader, reinterpret_cast<CountState *>(state_p)->count);
+    CheckRead(reader);
+}
+
+template <class T>
+static void SerializeValue(const_data_ptr_t state_p, string &target) {
+    auto &state = *reinterpret_cast<const ValueState<T> *>(state_p);
+    WriteValue<uint8_t>(target, state.isset ? 1 : 0);
+    if (state.isset) {
+        WriteField(target, state.value);
+    }
+}
+
+template <class T>
+static void DeserializeValue(const char *data, idx_t size, data_ptr_t state_p) {
+    auto &state = *reinterpret_cast<ValueState<T> *>(state_p);
+    StateReader reader(data, size);
+    state.isset = reader.Read<uint8_t>() != 0;
+    if (state.isset) {
+        ReadField(reader, state.value);
+    }
+    CheckRead(reader);
+}
+
+template <class T>
+static void SerializeAverage(const_data_ptr_t state_p, string &target) {
+    auto &state = *reinterpret_cast<const AverageState<T> *>(state_p);
+    WriteField(target, state.count);
+    WriteField(target, state.sum);
+}
+
+template <class T>
+static void DeserializeAverage(const char *data, idx_t size, data_ptr_t state_p) {
+    auto &state = *reinterpret_cast<AverageState<T> *>(state_p);
+    StateReader reader(data, size);
+    ReadField(reader, state.count);
+    ReadField(reader, state.sum);
+    CheckRead(reader);
+}
+
+// The codec travels with the function, as the overloads of one name differ in their states
+struct StateCodecInfo : public AggregateFunctionInfo {
+    explicit StateCodecInfo(AggregateStateCodec codec) : codec(codec) {
+    }
+    AggregateStateCodec codec;
+};
+
+static AggregateFunction WithCodec(AggregateFunction function, const string &name, AggregateStateCodec codec) {
+    function.name = name;
+    function.function_info = make_shared_ptr<StateCodecInfo>(codec);
+    return function;
+}
+
+template <class STATE, class INPUT, class RESULT, class OP>
+static AggregateFunction SerializableUnary(const string &name, const LogicalType &input, const LogicalType &result,
+                                           AggregateStateCodec codec) {
+    return WithCodec(AggregateFunction::UnaryAggregate<STATE, INPUT, RESULT, OP>(input, result), name, codec);
+}
+
+template <bool MAX, class T>
+static AggregateFunction SerializableExtreme(const string &name, const LogicalType &type) {
+    return SerializableUnary<ValueState<T>, T, T, ExtremeFunction<MAX>>(
+        name, type, type, {SerializeValue<T>, DeserializeValue<T>});
+}
+
+template <bool MAX>
+static void AddExtremes(AggregateFunctionSet &set, const string &name) {
+    set.AddFunction(SerializableExtreme<MAX, int64_t>(name, LogicalType::BIGINT));
+    set.AddFunction(SerializableExtreme<MAX, uint64_t>(name, LogicalType::UBIGINT));
+    set.AddFunction(SerializableExtreme<MAX, hugeint_t>(name, LogicalType::HUGEINT));
+    set.AddFunction(SerializableExtreme<MAX, double>(name, LogicalType::DOUBLE));
+    set.AddFunction(SerializableExtreme<MAX, date_t>(name, LogicalType::DATE));
+    set.AddFunction(SerializableExtreme<MAX, timestamp_t>(name, LogicalType::TIMESTAMP));
+    set.AddFunction(SerializableExtreme<MAX, timestamp_tz_t>(name, LogicalType::TIMESTAMP_TZ));
+}
+
+AggregateFunctionSet GetSerializableAggregates(const string &name) {
+    AggregateFunctionSet set(name);
+    if (name == "count") {
+        AggregateFunction count(name, {}, LogicalType::BIGINT, AggregateFunction::StateSize<CountState>,
+                                AggregateFunction::StateInitialize<CountState, CountFunction>, CountUpdate,
+                                AggregateFunction::StateCombine<CountState, CountFunction>,
+                                AggregateFunction::StateFinalize<CountState, int64_t, CountFunction>);
+        count = WithCodec(count, name, {SerializeCount, DeserializeCount});
+        set.AddFunction(count);
+        count.arguments.push_back(LogicalType::ANY);
+        set.AddFunction(count);
+    } else if (name == "sum") {
+        // integers add up in a hugeint and floats in a double, as in DuckDB
+        set.AddFunction(SerializableUnary<ValueState<hugeint_t>, int64_t, hugeint_t, SumFunction>(
+            name, LogicalType::BIGINT, LogicalType::HUGEINT,
+            {SerializeValue<hugeint_t>, DeserializeValue<hugeint_t>}));
+        set.AddFunction(SerializableUnary<ValueState<hugeint_t>, hugeint_t, hugeint_t, SumFunction>(
+            name, LogicalType::HUGEINT, LogicalType::HUGEINT,
+            {SerializeValue<hugeint_t>, DeserializeValue<hugeint_t>}));
+        set.AddFunction(SerializableUnary<ValueState<double>, double, double, SumFunction>(
+            name, LogicalType::DOUBLE, LogicalType::DOUBLE, {SerializeValue<double>, DeserializeValue<double>}));
+    } else if (name == "avg") {
+        set.AddFunction(SerializableUnary<AverageState<hugeint_t>, int64_t, double, AverageFunction>(
+            name, LogicalType::BIGINT, LogicalType::DOUBLE,
+            {SerializeAverage<hugeint_t>, DeserializeAverage<hugeint_t>}));
+        set.AddFunction(SerializableUnary<AverageState<hugeint_t>, hugeint_t, double, AverageFunction>(
+            name, LogicalType::HUGEINT, LogicalType::DOUBLE,
+            {SerializeAverage<hugeint_t>, DeserializeAverage<hugeint_t>}));
+        set.AddFunction(SerializableUnary<AverageState<double>, double, double, AverageFunction>(
+            name, LogicalType::DOUBLE, LogicalType::DOUBLE, {SerializeAverage<double>, DeserializeAverage<double>}));
+    } else if (name == "min") {
+        AddExtremes<false>(set, name);
+    } else if (name == "max") {
+        AddExtremes<true>(set, name);
+    }
+    return set;
+}
+
+const AggregateStateCodec *GetAggregateStateCodec(const AggregateFunction &function) {
+    auto info = dynamic_cast<const StateCodecInfo *>(function.function_info.get());
+    if (info) {
+        return &info->codec;
+    }
+    auto &name = function.name;
+    static const AggregateStateCodec UNIQ_CODEC {SerializeUniq<UniqState<12, 64>>, DeserializeUniq<UniqState<12, 64>>};
+    static const AggregateStateCodec UNIQ_COMBINED_CODEC {SerializeUniq<UniqState<17, 2048>>,
+                                                          DeserializeUniq<UniqState<17, 2048>>};
+    static const AggregateStateCodec TDIGEST_CODEC {SerializeTDigest, DeserializeTDigest};
+    static const AggregateStateCodec TIMING_CODEC {SerializeTiming, DeserializeTiming};
+    if (name == "uniq" || name == "uniqHLL12") {
+        return &UNIQ_CODEC;
+    } else if (name == "uniqCombined") {
+        return &UNIQ_COMBINED_CODEC;
+    } else if (name == "quantileTDigest" || name == "quantilesTDigest") {
+        return &TDIGEST_CODEC;
+    } else if (name == "quantileTiming" || name == "quantilesTiming") {
+        return &TIMING_CODEC;
+    }
+    return nullptr;
+}
+
+void RegisterAggregateFunctions(DatabaseInstance &instance) {
+    // uniq is uniqHLL12 in ClickHouse terms, uniqCombined uses its default precision of 17
+    ExtensionUtil::RegisterFunction(instance, GetUniqFunction<12, 64>("uniq"));
+    ExtensionUtil::RegisterFunction(instance, GetUniqFunction<12, 64>("uniqHLL12"));
+    ExtensionUtil::RegisterFunction(instance, GetUniqFunction<17, 2048>("uniqCombined"));
+    ExtensionUtil::RegisterFunction(instance, GetQuantileFunctions<TDigestState, TDigestFunction, double>(
+                                                  "quantileTDigest", LogicalType::DOUBLE, false));
+    ExtensionUtil::RegisterFunction(instance, GetQuantileFunctions<TDigestState, TDigestListFunction, list_entry_t>(
+                                                  "quantilesTDigest", LogicalType::DOUBLE, true));
+    ExtensionUtil::RegisterFunction(instance, GetQuantileFunctions<TimingState, TimingFunction, float>(
+                                                  "quantileTiming", LogicalType::FLOAT, false));
+    ExtensionUtil::RegisterFunction(instance, GetQuantileFunctions<TimingState, TimingListFunction, list_entry_t>(
+                                                  "quantilesTiming", LogicalType::FLOAT, true));
+    ExtensionUtil::RegisterFunction(instance, GetTopKFunctions());
+}
+
+} // namespace duckdb
@@ -0,0 +1,866 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/operator/add.hpp"
+#include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/common/operator/multiply.hpp"
+#include "duckdb/common/operator/subtract.hpp"
+#include "duckdb/common/vector_operations/binary_executor.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <cmath>
+
+namespace duckdb {
+
+// -- Tuple arithmetic
+//
+// Tuples are lists (or arrays) or unnamed structs of numbers. Lists are
+// combined element by element over their child vectors, structs field by
+// field over their entry vectors.
+
+static bool CheckedAdd(int64_t a, int64_t b, int64_t &result) {
+    return TryAddOperator::Operation(a, b, result);
+}
+static bool CheckedAdd(uint64_t a, uint64_t b, uint64_t &result) {
+    return TryAddOperator::Operation(a, b, result);
+}
+static bool CheckedAdd(hugeint_t a, hugeint_t b, hugeint_t &result) {
+    return TryAddOperator::Operation(a, b, result);
+}
+static bool CheckedAdd(uhugeint_t a, uhugeint_t b, uhugeint_t &result) {
+    return TryAddOperator::Operation(a, b, result);
+}
+static bool CheckedAdd(double a, double b, double &result) {
+    result = a + b;
+    return true;
+}
+static bool CheckedSubtract(int64_t a, int64_t b, int64_t &result) {
+    return TrySubtractOperator::Operation(a, b, result);
+}
+static bool CheckedSubtract(double a, double b, double &result) {
+    result = a - b;
+    return true;
+}
+static bool CheckedMultiply(int64_t a, int64_t b, int64_t &result) {
+    return TryMultiplyOperator::Operation(a, b, result);
+}
+static bool CheckedMultiply(double a, double b, double &result) {
+    result = a * b;
+    return true;
+}
+
+// Each operator returns false for a NULL element and throws on overflow
+struct TuplePlusOperator {
+    template <class T>
+    static bool Operation(T a, T b, T &result) {
+        if (!CheckedAdd(a, b, result)) {
+            throw OutOfRangeException("Overflow in tuplePlus of %s and %s", std::to_string(a), std::to_string(b));
+        }
+        return true;
+    }
+};
+
+struct TupleMinusOperator {
+    template <class T>
+    static bool Operation(T a, T b, T &result) {
+        if (!CheckedSubtract(a, b, result)) {
+            throw OutOfRangeException("Overflow in tupleMinus of %s and %s", std::to_string(a), std::to_string(b));
+        }
+        return true;
+    }
+};
+
+struct TupleMultiplyOperator {
+    template <class T>
+    static bool Operation(T a, T b, T &result) {
+        if (!CheckedMultiply(a, b, result)) {
+            throw OutOfRangeException("Overflow in tupleMultiply of %s and %s", std::to_string(a),
+                                      std::to_string(b));
+        }
+        return true;
+    }
+};
+
+// always on doubles, so division by zero gives inf or nan as in ClickHouse
+struct TupleDivideOperator {
+    template <class T>
+    static bool Operation(T a, T b, T &result) {
+        result = a / b;
+        return true;
+    }
+};
+
+// always on integers; division by zero is NULL
+struct TupleIntDivOperator {
+    template <class T>
+    static bool Operation(T a, T b, T &result) {
+        if (b == 0) {
+            return false;
+        }
+        if (b == -1 && a == NumericLimits<T>::Minimum()) {
+            throw OutOfRangeException("Overflow in tupleIntDiv of %s and -1", std::to_string(a));
+        }
+        result = a / b;
+        return true;
+    }
+};
+
+struct TupleModuloOperator {
+    static bool Operation(int64_t a, int64_t b, int64_t &result) {
+        if (b == 0) {
+            return false;
+        }
+        result = b == -1 ? 0 : a % b;
+        return true;
+    }
+    static bool Operation(double a, double b, double &result) {
+        if (b == 0) {
+            return false;
+        }
+        result = std::fmod(a, b);
+        return true;
+    }
+};
+
+enum class TupleNumbers : uint8_t { SUPERTYPE, INTEGERS, DOUBLES };
+
+template <class T, class OP, bool BY_NUMBER>
+static void TupleListFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &name = state.expr.Cast<BoundFunctionExpression>().function.name;
+    auto count = args.AllConstant() ? 1 : args.size();
+    auto &left = args.data[0];
+    auto &right = args.data[1];
+
+    UnifiedVectorFormat left_format, right_format, left_child_format, right_child_format;
+    left.ToUnifiedFormat(count, left_format);
+    right.ToUnifiedFormat(count, right_format);
+    ListVector::GetEntry(left).ToUnifiedFormat(ListVector::GetListSize(left), left_child_format);
+    if (!BY_NUMBER) {
+        ListVector::GetEntry(right).ToUnifiedFormat(ListVector::GetListSize(right), right_child_format);
+    }
+    auto left_entries = UnifiedVectorFormat::GetData<list_entry_t>(left_format);
+    auto left_values = UnifiedVectorFormat::GetData<T>(left_child_format);
+
+    idx_t total = 0;
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = left_format.sel->get_index(i);
+        if (left_format.validity.RowIsValid(idx)) {
+            total += left_entries[idx].length;
+        }
+    }
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    ListVector::Reserve(result, total);
+    auto &result_child = ListVector::GetEntry(result);
+    auto result_values = FlatVector::GetData<T>(result_child);
+    auto &result_child_validity = FlatVector::Validity(result_child);
+    auto result_entries = FlatVector::GetData<list_entry_t>(result);
+    auto &result_validity = FlatVector::Validity(result);
+
+    idx_t offset = 0;
+    for (idx_t i = 0; i < count; i++) {
+        auto left_idx = left_format.sel->get_index(i);
+        auto right_idx = right_format.sel->get_index(i);
+        if (!left_format.validity.RowIsValid(left_idx) || !right_format.validity.RowIsValid(right_idx)) {
+            result_validity.SetInvalid(i);
+            continue;
+        }
+        auto &entry = left_entries[left_idx];
+        list_entry_t right_entry(0, 0);
+        if (!BY_NUMBER) {
+            right_entry = UnifiedVectorFormat::GetData<list_entry_t>(right_format)[right_idx];
+            if (right_entry.length != entry.length) {
+                throw InvalidInputException("%s: tuples have different sizes %d and %d", name, entry.length,
+                                            right_entry.length);
+            }
+        }
+        for (idx_t k = 0; k < entry.length; k++) {
+            auto a_idx = left_child_format.sel->get_index(entry.offset + k);
+            bool valid = left_child_format.validity.RowIsValid(a_idx);
+            T b;
+            if (BY_NUMBER) {
+                b = UnifiedVectorFormat::GetData<T>(right_format)[right_idx];
+            } else {
+                auto b_idx = right_child_format.sel->get_index(right_entry.offset + k);
+                valid = valid && right_child_format.validity.RowIsValid(b_idx);
+                b = UnifiedVectorFormat::GetData<T>(right_child_format)[b_idx];
+            }
+            if (!valid || !OP::Operation(left_values[a_idx], b, result_values[offset + k])) {
+                result_child_validity.SetInvalid(offset + k);
+            }
+        }
+        result_entries[i] = list_entry_t(offset, entry.length);
+        offset += entry.length;
+    }
+    ListVector::SetListSize(result, offset);
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+template <class T, class OP, bool BY_NUMBER>
+static void TupleStructFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto constant = args.AllConstant();
+    auto count = constant ? 1 : args.size();
+    auto &left = args.data[0];
+    auto &right = args.data[1];
+    left.Flatten(count);
+    right.Flatten(count);
+    auto &left_fields = StructVector::GetEntries(left);
+    auto &result_fields = StructVector::GetEntries(result);
+    for (idx_t f = 0; f < left_fields.size(); f++) {
+        auto &right_field = BY_NUMBER ? right : *StructVector::GetEntries(right)[f];
+        BinaryExecutor::ExecuteWithNulls<T, T, T>(*left_fields[f], right_field, *result_fields[f], count,
+                                                  [](T a, T b, ValidityMask &mask, idx_t idx) {
+                                                      T value;
+                                                      if (!OP::Operation(a, b, value)) {
+                                                          mask.SetInvalid(idx);
+                                                          return T();
+                                                      }
+                                                      return value;
+                                                  });
+    }
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto &validity = FlatVector::Validity(result);
+    auto &left_validity = FlatVector::Validity(left);
+    auto &right_validity = FlatVector::Validity(right);
+    for (idx_t i = 0; i < count; i++) {
+        if (!left_validity.RowIsValid(i) || !right_validity.RowIsValid(i)) {
+            validity.SetInvalid(i);
+        }
+    }
+    if (constant) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+// The element types of a tuple, or nothing if the type is not one
+static bool TupleElementTypes(const LogicalType &type, vector<LogicalType> &types) {
+    switch (type.id()) {
+    case LogicalTypeId::LIST:
+        types.push_back(ListType::GetChildType(type));
+        return true;
+    case LogicalTypeId::ARRAY:
+        types.push_back(ArrayType::GetChildType(type));
+        return true;
+    case LogicalTypeId::STRUCT:
+        for (auto &child : StructType::GetChildTypes(type)) {
+            types.push_back(child.second);
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The tuple type with every element converted to the given number type
+static LogicalType TupleOf(const LogicalType &type, const LogicalType &number) {
+    if (type.id() != LogicalTypeId::STRUCT) {
+        return LogicalType::LIST(number);
+    }
+    child_list_t<LogicalType> children;
+    for (auto &child : StructType::GetChildTypes(type)) {
+        children.emplace_back(child.first, number);
+    }
+    return LogicalType::STRUCT(std::move(children));
+}
+
+template <class OP, bool BY_NUMBER, TupleNumbers NUMBERS>
+static unique_ptr<FunctionData> TupleBind(ClientContext &context, ScalarFunction &bound_function,
+                                          vector<unique_ptr<Expression>> &arguments) {
+    auto &name = bound_function.name;
+    auto &left = arguments[0]->return_type;
+    auto &right = arguments[1]->return_type;
+    vector<LogicalType> types;
+    if (!TupleElementTypes(left, types)) {
+        throw BinderException("%s: the first argument must be a tuple or an array, not %s", name, left.ToString());
+    }
+    bool is_struct = left.id() == LogicalTypeId::STRUCT;
+    if (BY_NUMBER) {
+        types.push_back(right);
+    } else {
+        auto left_size = types.size();
+        if (!TupleElementTypes(right, types) || (right.id() == LogicalTypeId::STRUCT) != is_struct) {
+            throw BinderException("%s: both arguments must be tuples or both arrays, not %s and %s", name,
+                                  left.ToString(), right.ToString());
+        }
+        if (is_struct && types.size() != 2 * left_size) {
+            throw BinderException("%s: tuples have different sizes %d and %d", name, left_size,
+                                  types.size() - left_size);
+        }
+    }
+    bool integers = true;
+    for (auto &type : types) {
+        if (type.id() != LogicalTypeId::SQLNULL && !type.IsNumeric()) {
+            throw BinderException("%s: tuple elements must be numbers, not %s", name, type.ToString());
+        }
+        integers = integers && (type.IsIntegral() || type.id() == LogicalTypeId::SQLNULL);
+    }
+    if (NUMBERS == TupleNumbers::INTEGERS || (NUMBERS == TupleNumbers::SUPERTYPE && integers)) {
+        bound_function.arguments = {TupleOf(left, LogicalType::BIGINT),
+                                    BY_NUMBER ? LogicalType::BIGINT : TupleOf(right, LogicalType::BIGINT)};
+        bound_function.function = is_struct ? TupleStructFunction<int64_t, OP, BY_NUMBER>
+                                            : TupleListFunction<int64_t, OP, BY_NUMBER>;
+    } else {
+        bound_function.arguments = {TupleOf(left, LogicalType::DOUBLE),
+                                    BY_NUMBER ? LogicalType::DOUBLE : TupleOf(right, LogicalType::DOUBLE)};
+        bound_function.function = is_struct ? TupleStructFunction<double, OP, BY_NUMBER>
+                                            : TupleListFunction<double, OP, BY_NUMBER>;
+    }
+    bound_function.return_type = bound_function.arguments[0];
+    return nullptr;
+}
+
+template <class OP, bool BY_NUMBER, TupleNumbers NUMBERS>
+static ScalarFunction TupleFunction(const string &name) {
+    // the kernel is chosen in bind
+    return ScalarFunction(name, {LogicalType::ANY, LogicalType::ANY}, LogicalType::ANY, nullptr,
+                          TupleBind<OP, BY_NUMBER, NUMBERS>);
+}
+
+// -- Array functions
+
+template <class T>
+static bool ElementsEqual(const UnifiedVectorFormat &left, idx_t l, const UnifiedVectorFormat &right, idx_t r) {
+    return Equals::Operation(UnifiedVectorFormat::GetData<T>(left)[left.sel->get_index(l)],
+                             UnifiedVectorFormat::GetData<T>(right)[right.sel->get_index(r)]);
+}
+
+// Compares elements of two vectors of the same type by position, directly on
+// the data for flat types and through Values for nested ones. NULLs are left
+// to the caller.
+class ElementComparer {
+public:
+    ElementComparer(Vector &left_p, idx_t left_count, Vector &right_p, idx_t right_count)
+        : left(left_p), right(right_p) {
+        left.ToUnifiedFormat(left_count, left_format);
+        right.ToUnifiedFormat(right_count, right_format);
+        switch (left.GetType().InternalType()) {
+        case PhysicalType::BOOL:
+            equal = ElementsEqual<bool>;
+            break;
+        case PhysicalType::INT8:
+            equal = ElementsEqual<int8_t>;
+            break;
+        case PhysicalType::INT16:
+            equal = ElementsEqual<int16_t>;
+            break;
+        case PhysicalType::INT32:
+            equal = ElementsEqual<int32_t>;
+            break;
+        case PhysicalType::INT64:
+            equal = ElementsEqual<int64_t>;
+            break;
+        case PhysicalType::UINT8:
+            equal = ElementsEqual<uint8_t>;
+            break;
+        case PhysicalType::UINT16:
+            equal = ElementsEqual<uint16_t>;
+            break;
+        case PhysicalType::UINT32:
+            equal = ElementsEqual<uint32_t>;
+            break;
+        case PhysicalType::UINT64:
+            equal = ElementsEqual<uint64_t>;
+            break;
+        case PhysicalType::INT128:
+            equal = ElementsEqual<hugeint_t>;
+            break;
+        case PhysicalType::UINT128:
+            equal = ElementsEqual<uhugeint_t>;
+            break;
+        case PhysicalType::FLOAT:
+            equal = ElementsEqual<float>;
+            break;
+        case PhysicalType::DOUBLE:
+            equal = ElementsEqual<double>;
+            break;
+        case PhysicalType::INTERVAL:
+            equal = ElementsEqual<interval_t>;
+            break;
+        case PhysicalType::VARCHAR:
+            equal = ElementsEqual<string_t>;
+            break;
+        default:
+            equal = nullptr;
+            break;
+        }
+    }
+
+    bool LeftIsValid(idx_t l) const {
+        return left_format.validity.RowIsValid(left_format.sel->get_index(l));
+    }
+    bool Equal(idx_t l, idx_t r) const {
+        if (equal) {
+            return equal(left_format, l, right_format, r);
+        }
+        return Value::NotDistinctFrom(left.GetValue(l), right.GetValue(r));
+    }
+
+private:
+    Vector &left;
+    Vector &right;
+    UnifiedVectorFormat left_format;
+    UnifiedVectorFormat right_format;
+    bool (*equal)(const UnifiedVectorFormat &, idx_t, const UnifiedVectorFormat &, idx_t);
+};
+
+// Child positions of the first occurrence of every distinct non-NULL element
+// of a list, in order, through a small open-addressing table of positions
+class FirstOccurrences {
+public:
+    FirstOccurrences(Vector &child, idx_t child_count)
+        : comparer(child, child_count, child, child_count), hashes(LogicalType::HASH, MaxValue<idx_t>(child_count, 1)) {
+        VectorOperations::Hash(child, hashes, child_count);
+        hash_data = FlatVector::GetData<hash_t>(hashes);
+    }
+
+    const vector<idx_t> &Find(const list_entry_t &entry) {
+        positions.clear();
+        auto capacity = NextPowerOfTwo(MaxValue<idx_t>(2 * entry.length, 8));
+        auto mask = capacity - 1;
+        table.assign(capacity, DConstants::INVALID_INDEX);
+        for (idx_t k = 0; k < entry.length; k++) {
+            auto position = entry.offset + k;
+            if (!comparer.LeftIsValid(position)) {
+                continue;
+            }
+            auto slot = hash_data[position] & mask;
+            bool found = false;
+            for (; table[slot] != DConstants::INVALID_INDEX; slot = (slot + 1) & mask) {
+                auto other = table[slot];
+                if (hash_data[other] == hash_data[position] && comparer.Equal(other, position)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                table[slot] = position;
+                positions.push_back(position);
+            }
+        }
+        return positions;
+    }
+
+private:
+    ElementComparer comparer;
+    Vector hashes;
+    hash_t *hash_data;
+    vector<idx_t> table;
+    vector<idx_t> positions;
+};
+
+// NULL elements are skipped, an empty array sums to 0. HUGEINT and UHUGEINT
+// arrays sum in their own type, narrower integers in BIGINT or UBIGINT.
+template <class T>
+static void ArraySumFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &input = args.data[0];
+    auto &child = ListVector::GetEntry(input);
+    UnifiedVectorFormat child_format;
+    child.ToUnifiedFormat(ListVector::GetListSize(input), child_format);
+    auto values = UnifiedVectorFormat::GetData<T>(child_format);
+    UnaryExecutor::Execute<list_entry_t, T>(input, result, args.size(), [&](list_entry_t entry) {
+        T sum = 0;
+        for (idx_t k = 0; k < entry.length; k++) {
+            auto idx = child_format.sel->get_index(entry.offset + k);
+            if (child_format.validity.RowIsValid(idx) && !CheckedAdd(sum, values[idx], sum)) {
+                throw OutOfRangeException("Overflow in arraySum");
+            }
+        }
+        return sum;
+    });
+}
+
+static unique_ptr<FunctionData> ArraySumBind(ClientContext &context, ScalarFunction &bound_function,
+                                             vector<unique_ptr<Expression>> &arguments) {
+    auto &type = arguments[0]->return_type;
+    if (type.id() != LogicalTypeId::LIST && type.id() != LogicalTypeId::ARRAY) {
+        throw BinderException("arraySum: the argument must be an array, not %s", type.ToString());
+    }
+    auto element = type.id() == LogicalTypeId::LIST ? ListType::GetChildType(type) : ArrayType::GetChildType(type);
+    LogicalType sum_type;
+    if (element.id() == LogicalTypeId::HUGEINT) {
+        sum_type = LogicalType::HUGEINT;
+        bound_function.function = ArraySumFunction<hugeint_t>;
+    } else if (element.id() == LogicalTypeId::UHUGEINT) {
+        sum_type = LogicalType::UHUGEINT;
+        bound_function.function = ArraySumFunction<uhugeint_t>;
+    } else if (element.id() == LogicalTypeId::BOOLEAN || element.IsSigned() || element.id() == LogicalTypeId::SQLNULL) {
+        sum_type = LogicalType::BIGINT;
+        bound_function.function = ArraySumFunction<int64_t>;
+    } else if (element.IsUnsigned()) {
+        sum_type = LogicalType::UBIGINT;
+        bound_function.function = ArraySumFunction<uint64_t>;
+    } else if (element.IsNumeric()) {
+        sum_type = LogicalType::DOUBLE;
+        bound_function.function = ArraySumFunction<double>;
+    } else {
+        throw BinderException("arraySum: array elements must be numbers, not %s", element.ToString());
+    }
+    bound_function.arguments[0] = LogicalType::LIST(sum_type);
+    bound_function.return_type = sum_type;
+    return nullptr;
+}
+
+static void ArrayUniqFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &input = args.data[0];
+    FirstOccurrences distinct(ListVector::GetEntry(input), ListVector::GetListSize(input));
+    UnaryExecutor::Execute<list_entry_t, uint64_t>(input, result, args.size(), [&](list_entry_t entry) {
+        return distinct.Find(entry).size();
+    });
+}
+
+// Elements in order of first occurrence, without NULLs
+static void ArrayDistinctFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &input = args.data[0];
+    auto count = args.AllConstant() ? 1 : args.size();
+    auto &child = ListVector::GetEntry(input);
+    FirstOccurrences distinct(child, ListVector::GetListSize(input));
+    UnifiedVectorFormat format;
+    input.ToUnifiedFormat(count, format);
+    auto entries = UnifiedVectorFormat::GetData<list_entry_t>(format);
+
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto result_entries = FlatVector::GetData<list_entry_t>(result);
+    auto &validity = FlatVector::Validity(result);
+    auto base = ListVector::GetListSize(result);
+    vector<idx_t> selected;
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = format.sel->get_index(i);
+        if (!format.validity.RowIsValid(idx)) {
+            validity.SetInvalid(i);
+            continue;
+        }
+        auto &positions = distinct.Find(entries[idx]);
+        result_entries[i] = list_entry_t(base + selected.size(), positions.size());
+        selected.insert(selected.end(), positions.begin(), positions.end());
+    }
+    SelectionVector sel(MaxValue<idx_t>(selected.size(), 1));
+    for (idx_t k = 0; k < selected.size(); k++) {
+        sel.set_index(k, selected[k]);
+    }
+    ListVector::Append(result, child, sel, selected.size());
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+// Arrays of a fixed size are read as lists
+static unique_ptr<FunctionData> ListArgumentBind(ClientContext &context, ScalarFunction &bound_function,
+                                                 vector<unique_ptr<Expression>> &arguments) {
+    auto &type = arguments[0]->return_type;
+    if (type.id() == LogicalTypeId::ARRAY) {
+        bound_function.arguments[0] = LogicalType::LIST(ArrayType::GetChildType(type));
+    } else if (type.id() == LogicalTypeId::LIST) {
+        bound_function.arguments[0] = type;
+    }
+    if (bound_function.return_type.id() == LogicalTypeId::LIST &&
+        ListType::GetChildType(bound_function.return_type).id() == LogicalTypeId::ANY) {
+        bound_function.return_type = bound_function.arguments[0];
+    }
+    return nullptr;
+}
+
+// [1, 2, ..., length]
+static void ArrayEnumerateFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &input = args.data[0];
+    auto count = args.AllConstant() ? 1 : args.size();
+    UnifiedVectorFormat format;
+    input.ToUnifiedFormat(count, format);
+    auto entries = UnifiedVectorFormat::GetData<list_entry_t>(format);
+    idx_t total = 0;
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = format.sel->get_index(i);
+        if (format.validity.RowIsValid(idx)) {
+            total += entries[idx].length;
+        }
+    }
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    ListVector::Reserve(result, total);
+    auto numbers = FlatVector::GetData<uint32_t>(ListVector::GetEntry(result));
+    auto result_entries = FlatVector::GetData<list_entry_t>(result);
+    auto &validity = FlatVector::Validity(result);
+    idx_t offset = 0;
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = format.sel->get_index(i);
+        if (!format.validity.RowIsValid(idx)) {
+            validity.SetInvalid(i);
+            continue;
+        }
+        auto length = entries[idx].length;
+        for (idx_t k = 0; k < length; k++) {
+            numbers[offset + k] = UnsafeNumericCast<uint32_t>(k + 1);
+        }
+        result_entries[i] = list_entry_t(offset, length);
+        offset += length;
+    }
+    ListVector::SetListSize(result, offset);
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+// arrayExists(array): whether any element is true or non-zero
+static void ArrayAnyFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &input = args.data[0];
+    UnifiedVectorFormat child_format;
+    ListVector::GetEntry(input).ToUnifiedFormat(ListVector::GetListSize(input), child_format);
+    auto values = UnifiedVectorFormat::GetData<bool>(child_format);
+    UnaryExecutor::Execute<list_entry_t, bool>(input, result, args.size(), [&](list_entry_t entry) {
+        for (idx_t k = 0; k < entry.length; k++) {
+            auto idx = child_format.sel->get_index(entry.offset + k);
+            if (child_format.validity.RowIsValid(idx) && values[idx]) {
+                return true;
+            }
+        }
+        return false;
+    });
+}
+
+// arrayExists(needle, array): whether the array holds the needle
+static void ArrayContainsFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto count = args.AllConstant() ? 1 : args.size();
+    auto &needles = args.data[0];
+    auto &input = args.data[1];
+    ElementComparer comparer(ListVector::GetEntry(input), ListVector::GetListSize(input), needles, count);
+    UnifiedVectorFormat needle_format, list_format;
+    needles.ToUnifiedFormat(count, needle_format);
+    input.ToUnifiedFormat(count, list_format);
+    auto entries = UnifiedVectorFormat::GetData<list_entry_t>(list_format);
+
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto found = FlatVector::GetData<bool>(result);
+    auto &validity = FlatVector::Validity(result);
+    for (idx_t i = 0; i < count; i++) {
+        auto list_idx = list_format.sel->get_index(i);
+        if (!list_format.validity.RowIsValid(list_idx) ||
+            !needle_format.validity.RowIsValid(needle_format.sel->get_index(i))) {
+            validity.SetInvalid(i);
+            continue;
+        }
+        auto &entry = entries[list_idx];
+        found[i] = false;
+        for (idx_t k = 0; k < entry.length && !found[i]; k++) {
+            found[i] = comparer.LeftIsValid(entry.offset + k) && comparer.Equal(entry.offset + k, i);
+        }
+    }
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+static unique_ptr<FunctionData> ArrayExistsBind(ClientContext &context, ScalarFunction &bound_function,
+                                                vector<unique_ptr<Expression>> &arguments) {
+    auto &type = arguments.back()->return_type;
+    if (type.id() != LogicalTypeId::LIST && type.id() != LogicalTypeId::ARRAY) {
+        throw BinderException("arrayExists: the last argument must be an array, not %s", type.ToString());
+    }
+    auto element = type.id() == LogicalTypeId::LIST ? ListType::GetChildType(type) : ArrayType::GetChildType(type);
+    if (arguments.size() == 1) {
+        bound_function.arguments[0] = LogicalType::LIST(LogicalType::BOOLEAN);
+        return nullptr;
+    }
+    LogicalType common;
+    if (!LogicalType::TryGetMaxLogicalType(context, arguments[0]->return_type, element, common)) {
+        throw BinderException("arrayExists: cannot look for %s in an array of %s",
+                              arguments[0]->return_type.ToString(), element.ToString());
+    }
+    bound_function.arguments = {common, LogicalType::LIST(common)};
+    return nullptr;
+}
+
+// -- ARRAY JOIN
+//
+// array_join((SELECT ...), 'a', 'b', ...) turns every row into one row per
+// element of the arrays a and b, which are joined side by side and must be
+// of the same size. The other columns are the parent row's, referenced
+// through a selection vector, and the elements are the list children's,
+// referenced likewise. With left := true a row whose arrays are empty or
+// NULL is kept once, with NULL elements.
+
+struct ArrayJoinData : public TableFunctionData {
+    vector<column_t> arrays;
+    bool left = false;
+};
+
+struct ArrayJoinLocalState : public LocalTableFunctionState {
+    // where the current input chunk continues
+    idx_t row = 0;
+    idx_t element = 0;
+};
+
+static unique_ptr<FunctionData> ArrayJoinBind(ClientContext &context, TableFunctionBindInput &input,
+                                              vector<LogicalType> &return_types, vector<string> &names) {
+    // inputs[0] stands for the subquery
+    if (input.inputs.size() < 2) {
+        throw BinderException("array_join: expected a subquery and at least one array column");
+    }
+    auto data = make_uniq<ArrayJoinData>();
+    return_types = input.input_table_types;
+    names = input.input_table_names;
+    for (idx_t i = 1; i < input.inputs.size(); i++) {
+        if (input.inputs[i].IsNull()) {
+            throw BinderException("array_join: array columns cannot be NULL");
+        }
+        auto name = input.inputs[i].GetValue<string>();
+        auto column = std::find_if(names.begin(), names.end(),
+                                   [&](const string &candidate) { return StringUtil::CIEquals(candidate, name); });
+        if (column == names.end()) {
+            throw BinderException("array_join: column \"%s\" not found in the subquery", name);
+        }
+        auto index = NumericCast<column_t>(column - names.begin());
+        if (return_types[index].id() != LogicalTypeId::LIST) {
+            throw BinderException("array_join: column \"%s\" is not an array", name);
+        }
+        if (std::find(data->arrays.begin(), data->arrays.end(), index) != data->arrays.end()) {
+            throw BinderException("array_join: column \"%s\" is joined twice", name);
+        }
+        data->arrays.push_back(index);
+        return_types[index] = ListType::GetChildType(return_types[index]);
+    }
+    auto left = input.named_parameters.find("left");
+    if (left != input.named_parameters.end() && !left->second.IsNull()) {
+        data->left = left->second.GetValue<bool>();
+    }
+    return std::move(data);
+}
+
+static unique_ptr<LocalTableFunctionState> ArrayJoinInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                              GlobalTableFunctionState *global_state) {
+    return make_uniq<ArrayJoinLocalState>();
+}
+
+static OperatorResultType ArrayJoinFunction(ExecutionContext &context, TableFunctionInput &data_p, DataChunk &input,
+                                            DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<ArrayJoinData>();
+    auto &state = data_p.local_state->Cast<ArrayJoinLocalState>();
+    auto arrays = data.arrays.size();
+    vector<UnifiedVectorFormat> formats(arrays);
+    for (idx_t a = 0; a < arrays; a++) {
+        input.data[data.arrays[a]].ToUnifiedFormat(input.size(), formats[a]);
+    }
+    SelectionVector parents(STANDARD_VECTOR_SIZE);
+    vector<SelectionVector> elements;
+    for (idx_t a = 0; a < arrays; a++) {
+        elements.emplace_back(STANDARD_VECTOR_SIZE);
+    }
+    // rows of left := true without elements
+    vector<idx_t> padding;
+    idx_t count = 0;
+    for (; state.row < input.size(); state.row++) {
+        idx_t size = 0;
+        for (idx_t a = 0; a < arrays; a++) {
+            auto index = formats[a].sel->get_index(state.row);
+            auto length = formats[a].validity.RowIsValid(index)
+                              ? UnifiedVectorFormat::GetData<list_entry_t>(formats[a])[index].length
+                              : 0;
+            if (a > 0 && length != size) {
+                throw InvalidInputException("array_join: sizes of the joined arrays do not match");
+            }
+            size = length;
+        }
+        if (size == 0 && data.left) {
+            if (count == STANDARD_VECTOR_SIZE) {
+                break;
+            }
+            padding.push_back(count);
+            parents.set_index(count, state.row);
+            for (idx_t a = 0; a < arrays; a++) {
+                elements[a].set_index(count, 0);
+            }
+            count++;
+            continue;
+        }
+        for (; state.element < size && count < STANDARD_VECTOR_SIZE; state.element++, count++) {
+            parents.set_index(count, state.row);
+            for (idx_t a = 0; a < arrays; a++) {
+                auto index = formats[a].sel->get_index(state.row);
+                auto &entry = UnifiedVectorFormat::GetData<list_entry_t>(formats[a])[index];
+                elements[a].set_index(count, entry.offset + state.element);
+            }
+        }
+        if (state.element < size) {
+            break;
+        }
+        state.element = 0;
+    }
+
+    vector<bool> joined(input.ColumnCount(), false);
+    for (idx_t a = 0; a < arrays; a++) {
+        auto column = data.arrays[a];
+        joined[column] = true;
+        auto &child = ListVector::GetEntry(input.data[column]);
+        if (ListVector::GetListSize(input.data[column]) == 0) {
+            // no element to reference, only padding rows
+            output.data[column].SetVectorType(VectorType::CONSTANT_VECTOR);
+            ConstantVector::SetNull(output.data[column], true);
+            continue;
+        }
+        output.data[column].Slice(child, elements[a], count);
+        if (!padding.empty()) {
+            output.data[column].Flatten(count);
+            for (auto row : padding) {
+                FlatVector::SetNull(output.data[column], row, true);
+            }
+        }
+    }
+    for (idx_t column = 0; column < input.ColumnCount(); column++) {
+        if (!joined[column]) {
+            output.data[column].Slice(input.data[column], parents, count);
+        }
+    }
+    output.SetCardinality(count);
+    if (state.row < input.size()) {
+        return OperatorResultType::HAVE_MORE_OUTPUT;
+    }
+    state.row = 0;
+    return OperatorResultType::NEED_MORE_INPUT;
+}
+
+void RegisterArrayFunctions(DatabaseInstance &instance) {
+    ExtensionUtil::RegisterFunction(instance,
+                                    TupleFunction<TuplePlusOperator, false, TupleNumbers::SUPERTYPE>("tuplePlus"));
+    ExtensionUtil::RegisterFunction(instance,
+                                    TupleFunction<TupleMinusOperator, false, TupleNumbers::SUPERTYPE>("tupleMinus"));
+    ExtensionUtil::RegisterFunction(
+        instance, TupleFunction<TupleMultiplyOperator, false, TupleNumbers::SUPERTYPE>("tupleMultiply"));
+    ExtensionUtil::RegisterFunction(instance,
+                                    TupleFunction<TupleDivideOperator, false, TupleNumbers::DOUBLES>("tupleDivide"));
+    ExtensionUtil::RegisterFunction(instance,
+                                    TupleFunction<TupleIntDivOperator, false, TupleNumbers::INTEGERS>("tupleIntDiv"));
+    ExtensionUtil::RegisterFunction(
+        instance, TupleFunction<TupleModuloOperator, false, TupleNumbers::SUPERTYPE>("tupleModulo"));
+    ExtensionUtil::RegisterFunction(
+        instance, TupleFunction<TupleMultiplyOperator, true, TupleNumbers::SUPERTYPE>("tupleMultiplyByNumber"));
+    ExtensionUtil::RegisterFunction(
+        instance, TupleFunction<TupleDivideOperator, true, TupleNumbers::DOUBLES>("tupleDivideByNumber"));
+    ExtensionUtil::RegisterFunction(
+        instance, TupleFunction<TupleIntDivOperator, true, TupleNumbers::INTEGERS>("tupleIntDivByNumber"));
+    ExtensionUtil::RegisterFunction(
+        instance, TupleFunction<TupleModuloOperator, true, TupleNumbers::SUPERTYPE>("tupleModuloByNumber"));
+
+    auto any_list = LogicalType::LIST(LogicalType::ANY);
+    ExtensionUtil::RegisterFunction(
+        instance, ScalarFunction("arraySum", {any_list}, LogicalType::BIGINT, nullptr, ArraySumBind));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("arrayUniq", {any_list}, LogicalType::UBIGINT,
+                                                             ArrayUniqFunction, ListArgumentBind));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("arrayDistinct", {any_list}, any_list,
+                                                             ArrayDistinctFunction, ListArgumentBind));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("arrayEnumerate", {any_list},
+                                                             LogicalType::LIST(LogicalType::UINTEGER),
+                                                             ArrayEnumerateFunction, ListArgumentBind));
+    ScalarFunctionSet exists("arrayExists");
+    exists.AddFunction(ScalarFunction({any_list}, LogicalType::BOOLEAN, ArrayAnyFunction, ArrayExistsBind));
+    exists.AddFunction(ScalarFunction({LogicalType::ANY, any_list}, LogicalType::BOOLEAN, ArrayContainsFunction,
+                                      ArrayExistsBind));
+    ExtensionUtil::RegisterFunction(instance, exists);
+
+    TableFunction array_join("array_join", {LogicalType::TABLE}, nullptr, ArrayJoinBind, nullptr, ArrayJoinInitLocal);
+    array_join.varargs = LogicalType::VARCHAR;
+    array_join.in_out_function = ArrayJoinFunction;
+    array_join.named_parameters["left"] = LogicalType::BOOLEAN;
+    ExtensionUtil::RegisterFunction(instance, array_join);
+}
+
+} // namespace duckdb
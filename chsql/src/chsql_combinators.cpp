@@ -0,0 +1,537 @@
+#include "chsql_aggregates.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include "duckdb/catalog/catalog_entry/aggregate_function_catalog_entry.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/aggregate_function.hpp"
+#include "duckdb/function/function_binder.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_aggregate_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+// ClickHouse aggregate combinators. A combinator wraps the bound base aggregate
+// and shares its state layout:
+//   -If     only feeds the rows where the trailing condition holds
+//   -Array  feeds the elements of its array arguments
+//   -State  finalizes into a BLOB holding the serialized state
+//   -Merge  reads such BLOBs back and combines them into its state
+// -State and -Merge bind the aggregates of GetSerializableAggregates in place
+// of DuckDB's count, sum, avg, min and max, whose states are not ours to store.
+
+struct CombinatorBase {
+    // ClickHouse name and the function it binds to
+    const char *name;
+    const char *function;
+    // -State/-Merge support, and whether -Merge needs the argument type to pick the overload
+    bool stateful;
+    bool typed;
+    LogicalTypeId merge_type;
+};
+
+static const CombinatorBase COMBINATOR_BASES[] = {
+    {"count", "count", true, false, LogicalTypeId::BIGINT},
+    {"sum", "sum", true, true, LogicalTypeId::DOUBLE},
+    {"avg", "avg", true, true, LogicalTypeId::DOUBLE},
+    {"min", "min", true, true, LogicalTypeId::DOUBLE},
+    {"max", "max", true, true, LogicalTypeId::DOUBLE},
+    {"any", "any_value", false, false, LogicalTypeId::INVALID},
+    {"anyLast", "last", false, false, LogicalTypeId::INVALID},
+    {"groupArray", "list", false, false, LogicalTypeId::INVALID},
+    {"uniq", "uniq", true, false, LogicalTypeId::BIGINT},
+    {"uniqHLL12", "uniqHLL12", true, false, LogicalTypeId::BIGINT},
+    {"uniqCombined", "uniqCombined", true, false, LogicalTypeId::BIGINT},
+    {"quantileTDigest", "quantileTDigest", true, false, LogicalTypeId::DOUBLE},
+    {"quantilesTDigest", "quantilesTDigest", true, false, LogicalTypeId::DOUBLE},
+    {"quantileTiming", "quantileTiming", true, false, LogicalTypeId::DOUBLE},
+    {"quantilesTiming", "quantilesTiming", true, false, LogicalTypeId::DOUBLE},
+    {"topK", "topK", false, false, LogicalTypeId::INVALID},
+};
+
+enum class CombinatorType : uint8_t { IF, ARRAY, STATE, MERGE };
+
+static const char *CombinatorSuffix(CombinatorType type) {
+    switch (type) {
+    case CombinatorType::IF:
+        return "If";
+    case CombinatorType::ARRAY:
+        return "Array";
+    case CombinatorType::STATE:
+        return "State";
+    default:
+        return "Merge";
+    }
+}
+
+static const CombinatorBase &FindBase(const string &name, CombinatorType type) {
+    auto base_name = name.substr(0, name.size() - strlen(CombinatorSuffix(type)));
+    for (auto &base : COMBINATOR_BASES) {
+        if (base_name == base.name) {
+            return base;
+        }
+    }
+    throw InternalException("No base aggregate for combinator '%s'", name);
+}
+
+// The inner aggregate, reachable from the calls that only get the function
+struct CombinatorInfo : public AggregateFunctionInfo {
+    explicit CombinatorInfo(AggregateFunction inner_p) : inner(std::move(inner_p)) {
+    }
+    AggregateFunction inner;
+};
+
+struct CombinatorBindData : public FunctionData {
+    AggregateFunction inner;
+    unique_ptr<FunctionData> inner_bind;
+    // -Array: which arguments are unnested
+    vector<bool> unnest;
+    // -State/-Merge: identifies the state layout inside the BLOB
+    string signature;
+    const AggregateStateCodec *codec = nullptr;
+
+    explicit CombinatorBindData(AggregateFunction inner_p) : inner(std::move(inner_p)) {
+    }
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<CombinatorBindData>(inner);
+        result->inner_bind = inner_bind ? inner_bind->Copy() : nullptr;
+        result->unnest = unnest;
+        result->signature = signature;
+        result->codec = codec;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        auto &other = other_p.Cast<CombinatorBindData>();
+        return inner == other.inner && FunctionData::Equals(inner_bind.get(), other.inner_bind.get()) &&
+               unnest == other.unnest && signature == other.signature;
+    }
+
+    AggregateInputData InnerInput(AggregateInputData &input) const {
+        return AggregateInputData(inner_bind.get(), input.allocator, input.combine_type);
+    }
+};
+
+static unique_ptr<BoundAggregateExpression> BindInner(ClientContext &context, const CombinatorBase &base,
+                                                      vector<unique_ptr<Expression>> children,
+                                                      bool serialized = false) {
+    auto functions = serialized ? GetSerializableAggregates(base.function) : AggregateFunctionSet(base.function);
+    if (functions.Size() == 0) {
+        functions = Catalog::GetEntry(context, CatalogType::AGGREGATE_FUNCTION_ENTRY, SYSTEM_CATALOG, DEFAULT_SCHEMA,
+                                      base.function)
+                        .Cast<AggregateFunctionCatalogEntry>()
+                        .functions;
+    }
+    vector<LogicalType> types;
+    for (auto &child : children) {
+        types.push_back(child->return_type);
+    }
+    FunctionBinder binder(context);
+    ErrorData error;
+    auto best = binder.BindFunction(base.function, functions, types, error);
+    if (!best.IsValid()) {
+        error.Throw();
+    }
+    auto function = functions.GetFunctionByOffset(best.GetIndex());
+    return binder.BindAggregateFunction(function, std::move(children), nullptr, AggregateType::NON_DISTINCT);
+}
+
+// Hands the wrapper the inner's argument types and result, and the inner to the state callbacks
+static unique_ptr<CombinatorBindData> FinishBind(AggregateFunction &function, BoundAggregateExpression &bound) {
+    auto result = make_uniq<CombinatorBindData>(bound.function);
+    result->inner_bind = std::move(bound.bind_info);
+    function.function_info = make_shared_ptr<CombinatorInfo>(bound.function);
+    function.return_type = bound.function.return_type;
+    function.varargs = LogicalType::INVALID;
+    function.arguments.clear();
+    return result;
+}
+
+static string InnerSignature(const CombinatorBase &base, const BoundAggregateExpression &bound) {
+    if (!base.typed) {
+        return base.name;
+    }
+    // the overloads of sum, avg, min and max keep different states
+    vector<string> types;
+    for (auto &argument : bound.function.arguments) {
+        types.push_back(argument.ToString());
+    }
+    return StringUtil::Format("%s(%s)", base.name, StringUtil::Join(types, ", "));
+}
+
+static unique_ptr<FunctionData> IfBind(ClientContext &context, AggregateFunction &function,
+                                       vector<unique_ptr<Expression>> &arguments) {
+    auto &base = FindBase(function.name, CombinatorType::IF);
+    if (arguments.empty()) {
+        throw BinderException("%s: the last argument must be the condition", function.name);
+    }
+    auto condition = std::move(arguments.back());
+    arguments.pop_back();
+    auto bound = BindInner(context, base, std::move(arguments));
+    auto result = FinishBind(function, *bound);
+    arguments = std::move(bound->children);
+    for (auto &argument : arguments) {
+        function.arguments.push_back(argument->return_type);
+    }
+    arguments.push_back(std::move(condition));
+    function.arguments.push_back(LogicalType::BOOLEAN);
+    return std::move(result);
+}
+
+static unique_ptr<FunctionData> ArrayBind(ClientContext &context, AggregateFunction &function,
+                                          vector<unique_ptr<Expression>> &arguments) {
+    auto &base = FindBase(function.name, CombinatorType::ARRAY);
+    vector<bool> unnest;
+    vector<unique_ptr<Expression>> children;
+    for (idx_t i = 0; i < arguments.size(); i++) {
+        auto &type = arguments[i]->return_type;
+        // constant parameters such as the levels of quantilesTDigest stay whole, even as lists
+        unnest.push_back(type.id() == LogicalTypeId::LIST && (i == 0 || !arguments[i]->IsFoldable()));
+        if (unnest.back()) {
+            children.push_back(make_uniq<BoundReferenceExpression>(ListType::GetChildType(type), i));
+        } else {
+            children.push_back(arguments[i]->Copy());
+        }
+    }
+    if (std::find(unnest.begin(), unnest.end(), true) == unnest.end()) {
+        throw BinderException("%s: expected an array argument", function.name);
+    }
+    auto bound = BindInner(context, base, std::move(children));
+    auto result = FinishBind(function, *bound);
+    // arguments the inner bind consumed (levels, k) are dropped
+    arguments.resize(bound->children.size());
+    unnest.resize(bound->children.size());
+    for (idx_t i = 0; i < arguments.size(); i++) {
+        auto &type = bound->children[i]->return_type;
+        function.arguments.push_back(unnest[i] ? LogicalType::LIST(type) : type);
+    }
+    result->unnest = std::move(unnest);
+    return std::move(result);
+}
+
+static unique_ptr<FunctionData> StateBind(ClientContext &context, AggregateFunction &function,
+                                          vector<unique_ptr<Expression>> &arguments) {
+    auto &base = FindBase(function.name, CombinatorType::STATE);
+    auto bound = BindInner(context, base, std::move(arguments), true);
+    auto result = FinishBind(function, *bound);
+    result->codec = GetAggregateStateCodec(bound->function);
+    if (!result->codec) {
+        throw BinderException("%s: this state cannot be serialized", function.name);
+    }
+    result->signature = InnerSignature(base, *bound);
+    arguments = std::move(bound->children);
+    for (auto &argument : arguments) {
+        function.arguments.push_back(argument->return_type);
+    }
+    function.return_type = LogicalType::BLOB;
+    return std::move(result);
+}
+
+static unique_ptr<FunctionData> MergeBind(ClientContext &context, AggregateFunction &function,
+                                          vector<unique_ptr<Expression>> &arguments) {
+    auto &base = FindBase(function.name, CombinatorType::MERGE);
+    if (arguments.empty()) {
+        throw BinderException("%s: expected a state produced by %sState", function.name, base.name);
+    }
+    // sumMerge(state, 'BIGINT') picks the overload the state was produced with
+    LogicalType type(base.merge_type);
+    idx_t parameters = 1;
+    if (base.typed && arguments.size() > 1 && arguments[1]->IsFoldable() &&
+        arguments[1]->return_type.id() == LogicalTypeId::VARCHAR) {
+        auto name = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+        type = TransformStringToLogicalType(StringValue::Get(name), context);
+        parameters = 2;
+    }
+    vector<unique_ptr<Expression>> children;
+    children.push_back(make_uniq<BoundReferenceExpression>(type, 0));
+    for (idx_t i = parameters; i < arguments.size(); i++) {
+        children.push_back(arguments[i]->Copy());
+    }
+    auto bound = BindInner(context, base, std::move(children), true);
+    auto result = FinishBind(function, *bound);
+    result->codec = GetAggregateStateCodec(bound->function);
+    if (!result->codec) {
+        throw BinderException("%s: this state cannot be serialized", function.name);
+    }
+    result->signature = InnerSignature(base, *bound);
+    if (bound->children.size() > 1) {
+        throw BinderException("%s: only the state and constant parameters are accepted", function.name);
+    }
+    arguments.resize(1);
+    function.arguments.push_back(LogicalType::BLOB);
+    return std::move(result);
+}
+
+// -- State callbacks shared by all combinators
+
+static const AggregateFunction &Inner(const AggregateFunction &function) {
+    return function.function_info->Cast<CombinatorInfo>().inner;
+}
+
+static idx_t CombinatorStateSize(const AggregateFunction &function) {
+    auto &inner = Inner(function);
+    return inner.state_size(inner);
+}
+
+static void CombinatorInitialize(const AggregateFunction &function, data_ptr_t state) {
+    auto &inner = Inner(function);
+    inner.initialize(inner, state);
+}
+
+static void CombinatorCombine(Vector &source, Vector &target, AggregateInputData &input, idx_t count) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    auto inner_input = data.InnerInput(input);
+    data.inner.combine(source, target, inner_input, count);
+}
+
+static void CombinatorFinalize(Vector &states, AggregateInputData &input, Vector &result, idx_t count, idx_t offset) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    auto inner_input = data.InnerInput(input);
+    data.inner.finalize(states, inner_input, result, count, offset);
+}
+
+static void CombinatorDestroy(Vector &states, AggregateInputData &input, idx_t count) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    if (data.inner.destructor) {
+        auto inner_input = data.InnerInput(input);
+        data.inner.destructor(states, inner_input, count);
+    }
+}
+
+static void CombinatorUpdate(Vector inputs[], AggregateInputData &input, idx_t input_count, Vector &states,
+                             idx_t count) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    auto inner_input = data.InnerInput(input);
+    data.inner.update(inputs, inner_input, input_count, states, count);
+}
+
+static void IfUpdate(Vector inputs[], AggregateInputData &input, idx_t input_count, Vector &states, idx_t count) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    auto inner_input = data.InnerInput(input);
+    auto arguments = input_count - 1;
+    UnifiedVectorFormat condition;
+    inputs[arguments].ToUnifiedFormat(count, condition);
+    auto conditions = UnifiedVectorFormat::GetData<bool>(condition);
+    SelectionVector sel(count);
+    idx_t selected = 0;
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = condition.sel->get_index(i);
+        if (condition.validity.RowIsValid(idx) && conditions[idx]) {
+            sel.set_index(selected++, i);
+        }
+    }
+    if (selected == count) {
+        data.inner.update(inputs, inner_input, arguments, states, count);
+        return;
+    }
+    if (selected == 0) {
+        return;
+    }
+    vector<Vector> sliced;
+    sliced.reserve(arguments);
+    for (idx_t c = 0; c < arguments; c++) {
+        sliced.emplace_back(inputs[c], sel, selected);
+    }
+    Vector sliced_states(states, sel, selected);
+    data.inner.update(sliced.data(), inner_input, arguments, sliced_states, selected);
+}
+
+// Elements are fed in batches of a vector; arrays of one row must have equal sizes
+static void ArrayUpdate(Vector inputs[], AggregateInputData &input, idx_t input_count, Vector &states, idx_t count) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    auto inner_input = data.InnerInput(input);
+    vector<UnifiedVectorFormat> formats(input_count);
+    for (idx_t c = 0; c < input_count; c++) {
+        inputs[c].ToUnifiedFormat(count, formats[c]);
+    }
+    SelectionVector rows(STANDARD_VECTOR_SIZE);
+    vector<SelectionVector> elements;
+    for (idx_t c = 0; c < input_count; c++) {
+        elements.emplace_back(STANDARD_VECTOR_SIZE);
+    }
+    idx_t batch = 0;
+    auto flush = [&]() {
+        vector<Vector> sliced;
+        sliced.reserve(input_count);
+        for (idx_t c = 0; c < input_count; c++) {
+            if (data.unnest[c]) {
+                sliced.emplace_back(ListVector::GetEntry(inputs[c]), elements[c], batch);
+            } else {
+                sliced.emplace_back(inputs[c], rows, batch);
+            }
+        }
+        Vector sliced_states(states, rows, batch);
+        data.inner.update(sliced.data(), inner_input, input_count, sliced_states, batch);
+        batch = 0;
+    };
+    for (idx_t i = 0; i < count; i++) {
+        optional_idx length;
+        for (idx_t c = 0; c < input_count; c++) {
+            if (!data.unnest[c]) {
+                continue;
+            }
+            auto idx = formats[c].sel->get_index(i);
+            auto size = formats[c].validity.RowIsValid(idx)
+                            ? UnifiedVectorFormat::GetData<list_entry_t>(formats[c])[idx].length
+                            : 0;
+            if (length.IsValid() && length.GetIndex() != size) {
+                throw InvalidInputException("Array arguments of aggregate function with -Array combinator must "
+                                            "have equal sizes");
+            }
+            length = size;
+        }
+        for (idx_t j = 0; j < length.GetIndex(); j++) {
+            for (idx_t c = 0; c < input_count; c++) {
+                if (data.unnest[c]) {
+                    auto idx = formats[c].sel->get_index(i);
+                    elements[c].set_index(batch, UnifiedVectorFormat::GetData<list_entry_t>(formats[c])[idx].offset + j);
+                }
+            }
+            rows.set_index(batch++, i);
+            if (batch == STANDARD_VECTOR_SIZE) {
+                flush();
+            }
+        }
+    }
+    if (batch > 0) {
+        flush();
+    }
+}
+
+// -- -State BLOBs: a format byte, the signature of the producing aggregate, then
+// the fields of the state as its codec writes them. Format 1 held DuckDB's
+// in-memory states and is no longer read.
+
+static constexpr uint8_t STATE_FORMAT = 2;
+
+static void StateFinalize(Vector &states, AggregateInputData &input, Vector &result, idx_t count, idx_t offset) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    UnifiedVectorFormat state_format;
+    states.ToUnifiedFormat(count, state_format);
+    auto state_data = UnifiedVectorFormat::GetData<const_data_ptr_t>(state_format);
+    auto result_data = FlatVector::GetData<string_t>(result);
+    string blob;
+    for (idx_t i = 0; i < count; i++) {
+        auto state = state_data[state_format.sel->get_index(i)];
+        blob.clear();
+        blob.push_back(char(STATE_FORMAT));
+        auto signature_size = uint16_t(data.signature.size());
+        blob.append(const_char_ptr_cast(&signature_size), sizeof(signature_size));
+        blob += data.signature;
+        data.codec->serialize(state, blob);
+        result_data[offset + i] = StringVector::AddStringOrBlob(result, blob);
+    }
+}
+
+static void ReadState(const CombinatorBindData &data, const string_t &blob, data_ptr_t state) {
+    auto bytes = blob.GetData();
+    auto size = blob.GetSize();
+    uint16_t signature_size = 0;
+    if (size >= 1 && uint8_t(bytes[0]) < STATE_FORMAT) {
+        throw InvalidInputException("Aggregate state written by an older version of the extension, compute it again");
+    }
+    if (size < 1 + sizeof(signature_size) || uint8_t(bytes[0]) != STATE_FORMAT) {
+        throw InvalidInputException("Not an aggregate state produced by a -State combinator");
+    }
+    memcpy(&signature_size, bytes + 1, sizeof(signature_size));
+    auto header = 1 + sizeof(signature_size) + signature_size;
+    if (size < header) {
+        throw InvalidInputException("Not an aggregate state produced by a -State combinator");
+    }
+    auto signature = string(bytes + 1 + sizeof(signature_size), signature_size);
+    if (signature != data.signature) {
+        throw InvalidInputException("Aggregate state of %s cannot be merged as %s", signature, data.signature);
+    }
+    data.codec->deserialize(bytes + header, size - header, state);
+}
+
+// Each BLOB is read into a temporary state which is then combined into the group's state
+static void MergeUpdate(Vector inputs[], AggregateInputData &input, idx_t input_count, Vector &states, idx_t count) {
+    auto &data = input.bind_data->Cast<CombinatorBindData>();
+    auto &inner = data.inner;
+    auto inner_input = data.InnerInput(input);
+    auto state_size = inner.state_size(inner);
+    auto stride = AlignValue(state_size);
+
+    UnifiedVectorFormat blob_format, state_format;
+    inputs[0].ToUnifiedFormat(count, blob_format);
+    states.ToUnifiedFormat(count, state_format);
+    auto blobs = UnifiedVectorFormat::GetData<string_t>(blob_format);
+    auto state_data = UnifiedVectorFormat::GetData<data_ptr_t>(state_format);
+
+    auto temp = make_unsafe_uniq_array<data_t>(stride * count);
+    Vector sources(LogicalType::POINTER, count);
+    Vector targets(LogicalType::POINTER, count);
+    auto source_data = FlatVector::GetData<data_ptr_t>(sources);
+    auto target_data = FlatVector::GetData<data_ptr_t>(targets);
+    idx_t valid = 0;
+    try {
+        for (idx_t i = 0; i < count; i++) {
+            auto idx = blob_format.sel->get_index(i);
+            if (!blob_format.validity.RowIsValid(idx)) {
+                continue;
+            }
+            auto state = temp.get() + valid * stride;
+            inner.initialize(inner, state);
+            source_data[valid] = state;
+            target_data[valid] = state_data[state_format.sel->get_index(i)];
+            valid++;
+            ReadState(data, blobs[idx], state);
+        }
+    } catch (...) {
+        if (inner.destructor) {
+            inner.destructor(sources, inner_input, valid);
+        }
+        throw;
+    }
+    if (valid == 0) {
+        return;
+    }
+    inner.combine(sources, targets, inner_input, valid);
+    if (inner.destructor) {
+        inner.destructor(sources, inner_input, valid);
+    }
+}
+
+static AggregateFunction GetCombinatorFunction(const string &name, CombinatorType type) {
+    aggregate_update_t update = CombinatorUpdate;
+    aggregate_finalize_t finalize = CombinatorFinalize;
+    bind_aggregate_function_t bind = StateBind;
+    switch (type) {
+    case CombinatorType::IF:
+        update = IfUpdate;
+        bind = IfBind;
+        break;
+    case CombinatorType::ARRAY:
+        update = ArrayUpdate;
+        bind = ArrayBind;
+        break;
+    case CombinatorType::STATE:
+        finalize = StateFinalize;
+        break;
+    case CombinatorType::MERGE:
+        update = MergeUpdate;
+        bind = MergeBind;
+        break;
+    }
+    AggregateFunction function(name, {}, LogicalType::ANY, CombinatorStateSize, CombinatorInitialize, update,
+                               CombinatorCombine, finalize, FunctionNullHandling::DEFAULT_NULL_HANDLING, nullptr,
+                               bind, CombinatorDestroy);
+    function.varargs = LogicalType::ANY;
+    return function;
+}
+
+void RegisterCombinatorFunctions(DatabaseInstance &instance) {
+    for (auto &base : COMBINATOR_BASES) {
+        for (auto type : {CombinatorType::IF, CombinatorType::ARRAY, CombinatorType::STATE, CombinatorType::MERGE}) {
+            if (!base.stateful && (type == CombinatorType::STATE || type == CombinatorType::MERGE)) {
+                continue;
+            }
+            auto name = string(base.name) + CombinatorSuffix(type);
+            ExtensionUtil::RegisterFunction(instance, GetCombinatorFunction(name, type));
+        }
+    }
+}
+
+} // namespace duckdb
@@ -0,0 +1,319 @@
+#include "chsql_compression.hpp"
+#include "chsql_pool.hpp"
+#include "duckdb/catalog/catalog_transaction.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/http_util.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/common/types/uuid.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/database.hpp"
+#include "duckdb/main/extension_helper.hpp"
+#include "duckdb/main/secret/secret.hpp"
+#include "duckdb/main/secret/secret_manager.hpp"
+
+namespace duckdb {
+
+static bool IsParquetFormat(const string &format) {
+    return StringUtil::Lower(format) == "parquet";
+}
+
+string RemoteCompression::Validate(const string &codec, const string &format) {
+    auto lcodec = StringUtil::Lower(codec);
+    if (lcodec.empty() || lcodec == "none") {
+        return "";
+    }
+    if (lcodec != "zstd" && lcodec != "lz4" && lcodec != "gzip") {
+        throw InvalidInputException("Unsupported compression '%s', expected zstd, lz4 or gzip", codec);
+    }
+    // the local text readers understand gzip and zstd streams only
+    if (lcodec == "lz4" && !IsParquetFormat(format)) {
+        throw InvalidInputException("Compression 'lz4' is only supported with format 'Parquet'");
+    }
+    return lcodec;
+}
+
+string RemoteCompression::UrlParameters(const string &codec, const string &format) {
+    if (codec.empty()) {
+        return "";
+    }
+    if (IsParquetFormat(format)) {
+        return "output_format_parquet_compression_method=" + codec + "&";
+    }
+    return "enable_http_compression=1&";
+}
+
+bool RemoteCompression::Streamed(const string &codec, const string &format) {
+    return !codec.empty() && !IsParquetFormat(format);
+}
+
+RemoteHttpAuth RemoteHttpAuth::Lookup(ClientContext &context, const string &url) {
+    RemoteHttpAuth result;
+    auto &secret_manager = SecretManager::Get(context);
+    auto transaction = CatalogTransaction::GetSystemCatalogTransaction(context);
+    int64_t best_score = -1;
+    for (auto &entry : secret_manager.AllSecrets(transaction)) {
+        auto &secret = *entry.secret;
+        if (secret.GetType() != "http" || StringUtil::StartsWith(secret.GetName(), "__chsql_")) {
+            continue;
+        }
+        auto score = secret.MatchScore(url);
+        auto key_value = dynamic_cast<const KeyValueSecret *>(&secret);
+        if (score <= best_score || !key_value) {
+            continue;
+        }
+        best_score = score;
+        result.headers.clear();
+        Value user_headers;
+        if (key_value->TryGetValue("extra_http_headers", user_headers) && !user_headers.IsNull()) {
+            for (auto &header : MapValue::GetChildren(user_headers)) {
+                auto &kv = StructValue::GetChildren(header);
+                result.headers[kv[0].ToString()] = kv[1].ToString();
+            }
+        }
+        hash_t values = 0;
+        for (auto &kv : key_value->secret_map) {
+            values = CombineHash(values, Hash(kv.first.c_str()));
+            values = CombineHash(values, Hash(kv.second.ToString().c_str()));
+        }
+        result.identity = secret.GetName() + ":" + std::to_string(values);
+    }
+    return result;
+}
+
+static constexpr const char *REMOTE_STREAM_PREFIX = "chsqlstream://";
+// the body a stream buffers ahead of its reader
+static constexpr idx_t REMOTE_STREAM_BUFFER = 8 * 1024 * 1024;
+
+// The open streams by path, for the file system to hand to the readers
+static mutex remote_streams_lock;
+static unordered_map<string, weak_ptr<RemoteStream>> remote_streams;
+
+RemoteStream::RemoteStream(ClientContext &context, const string &url_p, const string &codec)
+    : url(url_p), http(HTTPUtil::Get(DatabaseInstance::GetDatabase(context))),
+      headers(DatabaseInstance::GetDatabase(context)), clients(RemoteHttpClientPool::Get(context)) {
+    // everything from the context is resolved here: the request runs on a thread of its own
+    params = http.InitializeParameters(context, url);
+    for (auto &header : RemoteHttpAuth::Lookup(context, url).headers) {
+        headers.Insert(header.first, header.second);
+    }
+    if (!codec.empty()) {
+        // the header goes with this request only, next to the user's own, e.g. X-ClickHouse-User
+        headers.Insert("Accept-Encoding", codec);
+    }
+    request = make_uniq<GetRequestInfo>(
+        url, headers, *params,
+        [this](const HTTPResponse &response) {
+            lock_guard<mutex> guard(lock);
+            success = response.Success();
+            error_head.clear();
+            return !cancelled;
+        },
+        [this](const_data_ptr_t data, idx_t length) { return Push(data, length); });
+    client = clients->Acquire(context, http, *params, request->proto_host_port);
+    thread = std::thread([this]() { Run(); });
+}
+
+RemoteStream::~RemoteStream() {
+    {
+        lock_guard<mutex> guard(lock);
+        cancelled = true;
+    }
+    changed.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    lock_guard<mutex> guard(remote_streams_lock);
+    remote_streams.erase(path);
+}
+
+void RemoteStream::Run() {
+    unique_ptr<HTTPResponse> response;
+    std::exception_ptr failure;
+    try {
+        response = http.Request(*request, client);
+        lock_guard<mutex> guard(lock);
+        if (response->Success() && !cancelled) {
+            clients->Release(request->proto_host_port, std::move(client));
+        }
+    } catch (std::exception &) {
+        failure = std::current_exception();
+    }
+    Finish(std::move(response), failure);
+}
+
+bool RemoteStream::Push(const_data_ptr_t data, idx_t length) {
+    unique_lock<mutex> guard(lock);
+    if (!success) {
+        if (error_head.size() < 1024) {
+            error_head.append(const_char_ptr_cast(data), MinValue<idx_t>(length, 1024 - error_head.size()));
+        }
+        return !cancelled;
+    }
+    // a retry would send the body from its start again
+    params->retries = 0;
+    changed.wait(guard, [&]() { return cancelled || buffered < REMOTE_STREAM_BUFFER; });
+    if (cancelled) {
+        return false;
+    }
+    chunks.emplace_back(const_char_ptr_cast(data), length);
+    buffered += length;
+    guard.unlock();
+    changed.notify_all();
+    return true;
+}
+
+void RemoteStream::Finish(unique_ptr<HTTPResponse> response, std::exception_ptr failure) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (failure) {
+            exception = failure;
+        } else if (!response->Success()) {
+            exception = std::make_exception_ptr(
+                IOException("Request to %s failed: %s %s", url, response->GetError(), error_head));
+        }
+        done = true;
+    }
+    changed.notify_all();
+}
+
+idx_t RemoteStream::Read(data_ptr_t buffer, idx_t nr_bytes) {
+    unique_lock<mutex> guard(lock);
+    changed.wait(guard, [&]() { return buffered > 0 || done; });
+    if (buffered == 0) {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return 0;
+    }
+    idx_t read = 0;
+    while (read < nr_bytes && !chunks.empty()) {
+        auto &front = chunks.front();
+        auto count = MinValue<idx_t>(nr_bytes - read, front.size() - front_offset);
+        memcpy(buffer + read, front.data() + front_offset, count);
+        read += count;
+        front_offset += count;
+        if (front_offset == front.size()) {
+            chunks.pop_front();
+            front_offset = 0;
+        }
+    }
+    buffered -= read;
+    guard.unlock();
+    changed.notify_all();
+    return read;
+}
+
+shared_ptr<RemoteStream> RemoteCompression::Open(ClientContext &context, const string &url, const string &codec) {
+    auto &db = DatabaseInstance::GetDatabase(context);
+    if (!db.ExtensionIsLoaded("httpfs")) {
+        ExtensionHelper::TryAutoLoadExtension(context, "httpfs");
+    }
+    auto stream = make_shared_ptr<RemoteStream>(context, url, codec);
+    // the readers detect the codec by the extension: take it from the magic number
+    uint8_t magic[4] = {0, 0, 0, 0};
+    idx_t available;
+    {
+        unique_lock<mutex> guard(stream->lock);
+        stream->changed.wait(guard, [&]() { return stream->buffered >= sizeof(magic) || stream->done; });
+        if (stream->buffered == 0 && stream->exception) {
+            std::rethrow_exception(stream->exception);
+        }
+        available = 0;
+        for (auto &chunk : stream->chunks) {
+            for (idx_t i = 0; i < chunk.size() && available < sizeof(magic); i++) {
+                magic[available++] = UnsafeNumericCast<uint8_t>(chunk[i]);
+            }
+        }
+    }
+    string extension;
+    if (available >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        extension = ".gz";
+    } else if (available == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        extension = ".zst";
+    }
+    stream->path = REMOTE_STREAM_PREFIX + UUID::ToString(UUID::GenerateRandomUUID()) + extension;
+    lock_guard<mutex> guard(remote_streams_lock);
+    remote_streams[stream->path] = stream;
+    return stream;
+}
+
+class RemoteStreamHandle : public FileHandle {
+public:
+    RemoteStreamHandle(FileSystem &fs, const string &path, FileOpenFlags flags, shared_ptr<RemoteStream> stream)
+        : FileHandle(fs, path, flags), stream(std::move(stream)) {
+    }
+
+    void Close() override {
+    }
+
+    shared_ptr<RemoteStream> stream;
+};
+
+// A read-only file system over the open streams, front to back like a pipe
+class RemoteStreamFileSystem : public FileSystem {
+public:
+    unique_ptr<FileHandle> OpenFile(const string &path, FileOpenFlags flags,
+                                    optional_ptr<FileOpener> opener = nullptr) override {
+        if (flags.OpenForWriting()) {
+            throw PermissionException("%s is read-only", path);
+        }
+        shared_ptr<RemoteStream> stream;
+        {
+            lock_guard<mutex> guard(remote_streams_lock);
+            auto entry = remote_streams.find(path);
+            if (entry != remote_streams.end()) {
+                stream = entry->second.lock();
+            }
+        }
+        if (!stream) {
+            throw IOException("%s is not an open remote response", path);
+        }
+        return make_uniq<RemoteStreamHandle>(*this, path, flags, std::move(stream));
+    }
+
+    int64_t Read(FileHandle &handle, void *buffer, int64_t nr_bytes) override {
+        auto &stream = *handle.Cast<RemoteStreamHandle>().stream;
+        return UnsafeNumericCast<int64_t>(stream.Read(static_cast<data_ptr_t>(buffer), NumericCast<idx_t>(nr_bytes)));
+    }
+
+    void Read(FileHandle &handle, void *buffer, int64_t nr_bytes, idx_t location) override {
+        throw NotImplementedException("%s can only be read front to back", handle.path);
+    }
+
+    int64_t GetFileSize(FileHandle &handle) override {
+        // unknown until the end, like a pipe
+        return 0;
+    }
+
+    bool FileExists(const string &filename, optional_ptr<FileOpener> opener = nullptr) override {
+        lock_guard<mutex> guard(remote_streams_lock);
+        return remote_streams.find(filename) != remote_streams.end();
+    }
+
+    bool IsPipe(const string &filename, optional_ptr<FileOpener> opener = nullptr) override {
+        return true;
+    }
+
+    bool CanSeek() override {
+        return false;
+    }
+
+    bool OnDiskFile(FileHandle &handle) override {
+        return false;
+    }
+
+    bool CanHandleFile(const string &fpath) override {
+        return StringUtil::StartsWith(fpath, REMOTE_STREAM_PREFIX);
+    }
+
+    string GetName() const override {
+        return "RemoteStreamFileSystem";
+    }
+};
+
+void RegisterRemoteStreamFileSystem(DatabaseInstance &instance) {
+    instance.GetFileSystem().RegisterSubSystem(make_uniq<RemoteStreamFileSystem>());
+}
+
+} // namespace duckdb
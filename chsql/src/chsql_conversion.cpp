@@ -0,0 +1,89 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+namespace duckdb {
+
+// Rows that could not be converted (or were NULL) become 0
+template <class T>
+static void ZeroFillNulls(Vector &result, idx_t count) {
+    if (result.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+        if (ConstantVector::IsNull(result)) {
+            *ConstantVector::GetData<T>(result) = T(0);
+            ConstantVector::SetNull(result, false);
+        }
+        return;
+    }
+    result.Flatten(count);
+    auto &validity = FlatVector::Validity(result);
+    if (validity.AllValid()) {
+        return;
+    }
+    auto data = FlatVector::GetData<T>(result);
+    for (idx_t i = 0; i < count; i++) {
+        if (!validity.RowIsValid(i)) {
+            data[i] = T(0);
+        }
+    }
+    validity.SetAllValid(count);
+}
+
+// toXxxOrZero / toXxxOrNull: strings are parsed once per row straight into the
+// result, failures only touch the validity mask. Other input types go through
+// a single non-throwing vector cast.
+template <class T, bool OR_NULL>
+static void ToNumberOrDefaultFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &input = args.data[0];
+    auto count = args.size();
+    if (input.GetType().id() == LogicalTypeId::VARCHAR) {
+        UnaryExecutor::ExecuteWithNulls<string_t, T>(input, result, count,
+                                                     [&](string_t str, ValidityMask &mask, idx_t idx) {
+                                                         T value;
+                                                         if (TryCast::Operation<string_t, T>(str, value, false)) {
+                                                             return value;
+                                                         }
+                                                         if (OR_NULL) {
+                                                             mask.SetInvalid(idx);
+                                                         }
+                                                         return T(0);
+                                                     });
+    } else {
+        string error;
+        VectorOperations::TryCast(state.GetContext(), input, result, count, &error);
+    }
+    if (!OR_NULL) {
+        ZeroFillNulls<T>(result, count);
+    }
+}
+
+template <class T>
+static void RegisterConversion(DatabaseInstance &instance, const string &name, const LogicalType &type) {
+    ScalarFunction or_zero(name + "OrZero", {LogicalType::ANY}, type, ToNumberOrDefaultFunction<T, false>);
+    // NULL input also yields 0, like the CASE expressions these replace
+    or_zero.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+    ExtensionUtil::RegisterFunction(instance, or_zero);
+
+    ScalarFunction or_null(name + "OrNull", {LogicalType::ANY}, type, ToNumberOrDefaultFunction<T, true>);
+    ExtensionUtil::RegisterFunction(instance, or_null);
+}
+
+void RegisterConversionFunctions(DatabaseInstance &instance) {
+    RegisterConversion<int8_t>(instance, "toInt8", LogicalType::TINYINT);
+    RegisterConversion<int16_t>(instance, "toInt16", LogicalType::SMALLINT);
+    RegisterConversion<int32_t>(instance, "toInt32", LogicalType::INTEGER);
+    RegisterConversion<int64_t>(instance, "toInt64", LogicalType::BIGINT);
+    RegisterConversion<hugeint_t>(instance, "toInt128", LogicalType::HUGEINT);
+    RegisterConversion<hugeint_t>(instance, "toInt256", LogicalType::HUGEINT);
+    RegisterConversion<uint8_t>(instance, "toUInt8", LogicalType::UTINYINT);
+    RegisterConversion<uint16_t>(instance, "toUInt16", LogicalType::USMALLINT);
+    RegisterConversion<uint32_t>(instance, "toUInt32", LogicalType::UINTEGER);
+    RegisterConversion<uint64_t>(instance, "toUInt64", LogicalType::UBIGINT);
+    RegisterConversion<double>(instance, "toFloat", LogicalType::DOUBLE);
+    RegisterConversion<float>(instance, "toFloat32", LogicalType::FLOAT);
+    RegisterConversion<double>(instance, "toFloat64", LogicalType::DOUBLE);
+}
+
+} // namespace duckdb
@@ -0,0 +1,562 @@
+#include "chsql_extension.hpp"
+#include "duckdb/catalog/catalog.hpp"
+#include "duckdb/catalog/catalog_entry/scalar_function_catalog_entry.hpp"
+#include "duckdb/common/operator/add.hpp"
+#include "duckdb/common/operator/multiply.hpp"
+#include "duckdb/common/types/date.hpp"
+#include "duckdb/common/types/timestamp.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/expression_executor_state.hpp"
+#include "duckdb/function/function_binder.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_constant_expression.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/planner/expression/bound_reference_expression.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+// -- Civil date arithmetic on days since 1970-01-01 (Howard Hinnant's algorithms)
+
+static int64_t FloorDiv(int64_t value, int64_t divisor) {
+    auto quotient = value / divisor;
+    return quotient - (value % divisor < 0 ? 1 : 0);
+}
+
+static int64_t FloorTo(int64_t value, int64_t step) {
+    return FloorDiv(value, step) * step;
+}
+
+static void CivilFromDays(int64_t days, int64_t &year, int64_t &month, int64_t &day) {
+    days += 719468;
+    auto era = FloorDiv(days, 146097);
+    auto day_of_era = days - era * 146097;
+    auto year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    auto day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    auto shifted_month = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+static int64_t DaysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2 ? 1 : 0;
+    auto era = FloorDiv(year, 400);
+    auto year_of_era = year - era * 400;
+    auto day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    auto day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// -- Time zones
+
+static const int64_t SAMPLE_FIRST_DAY = 0;
+static const int64_t SAMPLE_LAST_DAY = 36525;
+static const int64_t SAMPLES_PER_DAY = 96;
+
+// UTC offsets of a time zone as a sorted list of transitions, sampled once
+// from DuckDB's ICU time zone support for 1970 to 2070 and then looked up per
+// row without calling into ICU. Instants outside of that range are left to ICU.
+class TimeZoneOffsets : public ObjectCacheEntry {
+public:
+    static string ObjectType() {
+        return "chsql_time_zone";
+    }
+    string GetObjectType() override {
+        return ObjectType();
+    }
+
+    // instants (UTC microseconds) at which the offset changes
+    vector<int64_t> transitions;
+    // offsets[i] holds before transitions[i], the last one after all of them
+    vector<int64_t> offsets;
+
+    // false for UTC, whose offset holds at every instant
+    bool sampled = false;
+
+    bool Covers(int64_t utc) const {
+        return !sampled || (utc >= SAMPLE_FIRST_DAY * Interval::MICROS_PER_DAY &&
+                            utc <= SAMPLE_LAST_DAY * Interval::MICROS_PER_DAY);
+    }
+
+    int64_t Offset(int64_t utc) const {
+        if (transitions.empty()) {
+            return offsets[0];
+        }
+        auto index = std::upper_bound(transitions.begin(), transitions.end(), utc) - transitions.begin();
+        return offsets[index];
+    }
+};
+
+static bool IsUTC(const string &name) {
+    auto lower = StringUtil::Lower(name);
+    return lower == "utc" || lower == "gmt" || lower == "z" || lower == "etc/utc" || lower == "etc/gmt" ||
+           lower == "universal" || lower == "zulu";
+}
+
+// ICU's timezone(name, instant), bound to the first column of a chunk
+static unique_ptr<Expression> BindIcuTimeZone(ClientContext &context, const string &name) {
+    auto entry = Catalog::GetEntry(context, CatalogType::SCALAR_FUNCTION_ENTRY, SYSTEM_CATALOG, DEFAULT_SCHEMA,
+                                   "timezone", OnEntryNotFound::RETURN_NULL);
+    if (!entry) {
+        throw BinderException("Time zone '%s' needs the icu extension, load it or pass 'UTC'", name);
+    }
+    vector<unique_ptr<Expression>> children;
+    children.push_back(make_uniq<BoundConstantExpression>(Value(name)));
+    children.push_back(make_uniq<BoundReferenceExpression>(LogicalType::TIMESTAMP_TZ, 0));
+    FunctionBinder binder(context);
+    ErrorData error;
+    auto expr = binder.BindScalarFunction(entry->Cast<ScalarFunctionCatalogEntry>(), std::move(children), error);
+    if (!expr) {
+        error.Throw();
+    }
+    return expr;
+}
+
+// Offsets at arbitrary instants, asked from ICU a chunk at a time
+class IcuOffsets {
+public:
+    IcuOffsets(ClientContext &context, const Expression &expr) : executor(context, expr) {
+        input.Initialize(Allocator::Get(context), {LogicalType::TIMESTAMP_TZ});
+    }
+
+    vector<int64_t> Get(const vector<int64_t> &instants) {
+        vector<int64_t> result;
+        for (idx_t begin = 0; begin < instants.size(); begin += STANDARD_VECTOR_SIZE) {
+            auto count = MinValue<idx_t>(STANDARD_VECTOR_SIZE, instants.size() - begin);
+            input.Reset();
+            auto data = FlatVector::GetData<timestamp_t>(input.data[0]);
+            for (idx_t i = 0; i < count; i++) {
+                data[i] = timestamp_t(instants[begin + i]);
+            }
+            input.SetCardinality(count);
+            Vector local(LogicalType::TIMESTAMP, count);
+            executor.ExecuteExpression(input, local);
+            local.Flatten(count);
+            auto local_data = FlatVector::GetData<timestamp_t>(local);
+            for (idx_t i = 0; i < count; i++) {
+                result.push_back(local_data[i].value - instants[begin + i]);
+            }
+        }
+        return result;
+    }
+
+private:
+    ExpressionExecutor executor;
+    DataChunk input;
+};
+
+static shared_ptr<TimeZoneOffsets> SampleTimeZone(ClientContext &context, const Expression &icu) {
+    IcuOffsets offsets(context, icu);
+    auto offsets_at = [&](const vector<int64_t> &instants) {
+        return offsets.Get(instants);
+    };
+
+    // one sample per day, then every quarter hour of the days where the offset changed
+    vector<int64_t> days;
+    for (int64_t day = SAMPLE_FIRST_DAY; day <= SAMPLE_LAST_DAY; day++) {
+        days.push_back(day * Interval::MICROS_PER_DAY);
+    }
+    auto daily = offsets_at(days);
+    auto result = make_shared_ptr<TimeZoneOffsets>();
+    result->sampled = true;
+    result->offsets.push_back(daily[0]);
+    auto step = Interval::MICROS_PER_DAY / SAMPLES_PER_DAY;
+    for (idx_t i = 1; i < daily.size(); i++) {
+        if (daily[i] == daily[i - 1]) {
+            continue;
+        }
+        vector<int64_t> instants;
+        for (int64_t s = 1; s <= SAMPLES_PER_DAY; s++) {
+            instants.push_back(days[i - 1] + s * step);
+        }
+        auto within = offsets_at(instants);
+        for (idx_t s = 0; s < within.size(); s++) {
+            if (within[s] != daily[i - 1]) {
+                result->transitions.push_back(instants[s]);
+                result->offsets.push_back(within[s]);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+static shared_ptr<TimeZoneOffsets> GetTimeZone(ClientContext &context, const Expression &icu, const string &name) {
+    auto &cache = ObjectCache::GetObjectCache(context);
+    auto key = TimeZoneOffsets::ObjectType() + ":" + name;
+    auto zone = cache.Get<TimeZoneOffsets>(key);
+    if (!zone) {
+        zone = SampleTimeZone(context, icu);
+        cache.Put(key, zone);
+    }
+    return zone;
+}
+
+// -- Functions
+
+enum class DateTimeUnit : uint8_t { MICROS, DAY, WEEK, MONTH, YEAR };
+
+struct DateTimeBindData : public FunctionData {
+    // converts instants to local wall time, nullptr for plain dates and timestamps
+    shared_ptr<TimeZoneOffsets> zone;
+    // ICU's timezone() for the instants the zone does not cover, nullptr for UTC
+    unique_ptr<Expression> icu;
+    // toStartOfInterval
+    DateTimeUnit unit = DateTimeUnit::MICROS;
+    int64_t step = 1;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<DateTimeBindData>();
+        result->zone = zone;
+        result->icu = icu ? icu->Copy() : nullptr;
+        result->unit = unit;
+        result->step = step;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        auto &other = other_p.Cast<DateTimeBindData>();
+        return zone == other.zone && unit == other.unit && step == other.step;
+    }
+};
+
+// The offsets of one thread: from the sampled transitions where they cover the
+// instant, from ICU elsewhere. Executors without a client context, which ICU
+// needs, keep the offset at the nearest end of the sampled range.
+struct DateTimeLocalState : public FunctionLocalState {
+    DateTimeLocalState(optional_ptr<ClientContext> context, const DateTimeBindData &data)
+        : context(context), data(data) {
+    }
+
+    optional_ptr<ClientContext> context;
+    const DateTimeBindData &data;
+    unique_ptr<IcuOffsets> icu;
+
+    int64_t Offset(int64_t utc) {
+        if (data.zone->Covers(utc) || !context) {
+            return data.zone->Offset(utc);
+        }
+        if (!icu) {
+            icu = make_uniq<IcuOffsets>(*context, *data.icu);
+        }
+        return icu->Get({utc})[0];
+    }
+
+    // the instant of a local wall time; for times skipped or repeated by a
+    // transition the offset before it wins
+    int64_t LocalToUTC(int64_t local) {
+        return local - Offset(local - Offset(local));
+    }
+};
+
+static unique_ptr<FunctionLocalState> DateTimeInitLocal(ExpressionState &state, const BoundFunctionExpression &expr,
+                                                        FunctionData *bind_data) {
+    optional_ptr<ClientContext> context = state.HasContext() ? &state.GetContext() : nullptr;
+    return make_uniq<DateTimeLocalState>(context, bind_data->Cast<DateTimeBindData>());
+}
+
+// Every function works on the local wall time in microseconds since the epoch
+static bool ToLocal(date_t input, DateTimeLocalState &, int64_t &local) {
+    return Date::IsFinite(input) &&
+           TryMultiplyOperator::Operation<int64_t, int64_t, int64_t>(input.days, Interval::MICROS_PER_DAY, local);
+}
+
+static bool ToLocal(timestamp_t input, DateTimeLocalState &state, int64_t &local) {
+    if (!Timestamp::IsFinite(input)) {
+        return false;
+    }
+    if (!state.data.zone) {
+        local = input.value;
+        return true;
+    }
+    return TryAddOperator::Operation<int64_t, int64_t, int64_t>(input.value, state.Offset(input.value), local);
+}
+
+static bool FromLocal(int64_t local, DateTimeLocalState &, date_t &result) {
+    result = date_t(UnsafeNumericCast<int32_t>(FloorDiv(local, Interval::MICROS_PER_DAY)));
+    return true;
+}
+
+static bool FromLocal(int64_t local, DateTimeLocalState &state, timestamp_t &result) {
+    result = timestamp_t(state.data.zone ? state.LocalToUTC(local) : local);
+    return true;
+}
+
+static int64_t LocalDays(int64_t local) {
+    return FloorDiv(local, Interval::MICROS_PER_DAY);
+}
+
+struct ToYYYYMMOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &, RESULT &result) {
+        int64_t year, month, day;
+        CivilFromDays(LocalDays(local), year, month, day);
+        result = RESULT(year * 100 + month);
+        return year >= 0;
+    }
+};
+
+struct ToYYYYMMDDOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &, RESULT &result) {
+        int64_t year, month, day;
+        CivilFromDays(LocalDays(local), year, month, day);
+        result = RESULT(year * 10000 + month * 100 + day);
+        return year >= 0;
+    }
+};
+
+struct ToYYYYMMDDhhmmssOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &, RESULT &result) {
+        int64_t year, month, day;
+        auto days = LocalDays(local);
+        CivilFromDays(days, year, month, day);
+        auto seconds = (local - days * Interval::MICROS_PER_DAY) / Interval::MICROS_PER_SEC;
+        auto time = seconds / 3600 * 10000 + seconds / 60 % 60 * 100 + seconds % 60;
+        result = RESULT((year * 10000 + month * 100 + day) * 1000000 + time);
+        return year >= 0;
+    }
+};
+
+struct ToRelativeDayNumOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &, RESULT &result) {
+        return TryCast::Operation(LocalDays(local), result);
+    }
+};
+
+struct ToStartOfHourOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &state, RESULT &result) {
+        return FromLocal(FloorTo(local, Interval::MICROS_PER_HOUR), state, result);
+    }
+};
+
+struct ToStartOfDayOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &state, RESULT &result) {
+        return FromLocal(FloorTo(local, Interval::MICROS_PER_DAY), state, result);
+    }
+};
+
+// 1970-01-01 was a Thursday
+struct ToMondayOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &state, RESULT &result) {
+        auto days = LocalDays(local);
+        return FromLocal((days - (days + 3 - FloorTo(days + 3, 7))) * Interval::MICROS_PER_DAY, state, result);
+    }
+};
+
+// Buckets are aligned as ClickHouse aligns them: whole hours from the start
+// of the day, shorter steps and days from the epoch, weeks from its first
+// Monday, months from January 1970 and years from year 0.
+struct ToStartOfIntervalOperator {
+    template <class RESULT>
+    static bool Operation(int64_t local, DateTimeLocalState &state, RESULT &result) {
+        auto &data = state.data;
+        auto days = LocalDays(local);
+        int64_t start;
+        switch (data.unit) {
+        case DateTimeUnit::MICROS:
+            if (data.step % Interval::MICROS_PER_HOUR == 0) {
+                auto day_start = days * Interval::MICROS_PER_DAY;
+                start = day_start + FloorTo(local - day_start, data.step);
+            } else {
+                start = FloorTo(local, data.step);
+            }
+            return FromLocal(start, state, result);
+        case DateTimeUnit::DAY:
+            start = FloorTo(days, data.step);
+            break;
+        case DateTimeUnit::WEEK:
+            start = 4 + FloorTo(days - 4, data.step * 7);
+            break;
+        case DateTimeUnit::MONTH: {
+            int64_t year, month, day;
+            CivilFromDays(days, year, month, day);
+            auto index = FloorTo((year - 1970) * 12 + month - 1, data.step);
+            start = DaysFromCivil(1970 + FloorDiv(index, 12), index - FloorTo(index, 12) + 1, 1);
+            break;
+        }
+        case DateTimeUnit::YEAR: {
+            int64_t year, month, day;
+            CivilFromDays(days, year, month, day);
+            start = DaysFromCivil(FloorTo(year, data.step), 1, 1);
+            break;
+        }
+        default:
+            throw InternalException("Unknown toStartOfInterval unit");
+        }
+        return FromLocal(start * Interval::MICROS_PER_DAY, state, result);
+    }
+};
+
+template <class INPUT, class RESULT, class OP>
+static void DateTimeFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &local_state = ExecuteFunctionState::GetFunctionState(state)->Cast<DateTimeLocalState>();
+    UnaryExecutor::ExecuteWithNulls<INPUT, RESULT>(args.data[0], result, args.size(),
+                                                   [&](INPUT input, ValidityMask &mask, idx_t idx) {
+                                                       int64_t local;
+                                                       RESULT value;
+                                                       if (!ToLocal(input, local_state, local) ||
+                                                           !OP::template Operation<RESULT>(local, local_state, value)) {
+                                                           mask.SetInvalid(idx);
+                                                           return RESULT();
+                                                       }
+                                                       return value;
+                                                   });
+}
+
+template <class RESULT, class OP>
+static scalar_function_t SelectDateTimeFunction(const LogicalType &input) {
+    if (input.id() == LogicalTypeId::DATE) {
+        return DateTimeFunction<date_t, RESULT, OP>;
+    }
+    return DateTimeFunction<timestamp_t, RESULT, OP>;
+}
+
+static string ConstantString(ClientContext &context, const string &function, Expression &expr, const char *what) {
+    if (!expr.IsFoldable()) {
+        throw BinderException("%s: the %s must be a constant", function, what);
+    }
+    auto value = ExpressionExecutor::EvaluateScalar(context, expr);
+    if (value.IsNull()) {
+        throw BinderException("%s: the %s cannot be NULL", function, what);
+    }
+    return value.ToString();
+}
+
+// Strings are read as timestamps. Dates have no time zone; timestamps with
+// time zone use the session's TimeZone unless one is passed, and plain
+// timestamps are taken as UTC when one is passed.
+static unique_ptr<DateTimeBindData> BindDateTimeInput(ClientContext &context, ScalarFunction &bound_function,
+                                                      vector<unique_ptr<Expression>> &arguments,
+                                                      idx_t zone_argument) {
+    auto data = make_uniq<DateTimeBindData>();
+    auto &input = bound_function.arguments[0];
+    if (input.id() == LogicalTypeId::VARCHAR) {
+        input = LogicalType::TIMESTAMP;
+    }
+    string zone;
+    if (zone_argument < arguments.size()) {
+        zone = ConstantString(context, bound_function.name, *arguments[zone_argument], "time zone");
+        Function::EraseArgument(bound_function, arguments, zone_argument);
+    } else if (input.id() == LogicalTypeId::TIMESTAMP_TZ) {
+        Value setting;
+        zone = context.TryGetCurrentSetting("TimeZone", setting) ? setting.ToString() : "UTC";
+    }
+    if (zone.empty() || bound_function.arguments[0].id() == LogicalTypeId::DATE) {
+        return data;
+    }
+    if (IsUTC(zone)) {
+        data->zone = make_shared_ptr<TimeZoneOffsets>();
+        data->zone->offsets.push_back(0);
+    } else {
+        data->icu = BindIcuTimeZone(context, zone);
+        data->zone = GetTimeZone(context, *data->icu, zone);
+    }
+    return data;
+}
+
+template <class RESULT, class OP>
+static unique_ptr<FunctionData> DateTimeBind(ClientContext &context, ScalarFunction &bound_function,
+                                             vector<unique_ptr<Expression>> &arguments) {
+    auto data = BindDateTimeInput(context, bound_function, arguments, 1);
+    bound_function.function = SelectDateTimeFunction<RESULT, OP>(bound_function.arguments[0]);
+    return std::move(data);
+}
+
+static unique_ptr<FunctionData> StartOfIntervalBind(ClientContext &context, ScalarFunction &bound_function,
+                                                    vector<unique_ptr<Expression>> &arguments) {
+    auto &name = bound_function.name;
+    if (!arguments[1]->IsFoldable()) {
+        throw BinderException("%s: the interval must be a constant", name);
+    }
+    auto value = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+    if (value.IsNull()) {
+        throw BinderException("%s: the interval cannot be NULL", name);
+    }
+    auto interval = IntervalValue::Get(value);
+    auto data = BindDateTimeInput(context, bound_function, arguments, 2);
+    Function::EraseArgument(bound_function, arguments, 1);
+
+    if (interval.months == 0 && interval.days == 0 && interval.micros > 0) {
+        data->unit = DateTimeUnit::MICROS;
+        data->step = interval.micros;
+    } else if (interval.months == 0 && interval.days > 0 && interval.micros == 0) {
+        data->unit = interval.days % 7 == 0 ? DateTimeUnit::WEEK : DateTimeUnit::DAY;
+        data->step = interval.days % 7 == 0 ? interval.days / 7 : interval.days;
+    } else if (interval.months > 0 && interval.days == 0 && interval.micros == 0) {
+        data->unit = interval.months % 12 == 0 ? DateTimeUnit::YEAR : DateTimeUnit::MONTH;
+        data->step = interval.months % 12 == 0 ? interval.months / 12 : interval.months;
+    } else {
+        throw BinderException("%s: the interval must be a positive number of a single unit, not %s", name,
+                              value.ToString());
+    }
+
+    // dates stay dates unless the buckets are shorter than a day
+    auto &input = bound_function.arguments[0];
+    if (input.id() == LogicalTypeId::DATE && data->unit != DateTimeUnit::MICROS) {
+        bound_function.return_type = LogicalType::DATE;
+        bound_function.function = SelectDateTimeFunction<date_t, ToStartOfIntervalOperator>(input);
+    } else {
+        bound_function.return_type =
+            input.id() == LogicalTypeId::TIMESTAMP_TZ ? LogicalType::TIMESTAMP_TZ : LogicalType::TIMESTAMP;
+        bound_function.function = SelectDateTimeFunction<timestamp_t, ToStartOfIntervalOperator>(input);
+    }
+    return std::move(data);
+}
+
+// One overload per input type, with and without a time zone. A null result
+// type means timestamps for plain inputs and timestamps with time zone for those.
+static ScalarFunctionSet DateTimeFunctionSet(const string &name, const LogicalType &result, bind_scalar_function_t bind,
+                                             vector<LogicalType> extra = {}) {
+    ScalarFunctionSet set(name);
+    vector<LogicalType> inputs {LogicalType::DATE, LogicalType::TIMESTAMP, LogicalType::TIMESTAMP_TZ,
+                                LogicalType::VARCHAR};
+    for (auto &input : inputs) {
+        auto return_type = result;
+        if (return_type.id() == LogicalTypeId::SQLNULL) {
+            return_type = input.id() == LogicalTypeId::TIMESTAMP_TZ ? LogicalType::TIMESTAMP_TZ : LogicalType::TIMESTAMP;
+        }
+        vector<LogicalType> arguments {input};
+        arguments.insert(arguments.end(), extra.begin(), extra.end());
+        // the function is chosen in bind
+        ScalarFunction function(arguments, return_type, nullptr, bind);
+        function.init_local_state = DateTimeInitLocal;
+        set.AddFunction(function);
+        function.arguments.push_back(LogicalType::VARCHAR);
+        set.AddFunction(function);
+    }
+    return set;
+}
+
+void RegisterDateTimeFunctions(DatabaseInstance &instance) {
+    ExtensionUtil::RegisterFunction(instance, DateTimeFunctionSet("toYYYYMM", LogicalType::UINTEGER,
+                                                                  DateTimeBind<uint32_t, ToYYYYMMOperator>));
+    ExtensionUtil::RegisterFunction(instance, DateTimeFunctionSet("toYYYYMMDD", LogicalType::UINTEGER,
+                                                                  DateTimeBind<uint32_t, ToYYYYMMDDOperator>));
+    ExtensionUtil::RegisterFunction(instance,
+                                    DateTimeFunctionSet("toYYYYMMDDhhmmss", LogicalType::UBIGINT,
+                                                        DateTimeBind<uint64_t, ToYYYYMMDDhhmmssOperator>));
+    ExtensionUtil::RegisterFunction(instance,
+                                    DateTimeFunctionSet("toRelativeDayNum", LogicalType::INTEGER,
+                                                        DateTimeBind<int32_t, ToRelativeDayNumOperator>));
+    ExtensionUtil::RegisterFunction(
+        instance, DateTimeFunctionSet("toMonday", LogicalType::DATE, DateTimeBind<date_t, ToMondayOperator>));
+    ExtensionUtil::RegisterFunction(instance, DateTimeFunctionSet("toStartOfHour", LogicalType::SQLNULL,
+                                                                  DateTimeBind<timestamp_t, ToStartOfHourOperator>));
+    ExtensionUtil::RegisterFunction(instance, DateTimeFunctionSet("toStartOfDay", LogicalType::SQLNULL,
+                                                                  DateTimeBind<timestamp_t, ToStartOfDayOperator>));
+    ExtensionUtil::RegisterFunction(instance, DateTimeFunctionSet("toStartOfInterval", LogicalType::SQLNULL,
+                                                                  StartOfIntervalBind, {LogicalType::INTERVAL}));
+}
+
+} // namespace duckdb
@@ -0,0 +1,894 @@
+#include "chsql_dictionary.hpp"
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <algorithm>
+
+namespace duckdb {
+
+// ClickHouse's max_array_size for flat dictionaries
+static constexpr int64_t FLAT_MAX_KEY = 500000;
+
+static int64_t SteadyTicks() {
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+static string LayoutName(DictionaryLayout layout) {
+    switch (layout) {
+    case DictionaryLayout::FLAT:
+        return "flat";
+    case DictionaryLayout::RANGE_HASHED:
+        return "range_hashed";
+    default:
+        return "hashed";
+    }
+}
+
+static DictionaryLayout ParseLayout(const string &name) {
+    auto lower = StringUtil::Lower(name);
+    if (lower == "flat") {
+        return DictionaryLayout::FLAT;
+    } else if (lower == "hashed") {
+        return DictionaryLayout::HASHED;
+    } else if (lower == "range_hashed") {
+        return DictionaryLayout::RANGE_HASHED;
+    }
+    throw BinderException("Unknown dictionary layout '%s', expected flat, hashed or range_hashed", name);
+}
+
+// A parquet path, a query, or a table (or table function) to select from
+static string SourceQuery(const string &source) {
+    auto trimmed = source;
+    StringUtil::Trim(trimmed);
+    auto lower = StringUtil::Lower(trimmed);
+    if (StringUtil::EndsWith(lower, ".parquet")) {
+        return "SELECT * FROM read_parquet(" + KeywordHelper::WriteQuoted(trimmed, '\'') + ")";
+    }
+    for (auto keyword : {"select ", "with ", "from ", "values ", "("}) {
+        if (StringUtil::StartsWith(lower, keyword)) {
+            return trimmed;
+        }
+    }
+    return "SELECT * FROM " + trimmed;
+}
+
+static bool IsIntegerKey(const LogicalType &type) {
+    switch (type.id()) {
+    case LogicalTypeId::TINYINT:
+    case LogicalTypeId::SMALLINT:
+    case LogicalTypeId::INTEGER:
+    case LogicalTypeId::BIGINT:
+    case LogicalTypeId::UTINYINT:
+    case LogicalTypeId::USMALLINT:
+    case LogicalTypeId::UINTEGER:
+    case LogicalTypeId::UBIGINT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Range bounds are compared as int64: microseconds for dates and timestamps
+static LogicalType RangeType(const LogicalType &type) {
+    switch (type.id()) {
+    case LogicalTypeId::DATE:
+    case LogicalTypeId::TIMESTAMP:
+    case LogicalTypeId::TIMESTAMP_SEC:
+    case LogicalTypeId::TIMESTAMP_MS:
+    case LogicalTypeId::TIMESTAMP_NS:
+        return LogicalType::TIMESTAMP;
+    default:
+        return LogicalType::BIGINT;
+    }
+}
+
+static idx_t FindColumn(const vector<string> &names, const string &name, const DictionaryDefinition &definition,
+                        const char *role) {
+    for (idx_t i = 0; i < names.size(); i++) {
+        if (StringUtil::CIEquals(names[i], name)) {
+            return i;
+        }
+    }
+    throw InvalidInputException("Dictionary '%s': %s column '%s' not found in the source", definition.name, role,
+                                name);
+}
+
+optional_idx DictionarySnapshot::FindAttribute(const string &name) const {
+    for (idx_t i = 0; i < names.size(); i++) {
+        if (StringUtil::CIEquals(names[i], name)) {
+            return i;
+        }
+    }
+    return optional_idx();
+}
+
+static unique_ptr<DictionarySnapshot> BuildSnapshot(ClientContext &context, const DictionaryDefinition &definition,
+                                                    MaterializedQueryResult &result) {
+    auto &collection = result.Collection();
+    auto snapshot = make_uniq<DictionarySnapshot>();
+
+    auto key_col = definition.key.empty() ? 0 : FindColumn(result.names, definition.key, definition, "key");
+    optional_idx min_col, max_col;
+    if (definition.layout == DictionaryLayout::RANGE_HASHED) {
+        min_col = FindColumn(result.names, definition.range_min, definition, "range_min");
+        max_col = FindColumn(result.names, definition.range_max, definition, "range_max");
+        snapshot->range_type = RangeType(result.types[min_col.GetIndex()]);
+    }
+    snapshot->string_keys = !IsIntegerKey(result.types[key_col]);
+    snapshot->key_type = snapshot->string_keys ? LogicalType::VARCHAR : LogicalType::BIGINT;
+    if (snapshot->string_keys && definition.layout == DictionaryLayout::FLAT) {
+        throw InvalidInputException("Dictionary '%s': the flat layout needs an integer key, use layout := 'hashed'",
+                                    definition.name);
+    }
+
+    snapshot->rows = collection.Count();
+    vector<idx_t> attribute_cols;
+    for (idx_t col = 0; col < result.names.size(); col++) {
+        if (col == key_col || (min_col.IsValid() && col == min_col.GetIndex()) ||
+            (max_col.IsValid() && col == max_col.GetIndex())) {
+            continue;
+        }
+        attribute_cols.push_back(col);
+        snapshot->names.push_back(result.names[col]);
+        snapshot->types.push_back(result.types[col]);
+        auto attribute = make_uniq<Vector>(result.types[col], MaxValue<idx_t>(snapshot->rows, 1));
+        if (snapshot->rows == 0) {
+            // gathers for missing keys read row 0
+            FlatVector::SetNull(*attribute, 0, true);
+        }
+        snapshot->attributes.push_back(std::move(attribute));
+    }
+
+    idx_t key_bytes = 0;
+    idx_t offset = 0;
+    for (auto &chunk : collection.Chunks()) {
+        auto count = chunk.size();
+        Vector keys(snapshot->key_type);
+        VectorOperations::Cast(context, chunk.data[key_col], keys, count);
+        UnifiedVectorFormat key_format;
+        keys.ToUnifiedFormat(count, key_format);
+
+        auto range_type = min_col.IsValid() ? snapshot->range_type : LogicalType::BIGINT;
+        Vector mins(range_type), maxs(range_type);
+        UnifiedVectorFormat min_format, max_format;
+        if (min_col.IsValid()) {
+            VectorOperations::Cast(context, chunk.data[min_col.GetIndex()], mins, count);
+            VectorOperations::Cast(context, chunk.data[max_col.GetIndex()], maxs, count);
+            mins.ToUnifiedFormat(count, min_format);
+            maxs.ToUnifiedFormat(count, max_format);
+        }
+
+        for (idx_t i = 0; i < count; i++) {
+            auto key_idx = key_format.sel->get_index(i);
+            if (!key_format.validity.RowIsValid(key_idx)) {
+                continue;
+            }
+            auto row = offset + i;
+            // hashed keeps the last row of a key, range_hashed a slot of ranges per key
+            idx_t *entry;
+            bool inserted = false;
+            if (snapshot->string_keys) {
+                auto key = UnifiedVectorFormat::GetData<string_t>(key_format)[key_idx];
+                auto existing = snapshot->string_index.find(key);
+                if (existing == snapshot->string_index.end()) {
+                    key_bytes += key.GetSize();
+                    existing = snapshot->string_index.emplace(snapshot->key_heap.AddBlob(key), row).first;
+                    inserted = true;
+                }
+                entry = &existing->second;
+            } else {
+                auto key = UnifiedVectorFormat::GetData<int64_t>(key_format)[key_idx];
+                if (definition.layout == DictionaryLayout::FLAT) {
+                    if (key < 0 || key > FLAT_MAX_KEY) {
+                        throw InvalidInputException("Dictionary '%s': key %lld does not fit the flat layout (0 to "
+                                                    "%lld), use layout := 'hashed'",
+                                                    definition.name, key, FLAT_MAX_KEY);
+                    }
+                    if (idx_t(key) >= snapshot->flat.size()) {
+                        snapshot->flat.resize(idx_t(key) + 1, DConstants::INVALID_INDEX);
+                    }
+                    entry = &snapshot->flat[idx_t(key)];
+                    inserted = *entry == DConstants::INVALID_INDEX;
+                } else {
+                    auto existing = snapshot->int_index.emplace(key, row);
+                    inserted = existing.second;
+                    entry = &existing.first->second;
+                }
+            }
+            if (definition.layout != DictionaryLayout::RANGE_HASHED) {
+                *entry = row;
+                continue;
+            }
+            if (inserted) {
+                *entry = snapshot->ranges.size();
+                snapshot->ranges.emplace_back();
+            }
+            // a NULL bound leaves that side of the range open
+            DictionaryRange range {NumericLimits<int64_t>::Minimum(), NumericLimits<int64_t>::Maximum(), row};
+            auto min_idx = min_format.sel->get_index(i);
+            auto max_idx = max_format.sel->get_index(i);
+            if (min_format.validity.RowIsValid(min_idx)) {
+                range.min = UnifiedVectorFormat::GetData<int64_t>(min_format)[min_idx];
+            }
+            if (max_format.validity.RowIsValid(max_idx)) {
+                range.max = UnifiedVectorFormat::GetData<int64_t>(max_format)[max_idx];
+            }
+            snapshot->ranges[*entry].push_back(range);
+        }
+
+        for (idx_t a = 0; a < attribute_cols.size(); a++) {
+            VectorOperations::Copy(chunk.data[attribute_cols[a]], *snapshot->attributes[a], count, 0, offset);
+        }
+        offset += count;
+    }
+
+    idx_t range_count = 0;
+    for (auto &ranges : snapshot->ranges) {
+        std::sort(ranges.begin(), ranges.end(),
+                  [](const DictionaryRange &a, const DictionaryRange &b) { return a.min < b.min; });
+        range_count += ranges.size();
+    }
+    // hash map entries are estimated at two words of overhead each
+    snapshot->bytes = collection.SizeInBytes() + snapshot->flat.size() * sizeof(idx_t) +
+                      snapshot->int_index.size() * (sizeof(int64_t) + sizeof(idx_t) + 2 * sizeof(void *)) +
+                      snapshot->string_index.size() * (sizeof(string_t) + sizeof(idx_t) + 2 * sizeof(void *)) +
+                      key_bytes + range_count * sizeof(DictionaryRange);
+    return snapshot;
+}
+
+Dictionary::Dictionary(DictionaryDefinition definition_p) : definition(std::move(definition_p)) {
+    status.status = "NOT_LOADED";
+}
+
+Dictionary::~Dictionary() {
+    lock_guard<mutex> guard(reload_lock);
+    if (!reload.joinable()) {
+        return;
+    }
+    if (reload.get_id() == std::this_thread::get_id()) {
+        // the reload dropped the last reference to the database, which owns
+        // this dictionary; it touches nothing after that
+        reload.detach();
+    } else {
+        reload.join();
+    }
+}
+
+shared_ptr<const DictionarySnapshot> Dictionary::CurrentSnapshot() {
+    lock_guard<mutex> guard(lock);
+    return snapshot;
+}
+
+shared_ptr<const DictionarySnapshot> Dictionary::GetSnapshot(ClientContext &context) {
+    auto current = CurrentSnapshot();
+    if (definition.lifetime > 0 && SteadyTicks() >= expires.load() && !loading.exchange(true)) {
+        // lookups keep using the current snapshot while the reload runs. The
+        // thread is joined by the next reload or when the dictionary is
+        // destroyed, so it never outlives the dictionary.
+        weak_ptr<DatabaseInstance> weak_db = context.db;
+        lock_guard<mutex> guard(reload_lock);
+        if (reload.joinable()) {
+            // already finished: loading is only cleared at the end of a reload
+            reload.join();
+        }
+        reload = std::thread([this, weak_db]() {
+            auto db = weak_db.lock();
+            if (!db) {
+                loading = false;
+                return;
+            }
+            try {
+                Load(*db);
+            } catch (std::exception &) {
+                // recorded in the status, the previous snapshot stays in use
+            }
+        });
+    }
+    if (!current) {
+        throw InvalidInputException("Dictionary '%s' is not loaded: %s", definition.name, GetStatus().last_exception);
+    }
+    return current;
+}
+
+void Dictionary::Load(DatabaseInstance &db) {
+    loading = true;
+    auto start = std::chrono::steady_clock::now();
+    auto finish = [&](const string &state, const string &error, bool loaded) {
+        auto now = std::chrono::steady_clock::now();
+        lock_guard<mutex> guard(lock);
+        status.status = state;
+        status.last_exception = error;
+        status.loading_duration = std::chrono::duration<double>(now - start).count();
+        if (loaded) {
+            status.last_successful_update = Timestamp::GetCurrentTimestamp();
+        }
+        expires = (now + std::chrono::seconds(definition.lifetime)).time_since_epoch().count();
+        loading = false;
+    };
+    try {
+        Connection con(db);
+        auto result = con.Query(SourceQuery(definition.source));
+        if (result->HasError()) {
+            result->ThrowError();
+        }
+        shared_ptr<const DictionarySnapshot> loaded = BuildSnapshot(*con.context, definition, *result);
+        {
+            lock_guard<mutex> guard(lock);
+            snapshot = std::move(loaded);
+        }
+        finish("LOADED", string(), true);
+    } catch (std::exception &ex) {
+        ErrorData error(ex);
+        finish(CurrentSnapshot() ? "LOADED_AND_RELOAD_FAILED" : "FAILED", error.RawMessage(), false);
+        throw;
+    }
+}
+
+Dictionary::Status Dictionary::GetStatus() {
+    lock_guard<mutex> guard(lock);
+    return status;
+}
+
+shared_ptr<DictionaryRegistry> DictionaryRegistry::Get(ClientContext &context) {
+    return ObjectCache::GetObjectCache(context).GetOrCreate<DictionaryRegistry>(ObjectType());
+}
+
+shared_ptr<Dictionary> DictionaryRegistry::Find(const string &name) {
+    lock_guard<mutex> guard(lock);
+    auto entry = dictionaries.find(name);
+    return entry == dictionaries.end() ? nullptr : entry->second;
+}
+
+// A replaced or removed dictionary is released outside of the lock, as its
+// destructor waits for a running reload
+void DictionaryRegistry::Add(shared_ptr<Dictionary> dictionary) {
+    lock_guard<mutex> guard(lock);
+    auto name = dictionary->definition.name;
+    std::swap(dictionaries[name], dictionary);
+}
+
+bool DictionaryRegistry::Remove(const string &name) {
+    shared_ptr<Dictionary> removed;
+    lock_guard<mutex> guard(lock);
+    auto entry = dictionaries.find(name);
+    if (entry == dictionaries.end()) {
+        return false;
+    }
+    removed = std::move(entry->second);
+    dictionaries.erase(entry);
+    return true;
+}
+
+vector<shared_ptr<Dictionary>> DictionaryRegistry::GetDictionaries() {
+    lock_guard<mutex> guard(lock);
+    vector<shared_ptr<Dictionary>> result;
+    for (auto &entry : dictionaries) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+// -- dictGet, dictGetOrDefault, dictHas
+
+static bool SameArgument(const optional_idx &a, const optional_idx &b) {
+    return a.IsValid() == b.IsValid() && (!a.IsValid() || a.GetIndex() == b.GetIndex());
+}
+
+struct DictionaryFunctionData : public FunctionData {
+    shared_ptr<Dictionary> dictionary;
+    // empty for dictHas
+    string attribute;
+    LogicalType type;
+    idx_t key_arg = 0;
+    optional_idx point_arg;
+    optional_idx default_arg;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<DictionaryFunctionData>();
+        result->dictionary = dictionary;
+        result->attribute = attribute;
+        result->type = type;
+        result->key_arg = key_arg;
+        result->point_arg = point_arg;
+        result->default_arg = default_arg;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        auto &other = other_p.Cast<DictionaryFunctionData>();
+        return dictionary == other.dictionary && attribute == other.attribute && type == other.type &&
+               key_arg == other.key_arg && SameArgument(point_arg, other.point_arg) &&
+               SameArgument(default_arg, other.default_arg);
+    }
+};
+
+// The snapshot of every dictionary the current query reads, taken by its first
+// lookup, so that all its threads and chunks agree when a reload lands mid-query
+class DictionaryQueryState : public ClientContextState {
+public:
+    static shared_ptr<const DictionarySnapshot> Get(ClientContext &context, Dictionary &dictionary) {
+        auto state = context.registered_state->GetOrCreate<DictionaryQueryState>("chsql_dictionary_snapshots");
+        lock_guard<mutex> guard(state->lock);
+        auto &snapshot = state->snapshots[&dictionary];
+        if (!snapshot) {
+            snapshot = dictionary.GetSnapshot(context);
+        }
+        return snapshot;
+    }
+
+    void QueryEnd(ClientContext &context) override {
+        lock_guard<mutex> guard(lock);
+        snapshots.clear();
+    }
+
+private:
+    mutex lock;
+    // the bind data keeps the dictionaries alive for the query
+    unordered_map<Dictionary *, shared_ptr<const DictionarySnapshot>> snapshots;
+};
+
+struct DictionaryLocalState : public FunctionLocalState {
+    shared_ptr<const DictionarySnapshot> snapshot;
+    // dictGet only
+    idx_t attribute = 0;
+};
+
+static string ConstantName(ClientContext &context, const string &function, Expression &expr, const char *what) {
+    if (!expr.IsFoldable()) {
+        throw BinderException("%s: the %s name must be a constant", function, what);
+    }
+    auto value = ExpressionExecutor::EvaluateScalar(context, expr);
+    if (value.IsNull()) {
+        throw BinderException("%s: the %s name cannot be NULL", function, what);
+    }
+    return value.ToString();
+}
+
+static unique_ptr<FunctionData> DictionaryFunctionBind(ClientContext &context, ScalarFunction &bound_function,
+                                                       vector<unique_ptr<Expression>> &arguments) {
+    auto &function = bound_function.name;
+    auto name = ConstantName(context, function, *arguments[0], "dictionary");
+    auto data = make_uniq<DictionaryFunctionData>();
+    data->dictionary = DictionaryRegistry::Get(context)->Find(name);
+    if (!data->dictionary) {
+        throw BinderException("%s: dictionary '%s' does not exist", function, name);
+    }
+    auto snapshot = DictionaryQueryState::Get(context, *data->dictionary);
+
+    bool has = function == "dictHas";
+    bool or_default = function == "dictGetOrDefault";
+    data->key_arg = has ? 1 : 2;
+    auto points = arguments.size() - data->key_arg - 1 - (or_default ? 1 : 0);
+    bool range = data->dictionary->definition.layout == DictionaryLayout::RANGE_HASHED;
+    if (range && points != 1) {
+        throw BinderException("%s: dictionary '%s' is range_hashed, pass a key and a point in its ranges", function,
+                              name);
+    } else if (!range && points != 0) {
+        throw BinderException("%s: dictionary '%s' has no ranges, pass only a key", function, name);
+    }
+    bound_function.arguments[data->key_arg] = snapshot->key_type;
+    if (range) {
+        data->point_arg = data->key_arg + 1;
+        bound_function.arguments[data->key_arg + 1] = snapshot->range_type;
+    }
+    if (has) {
+        data->type = LogicalType::BOOLEAN;
+        bound_function.return_type = data->type;
+        return std::move(data);
+    }
+
+    data->attribute = ConstantName(context, function, *arguments[1], "attribute");
+    auto attribute = snapshot->FindAttribute(data->attribute);
+    if (!attribute.IsValid()) {
+        throw BinderException("%s: dictionary '%s' has no attribute '%s'", function, name, data->attribute);
+    }
+    data->type = snapshot->types[attribute.GetIndex()];
+    bound_function.return_type = data->type;
+    if (or_default) {
+        data->default_arg = arguments.size() - 1;
+        bound_function.arguments[arguments.size() - 1] = data->type;
+    }
+    return std::move(data);
+}
+
+static unique_ptr<FunctionLocalState> DictionaryInitLocalState(ExpressionState &state,
+                                                               const BoundFunctionExpression &expr,
+                                                               FunctionData *bind_data) {
+    auto &data = bind_data->Cast<DictionaryFunctionData>();
+    auto result = make_uniq<DictionaryLocalState>();
+    result->snapshot = DictionaryQueryState::Get(state.GetContext(), *data.dictionary);
+    if (data.attribute.empty()) {
+        return std::move(result);
+    }
+    auto attribute = result->snapshot->FindAttribute(data.attribute);
+    if (!attribute.IsValid() || result->snapshot->types[attribute.GetIndex()] != data.type) {
+        throw InvalidInputException("Dictionary '%s' changed attribute '%s' on reload, run the query again",
+                                    data.dictionary->definition.name, data.attribute);
+    }
+    result->attribute = attribute.GetIndex();
+    return std::move(result);
+}
+
+// Sorted by min: of the ranges starting at or before the point, the latest start wins
+static idx_t FindRange(const vector<DictionaryRange> &ranges, int64_t point) {
+    auto end = std::upper_bound(ranges.begin(), ranges.end(), point,
+                                [](int64_t value, const DictionaryRange &range) { return value < range.min; });
+    for (auto it = end; it != ranges.begin();) {
+        --it;
+        if (point <= it->max) {
+            return it->row;
+        }
+    }
+    return DConstants::INVALID_INDEX;
+}
+
+// Row of every key in the chunk, INVALID_INDEX where the dictionary has none
+static void ProbeRows(const DictionaryFunctionData &data, const DictionarySnapshot &snapshot, DataChunk &args,
+                      vector<idx_t> &rows) {
+    auto count = args.size();
+    auto &keys = args.data[data.key_arg];
+    if (keys.GetType() != snapshot.key_type ||
+        (data.point_arg.IsValid() && args.data[data.point_arg.GetIndex()].GetType() != snapshot.range_type)) {
+        throw InvalidInputException("Dictionary '%s' changed its key type on reload, run the query again",
+                                    data.dictionary->definition.name);
+    }
+    UnifiedVectorFormat key_format, point_format;
+    keys.ToUnifiedFormat(count, key_format);
+    if (data.point_arg.IsValid()) {
+        args.data[data.point_arg.GetIndex()].ToUnifiedFormat(count, point_format);
+    }
+    auto layout = data.dictionary->definition.layout;
+    for (idx_t i = 0; i < count; i++) {
+        rows[i] = DConstants::INVALID_INDEX;
+        auto key_idx = key_format.sel->get_index(i);
+        if (!key_format.validity.RowIsValid(key_idx)) {
+            continue;
+        }
+        auto entry = DConstants::INVALID_INDEX;
+        if (snapshot.string_keys) {
+            auto found = snapshot.string_index.find(UnifiedVectorFormat::GetData<string_t>(key_format)[key_idx]);
+            if (found != snapshot.string_index.end()) {
+                entry = found->second;
+            }
+        } else {
+            auto key = UnifiedVectorFormat::GetData<int64_t>(key_format)[key_idx];
+            if (layout == DictionaryLayout::FLAT) {
+                if (key >= 0 && idx_t(key) < snapshot.flat.size()) {
+                    entry = snapshot.flat[idx_t(key)];
+                }
+            } else {
+                auto found = snapshot.int_index.find(key);
+                if (found != snapshot.int_index.end()) {
+                    entry = found->second;
+                }
+            }
+        }
+        if (entry == DConstants::INVALID_INDEX || !data.point_arg.IsValid()) {
+            rows[i] = entry;
+            continue;
+        }
+        auto point_idx = point_format.sel->get_index(i);
+        if (point_format.validity.RowIsValid(point_idx)) {
+            rows[i] = FindRange(snapshot.ranges[entry], UnifiedVectorFormat::GetData<int64_t>(point_format)[point_idx]);
+        }
+    }
+}
+
+static void DictGetFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<DictionaryFunctionData>();
+    auto &local = ExecuteFunctionState::GetFunctionState(state)->Cast<DictionaryLocalState>();
+    auto &snapshot = *local.snapshot;
+    data.dictionary->query_count++;
+
+    auto count = args.size();
+    vector<idx_t> rows(count);
+    ProbeRows(data, snapshot, args, rows);
+
+    auto &attribute = *snapshot.attributes[local.attribute];
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    if (data.default_arg.IsValid()) {
+        // hits gathered into the first half of a scratch vector, the defaults
+        // copied into the second, then one gather picks a half per row
+        Vector scratch(data.type, 2 * count);
+        SelectionVector hits(count);
+        SelectionVector pick(count);
+        for (idx_t i = 0; i < count; i++) {
+            auto hit = rows[i] != DConstants::INVALID_INDEX;
+            hits.set_index(i, hit ? rows[i] : 0);
+            pick.set_index(i, hit ? i : count + i);
+        }
+        if (snapshot.rows > 0) {
+            VectorOperations::Copy(attribute, scratch, hits, count, 0, 0);
+        }
+        VectorOperations::Copy(args.data[data.default_arg.GetIndex()], scratch, count, 0, count);
+        VectorOperations::Copy(scratch, result, pick, 2 * count, 0, 0);
+    } else {
+        // one gather per chunk, misses point at row 0 and are nulled afterwards
+        SelectionVector sel(count);
+        for (idx_t i = 0; i < count; i++) {
+            sel.set_index(i, rows[i] == DConstants::INVALID_INDEX ? 0 : rows[i]);
+        }
+        if (snapshot.rows > 0) {
+            VectorOperations::Copy(attribute, result, sel, count, 0, 0);
+        }
+        auto &validity = FlatVector::Validity(result);
+        for (idx_t i = 0; i < count; i++) {
+            if (rows[i] == DConstants::INVALID_INDEX) {
+                validity.SetInvalid(i);
+            }
+        }
+    }
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+static void DictHasFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<DictionaryFunctionData>();
+    auto &local = ExecuteFunctionState::GetFunctionState(state)->Cast<DictionaryLocalState>();
+    data.dictionary->query_count++;
+
+    auto count = args.size();
+    vector<idx_t> rows(count);
+    ProbeRows(data, *local.snapshot, args, rows);
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto result_data = FlatVector::GetData<bool>(result);
+    for (idx_t i = 0; i < count; i++) {
+        result_data[i] = rows[i] != DConstants::INVALID_INDEX;
+    }
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+// -- create_dictionary, drop_dictionary, reload_dictionary
+
+struct DictionaryDDLData : public TableFunctionData {
+    DictionaryDefinition definition;
+};
+
+// Every execution, e.g. of a prepared statement, runs the statement once
+struct DictionaryDDLState : public GlobalTableFunctionState {
+    bool finished = false;
+};
+
+static unique_ptr<GlobalTableFunctionState> DictionaryDDLInit(ClientContext &context, TableFunctionInitInput &input) {
+    return make_uniq<DictionaryDDLState>();
+}
+
+static string StringParameter(TableFunctionBindInput &input, const string &name) {
+    auto entry = input.named_parameters.find(name);
+    if (entry == input.named_parameters.end() || entry->second.IsNull()) {
+        return string();
+    }
+    return StringValue::Get(entry->second);
+}
+
+static unique_ptr<FunctionData> CreateDictionaryBind(ClientContext &context, TableFunctionBindInput &input,
+                                                     vector<LogicalType> &return_types, vector<string> &names) {
+    auto result = make_uniq<DictionaryDDLData>();
+    auto &definition = result->definition;
+    definition.name = StringValue::Get(input.inputs[0]);
+    definition.source = StringValue::Get(input.inputs[1]);
+    definition.key = StringParameter(input, "primary_key");
+    auto layout = StringParameter(input, "layout");
+    if (!layout.empty()) {
+        definition.layout = ParseLayout(layout);
+    }
+    definition.range_min = StringParameter(input, "range_min");
+    definition.range_max = StringParameter(input, "range_max");
+    if (definition.layout == DictionaryLayout::RANGE_HASHED &&
+        (definition.range_min.empty() || definition.range_max.empty())) {
+        throw BinderException("create_dictionary: the range_hashed layout needs range_min and range_max");
+    }
+    auto lifetime = input.named_parameters.find("lifetime");
+    if (lifetime != input.named_parameters.end() && !lifetime->second.IsNull()) {
+        definition.lifetime = lifetime->second.GetValue<idx_t>();
+    }
+
+    names = {"name", "layout", "element_count", "bytes_allocated"};
+    return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::UBIGINT, LogicalType::UBIGINT};
+    return std::move(result);
+}
+
+static void OutputDictionary(Dictionary &dictionary, DataChunk &output) {
+    auto snapshot = dictionary.CurrentSnapshot();
+    output.SetValue(0, 0, Value(dictionary.definition.name));
+    output.SetValue(1, 0, Value(LayoutName(dictionary.definition.layout)));
+    output.SetValue(2, 0, Value::UBIGINT(snapshot ? snapshot->rows : 0));
+    output.SetValue(3, 0, Value::UBIGINT(snapshot ? snapshot->bytes : 0));
+    output.SetCardinality(1);
+}
+
+static void CreateDictionaryFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<DictionaryDDLData>();
+    auto &state = data_p.global_state->Cast<DictionaryDDLState>();
+    if (state.finished) {
+        return;
+    }
+    state.finished = true;
+    // replaces a dictionary of the same name only once the new one loaded
+    auto dictionary = make_shared_ptr<Dictionary>(data.definition);
+    dictionary->Load(*context.db);
+    DictionaryRegistry::Get(context)->Add(dictionary);
+    OutputDictionary(*dictionary, output);
+}
+
+static unique_ptr<FunctionData> DictionaryNameBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+    auto result = make_uniq<DictionaryDDLData>();
+    result->definition.name = StringValue::Get(input.inputs[0]);
+    names = {"name", "layout", "element_count", "bytes_allocated"};
+    return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::UBIGINT, LogicalType::UBIGINT};
+    return std::move(result);
+}
+
+static void ReloadDictionaryFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<DictionaryDDLData>();
+    auto &state = data_p.global_state->Cast<DictionaryDDLState>();
+    if (state.finished) {
+        return;
+    }
+    state.finished = true;
+    auto dictionary = DictionaryRegistry::Get(context)->Find(data.definition.name);
+    if (!dictionary) {
+        throw InvalidInputException("Dictionary '%s' does not exist", data.definition.name);
+    }
+    dictionary->Load(*context.db);
+    OutputDictionary(*dictionary, output);
+}
+
+static void DropDictionaryFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<DictionaryDDLData>();
+    auto &state = data_p.global_state->Cast<DictionaryDDLState>();
+    if (state.finished) {
+        return;
+    }
+    state.finished = true;
+    auto registry = DictionaryRegistry::Get(context);
+    auto dictionary = registry->Find(data.definition.name);
+    if (!dictionary || !registry->Remove(data.definition.name)) {
+        throw InvalidInputException("Dictionary '%s' does not exist", data.definition.name);
+    }
+    // queries bound before the drop keep their own reference
+    OutputDictionary(*dictionary, output);
+}
+
+// -- system.dictionaries
+struct SystemDictionariesState : public GlobalTableFunctionState {
+    vector<shared_ptr<Dictionary>> dictionaries;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> SystemDictionariesBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+    names.emplace_back("name");
+    names.emplace_back("status");
+    names.emplace_back("type");
+    names.emplace_back("key");
+    names.emplace_back("attribute.names");
+    names.emplace_back("attribute.types");
+    names.emplace_back("element_count");
+    names.emplace_back("bytes_allocated");
+    names.emplace_back("query_count");
+    names.emplace_back("source");
+    names.emplace_back("lifetime");
+    names.emplace_back("last_successful_update_time");
+    names.emplace_back("loading_duration");
+    names.emplace_back("last_exception");
+
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::LIST(LogicalType::VARCHAR));
+    return_types.emplace_back(LogicalType::LIST(LogicalType::VARCHAR));
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::TIMESTAMP);
+    return_types.emplace_back(LogicalType::DOUBLE);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return make_uniq<TableFunctionData>();
+}
+
+// the dictionaries at the time of each execution, not of the bind
+static unique_ptr<GlobalTableFunctionState> SystemDictionariesInit(ClientContext &context,
+                                                                   TableFunctionInitInput &input) {
+    auto result = make_uniq<SystemDictionariesState>();
+    result->dictionaries = DictionaryRegistry::Get(context)->GetDictionaries();
+    return std::move(result);
+}
+
+static void SystemDictionariesFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.global_state->Cast<SystemDictionariesState>();
+    idx_t count = 0;
+    while (data.offset < data.dictionaries.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &dictionary = *data.dictionaries[data.offset];
+        auto &definition = dictionary.definition;
+        auto snapshot = dictionary.CurrentSnapshot();
+        auto status = dictionary.GetStatus();
+        vector<Value> attribute_names, attribute_types;
+        if (snapshot) {
+            for (idx_t i = 0; i < snapshot->names.size(); i++) {
+                attribute_names.emplace_back(snapshot->names[i]);
+                attribute_types.emplace_back(snapshot->types[i].ToString());
+            }
+        }
+        output.SetValue(0, count, Value(definition.name));
+        output.SetValue(1, count, Value(dictionary.loading ? "LOADING" : status.status));
+        output.SetValue(2, count, Value(LayoutName(definition.layout)));
+        output.SetValue(3, count, Value(definition.key));
+        output.SetValue(4, count, Value::LIST(LogicalType::VARCHAR, std::move(attribute_names)));
+        output.SetValue(5, count, Value::LIST(LogicalType::VARCHAR, std::move(attribute_types)));
+        output.SetValue(6, count, Value::UBIGINT(snapshot ? snapshot->rows : 0));
+        output.SetValue(7, count, Value::UBIGINT(snapshot ? snapshot->bytes : 0));
+        output.SetValue(8, count, Value::UBIGINT(dictionary.query_count));
+        output.SetValue(9, count, Value(definition.source));
+        output.SetValue(10, count, Value::UBIGINT(definition.lifetime));
+        output.SetValue(11, count, snapshot ? Value::TIMESTAMP(status.last_successful_update) : Value());
+        output.SetValue(12, count, Value::DOUBLE(status.loading_duration));
+        output.SetValue(13, count, status.last_exception.empty() ? Value() : Value(status.last_exception));
+        count++;
+        data.offset++;
+    }
+    output.SetCardinality(count);
+}
+
+void RegisterDictionaryFunctions(DatabaseInstance &instance) {
+    // the dictionary and attribute names are VARCHAR constants, the binder fixes the key and point types
+    auto name = LogicalType::VARCHAR;
+    auto any = LogicalType::ANY;
+    ScalarFunctionSet dict_get("dictGet");
+    dict_get.AddFunction(ScalarFunction({name, name, any}, any, DictGetFunction, DictionaryFunctionBind));
+    dict_get.AddFunction(ScalarFunction({name, name, any, any}, any, DictGetFunction, DictionaryFunctionBind));
+    ScalarFunctionSet dict_get_or_default("dictGetOrDefault");
+    dict_get_or_default.AddFunction(
+        ScalarFunction({name, name, any, any}, any, DictGetFunction, DictionaryFunctionBind));
+    dict_get_or_default.AddFunction(
+        ScalarFunction({name, name, any, any, any}, any, DictGetFunction, DictionaryFunctionBind));
+    ScalarFunctionSet dict_has("dictHas");
+    dict_has.AddFunction(ScalarFunction({name, any}, LogicalType::BOOLEAN, DictHasFunction, DictionaryFunctionBind));
+    dict_has.AddFunction(
+        ScalarFunction({name, any, any}, LogicalType::BOOLEAN, DictHasFunction, DictionaryFunctionBind));
+    for (auto set : {&dict_get, &dict_get_or_default, &dict_has}) {
+        for (auto &function : set->functions) {
+            // a reload may change the answer between queries, but not within one
+            function.stability = FunctionStability::CONSISTENT_WITHIN_QUERY;
+            function.null_handling = FunctionNullHandling::SPECIAL_HANDLING;
+            function.init_local_state = DictionaryInitLocalState;
+        }
+        ExtensionUtil::RegisterFunction(instance, *set);
+    }
+
+    TableFunction create_func("create_dictionary", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                              CreateDictionaryFunction, CreateDictionaryBind, DictionaryDDLInit);
+    create_func.named_parameters["primary_key"] = LogicalType::VARCHAR;
+    create_func.named_parameters["layout"] = LogicalType::VARCHAR;
+    create_func.named_parameters["lifetime"] = LogicalType::UBIGINT;
+    create_func.named_parameters["range_min"] = LogicalType::VARCHAR;
+    create_func.named_parameters["range_max"] = LogicalType::VARCHAR;
+    ExtensionUtil::RegisterFunction(instance, create_func);
+    ExtensionUtil::RegisterFunction(instance,
+                                    TableFunction("reload_dictionary", {LogicalType::VARCHAR},
+                                                  ReloadDictionaryFunction, DictionaryNameBind, DictionaryDDLInit));
+    ExtensionUtil::RegisterFunction(instance,
+                                    TableFunction("drop_dictionary", {LogicalType::VARCHAR}, DropDictionaryFunction,
+                                                  DictionaryNameBind, DictionaryDDLInit));
+
+    auto dictionaries_func = TableFunction("system_dictionaries", {}, SystemDictionariesFunction,
+                                           SystemDictionariesBind, SystemDictionariesInit);
+    ExtensionUtil::RegisterFunction(instance, dictionaries_func);
+}
+
+} // namespace duckdb
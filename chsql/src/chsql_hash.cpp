@@ -0,0 +1,844 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+// Bit-exact ports of the hash functions ClickHouse uses. Inputs are read in
+// little-endian order, as ClickHouse does on the platforms it supports.
+
+static inline uint64_t Load64(const char *p) {
+    uint64_t result;
+    memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline uint64_t Load32(const char *p) {
+    uint32_t result;
+    memcpy(&result, p, sizeof(result));
+    return result;
+}
+
+static inline uint64_t RotateRight(uint64_t value, int shift) {
+    return shift == 0 ? value : (value >> shift) | (value << (64 - shift));
+}
+
+static inline uint64_t RotateLeft(uint64_t value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static inline uint64_t ShiftMix(uint64_t value) {
+    return value ^ (value >> 47);
+}
+
+static inline uint64_t Hash128To64(uint64_t low, uint64_t high, uint64_t mul = 0x9ddfea08eb382d69ULL) {
+    uint64_t a = (low ^ high) * mul;
+    a ^= a >> 47;
+    uint64_t b = (high ^ a) * mul;
+    b ^= b >> 47;
+    return b * mul;
+}
+
+// ClickHouse's IntHash64Impl: the murmur finalizer over the salted value, as
+// used by intHash64(), for the fixed-width arguments and array lengths of
+// cityHash64 and farmHash64, and by the murmurHash3_64 combiner
+static inline uint64_t IntHash64(uint64_t x) {
+    x ^= 0x4CF2D2BAAE6DA887ULL;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+struct WeakHash {
+    uint64_t first;
+    uint64_t second;
+};
+
+static inline WeakHash WeakHashLen32WithSeeds(const char *s, uint64_t a, uint64_t b) {
+    uint64_t w = Load64(s);
+    uint64_t x = Load64(s + 8);
+    uint64_t y = Load64(s + 16);
+    uint64_t z = Load64(s + 24);
+    a += w;
+    b = RotateRight(b + a + z, 21);
+    uint64_t c = a;
+    a += x;
+    a += y;
+    b += RotateRight(a, 44);
+    return {a + z, b + c};
+}
+
+static constexpr uint64_t K0 = 0xc3a5c85c97cb3127ULL;
+static constexpr uint64_t K1 = 0xb492b66fbe98f273ULL;
+static constexpr uint64_t K2 = 0x9ae16a3b2f90404fULL;
+static constexpr uint64_t K3 = 0xc949d7c7509e6557ULL;
+
+// -- CityHash v1.0.2, the version ClickHouse ships
+
+static uint64_t CityHashLen0To16(const char *s, idx_t len) {
+    if (len > 8) {
+        uint64_t a = Load64(s);
+        uint64_t b = Load64(s + len - 8);
+        return Hash128To64(a, RotateRight(b + len, int(len))) ^ b;
+    }
+    if (len >= 4) {
+        uint64_t a = Load32(s);
+        return Hash128To64(len + (a << 3), Load32(s + len - 4));
+    }
+    if (len > 0) {
+        uint8_t a = uint8_t(s[0]);
+        uint8_t b = uint8_t(s[len >> 1]);
+        uint8_t c = uint8_t(s[len - 1]);
+        uint32_t y = uint32_t(a) + (uint32_t(b) << 8);
+        uint32_t z = uint32_t(len) + (uint32_t(c) << 2);
+        return ShiftMix(y * K2 ^ z * K3) * K2;
+    }
+    return K2;
+}
+
+static uint64_t CityHashLen17To32(const char *s, idx_t len) {
+    uint64_t a = Load64(s) * K1;
+    uint64_t b = Load64(s + 8);
+    uint64_t c = Load64(s + len - 8) * K2;
+    uint64_t d = Load64(s + len - 16) * K0;
+    return Hash128To64(RotateRight(a - b, 43) + RotateRight(c, 30) + d, a + RotateRight(b ^ K3, 20) - c + len);
+}
+
+static uint64_t CityHashLen33To64(const char *s, idx_t len) {
+    uint64_t z = Load64(s + 24);
+    uint64_t a = Load64(s) + (len + Load64(s + len - 16)) * K0;
+    uint64_t b = RotateRight(a + z, 52);
+    uint64_t c = RotateRight(a, 37);
+    a += Load64(s + 8);
+    c += RotateRight(a, 7);
+    a += Load64(s + 16);
+    uint64_t vf = a + z;
+    uint64_t vs = b + RotateRight(a, 31) + c;
+    a = Load64(s + 16) + Load64(s + len - 32);
+    z = Load64(s + len - 8);
+    b = RotateRight(a + z, 52);
+    c = RotateRight(a, 37);
+    a += Load64(s + len - 24);
+    c += RotateRight(a, 7);
+    a += Load64(s + len - 16);
+    uint64_t wf = a + z;
+    uint64_t ws = b + RotateRight(a, 31) + c;
+    uint64_t r = ShiftMix((vf + ws) * K2 + (wf + vs) * K0);
+    return ShiftMix(r * K0 + vs) * K2;
+}
+
+static uint64_t CityHash64(const char *s, idx_t len) {
+    if (len <= 16) {
+        return CityHashLen0To16(s, len);
+    }
+    if (len <= 32) {
+        return CityHashLen17To32(s, len);
+    }
+    if (len <= 64) {
+        return CityHashLen33To64(s, len);
+    }
+    uint64_t x = Load64(s);
+    uint64_t y = Load64(s + len - 16) ^ K1;
+    uint64_t z = Load64(s + len - 56) ^ K0;
+    auto v = WeakHashLen32WithSeeds(s + len - 64, len, y);
+    auto w = WeakHashLen32WithSeeds(s + len - 32, len * K1, K0);
+    z += ShiftMix(v.second) * K1;
+    x = RotateRight(z + x, 39) * K1;
+    y = RotateRight(y, 33) * K1;
+    len = (len - 1) & ~idx_t(63);
+    do {
+        x = RotateRight(x + y + v.first + Load64(s + 16), 37) * K1;
+        y = RotateRight(y + v.second + Load64(s + 48), 42) * K1;
+        x ^= w.second;
+        y ^= v.first;
+        z = RotateRight(z ^ w.first, 33);
+        v = WeakHashLen32WithSeeds(s, v.second * K1, x + w.first);
+        w = WeakHashLen32WithSeeds(s + 32, z + w.second, y);
+        std::swap(z, x);
+        s += 64;
+        len -= 64;
+    } while (len != 0);
+    return Hash128To64(Hash128To64(v.first, w.first) + ShiftMix(y) * K1 + z, Hash128To64(v.second, w.second) + x);
+}
+
+// -- FarmHash Hash64 along its portable farmhashxo path, which defers to
+// farmhashna and farmhashuo for longer inputs. ClickHouse builds for x86-64
+// with SSE4.1 take farmhashte instead, which differs from 512 bytes on.
+
+static uint64_t FarmHashNaLen0To16(const char *s, idx_t len) {
+    if (len >= 8) {
+        uint64_t mul = K2 + len * 2;
+        uint64_t a = Load64(s) + K2;
+        uint64_t b = Load64(s + len - 8);
+        uint64_t c = RotateRight(b, 37) * mul + a;
+        uint64_t d = (RotateRight(a, 25) + b) * mul;
+        return Hash128To64(c, d, mul);
+    }
+    if (len >= 4) {
+        uint64_t mul = K2 + len * 2;
+        uint64_t a = Load32(s);
+        return Hash128To64(len + (a << 3), Load32(s + len - 4), mul);
+    }
+    if (len > 0) {
+        uint8_t a = uint8_t(s[0]);
+        uint8_t b = uint8_t(s[len >> 1]);
+        uint8_t c = uint8_t(s[len - 1]);
+        uint32_t y = uint32_t(a) + (uint32_t(b) << 8);
+        uint32_t z = uint32_t(len) + (uint32_t(c) << 2);
+        return ShiftMix(y * K2 ^ z * K0) * K2;
+    }
+    return K2;
+}
+
+static uint64_t FarmHashNaLen17To32(const char *s, idx_t len) {
+    uint64_t mul = K2 + len * 2;
+    uint64_t a = Load64(s) * K1;
+    uint64_t b = Load64(s + 8);
+    uint64_t c = Load64(s + len - 8) * mul;
+    uint64_t d = Load64(s + len - 16) * K2;
+    return Hash128To64(RotateRight(a + b, 43) + RotateRight(c, 30) + d, a + RotateRight(b + K2, 18) + c, mul);
+}
+
+// farmhashna for more than 64 bytes
+static uint64_t FarmHashNaLong(const char *s, idx_t len) {
+    const uint64_t seed = 81;
+    uint64_t x = seed;
+    uint64_t y = seed * K1 + 113;
+    uint64_t z = ShiftMix(y * K2 + 113) * K2;
+    WeakHash v {0, 0};
+    WeakHash w {0, 0};
+    x = x * K2 + Load64(s);
+    auto end = s + ((len - 1) / 64) * 64;
+    auto last64 = end + ((len - 1) & 63) - 63;
+    do {
+        x = RotateRight(x + y + v.first + Load64(s + 8), 37) * K1;
+        y = RotateRight(y + v.second + Load64(s + 48), 42) * K1;
+        x ^= w.second;
+        y += v.first + Load64(s + 40);
+        z = RotateRight(z + w.first, 33) * K1;
+        v = WeakHashLen32WithSeeds(s, v.second * K1, x + w.first);
+        w = WeakHashLen32WithSeeds(s + 32, z + w.second, y + Load64(s + 16));
+        std::swap(z, x);
+        s += 64;
+    } while (s != end);
+    uint64_t mul = K1 + ((z & 0xff) << 1);
+    s = last64;
+    w.first += ((len - 1) & 63);
+    v.first += w.first;
+    w.first += v.first;
+    x = RotateRight(x + y + v.first + Load64(s + 8), 37) * mul;
+    y = RotateRight(y + v.second + Load64(s + 48), 42) * mul;
+    x ^= w.second * 9;
+    y += v.first * 9 + Load64(s + 40);
+    z = RotateRight(z + w.first, 33) * mul;
+    v = WeakHashLen32WithSeeds(s, v.second * mul, x + w.first);
+    w = WeakHashLen32WithSeeds(s + 32, z + w.second, y + Load64(s + 16));
+    std::swap(z, x);
+    return Hash128To64(Hash128To64(v.first, w.first, mul) + ShiftMix(y) * K0 + z,
+                       Hash128To64(v.second, w.second, mul) + x, mul);
+}
+
+static uint64_t FarmHashUoH(uint64_t x, uint64_t y, uint64_t mul, int r) {
+    uint64_t a = (x ^ y) * mul;
+    a ^= a >> 47;
+    uint64_t b = (y ^ a) * mul;
+    return RotateRight(b, r) * mul;
+}
+
+// farmhashuo for more than 64 bytes
+static uint64_t FarmHashUoLong(const char *s, idx_t len) {
+    const uint64_t seed0 = 81;
+    const uint64_t seed1 = 0;
+    uint64_t x = seed0;
+    uint64_t y = seed1 * K2 + 113;
+    uint64_t z = ShiftMix(y * K2) * K2;
+    WeakHash v {seed0, seed1};
+    WeakHash w {0, 0};
+    uint64_t u = x - z;
+    x *= K2;
+    uint64_t mul = K2 + (u & 0x82);
+    auto end = s + ((len - 1) / 64) * 64;
+    auto last64 = end + ((len - 1) & 63) - 63;
+    do {
+        uint64_t a0 = Load64(s);
+        uint64_t a1 = Load64(s + 8);
+        uint64_t a2 = Load64(s + 16);
+        uint64_t a3 = Load64(s + 24);
+        uint64_t a4 = Load64(s + 32);
+        uint64_t a5 = Load64(s + 40);
+        uint64_t a6 = Load64(s + 48);
+        uint64_t a7 = Load64(s + 56);
+        x += a0 + a1;
+        y += a2;
+        z += a3;
+        v.first += a4;
+        v.second += a5 + a1;
+        w.first += a6;
+        w.second += a7;
+
+        x = RotateRight(x, 26);
+        x *= 9;
+        y = RotateRight(y, 29);
+        z *= mul;
+        v.first = RotateRight(v.first, 33);
+        v.second = RotateRight(v.second, 30);
+        w.first ^= x;
+        w.first *= 9;
+        z = RotateRight(z, 32);
+        z += w.second;
+        w.second += z;
+        z *= 9;
+        std::swap(u, y);
+
+        z += a0 + a6;
+        v.first += a2;
+        v.second += a3;
+        w.first += a4;
+        w.second += a5 + a6;
+        x += a1;
+        y += a7;
+
+        y += v.first;
+        v.first += x - y;
+        v.second += w.first;
+        w.first += v.second;
+        w.second += x - y;
+        x += w.second;
+        w.second = RotateRight(w.second, 34);
+        std::swap(u, z);
+        s += 64;
+    } while (s != end);
+    s = last64;
+    u *= 9;
+    v.second = RotateRight(v.second, 28);
+    v.first = RotateRight(v.first, 20);
+    w.first += ((len - 1) & 63);
+    u += y;
+    y += u;
+    x = RotateRight(y - x + v.first + Load64(s + 8), 37) * mul;
+    y = RotateRight(y ^ v.second ^ Load64(s + 48), 42) * mul;
+    x ^= w.second * 9;
+    y += v.first + Load64(s + 40);
+    z = RotateRight(z + w.first, 33) * mul;
+    v = WeakHashLen32WithSeeds(s, v.second * mul, x + w.first);
+    w = WeakHashLen32WithSeeds(s + 32, z + w.second, y + Load64(s + 16));
+    return FarmHashUoH(Hash128To64(v.first + x, w.first ^ y, mul) + z - u,
+                       FarmHashUoH(v.second + y, w.second + z, K2, 30) ^ x, K2, 31);
+}
+
+static uint64_t FarmHashXoH32(const char *s, idx_t len, uint64_t mul, uint64_t seed0 = 0, uint64_t seed1 = 0) {
+    uint64_t a = Load64(s) * K1;
+    uint64_t b = Load64(s + 8);
+    uint64_t c = Load64(s + len - 8) * mul;
+    uint64_t d = Load64(s + len - 16) * K2;
+    uint64_t u = RotateRight(a + b, 43) + RotateRight(c, 30) + d + seed0;
+    uint64_t v = a + RotateRight(b + K2, 18) + c + seed1;
+    a = ShiftMix((u ^ v) * mul);
+    b = ShiftMix((v ^ a) * mul);
+    return b;
+}
+
+static uint64_t FarmHash64(const char *s, idx_t len) {
+    if (len <= 16) {
+        return FarmHashNaLen0To16(s, len);
+    }
+    if (len <= 32) {
+        return FarmHashNaLen17To32(s, len);
+    }
+    if (len <= 64) {
+        uint64_t mul0 = K2 - 30;
+        uint64_t mul1 = K2 - 30 + 2 * len;
+        uint64_t h0 = FarmHashXoH32(s, 32, mul0);
+        uint64_t h1 = FarmHashXoH32(s + len - 32, 32, mul1);
+        return ((h1 * mul1) + h0) * mul1;
+    }
+    if (len <= 96) {
+        uint64_t mul0 = K2 - 114;
+        uint64_t mul1 = K2 - 114 + 2 * len;
+        uint64_t h0 = FarmHashXoH32(s, 32, mul0);
+        uint64_t h1 = FarmHashXoH32(s + 32, 32, mul1);
+        uint64_t h2 = FarmHashXoH32(s + len - 32, 32, mul1, h0, h1);
+        return (h2 * 9 + (h0 >> 17) + (h1 >> 21)) * mul1;
+    }
+    if (len <= 256) {
+        return FarmHashNaLong(s, len);
+    }
+    return FarmHashUoLong(s, len);
+}
+
+// -- SipHash-2-4 with a zero key
+
+#define SIP_ROUND                                                                                                      \
+    do {                                                                                                               \
+        v0 += v1;                                                                                                      \
+        v1 = RotateLeft(v1, 13);                                                                                       \
+        v1 ^= v0;                                                                                                      \
+        v0 = RotateLeft(v0, 32);                                                                                       \
+        v2 += v3;                                                                                                      \
+        v3 = RotateLeft(v3, 16);                                                                                       \
+        v3 ^= v2;                                                                                                      \
+        v0 += v3;                                                                                                      \
+        v3 = RotateLeft(v3, 21);                                                                                       \
+        v3 ^= v0;                                                                                                      \
+        v2 += v1;                                                                                                      \
+        v1 = RotateLeft(v1, 17);                                                                                       \
+        v1 ^= v2;                                                                                                      \
+        v2 = RotateLeft(v2, 32);                                                                                       \
+    } while (0)
+
+static uint64_t SipHash64(const char *s, idx_t len) {
+    uint64_t v0 = 0x736f6d6570736575ULL;
+    uint64_t v1 = 0x646f72616e646f6dULL;
+    uint64_t v2 = 0x6c7967656e657261ULL;
+    uint64_t v3 = 0x7465646279746573ULL;
+    auto end = s + (len & ~idx_t(7));
+    for (; s != end; s += 8) {
+        uint64_t m = Load64(s);
+        v3 ^= m;
+        SIP_ROUND;
+        SIP_ROUND;
+        v0 ^= m;
+    }
+    uint64_t last = uint64_t(len) << 56;
+    for (idx_t i = 0; i < (len & 7); i++) {
+        last |= uint64_t(uint8_t(s[i])) << (8 * i);
+    }
+    v3 ^= last;
+    SIP_ROUND;
+    SIP_ROUND;
+    v0 ^= last;
+    v2 ^= 0xff;
+    SIP_ROUND;
+    SIP_ROUND;
+    SIP_ROUND;
+    SIP_ROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+#undef SIP_ROUND
+
+// -- xxHash64 with a zero seed
+
+static constexpr uint64_t XXH_PRIME1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t XXH_PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t XXH_PRIME3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t XXH_PRIME4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t XXH_PRIME5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t XXHashRound(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME2;
+    acc = RotateLeft(acc, 31);
+    return acc * XXH_PRIME1;
+}
+
+static inline uint64_t XXHashMergeRound(uint64_t acc, uint64_t value) {
+    acc ^= XXHashRound(0, value);
+    return acc * XXH_PRIME1 + XXH_PRIME4;
+}
+
+static uint64_t XXHash64(const char *s, idx_t len) {
+    auto end = s + len;
+    uint64_t h;
+    if (len >= 32) {
+        uint64_t v1 = XXH_PRIME1 + XXH_PRIME2;
+        uint64_t v2 = XXH_PRIME2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - XXH_PRIME1;
+        auto limit = end - 32;
+        do {
+            v1 = XXHashRound(v1, Load64(s));
+            v2 = XXHashRound(v2, Load64(s + 8));
+            v3 = XXHashRound(v3, Load64(s + 16));
+            v4 = XXHashRound(v4, Load64(s + 24));
+            s += 32;
+        } while (s <= limit);
+        h = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        h = XXHashMergeRound(h, v1);
+        h = XXHashMergeRound(h, v2);
+        h = XXHashMergeRound(h, v3);
+        h = XXHashMergeRound(h, v4);
+    } else {
+        h = XXH_PRIME5;
+    }
+    h += len;
+    for (; s + 8 <= end; s += 8) {
+        h ^= XXHashRound(0, Load64(s));
+        h = RotateLeft(h, 27) * XXH_PRIME1 + XXH_PRIME4;
+    }
+    if (s + 4 <= end) {
+        h ^= Load32(s) * XXH_PRIME1;
+        h = RotateLeft(h, 23) * XXH_PRIME2 + XXH_PRIME3;
+        s += 4;
+    }
+    for (; s < end; s++) {
+        h ^= uint8_t(*s) * XXH_PRIME5;
+        h = RotateLeft(h, 11) * XXH_PRIME1;
+    }
+    h ^= h >> 33;
+    h *= XXH_PRIME2;
+    h ^= h >> 29;
+    h *= XXH_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+// -- MurmurHash3 x64_128 with a zero seed, folded to 64 bits
+
+static inline uint64_t MurmurMix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static uint64_t MurmurHash3_64(const char *s, idx_t len) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = 0;
+    uint64_t h2 = 0;
+    auto blocks = len / 16;
+    for (idx_t i = 0; i < blocks; i++) {
+        uint64_t k1 = Load64(s + i * 16);
+        uint64_t k2 = Load64(s + i * 16 + 8);
+        k1 *= c1;
+        k1 = RotateLeft(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = RotateLeft(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2;
+        k2 = RotateLeft(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = RotateLeft(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+    auto tail = reinterpret_cast<const uint8_t *>(s + blocks * 16);
+    auto rest = len & 15;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    for (idx_t i = rest; i > 8; i--) {
+        k2 ^= uint64_t(tail[i - 1]) << ((i - 9) * 8);
+    }
+    if (rest > 8) {
+        k2 *= c2;
+        k2 = RotateLeft(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+    for (idx_t i = MinValue<idx_t>(rest, 8); i > 0; i--) {
+        k1 ^= uint64_t(tail[i - 1]) << ((i - 1) * 8);
+    }
+    if (rest > 0) {
+        k1 *= c1;
+        k1 = RotateLeft(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+    h1 ^= len;
+    h2 ^= len;
+    h1 += h2;
+    h2 += h1;
+    h1 = MurmurMix(h1);
+    h2 = MurmurMix(h2);
+    h1 += h2;
+    h2 += h1;
+    return h1 ^ h2;
+}
+
+// -- Function implementations
+
+// Each implementation hashes bytes, combines the hash of the arguments so far
+// with the hash of the next one, and says whether fixed-width arguments go
+// through intHash64 rather than being hashed as bytes.
+struct CityHash64Impl {
+    static constexpr bool INT_HASH = true;
+    static uint64_t Apply(const char *data, idx_t size) {
+        return CityHash64(data, size);
+    }
+    static uint64_t Combine(uint64_t h1, uint64_t h2) {
+        return Hash128To64(h1, h2);
+    }
+};
+
+struct FarmHash64Impl {
+    static constexpr bool INT_HASH = true;
+    static uint64_t Apply(const char *data, idx_t size) {
+        return FarmHash64(data, size);
+    }
+    static uint64_t Combine(uint64_t h1, uint64_t h2) {
+        return Hash128To64(h1, h2);
+    }
+};
+
+struct SipHash64Impl {
+    static constexpr bool INT_HASH = false;
+    static uint64_t Apply(const char *data, idx_t size) {
+        return SipHash64(data, size);
+    }
+    static uint64_t Combine(uint64_t h1, uint64_t h2) {
+        uint64_t hashes[2] = {h1, h2};
+        return SipHash64(reinterpret_cast<const char *>(hashes), sizeof(hashes));
+    }
+};
+
+struct XXHash64Impl {
+    static constexpr bool INT_HASH = false;
+    static uint64_t Apply(const char *data, idx_t size) {
+        return XXHash64(data, size);
+    }
+    static uint64_t Combine(uint64_t h1, uint64_t h2) {
+        return Hash128To64(h1, h2);
+    }
+};
+
+struct MurmurHash3_64Impl {
+    static constexpr bool INT_HASH = false;
+    static uint64_t Apply(const char *data, idx_t size) {
+        return MurmurHash3_64(data, size);
+    }
+    static uint64_t Combine(uint64_t h1, uint64_t h2) {
+        return IntHash64(h1) ^ h2;
+    }
+};
+
+// Values narrower than 64 bits are zero-extended, as ClickHouse's bit_cast does
+template <class HASH, class T>
+static inline uint64_t HashFixed(const T &value) {
+    if (HASH::INT_HASH && sizeof(T) <= sizeof(uint64_t)) {
+        uint64_t bits = 0;
+        memcpy(&bits, &value, sizeof(T));
+        return IntHash64(bits);
+    }
+    return HASH::Apply(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <class HASH>
+static inline uint64_t HashString(const string_t &value) {
+    return HASH::Apply(value.GetData(), value.GetSize());
+}
+
+// Writes the hash of row i into hashes[i], or combines it into the hash of the
+// previous arguments. Flat inputs without NULLs take a branch-free loop. NULL
+// rows hash as the default value, which only matters inside lists and tuples;
+// a NULL argument makes the whole row NULL.
+template <class HASH, class T, uint64_t (*HASH_VALUE)(const T &)>
+static void HashColumn(Vector &input, idx_t count, uint64_t *hashes, bool first) {
+    if (input.GetVectorType() == VectorType::CONSTANT_VECTOR) {
+        auto hash = ConstantVector::IsNull(input) ? HASH_VALUE(T()) : HASH_VALUE(*ConstantVector::GetData<T>(input));
+        for (idx_t i = 0; i < count; i++) {
+            hashes[i] = first ? hash : HASH::Combine(hashes[i], hash);
+        }
+        return;
+    }
+    UnifiedVectorFormat format;
+    input.ToUnifiedFormat(count, format);
+    auto data = UnifiedVectorFormat::GetData<T>(format);
+    if (!format.sel->IsSet() && format.validity.AllValid()) {
+        if (first) {
+            for (idx_t i = 0; i < count; i++) {
+                hashes[i] = HASH_VALUE(data[i]);
+            }
+        } else {
+            for (idx_t i = 0; i < count; i++) {
+                hashes[i] = HASH::Combine(hashes[i], HASH_VALUE(data[i]));
+            }
+        }
+        return;
+    }
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = format.sel->get_index(i);
+        auto hash = format.validity.RowIsValid(idx) ? HASH_VALUE(data[idx]) : HASH_VALUE(T());
+        hashes[i] = first ? hash : HASH::Combine(hashes[i], hash);
+    }
+}
+
+template <class HASH>
+static void HashArgument(Vector &input, idx_t count, uint64_t *hashes, bool first);
+
+// An array hashes as its length followed by its elements, each combined in turn
+template <class HASH>
+static void HashList(Vector &input, idx_t count, uint64_t *hashes, bool first) {
+    UnifiedVectorFormat format;
+    input.ToUnifiedFormat(count, format);
+    auto entries = UnifiedVectorFormat::GetData<list_entry_t>(format);
+    auto &child = ListVector::GetEntry(input);
+    auto child_count = ListVector::GetListSize(input);
+    vector<uint64_t> child_hashes(child_count);
+    if (child_count > 0) {
+        HashArgument<HASH>(child, child_count, child_hashes.data(), true);
+    }
+    for (idx_t i = 0; i < count; i++) {
+        auto idx = format.sel->get_index(i);
+        auto entry = format.validity.RowIsValid(idx) ? entries[idx] : list_entry_t(0, 0);
+        auto hash = IntHash64(entry.length);
+        hash = first ? hash : HASH::Combine(hashes[i], hash);
+        for (idx_t k = 0; k < entry.length; k++) {
+            hash = HASH::Combine(hash, child_hashes[entry.offset + k]);
+        }
+        hashes[i] = hash;
+    }
+}
+
+template <class HASH>
+static void HashArgument(Vector &input, idx_t count, uint64_t *hashes, bool first) {
+    switch (input.GetType().InternalType()) {
+    case PhysicalType::BOOL:
+    case PhysicalType::UINT8:
+        return HashColumn<HASH, uint8_t, HashFixed<HASH, uint8_t>>(input, count, hashes, first);
+    case PhysicalType::INT8:
+        return HashColumn<HASH, int8_t, HashFixed<HASH, int8_t>>(input, count, hashes, first);
+    case PhysicalType::UINT16:
+        return HashColumn<HASH, uint16_t, HashFixed<HASH, uint16_t>>(input, count, hashes, first);
+    case PhysicalType::INT16:
+        return HashColumn<HASH, int16_t, HashFixed<HASH, int16_t>>(input, count, hashes, first);
+    case PhysicalType::UINT32:
+        return HashColumn<HASH, uint32_t, HashFixed<HASH, uint32_t>>(input, count, hashes, first);
+    case PhysicalType::INT32:
+        return HashColumn<HASH, int32_t, HashFixed<HASH, int32_t>>(input, count, hashes, first);
+    case PhysicalType::UINT64:
+        return HashColumn<HASH, uint64_t, HashFixed<HASH, uint64_t>>(input, count, hashes, first);
+    case PhysicalType::INT64:
+        return HashColumn<HASH, int64_t, HashFixed<HASH, int64_t>>(input, count, hashes, first);
+    case PhysicalType::UINT128:
+        return HashColumn<HASH, uhugeint_t, HashFixed<HASH, uhugeint_t>>(input, count, hashes, first);
+    case PhysicalType::INT128:
+        return HashColumn<HASH, hugeint_t, HashFixed<HASH, hugeint_t>>(input, count, hashes, first);
+    case PhysicalType::FLOAT:
+        return HashColumn<HASH, float, HashFixed<HASH, float>>(input, count, hashes, first);
+    case PhysicalType::DOUBLE:
+        return HashColumn<HASH, double, HashFixed<HASH, double>>(input, count, hashes, first);
+    case PhysicalType::VARCHAR:
+        return HashColumn<HASH, string_t, HashString<HASH>>(input, count, hashes, first);
+    case PhysicalType::LIST:
+        return HashList<HASH>(input, count, hashes, first);
+    case PhysicalType::STRUCT: {
+        // a tuple hashes as if its fields were separate arguments
+        input.Flatten(count);
+        auto &fields = StructVector::GetEntries(input);
+        for (idx_t f = 0; f < fields.size(); f++) {
+            HashArgument<HASH>(*fields[f], count, hashes, first && f == 0);
+        }
+        return;
+    }
+    default:
+        throw InternalException("Unsupported type for hashing");
+    }
+}
+
+template <class HASH>
+static void HashFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto constant = args.AllConstant();
+    auto count = constant ? 1 : args.size();
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto hashes = FlatVector::GetData<uint64_t>(result);
+    auto &validity = FlatVector::Validity(result);
+    for (idx_t c = 0; c < args.ColumnCount(); c++) {
+        auto &input = args.data[c];
+        HashArgument<HASH>(input, count, hashes, c == 0);
+        UnifiedVectorFormat format;
+        input.ToUnifiedFormat(count, format);
+        if (format.validity.AllValid()) {
+            continue;
+        }
+        for (idx_t i = 0; i < count; i++) {
+            if (!format.validity.RowIsValid(format.sel->get_index(i))) {
+                validity.SetInvalid(i);
+            }
+        }
+    }
+    if (constant) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+static void CheckHashable(const string &name, const LogicalType &type) {
+    switch (type.InternalType()) {
+    case PhysicalType::BOOL:
+    case PhysicalType::UINT8:
+    case PhysicalType::INT8:
+    case PhysicalType::UINT16:
+    case PhysicalType::INT16:
+    case PhysicalType::UINT32:
+    case PhysicalType::INT32:
+    case PhysicalType::UINT64:
+    case PhysicalType::INT64:
+    case PhysicalType::UINT128:
+    case PhysicalType::INT128:
+    case PhysicalType::FLOAT:
+    case PhysicalType::DOUBLE:
+    case PhysicalType::VARCHAR:
+        return;
+    case PhysicalType::LIST:
+        return CheckHashable(name, ListType::GetChildType(type));
+    case PhysicalType::STRUCT:
+        for (auto &child : StructType::GetChildTypes(type)) {
+            CheckHashable(name, child.second);
+        }
+        return;
+    default:
+        throw BinderException("%s: cannot hash values of type %s", name, type.ToString());
+    }
+}
+
+static unique_ptr<FunctionData> HashBind(ClientContext &context, ScalarFunction &bound_function,
+                                         vector<unique_ptr<Expression>> &arguments) {
+    if (arguments.empty()) {
+        throw BinderException("%s: at least one argument is required", bound_function.name);
+    }
+    bound_function.arguments.clear();
+    for (auto &arg : arguments) {
+        if (arg->HasParameter()) {
+            throw ParameterNotResolvedException();
+        }
+        auto type = arg->return_type;
+        if (type.id() == LogicalTypeId::SQLNULL) {
+            type = LogicalType::VARCHAR;
+        }
+        CheckHashable(bound_function.name, type);
+        bound_function.arguments.push_back(type);
+    }
+    bound_function.varargs = LogicalType::INVALID;
+    return nullptr;
+}
+
+template <class HASH>
+static ScalarFunction HashScalarFunction(const string &name) {
+    ScalarFunction function(name, {}, LogicalType::UBIGINT, HashFunction<HASH>, HashBind);
+    function.varargs = LogicalType::ANY;
+    return function;
+}
+
+// intHash64 converts its argument to UInt64 first, so negative numbers are
+// sign-extended rather than zero-extended as in the functions above
+template <class T>
+static void IntHash64Function(DataChunk &args, ExpressionState &state, Vector &result) {
+    UnaryExecutor::Execute<T, uint64_t>(args.data[0], result, args.size(),
+                                        [](T value) { return IntHash64(static_cast<uint64_t>(value)); });
+}
+
+void RegisterHashFunctions(DatabaseInstance &instance) {
+    ExtensionUtil::RegisterFunction(instance, HashScalarFunction<CityHash64Impl>("cityHash64"));
+    ExtensionUtil::RegisterFunction(instance, HashScalarFunction<SipHash64Impl>("sipHash64"));
+    ExtensionUtil::RegisterFunction(instance, HashScalarFunction<XXHash64Impl>("xxHash64"));
+    ExtensionUtil::RegisterFunction(instance, HashScalarFunction<MurmurHash3_64Impl>("murmurHash3_64"));
+    ExtensionUtil::RegisterFunction(instance, HashScalarFunction<FarmHash64Impl>("farmHash64"));
+
+    ScalarFunctionSet int_hash("intHash64");
+    int_hash.AddFunction(ScalarFunction({LogicalType::UBIGINT}, LogicalType::UBIGINT, IntHash64Function<uint64_t>));
+    int_hash.AddFunction(
+        ScalarFunction({LogicalType::BIGINT}, LogicalType::UBIGINT, IntHash64Function<int64_t>));
+    ExtensionUtil::RegisterFunction(instance, int_hash);
+}
+
+} // namespace duckdb
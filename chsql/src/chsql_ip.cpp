@@ -0,0 +1,674 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/types/uhugeint.hpp"
+#include "duckdb/common/vector_operations/binary_executor.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/cast/cast_function_set.hpp"
+#include "duckdb/function/cast/vector_cast_helpers.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+namespace duckdb {
+
+// -- Parsing and formatting, without intermediate strings
+
+static bool ParseIPv4(const char *s, idx_t len, uint32_t &result) {
+    uint32_t value = 0;
+    idx_t pos = 0;
+    for (idx_t octet = 0; octet < 4; octet++) {
+        if (octet > 0) {
+            if (pos >= len || s[pos] != '.') {
+                return false;
+            }
+            pos++;
+        }
+        idx_t digits = 0;
+        uint32_t part = 0;
+        while (pos < len && digits < 3 && StringUtil::CharacterIsDigit(s[pos])) {
+            part = part * 10 + uint32_t(s[pos] - '0');
+            pos++;
+            digits++;
+        }
+        if (digits == 0 || part > 255) {
+            return false;
+        }
+        value = (value << 8) | part;
+    }
+    result = value;
+    return pos == len;
+}
+
+static idx_t FormatIPv4(uint32_t ip, char *out) {
+    idx_t pos = 0;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        auto octet = (ip >> shift) & 0xFF;
+        if (octet >= 100) {
+            out[pos++] = char('0' + octet / 100);
+        }
+        if (octet >= 10) {
+            out[pos++] = char('0' + (octet / 10) % 10);
+        }
+        out[pos++] = char('0' + octet % 10);
+        if (shift > 0) {
+            out[pos++] = '.';
+        }
+    }
+    return pos;
+}
+
+static void StoreIPv4Mapped(uint32_t ip, uint8_t bytes[16]) {
+    memset(bytes, 0, 10);
+    bytes[10] = 0xFF;
+    bytes[11] = 0xFF;
+    bytes[12] = uint8_t(ip >> 24);
+    bytes[13] = uint8_t(ip >> 16);
+    bytes[14] = uint8_t(ip >> 8);
+    bytes[15] = uint8_t(ip);
+}
+
+static bool IsIPv4Mapped(const uint8_t bytes[16]) {
+    for (idx_t i = 0; i < 10; i++) {
+        if (bytes[i] != 0) {
+            return false;
+        }
+    }
+    return bytes[10] == 0xFF && bytes[11] == 0xFF;
+}
+
+// IPv6 text form, including '::' and a trailing dotted quad; IPv4 addresses
+// are accepted too and stored IPv4-mapped (::ffff:a.b.c.d) as ClickHouse does
+static bool ParseIPv6(const char *s, idx_t len, uint8_t bytes[16]) {
+    uint32_t ipv4;
+    if (ParseIPv4(s, len, ipv4)) {
+        StoreIPv4Mapped(ipv4, bytes);
+        return true;
+    }
+    uint16_t groups[8];
+    idx_t count = 0;
+    int64_t gap = -1;
+    idx_t pos = 0;
+    if (len >= 2 && s[0] == ':' && s[1] == ':') {
+        gap = 0;
+        pos = 2;
+    } else if (len == 0 || s[0] == ':') {
+        return false;
+    }
+    while (pos < len) {
+        if (count == 8) {
+            return false;
+        }
+        auto end = pos;
+        bool dotted = false;
+        while (end < len && s[end] != ':') {
+            dotted = dotted || s[end] == '.';
+            end++;
+        }
+        if (dotted) {
+            if (end != len || count > 6 || !ParseIPv4(s + pos, end - pos, ipv4)) {
+                return false;
+            }
+            groups[count++] = uint16_t(ipv4 >> 16);
+            groups[count++] = uint16_t(ipv4 & 0xFFFF);
+            pos = len;
+            break;
+        }
+        if (end == pos || end - pos > 4) {
+            return false;
+        }
+        uint32_t group = 0;
+        for (; pos < end; pos++) {
+            auto c = s[pos];
+            if (!StringUtil::CharacterIsHex(c)) {
+                return false;
+            }
+            group = group * 16 + StringUtil::GetHexValue(c);
+        }
+        groups[count++] = uint16_t(group);
+        if (pos == len) {
+            break;
+        }
+        // on ':', a second one is the '::' gap
+        pos++;
+        if (pos < len && s[pos] == ':') {
+            if (gap >= 0) {
+                return false;
+            }
+            gap = int64_t(count);
+            pos++;
+        } else if (pos == len) {
+            return false;
+        }
+    }
+    if ((gap < 0 && count != 8) || (gap >= 0 && count > 7)) {
+        return false;
+    }
+    memset(bytes, 0, 16);
+    idx_t head = gap < 0 ? count : idx_t(gap);
+    for (idx_t i = 0; i < head; i++) {
+        bytes[2 * i] = uint8_t(groups[i] >> 8);
+        bytes[2 * i + 1] = uint8_t(groups[i]);
+    }
+    for (idx_t i = head; i < count; i++) {
+        auto target = 8 - (count - i);
+        bytes[2 * target] = uint8_t(groups[i] >> 8);
+        bytes[2 * target + 1] = uint8_t(groups[i]);
+    }
+    return true;
+}
+
+// RFC 5952 text form: lower case, longest zero run compressed
+static idx_t FormatIPv6(const uint8_t bytes[16], char *out) {
+    static const char *HEX = "0123456789abcdef";
+    idx_t pos = 0;
+    if (IsIPv4Mapped(bytes)) {
+        memcpy(out, "::ffff:", 7);
+        uint32_t ip = uint32_t(bytes[12]) << 24 | uint32_t(bytes[13]) << 16 | uint32_t(bytes[14]) << 8 | bytes[15];
+        return 7 + FormatIPv4(ip, out + 7);
+    }
+    uint16_t groups[8];
+    for (idx_t i = 0; i < 8; i++) {
+        groups[i] = uint16_t(bytes[2 * i] << 8 | bytes[2 * i + 1]);
+    }
+    idx_t best_start = 8, best_len = 0;
+    for (idx_t i = 0; i < 8;) {
+        if (groups[i] != 0) {
+            i++;
+            continue;
+        }
+        auto start = i;
+        while (i < 8 && groups[i] == 0) {
+            i++;
+        }
+        if (i - start > best_len && i - start >= 2) {
+            best_start = start;
+            best_len = i - start;
+        }
+    }
+    for (idx_t i = 0; i < 8; i++) {
+        if (i == best_start) {
+            out[pos++] = ':';
+            out[pos++] = ':';
+            i += best_len - 1;
+            continue;
+        }
+        if (i > 0 && i != best_start + best_len) {
+            out[pos++] = ':';
+        }
+        bool leading = true;
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            auto digit = (groups[i] >> shift) & 0xF;
+            if (leading && digit == 0 && shift > 0) {
+                continue;
+            }
+            leading = false;
+            out[pos++] = HEX[digit];
+        }
+    }
+    return pos;
+}
+
+static uhugeint_t IPv6ToNumber(const uint8_t bytes[16]) {
+    uhugeint_t result;
+    result.upper = 0;
+    result.lower = 0;
+    for (idx_t i = 0; i < 8; i++) {
+        result.upper = result.upper << 8 | bytes[i];
+        result.lower = result.lower << 8 | bytes[8 + i];
+    }
+    return result;
+}
+
+static void NumberToIPv6(uhugeint_t number, uint8_t bytes[16]) {
+    for (idx_t i = 0; i < 8; i++) {
+        bytes[7 - i] = uint8_t(number.upper >> (8 * i));
+        bytes[15 - i] = uint8_t(number.lower >> (8 * i));
+    }
+}
+
+// -- CIDR ranges, IPv4 ranges live in the IPv4-mapped part of the IPv6 space
+
+struct IPRange {
+    uhugeint_t lower;
+    uhugeint_t upper;
+};
+
+static bool ParseCIDR(const char *s, idx_t len, IPRange &range) {
+    auto slash = static_cast<const char *>(memchr(s, '/', len));
+    auto address_len = slash ? idx_t(slash - s) : len;
+    uint8_t bytes[16];
+    uint32_t ipv4;
+    idx_t max_prefix = 128;
+    idx_t offset = 0;
+    if (ParseIPv4(s, address_len, ipv4)) {
+        StoreIPv4Mapped(ipv4, bytes);
+        max_prefix = 32;
+        offset = 96;
+    } else if (!ParseIPv6(s, address_len, bytes)) {
+        return false;
+    }
+    idx_t prefix = max_prefix;
+    if (slash) {
+        prefix = 0;
+        idx_t digits = 0;
+        for (idx_t pos = address_len + 1; pos < len; pos++, digits++) {
+            if (!StringUtil::CharacterIsDigit(s[pos]) || digits > 2) {
+                return false;
+            }
+            prefix = prefix * 10 + idx_t(s[pos] - '0');
+        }
+        if (digits == 0 || prefix > max_prefix) {
+            return false;
+        }
+    }
+    prefix += offset;
+    auto address = IPv6ToNumber(bytes);
+    uhugeint_t host_mask = prefix == 0 ? NumericLimits<uhugeint_t>::Maximum()
+                                       : (uhugeint_t(1) << uhugeint_t(128 - prefix)) - uhugeint_t(1);
+    if (prefix == 128) {
+        host_mask = uhugeint_t(0);
+    }
+    range.lower = address & ~host_mask;
+    range.upper = range.lower | host_mask;
+    return true;
+}
+
+static IPRange ParseCIDROrThrow(const string_t &cidr) {
+    IPRange range;
+    if (!ParseCIDR(cidr.GetData(), cidr.GetSize(), range)) {
+        throw InvalidInputException("Invalid CIDR range '%s'", cidr.GetString());
+    }
+    return range;
+}
+
+// Sorted, non-overlapping ranges looked up by binary search
+static void NormalizeRanges(vector<IPRange> &ranges) {
+    std::sort(ranges.begin(), ranges.end(),
+              [](const IPRange &a, const IPRange &b) { return a.lower < b.lower; });
+    idx_t merged = 0;
+    for (idx_t i = 0; i < ranges.size(); i++) {
+        if (merged > 0 && (ranges[merged - 1].upper == NumericLimits<uhugeint_t>::Maximum() ||
+                           ranges[i].lower <= ranges[merged - 1].upper + uhugeint_t(1))) {
+            if (ranges[merged - 1].upper < ranges[i].upper) {
+                ranges[merged - 1].upper = ranges[i].upper;
+            }
+            continue;
+        }
+        ranges[merged++] = ranges[i];
+    }
+    ranges.resize(merged);
+}
+
+static bool RangesContain(const vector<IPRange> &ranges, const uhugeint_t &address) {
+    auto entry = std::upper_bound(ranges.begin(), ranges.end(), address,
+                                  [](const uhugeint_t &value, const IPRange &range) { return value < range.lower; });
+    return entry != ranges.begin() && address <= (entry - 1)->upper;
+}
+
+static bool ParseAddress(const string_t &address, uhugeint_t &result) {
+    uint8_t bytes[16];
+    if (!ParseIPv6(address.GetData(), address.GetSize(), bytes)) {
+        return false;
+    }
+    result = IPv6ToNumber(bytes);
+    return true;
+}
+
+// -- Scalar functions
+
+template <bool THROW, bool OR_NULL>
+static void IPv4StringToNumFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    UnaryExecutor::ExecuteWithNulls<string_t, uint32_t>(
+        args.data[0], result, args.size(), [&](string_t input, ValidityMask &mask, idx_t idx) {
+            uint32_t ip;
+            if (ParseIPv4(input.GetData(), input.GetSize(), ip)) {
+                return ip;
+            }
+            if (THROW) {
+                throw InvalidInputException("Invalid IPv4 value '%s'", input.GetString());
+            }
+            if (OR_NULL) {
+                mask.SetInvalid(idx);
+            }
+            return uint32_t(0);
+        });
+}
+
+template <class T>
+static void IPv4NumToStringFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    UnaryExecutor::Execute<T, string_t>(args.data[0], result, args.size(), [&](T num) {
+        char buffer[16];
+        auto len = FormatIPv4(uint32_t(num), buffer);
+        return StringVector::AddString(result, buffer, len);
+    });
+}
+
+static unique_ptr<FunctionData> IPv4NumToStringBind(ClientContext &context, ScalarFunction &bound_function,
+                                                    vector<unique_ptr<Expression>> &arguments) {
+    // any integer is accepted, only the low 32 bits are used
+    switch (arguments[0]->return_type.id()) {
+    case LogicalTypeId::UTINYINT:
+    case LogicalTypeId::USMALLINT:
+    case LogicalTypeId::UINTEGER:
+    case LogicalTypeId::UBIGINT:
+        bound_function.arguments[0] = LogicalType::UBIGINT;
+        bound_function.function = IPv4NumToStringFunction<uint64_t>;
+        break;
+    default:
+        bound_function.arguments[0] = LogicalType::BIGINT;
+        bound_function.function = IPv4NumToStringFunction<int64_t>;
+        break;
+    }
+    return nullptr;
+}
+
+template <bool THROW, bool OR_NULL>
+static void IPv6StringToNumFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    UnaryExecutor::ExecuteWithNulls<string_t, string_t>(
+        args.data[0], result, args.size(), [&](string_t input, ValidityMask &mask, idx_t idx) {
+            uint8_t bytes[16];
+            if (!ParseIPv6(input.GetData(), input.GetSize(), bytes)) {
+                if (THROW) {
+                    throw InvalidInputException("Invalid IPv6 value '%s'", input.GetString());
+                }
+                if (OR_NULL) {
+                    mask.SetInvalid(idx);
+                }
+                memset(bytes, 0, 16);
+            }
+            return StringVector::AddStringOrBlob(result, const_char_ptr_cast(bytes), 16);
+        });
+}
+
+static void IPv6NumToStringFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    UnaryExecutor::Execute<string_t, string_t>(args.data[0], result, args.size(), [&](string_t input) {
+        if (input.GetSize() != 16) {
+            throw InvalidInputException("IPv6NumToString expects a 16 byte binary address");
+        }
+        char buffer[48];
+        auto len = FormatIPv6(const_data_ptr_cast(input.GetData()), buffer);
+        return StringVector::AddString(result, buffer, len);
+    });
+}
+
+static void IsIPAddressInRangeFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &prefix = args.data[1];
+    if (prefix.GetVectorType() == VectorType::CONSTANT_VECTOR && !ConstantVector::IsNull(prefix)) {
+        // the common case: one prefix parsed once for the whole chunk
+        auto range = ParseCIDROrThrow(*ConstantVector::GetData<string_t>(prefix));
+        UnaryExecutor::Execute<string_t, bool>(args.data[0], result, args.size(), [&](string_t address) {
+            uhugeint_t value;
+            return ParseAddress(address, value) && range.lower <= value && value <= range.upper;
+        });
+        return;
+    }
+    BinaryExecutor::Execute<string_t, string_t, bool>(args.data[0], prefix, result, args.size(),
+                                                      [&](string_t address, string_t cidr) {
+                                                          auto range = ParseCIDROrThrow(cidr);
+                                                          uhugeint_t value;
+                                                          return ParseAddress(address, value) &&
+                                                                 range.lower <= value && value <= range.upper;
+                                                      });
+}
+
+struct IPRangeSetBindData : public FunctionData {
+    // filled when the CIDR list is a constant, e.g. a literal table of ranges
+    bool constant = false;
+    vector<IPRange> ranges;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<IPRangeSetBindData>();
+        result->constant = constant;
+        result->ranges = ranges;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        auto &other = other_p.Cast<IPRangeSetBindData>();
+        if (constant != other.constant || ranges.size() != other.ranges.size()) {
+            return false;
+        }
+        for (idx_t i = 0; i < ranges.size(); i++) {
+            if (ranges[i].lower != other.ranges[i].lower || ranges[i].upper != other.ranges[i].upper) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static vector<IPRange> RangesFromList(const vector<Value> &cidrs) {
+    vector<IPRange> ranges;
+    for (auto &cidr : cidrs) {
+        if (cidr.IsNull()) {
+            continue;
+        }
+        ranges.push_back(ParseCIDROrThrow(string_t(StringValue::Get(cidr))));
+    }
+    NormalizeRanges(ranges);
+    return ranges;
+}
+
+static unique_ptr<FunctionData> IsIPAddressInRangeSetBind(ClientContext &context, ScalarFunction &bound_function,
+                                                          vector<unique_ptr<Expression>> &arguments) {
+    auto data = make_uniq<IPRangeSetBindData>();
+    if (arguments[1]->IsFoldable()) {
+        auto cidrs = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+        if (!cidrs.IsNull()) {
+            data->constant = true;
+            data->ranges = RangesFromList(ListValue::GetChildren(cidrs));
+        }
+    }
+    return std::move(data);
+}
+
+static void IsIPAddressInRangeSetFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
+    auto &data = func_expr.bind_info->Cast<IPRangeSetBindData>();
+    if (data.constant) {
+        UnaryExecutor::Execute<string_t, bool>(args.data[0], result, args.size(), [&](string_t address) {
+            uhugeint_t value;
+            return ParseAddress(address, value) && RangesContain(data.ranges, value);
+        });
+        return;
+    }
+    // per-row lists, read without boxing into Values. The ranges are only
+    // rebuilt when the row points at another list, so a constant list, e.g. a
+    // prepared statement parameter, or a dictionary of lists is built once per
+    // distinct list in the chunk.
+    auto count = args.size();
+    UnifiedVectorFormat address_format, list_format, cidr_format;
+    args.data[0].ToUnifiedFormat(count, address_format);
+    args.data[1].ToUnifiedFormat(count, list_format);
+    ListVector::GetEntry(args.data[1]).ToUnifiedFormat(ListVector::GetListSize(args.data[1]), cidr_format);
+    auto addresses = UnifiedVectorFormat::GetData<string_t>(address_format);
+    auto lists = UnifiedVectorFormat::GetData<list_entry_t>(list_format);
+    auto cidrs = UnifiedVectorFormat::GetData<string_t>(cidr_format);
+
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto result_data = FlatVector::GetData<bool>(result);
+    vector<IPRange> ranges;
+    idx_t ranges_list = DConstants::INVALID_INDEX;
+    for (idx_t i = 0; i < count; i++) {
+        auto address_idx = address_format.sel->get_index(i);
+        auto list_idx = list_format.sel->get_index(i);
+        if (!address_format.validity.RowIsValid(address_idx) || !list_format.validity.RowIsValid(list_idx)) {
+            FlatVector::SetNull(result, i, true);
+            continue;
+        }
+        if (list_idx != ranges_list) {
+            auto &list = lists[list_idx];
+            ranges.clear();
+            for (idx_t c = list.offset; c < list.offset + list.length; c++) {
+                auto cidr_idx = cidr_format.sel->get_index(c);
+                if (cidr_format.validity.RowIsValid(cidr_idx)) {
+                    ranges.push_back(ParseCIDROrThrow(cidrs[cidr_idx]));
+                }
+            }
+            NormalizeRanges(ranges);
+            ranges_list = list_idx;
+        }
+        uhugeint_t value;
+        result_data[i] = ParseAddress(addresses[address_idx], value) && RangesContain(ranges, value);
+    }
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+static LogicalType IPv4Type() {
+    auto type = LogicalType(LogicalTypeId::UINTEGER);
+    type.SetAlias("IPv4");
+    return type;
+}
+
+static LogicalType IPv6Type() {
+    auto type = LogicalType(LogicalTypeId::UHUGEINT);
+    type.SetAlias("IPv6");
+    return type;
+}
+
+static unique_ptr<FunctionData> IPv4CIDRToRangeBind(ClientContext &context, ScalarFunction &bound_function,
+                                                    vector<unique_ptr<Expression>> &arguments) {
+    // accepts IPv4 values as well as plain integers
+    bound_function.arguments[0] = LogicalType::UINTEGER;
+    return nullptr;
+}
+
+static void IPv4CIDRToRangeFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto count = args.size();
+    UnifiedVectorFormat ip_format, cidr_format;
+    args.data[0].ToUnifiedFormat(count, ip_format);
+    args.data[1].ToUnifiedFormat(count, cidr_format);
+    auto ips = UnifiedVectorFormat::GetData<uint32_t>(ip_format);
+    auto cidrs = UnifiedVectorFormat::GetData<uint8_t>(cidr_format);
+    auto &entries = StructVector::GetEntries(result);
+    auto lower = FlatVector::GetData<uint32_t>(*entries[0]);
+    auto upper = FlatVector::GetData<uint32_t>(*entries[1]);
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    for (idx_t i = 0; i < count; i++) {
+        auto ip_idx = ip_format.sel->get_index(i);
+        auto cidr_idx = cidr_format.sel->get_index(i);
+        if (!ip_format.validity.RowIsValid(ip_idx) || !cidr_format.validity.RowIsValid(cidr_idx)) {
+            FlatVector::SetNull(result, i, true);
+            continue;
+        }
+        auto prefix = MinValue<uint32_t>(cidrs[cidr_idx], 32);
+        uint32_t host_mask = prefix == 0 ? 0xFFFFFFFFu : (uint32_t(1) << (32 - prefix)) - 1;
+        lower[i] = ips[ip_idx] & ~host_mask;
+        upper[i] = lower[i] | host_mask;
+    }
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+// -- IPv4 / IPv6 types: numbers with an alias, cast from and to their text form
+
+static bool VarcharToIPv4Cast(Vector &source, Vector &result, idx_t count, CastParameters &parameters) {
+    bool success = true;
+    UnaryExecutor::ExecuteWithNulls<string_t, uint32_t>(
+        source, result, count, [&](string_t input, ValidityMask &mask, idx_t idx) {
+            uint32_t ip;
+            if (ParseIPv4(input.GetData(), input.GetSize(), ip)) {
+                return ip;
+            }
+            HandleCastError::AssignError(StringUtil::Format("Invalid IPv4 value '%s'", input.GetString()),
+                                         parameters);
+            success = false;
+            mask.SetInvalid(idx);
+            return uint32_t(0);
+        });
+    return success;
+}
+
+static bool IPv4ToVarcharCast(Vector &source, Vector &result, idx_t count, CastParameters &parameters) {
+    UnaryExecutor::Execute<uint32_t, string_t>(source, result, count, [&](uint32_t ip) {
+        char buffer[16];
+        auto len = FormatIPv4(ip, buffer);
+        return StringVector::AddString(result, buffer, len);
+    });
+    return true;
+}
+
+static bool VarcharToIPv6Cast(Vector &source, Vector &result, idx_t count, CastParameters &parameters) {
+    bool success = true;
+    UnaryExecutor::ExecuteWithNulls<string_t, uhugeint_t>(
+        source, result, count, [&](string_t input, ValidityMask &mask, idx_t idx) {
+            uint8_t bytes[16];
+            if (ParseIPv6(input.GetData(), input.GetSize(), bytes)) {
+                return IPv6ToNumber(bytes);
+            }
+            HandleCastError::AssignError(StringUtil::Format("Invalid IPv6 value '%s'", input.GetString()),
+                                         parameters);
+            success = false;
+            mask.SetInvalid(idx);
+            return uhugeint_t(0);
+        });
+    return success;
+}
+
+static bool IPv6ToVarcharCast(Vector &source, Vector &result, idx_t count, CastParameters &parameters) {
+    UnaryExecutor::Execute<uhugeint_t, string_t>(source, result, count, [&](uhugeint_t ip) {
+        uint8_t bytes[16];
+        NumberToIPv6(ip, bytes);
+        char buffer[48];
+        auto len = FormatIPv6(bytes, buffer);
+        return StringVector::AddString(result, buffer, len);
+    });
+    return true;
+}
+
+static void ToIPv6Function(DataChunk &args, ExpressionState &state, Vector &result) {
+    // without an error message target, invalid addresses throw like a CAST
+    CastParameters parameters;
+    VarcharToIPv6Cast(args.data[0], result, args.size(), parameters);
+}
+
+void RegisterIPFunctions(DatabaseInstance &instance) {
+    auto ipv4 = IPv4Type();
+    auto ipv6 = IPv6Type();
+    ExtensionUtil::RegisterType(instance, "IPv4", ipv4);
+    ExtensionUtil::RegisterType(instance, "IPv6", ipv6);
+    ExtensionUtil::RegisterCastFunction(instance, LogicalType::VARCHAR, ipv4, VarcharToIPv4Cast);
+    ExtensionUtil::RegisterCastFunction(instance, ipv4, LogicalType::VARCHAR, IPv4ToVarcharCast);
+    ExtensionUtil::RegisterCastFunction(instance, LogicalType::VARCHAR, ipv6, VarcharToIPv6Cast);
+    ExtensionUtil::RegisterCastFunction(instance, ipv6, LogicalType::VARCHAR, IPv6ToVarcharCast);
+
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("toIPv4", {LogicalType::VARCHAR}, ipv4,
+                                                             IPv4StringToNumFunction<true, false>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("toIPv6", {LogicalType::VARCHAR}, ipv6, ToIPv6Function));
+
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv4StringToNum", {LogicalType::VARCHAR},
+                                                             LogicalType::UINTEGER, IPv4StringToNumFunction<true, false>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv4StringToNumOrDefault", {LogicalType::VARCHAR},
+                                                             LogicalType::UINTEGER, IPv4StringToNumFunction<false, false>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv4StringToNumOrNull", {LogicalType::VARCHAR},
+                                                             LogicalType::UINTEGER, IPv4StringToNumFunction<false, true>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv4NumToString", {LogicalType::ANY},
+                                                             LogicalType::VARCHAR, IPv4NumToStringFunction<int64_t>,
+                                                             IPv4NumToStringBind));
+
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv6StringToNum", {LogicalType::VARCHAR},
+                                                             LogicalType::BLOB, IPv6StringToNumFunction<true, false>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv6StringToNumOrDefault", {LogicalType::VARCHAR},
+                                                             LogicalType::BLOB, IPv6StringToNumFunction<false, false>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv6StringToNumOrNull", {LogicalType::VARCHAR},
+                                                             LogicalType::BLOB, IPv6StringToNumFunction<false, true>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("IPv6NumToString", {LogicalType::BLOB},
+                                                             LogicalType::VARCHAR, IPv6NumToStringFunction));
+
+    ScalarFunctionSet in_range("isIPAddressInRange");
+    in_range.AddFunction(ScalarFunction({LogicalType::VARCHAR, LogicalType::VARCHAR}, LogicalType::BOOLEAN,
+                                        IsIPAddressInRangeFunction));
+    in_range.AddFunction(ScalarFunction({LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR)},
+                                        LogicalType::BOOLEAN, IsIPAddressInRangeSetFunction,
+                                        IsIPAddressInRangeSetBind));
+    ExtensionUtil::RegisterFunction(instance, in_range);
+
+    ExtensionUtil::RegisterFunction(
+        instance, ScalarFunction("IPv4CIDRToRange", {LogicalType::ANY, LogicalType::UTINYINT},
+                                 LogicalType::STRUCT({{"min", ipv4}, {"max", ipv4}}), IPv4CIDRToRangeFunction,
+                                 IPv4CIDRToRangeBind));
+}
+
+} // namespace duckdb
@@ -0,0 +1,993 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/operator/cast_operators.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/execution/expression_executor_state.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+// -- Documents
+
+enum class JSONValueType : uint8_t { NULL_VALUE, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+// One value of a parsed document. Nodes are stored in document order, so the
+// first child of a container directly follows it and siblings are chained
+// through next. Spans are offsets into the document text; string and key
+// spans exclude the quotes.
+struct JSONNode {
+    JSONValueType type = JSONValueType::NULL_VALUE;
+    // the string value or the key contains backslash escapes
+    bool escaped = false;
+    bool key_escaped = false;
+    // a number without fraction or exponent
+    bool integral = false;
+    uint32_t key_offset = 0;
+    uint32_t key_length = 0;
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    // index of the next sibling, 0 for the last one
+    uint32_t next = 0;
+    uint32_t children = 0;
+};
+
+static constexpr idx_t JSON_MAX_DEPTH = 1000;
+
+// A document parsed once into a flat node array, which any number of paths
+// can then be looked up in without scanning the text again.
+class JSONDocument {
+public:
+    const char *data = nullptr;
+    idx_t size = 0;
+    vector<JSONNode> nodes;
+
+    // false if the text is not a single valid JSON value
+    bool Parse(const char *data_p, idx_t size_p) {
+        data = data_p;
+        size = size_p;
+        nodes.clear();
+        frames.clear();
+        if (size > NumericLimits<uint32_t>::Maximum()) {
+            return false;
+        }
+        idx_t pos = 0;
+        JSONNode key;
+        while (true) {
+            if (!ParseValue(pos, key)) {
+                return false;
+            }
+            // close finished containers until the next value starts
+            while (true) {
+                SkipWhitespace(pos);
+                if (frames.empty()) {
+                    return pos == size;
+                }
+                if (pos >= size) {
+                    return false;
+                }
+                auto &container = nodes[frames.back().node];
+                bool object = container.type == JSONValueType::OBJECT;
+                if (data[pos] == (object ? '}' : ']')) {
+                    pos++;
+                    container.length = UnsafeNumericCast<uint32_t>(pos - container.offset);
+                    frames.pop_back();
+                    continue;
+                }
+                if (container.children > 0) {
+                    if (data[pos] != ',') {
+                        return false;
+                    }
+                    pos++;
+                    SkipWhitespace(pos);
+                }
+                if (object && !ParseKey(pos, key)) {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+
+    const JSONNode &Root() const {
+        return nodes[0];
+    }
+    idx_t IndexOf(const JSONNode &node) const {
+        return UnsafeNumericCast<idx_t>(&node - nodes.data());
+    }
+    const JSONNode *FirstChild(const JSONNode &node) const {
+        return node.children == 0 ? nullptr : &nodes[IndexOf(node) + 1];
+    }
+    const JSONNode *NextSibling(const JSONNode &node) const {
+        return node.next == 0 ? nullptr : &nodes[node.next];
+    }
+
+    // the value as written, strings with their quotes
+    string_t Raw(const JSONNode &node) const {
+        if (node.type == JSONValueType::STRING) {
+            return string_t(data + node.offset - 1, node.length + 2);
+        }
+        return string_t(data + node.offset, node.length);
+    }
+
+    bool KeyEquals(const JSONNode &node, const string &key) const;
+
+private:
+    struct Frame {
+        uint32_t node;
+        uint32_t last_child;
+    };
+    vector<Frame> frames;
+
+    void SkipWhitespace(idx_t &pos) const {
+        while (pos < size && (data[pos] == ' ' || data[pos] == '\n' || data[pos] == '\r' || data[pos] == '\t')) {
+            pos++;
+        }
+    }
+
+    // pos is on the opening quote, and ends up after the closing one
+    bool ParseString(idx_t &pos, uint32_t &offset, uint32_t &length, bool &escaped) const {
+        pos++;
+        auto start = pos;
+        escaped = false;
+        while (pos < size) {
+            auto c = static_cast<unsigned char>(data[pos]);
+            if (c == '"') {
+                offset = UnsafeNumericCast<uint32_t>(start);
+                length = UnsafeNumericCast<uint32_t>(pos - start);
+                pos++;
+                return true;
+            }
+            if (c == '\\') {
+                escaped = true;
+                pos += 2;
+            } else if (c < 0x20) {
+                return false;
+            } else {
+                pos++;
+            }
+        }
+        return false;
+    }
+
+    bool ParseKey(idx_t &pos, JSONNode &key) const {
+        if (pos >= size || data[pos] != '"' || !ParseString(pos, key.key_offset, key.key_length, key.key_escaped)) {
+            return false;
+        }
+        SkipWhitespace(pos);
+        if (pos >= size || data[pos] != ':') {
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    bool ParseLiteral(idx_t &pos, const char *literal, idx_t length) const {
+        if (size - pos < length || memcmp(data + pos, literal, length) != 0) {
+            return false;
+        }
+        pos += length;
+        return true;
+    }
+
+    bool ParseDigits(idx_t &pos) const {
+        auto start = pos;
+        while (pos < size && StringUtil::CharacterIsDigit(data[pos])) {
+            pos++;
+        }
+        return pos > start;
+    }
+
+    bool ParseNumber(idx_t &pos, JSONNode &node) const {
+        if (data[pos] == '-') {
+            pos++;
+        }
+        if (pos < size && data[pos] == '0') {
+            pos++;
+        } else if (!ParseDigits(pos)) {
+            return false;
+        }
+        node.integral = true;
+        if (pos < size && data[pos] == '.') {
+            pos++;
+            node.integral = false;
+            if (!ParseDigits(pos)) {
+                return false;
+            }
+        }
+        if (pos < size && (data[pos] == 'e' || data[pos] == 'E')) {
+            pos++;
+            node.integral = false;
+            if (pos < size && (data[pos] == '+' || data[pos] == '-')) {
+                pos++;
+            }
+            if (!ParseDigits(pos)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ParseValue(idx_t &pos, const JSONNode &key) {
+        SkipWhitespace(pos);
+        if (pos >= size) {
+            return false;
+        }
+        auto index = UnsafeNumericCast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+        if (!frames.empty()) {
+            auto &frame = frames.back();
+            auto &parent = nodes[frame.node];
+            if (parent.children > 0) {
+                nodes[frame.last_child].next = index;
+            }
+            parent.children++;
+            frame.last_child = index;
+            if (parent.type == JSONValueType::OBJECT) {
+                nodes[index].key_offset = key.key_offset;
+                nodes[index].key_length = key.key_length;
+                nodes[index].key_escaped = key.key_escaped;
+            }
+        }
+        auto &node = nodes[index];
+        auto start = pos;
+        switch (data[pos]) {
+        case '{':
+        case '[':
+            node.type = data[pos] == '{' ? JSONValueType::OBJECT : JSONValueType::ARRAY;
+            node.offset = UnsafeNumericCast<uint32_t>(pos);
+            pos++;
+            frames.push_back({index, 0});
+            // the length is set once the container closes
+            return frames.size() <= JSON_MAX_DEPTH;
+        case '"':
+            node.type = JSONValueType::STRING;
+            return ParseString(pos, node.offset, node.length, node.escaped);
+        case 't':
+            node.type = JSONValueType::BOOLEAN;
+            if (!ParseLiteral(pos, "true", 4)) {
+                return false;
+            }
+            break;
+        case 'f':
+            node.type = JSONValueType::BOOLEAN;
+            if (!ParseLiteral(pos, "false", 5)) {
+                return false;
+            }
+            break;
+        case 'n':
+            node.type = JSONValueType::NULL_VALUE;
+            if (!ParseLiteral(pos, "null", 4)) {
+                return false;
+            }
+            break;
+        default:
+            node.type = JSONValueType::NUMBER;
+            if (!ParseNumber(pos, node)) {
+                return false;
+            }
+            break;
+        }
+        node.offset = UnsafeNumericCast<uint32_t>(start);
+        node.length = UnsafeNumericCast<uint32_t>(pos - start);
+        return true;
+    }
+};
+
+static idx_t HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return 16;
+}
+
+static bool ParseCodeUnit(const char *s, idx_t remaining, uint32_t &unit) {
+    if (remaining < 4) {
+        return false;
+    }
+    unit = 0;
+    for (idx_t i = 0; i < 4; i++) {
+        auto digit = HexValue(s[i]);
+        if (digit > 15) {
+            return false;
+        }
+        unit = unit << 4 | UnsafeNumericCast<uint32_t>(digit);
+    }
+    return true;
+}
+
+static void AppendUTF8(uint32_t code, string &target) {
+    if (code < 0x80) {
+        target += char(code);
+    } else if (code < 0x800) {
+        target += char(0xC0 | code >> 6);
+        target += char(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        target += char(0xE0 | code >> 12);
+        target += char(0x80 | (code >> 6 & 0x3F));
+        target += char(0x80 | (code & 0x3F));
+    } else {
+        target += char(0xF0 | code >> 18);
+        target += char(0x80 | (code >> 12 & 0x3F));
+        target += char(0x80 | (code >> 6 & 0x3F));
+        target += char(0x80 | (code & 0x3F));
+    }
+}
+
+// Decodes the escapes of a string span; malformed escapes are kept as written
+static void JSONUnescape(const char *s, idx_t length, string &target) {
+    target.clear();
+    target.reserve(length);
+    for (idx_t i = 0; i < length; i++) {
+        if (s[i] != '\\' || i + 1 == length) {
+            target += s[i];
+            continue;
+        }
+        auto c = s[++i];
+        switch (c) {
+        case 'b':
+            target += '\b';
+            break;
+        case 'f':
+            target += '\f';
+            break;
+        case 'n':
+            target += '\n';
+            break;
+        case 'r':
+            target += '\r';
+            break;
+        case 't':
+            target += '\t';
+            break;
+        case 'u': {
+            uint32_t code;
+            if (!ParseCodeUnit(s + i + 1, length - i - 1, code)) {
+                target += "\\u";
+                break;
+            }
+            i += 4;
+            uint32_t low;
+            if (code >= 0xD800 && code < 0xDC00 && i + 2 < length && s[i + 1] == '\\' && s[i + 2] == 'u' &&
+                ParseCodeUnit(s + i + 3, length - i - 3, low) && low >= 0xDC00 && low < 0xE000) {
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                i += 6;
+            }
+            AppendUTF8(code, target);
+            break;
+        }
+        default:
+            // '"', '\\' and '/' stand for themselves
+            target += c;
+            break;
+        }
+    }
+}
+
+bool JSONDocument::KeyEquals(const JSONNode &node, const string &key) const {
+    if (!node.key_escaped) {
+        return node.key_length == key.size() && memcmp(data + node.key_offset, key.data(), key.size()) == 0;
+    }
+    string decoded;
+    JSONUnescape(data + node.key_offset, node.key_length, decoded);
+    return decoded == key;
+}
+
+// Parsed documents shared by the JSON functions of one expression executor,
+// so that every JSON function of a projection over the same column reuses one
+// parse per row. A slot is found by the address of the text and only hit when
+// the cached copy still matches it byte for byte. Texts are only copied when
+// more than one function can hit them, up to MAX_CACHED_BYTES in total, and
+// are freed with the executor.
+class JSONDocumentCache {
+public:
+    // nullptr if the text is not valid JSON; valid until the next call
+    const JSONDocument *Parse(const string_t &input) {
+        auto ptr = input.GetData();
+        auto size = input.GetSize();
+        if (users < 2 || size <= string_t::INLINE_LENGTH || size > MAX_CACHED_SIZE) {
+            return scratch.Parse(ptr, size) ? &scratch : nullptr;
+        }
+        if (entries.empty()) {
+            entries.resize(CAPACITY);
+        }
+        auto &entry = entries[Hash<uint64_t>(uint64_t(CastPointerToValue(ptr)) ^ size) & (CAPACITY - 1)];
+        if (entry.ptr == ptr && entry.text.size() == size && memcmp(entry.text.data(), ptr, size) == 0) {
+            return entry.valid ? &entry.document : nullptr;
+        }
+        cached_bytes -= entry.Bytes();
+        if (cached_bytes + size > MAX_CACHED_BYTES) {
+            entry = Entry();
+            return scratch.Parse(ptr, size) ? &scratch : nullptr;
+        }
+        entry.ptr = ptr;
+        entry.text.assign(ptr, size);
+        entry.valid = entry.document.Parse(entry.text.data(), size);
+        cached_bytes += entry.Bytes();
+        return entry.valid ? &entry.document : nullptr;
+    }
+
+    // the JSON functions of the executor
+    idx_t users = 0;
+
+private:
+    // one chunk worth of slots, with the text held per slot and in total bounded
+    static constexpr idx_t CAPACITY = 2 * STANDARD_VECTOR_SIZE;
+    static constexpr idx_t MAX_CACHED_SIZE = 32 * 1024;
+    static constexpr idx_t MAX_CACHED_BYTES = 4 * 1024 * 1024;
+
+    struct Entry {
+        const char *ptr = nullptr;
+        string text;
+        JSONDocument document;
+        bool valid = false;
+
+        idx_t Bytes() const {
+            return text.capacity() + document.nodes.capacity() * sizeof(JSONNode);
+        }
+    };
+
+    vector<Entry> entries;
+    idx_t cached_bytes = 0;
+    JSONDocument scratch;
+};
+
+// The document caches of a connection's expression executors. Every JSON
+// function joins the cache of its executor when its state is initialized.
+class JSONDocumentCaches : public ClientContextState {
+public:
+    shared_ptr<JSONDocumentCache> Join(const ExpressionExecutor *executor) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto entry = caches.begin(); entry != caches.end();) {
+            entry = entry->second.expired() ? caches.erase(entry) : std::next(entry);
+        }
+        auto &slot = caches[executor];
+        auto cache = slot.lock();
+        if (!cache) {
+            cache = make_shared_ptr<JSONDocumentCache>();
+            slot = cache;
+        }
+        cache->users++;
+        return cache;
+    }
+
+private:
+    std::mutex lock;
+    unordered_map<const ExpressionExecutor *, weak_ptr<JSONDocumentCache>> caches;
+};
+
+struct JSONPathLocalState : public FunctionLocalState {
+    shared_ptr<JSONDocumentCache> cache;
+};
+
+static unique_ptr<FunctionLocalState> JSONPathInitLocal(ExpressionState &state, const BoundFunctionExpression &,
+                                                        FunctionData *) {
+    auto result = make_uniq<JSONPathLocalState>();
+    if (state.HasContext()) {
+        auto &caches = *state.GetContext().registered_state->GetOrCreate<JSONDocumentCaches>("chsql_json_documents");
+        result->cache = caches.Join(state.root.executor);
+    } else {
+        result->cache = make_shared_ptr<JSONDocumentCache>();
+    }
+    return std::move(result);
+}
+
+// -- Paths
+
+// A key, an index or both (a JSON pointer token that is a number). Indexes
+// are zero based and count from the end when negative; on an object they
+// select the n-th member.
+struct JSONPathStep {
+    string key;
+    int64_t index = 0;
+    bool has_key = false;
+    bool has_index = false;
+
+    bool operator==(const JSONPathStep &other) const {
+        return key == other.key && index == other.index && has_key == other.has_key && has_index == other.has_index;
+    }
+};
+
+using JSONPath = vector<JSONPathStep>;
+
+static JSONPathStep KeyStep(string key) {
+    JSONPathStep step;
+    step.key = std::move(key);
+    step.has_key = true;
+    return step;
+}
+
+static JSONPathStep IndexStep(int64_t index) {
+    JSONPathStep step;
+    step.index = index;
+    step.has_index = true;
+    return step;
+}
+
+static bool ParseIndex(const string &text, int64_t &index) {
+    if (text.empty() || !TryCast::Operation<string_t, int64_t>(string_t(text), index, true)) {
+        return false;
+    }
+    return true;
+}
+
+// $.a.b[0]["c d"][#-1]
+static void AppendJSONPath(const string &path, JSONPath &target) {
+    idx_t pos = 1;
+    auto size = path.size();
+    while (pos < size) {
+        if (path[pos] == '.') {
+            pos++;
+            if (pos < size && path[pos] == '"') {
+                auto end = path.find('"', pos + 1);
+                if (end == string::npos) {
+                    throw InvalidInputException("JSON path '%s' has an unterminated quoted key", path);
+                }
+                target.push_back(KeyStep(path.substr(pos + 1, end - pos - 1)));
+                pos = end + 1;
+                continue;
+            }
+            auto end = pos;
+            while (end < size && path[end] != '.' && path[end] != '[') {
+                end++;
+            }
+            if (end == pos || (end - pos == 1 && path[pos] == '*')) {
+                throw InvalidInputException("JSON path '%s' needs a key after '.', wildcards are not supported", path);
+            }
+            target.push_back(KeyStep(path.substr(pos, end - pos)));
+            pos = end;
+        } else if (path[pos] == '[') {
+            auto end = path.find(']', pos);
+            if (end == string::npos) {
+                throw InvalidInputException("JSON path '%s' has an unterminated '['", path);
+            }
+            auto inner = path.substr(pos + 1, end - pos - 1);
+            int64_t index;
+            if (inner.size() >= 2 && (inner[0] == '"' || inner[0] == '\'') && inner.back() == inner[0]) {
+                target.push_back(KeyStep(inner.substr(1, inner.size() - 2)));
+            } else if (inner.size() > 1 && inner[0] == '#' && ParseIndex(inner.substr(1), index) && index < 0) {
+                target.push_back(IndexStep(index));
+            } else if (ParseIndex(inner, index) && index >= 0) {
+                target.push_back(IndexStep(index));
+            } else {
+                throw InvalidInputException("JSON path '%s' has an invalid subscript [%s]", path, inner);
+            }
+            pos = end + 1;
+        } else {
+            throw InvalidInputException("JSON path '%s' expects '.' or '[' at position %d", path, pos);
+        }
+    }
+}
+
+// /a/b/0, with ~1 for '/' and ~0 for '~'
+static void AppendJSONPointer(const string &pointer, JSONPath &target) {
+    for (auto &token : StringUtil::Split(pointer.substr(1), '/')) {
+        auto key = StringUtil::Replace(StringUtil::Replace(token, "~1", "/"), "~0", "~");
+        int64_t index;
+        auto step = KeyStep(key);
+        if (ParseIndex(key, index) && index >= 0) {
+            step.index = index;
+            step.has_index = true;
+        }
+        target.push_back(std::move(step));
+    }
+}
+
+// A string argument starting with '$' is a JSONPath and one starting with '/'
+// a JSON pointer, anything else a single key as in ClickHouse
+static void AppendPathString(const string &text, JSONPath &target) {
+    if (!text.empty() && text[0] == '$') {
+        AppendJSONPath(text, target);
+    } else if (!text.empty() && text[0] == '/') {
+        AppendJSONPointer(text, target);
+    } else {
+        target.push_back(KeyStep(text));
+    }
+}
+
+// ClickHouse indexes are one based and count from the end when negative
+static void AppendPathIndex(int64_t index, JSONPath &target) {
+    if (index == 0) {
+        // matches nothing, as in ClickHouse
+        target.push_back(IndexStep(NumericLimits<int64_t>::Maximum()));
+    } else {
+        target.push_back(IndexStep(index > 0 ? index - 1 : index));
+    }
+}
+
+static const JSONNode *FindPath(const JSONDocument &document, const JSONPath &path) {
+    auto node = &document.Root();
+    for (auto &step : path) {
+        bool object = node->type == JSONValueType::OBJECT;
+        if (!object && node->type != JSONValueType::ARRAY) {
+            return nullptr;
+        }
+        auto child = document.FirstChild(*node);
+        if (object && step.has_key) {
+            while (child && !document.KeyEquals(*child, step.key)) {
+                child = document.NextSibling(*child);
+            }
+        } else if (step.has_index) {
+            auto index = step.index < 0 ? step.index + int64_t(node->children) : step.index;
+            if (index < 0 || index >= int64_t(node->children)) {
+                return nullptr;
+            }
+            for (int64_t i = 0; i < index; i++) {
+                child = document.NextSibling(*child);
+            }
+        } else {
+            return nullptr;
+        }
+        if (!child) {
+            return nullptr;
+        }
+        node = child;
+    }
+    return node;
+}
+
+// -- Functions
+
+struct JSONPathBindData : public FunctionData {
+    // paths given as constants are compiled here; otherwise per row
+    bool constant = false;
+    // a constant NULL path argument, every result is NULL
+    bool null_path = false;
+    JSONPath path;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<JSONPathBindData>();
+        result->constant = constant;
+        result->null_path = null_path;
+        result->path = path;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        auto &other = other_p.Cast<JSONPathBindData>();
+        return constant == other.constant && null_path == other.null_path && path == other.path;
+    }
+};
+
+static unique_ptr<FunctionData> JSONPathBind(ClientContext &context, ScalarFunction &bound_function,
+                                             vector<unique_ptr<Expression>> &arguments) {
+    auto data = make_uniq<JSONPathBindData>();
+    data->constant = true;
+    bound_function.arguments.resize(1);
+    for (idx_t i = 1; i < arguments.size(); i++) {
+        auto &arg = *arguments[i];
+        if (arg.HasParameter()) {
+            throw ParameterNotResolvedException();
+        }
+        auto &type = arg.return_type;
+        if (type.IsIntegral()) {
+            bound_function.arguments.push_back(LogicalType::BIGINT);
+        } else if (type.id() == LogicalTypeId::VARCHAR || type.id() == LogicalTypeId::SQLNULL) {
+            bound_function.arguments.push_back(LogicalType::VARCHAR);
+        } else {
+            throw BinderException("%s: path arguments must be strings or integers, not %s", bound_function.name,
+                                  type.ToString());
+        }
+        data->constant = data->constant && arg.IsFoldable();
+    }
+    bound_function.varargs = LogicalType::INVALID;
+    if (!data->constant) {
+        return std::move(data);
+    }
+
+    for (idx_t i = 1; i < arguments.size(); i++) {
+        auto value = ExpressionExecutor::EvaluateScalar(context, *arguments[i]);
+        if (value.IsNull()) {
+            data->null_path = true;
+        } else if (bound_function.arguments[i].id() == LogicalTypeId::BIGINT) {
+            AppendPathIndex(value.GetValue<int64_t>(), data->path);
+        } else {
+            try {
+                AppendPathString(StringValue::Get(value.DefaultCastAs(LogicalType::VARCHAR)), data->path);
+            } catch (InvalidInputException &ex) {
+                throw BinderException("%s: %s", bound_function.name, ex.what());
+            }
+        }
+    }
+    while (arguments.size() > 1) {
+        Function::EraseArgument(bound_function, arguments, arguments.size() - 1);
+    }
+    return std::move(data);
+}
+
+// Each OP writes row of result from the node the path found, which is nullptr
+// when the path is missing or the document is not valid JSON. Returning false
+// makes the row NULL.
+template <class OP>
+static void JSONPathFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &func_expr = state.expr.Cast<BoundFunctionExpression>();
+    auto &data = func_expr.bind_info->Cast<JSONPathBindData>();
+    auto count = args.size();
+    if (args.AllConstant()) {
+        count = 1;
+    }
+    result.SetVectorType(VectorType::FLAT_VECTOR);
+    auto &validity = FlatVector::Validity(result);
+
+    vector<UnifiedVectorFormat> inputs(args.ColumnCount());
+    for (idx_t c = 0; c < args.ColumnCount(); c++) {
+        args.data[c].ToUnifiedFormat(count, inputs[c]);
+    }
+    auto documents = UnifiedVectorFormat::GetData<string_t>(inputs[0]);
+    auto &cache = *ExecuteFunctionState::GetFunctionState(state)->Cast<JSONPathLocalState>().cache;
+    JSONPath row_path;
+    for (idx_t i = 0; i < count; i++) {
+        auto doc_idx = inputs[0].sel->get_index(i);
+        if (data.null_path || !inputs[0].validity.RowIsValid(doc_idx)) {
+            validity.SetInvalid(i);
+            continue;
+        }
+        auto path = &data.path;
+        if (!data.constant) {
+            row_path.clear();
+            bool valid = true;
+            for (idx_t c = 1; c < args.ColumnCount() && valid; c++) {
+                auto idx = inputs[c].sel->get_index(i);
+                valid = inputs[c].validity.RowIsValid(idx);
+                if (!valid) {
+                    break;
+                }
+                if (args.data[c].GetType().id() == LogicalTypeId::BIGINT) {
+                    AppendPathIndex(UnifiedVectorFormat::GetData<int64_t>(inputs[c])[idx], row_path);
+                } else {
+                    AppendPathString(UnifiedVectorFormat::GetData<string_t>(inputs[c])[idx].GetString(), row_path);
+                }
+            }
+            if (!valid) {
+                validity.SetInvalid(i);
+                continue;
+            }
+            path = &row_path;
+        }
+        auto document = cache.Parse(documents[doc_idx]);
+        auto node = document ? FindPath(*document, *path) : nullptr;
+        if (!OP::Operation(document, node, result, i)) {
+            validity.SetInvalid(i);
+        }
+    }
+    if (args.AllConstant()) {
+        result.SetVectorType(VectorType::CONSTANT_VECTOR);
+    }
+}
+
+// Containers without the whitespace between tokens, as ClickHouse returns them
+static string_t MinifiedRaw(const JSONDocument &document, const JSONNode &node, Vector &result) {
+    auto raw = document.Raw(node);
+    if (node.type != JSONValueType::ARRAY && node.type != JSONValueType::OBJECT) {
+        return StringVector::AddString(result, raw);
+    }
+    auto s = raw.GetData();
+    auto size = raw.GetSize();
+    string minified;
+    minified.reserve(size);
+    bool in_string = false;
+    for (idx_t i = 0; i < size; i++) {
+        auto c = s[i];
+        if (in_string) {
+            minified += c;
+            if (c == '\\' && i + 1 < size) {
+                minified += s[++i];
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            minified += c;
+            in_string = c == '"';
+        }
+    }
+    return StringVector::AddString(result, minified);
+}
+
+static string_t StringValueOf(const JSONDocument &document, const JSONNode &node, Vector &result) {
+    if (!node.escaped) {
+        return StringVector::AddString(result, document.data + node.offset, node.length);
+    }
+    string decoded;
+    JSONUnescape(document.data + node.offset, node.length, decoded);
+    return StringVector::AddString(result, decoded);
+}
+
+// Numbers, booleans and strings holding a number convert; anything else is NULL
+template <class T>
+static bool NumericValueOf(const JSONDocument &document, const JSONNode &node, T &target) {
+    switch (node.type) {
+    case JSONValueType::BOOLEAN:
+        target = document.data[node.offset] == 't' ? 1 : 0;
+        return true;
+    case JSONValueType::NUMBER: {
+        string_t text(document.data + node.offset, node.length);
+        if (node.integral || std::is_floating_point<T>::value) {
+            return TryCast::Operation<string_t, T>(text, target, true);
+        }
+        // ClickHouse truncates fractional numbers when extracting integers
+        double value;
+        return TryCast::Operation<string_t, double>(text, value, true) && TryCast::Operation(value, target);
+    }
+    case JSONValueType::STRING: {
+        if (node.escaped) {
+            return false;
+        }
+        return TryCast::Operation<string_t, T>(string_t(document.data + node.offset, node.length), target, false);
+    }
+    default:
+        return false;
+    }
+}
+
+struct JSONExtractRawOperator {
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        if (!node) {
+            return false;
+        }
+        FlatVector::GetData<string_t>(result)[row] = MinifiedRaw(*document, *node, result);
+        return true;
+    }
+};
+
+// strings without their quotes, other scalars as written
+struct JSONExtractStringOperator {
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        if (!node || node->type == JSONValueType::NULL_VALUE) {
+            return false;
+        }
+        auto target = FlatVector::GetData<string_t>(result);
+        if (node->type == JSONValueType::STRING) {
+            target[row] = StringValueOf(*document, *node, result);
+        } else {
+            target[row] = MinifiedRaw(*document, *node, result);
+        }
+        return true;
+    }
+};
+
+template <class T>
+struct JSONExtractNumericOperator {
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        return node && NumericValueOf<T>(*document, *node, FlatVector::GetData<T>(result)[row]);
+    }
+};
+
+struct JSONExtractBoolOperator {
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        double value;
+        if (!node || !NumericValueOf<double>(*document, *node, value)) {
+            return false;
+        }
+        FlatVector::GetData<bool>(result)[row] = value != 0;
+        return true;
+    }
+};
+
+struct JSONHasOperator {
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        FlatVector::GetData<bool>(result)[row] = node != nullptr;
+        return true;
+    }
+};
+
+// elements of an array or members of an object, 0 for anything else
+struct JSONLengthOperator {
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        bool container = node && (node->type == JSONValueType::ARRAY || node->type == JSONValueType::OBJECT);
+        FlatVector::GetData<uint64_t>(result)[row] = container ? node->children : 0;
+        return true;
+    }
+};
+
+// The names of ClickHouse's JSONType enum
+struct JSONTypeOperator {
+    static const char *TypeName(const JSONDocument &document, const JSONNode &node) {
+        switch (node.type) {
+        case JSONValueType::NULL_VALUE:
+            return "Null";
+        case JSONValueType::BOOLEAN:
+            return "Bool";
+        case JSONValueType::STRING:
+            return "String";
+        case JSONValueType::ARRAY:
+            return "Array";
+        case JSONValueType::OBJECT:
+            return "Object";
+        case JSONValueType::NUMBER: {
+            string_t text(document.data + node.offset, node.length);
+            int64_t signed_value;
+            uint64_t unsigned_value;
+            if (node.integral && TryCast::Operation<string_t, int64_t>(text, signed_value, true)) {
+                return "Int64";
+            }
+            if (node.integral && TryCast::Operation<string_t, uint64_t>(text, unsigned_value, true)) {
+                return "UInt64";
+            }
+            return "Double";
+        }
+        default:
+            return "Null";
+        }
+    }
+
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        auto name = node ? TypeName(*document, *node) : "Null";
+        FlatVector::GetData<string_t>(result)[row] = string_t(name);
+        return true;
+    }
+};
+
+// Keys or values of an object (values also of an array) as a list; NULL for scalars
+template <bool KEYS>
+struct JSONExtractMembersOperator {
+    static bool Operation(const JSONDocument *document, const JSONNode *node, Vector &result, idx_t row) {
+        if (!node || (node->type != JSONValueType::OBJECT && (KEYS || node->type != JSONValueType::ARRAY))) {
+            return false;
+        }
+        auto offset = ListVector::GetListSize(result);
+        ListVector::Reserve(result, offset + node->children);
+        auto &child = ListVector::GetEntry(result);
+        auto values = FlatVector::GetData<string_t>(child);
+        auto &child_validity = FlatVector::Validity(child);
+        idx_t n = 0;
+        string decoded;
+        for (auto member = document->FirstChild(*node); member; member = document->NextSibling(*member), n++) {
+            if (KEYS) {
+                JSONUnescape(document->data + member->key_offset, member->key_length, decoded);
+                values[offset + n] = StringVector::AddString(child, decoded);
+            } else if (!JSONExtractStringOperator::Operation(document, member, child, offset + n)) {
+                child_validity.SetInvalid(offset + n);
+            }
+        }
+        ListVector::SetListSize(result, offset + n);
+        FlatVector::GetData<list_entry_t>(result)[row] = list_entry_t(offset, n);
+        return true;
+    }
+};
+
+template <class OP>
+static ScalarFunction JSONPathScalarFunction(const string &name, const LogicalType &return_type) {
+    ScalarFunction function(name, {LogicalType::VARCHAR}, return_type, JSONPathFunction<OP>, JSONPathBind);
+    function.varargs = LogicalType::ANY;
+    function.init_local_state = JSONPathInitLocal;
+    return function;
+}
+
+void RegisterJSONFunctions(DatabaseInstance &instance) {
+    auto keys = LogicalType::LIST(LogicalType::VARCHAR);
+    ExtensionUtil::RegisterFunction(instance,
+                                    JSONPathScalarFunction<JSONExtractRawOperator>("JSONExtract", LogicalType::JSON()));
+    ExtensionUtil::RegisterFunction(
+        instance, JSONPathScalarFunction<JSONExtractRawOperator>("JSONExtractRaw", LogicalType::JSON()));
+    ExtensionUtil::RegisterFunction(
+        instance, JSONPathScalarFunction<JSONExtractStringOperator>("JSONExtractString", LogicalType::VARCHAR));
+    ExtensionUtil::RegisterFunction(
+        instance, JSONPathScalarFunction<JSONExtractNumericOperator<int64_t>>("JSONExtractInt", LogicalType::BIGINT));
+    ExtensionUtil::RegisterFunction(instance, JSONPathScalarFunction<JSONExtractNumericOperator<uint64_t>>(
+                                                  "JSONExtractUInt", LogicalType::UBIGINT));
+    ExtensionUtil::RegisterFunction(instance, JSONPathScalarFunction<JSONExtractNumericOperator<double>>(
+                                                  "JSONExtractFloat", LogicalType::DOUBLE));
+    ExtensionUtil::RegisterFunction(
+        instance, JSONPathScalarFunction<JSONExtractBoolOperator>("JSONExtractBool", LogicalType::BOOLEAN));
+    ExtensionUtil::RegisterFunction(instance,
+                                    JSONPathScalarFunction<JSONHasOperator>("JSONHas", LogicalType::BOOLEAN));
+    ExtensionUtil::RegisterFunction(instance,
+                                    JSONPathScalarFunction<JSONLengthOperator>("JSONLength", LogicalType::UBIGINT));
+    ExtensionUtil::RegisterFunction(instance,
+                                    JSONPathScalarFunction<JSONTypeOperator>("JSONType", LogicalType::VARCHAR));
+    ExtensionUtil::RegisterFunction(
+        instance, JSONPathScalarFunction<JSONExtractMembersOperator<true>>("JSONExtractKeys", keys));
+    ExtensionUtil::RegisterFunction(
+        instance, JSONPathScalarFunction<JSONExtractMembersOperator<false>>("JSONExtractValues", keys));
+}
+
+} // namespace duckdb
@@ -0,0 +1,450 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/operator/comparison_operators.hpp"
+#include "duckdb/common/string_map_set.hpp"
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/common/types/string_heap.hpp"
+#include "duckdb/function/create_sort_key.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+namespace duckdb {
+
+// limit_by((SELECT ...), n, 'key', ...) is ClickHouse's LIMIT n BY key.
+//
+// By default the first n rows of every key pass and the rest are dropped as
+// they stream by, "first" being the order in which the rows reach the
+// operator. The counts are sharded by the hash of the key, so threads only
+// wait for each other when their keys share a shard.
+//
+// With order_by := 'column [ASC|DESC] [NULLS FIRST|LAST], ...' every key keeps
+// a heap of the sort keys of its offset + n first rows in that order, which
+// point into a payload collection of its shard, and the rows that pass come
+// out once the last thread has finished its input. Memory stays bounded by
+// keys * (offset + n) rows, as rows pushed out of the heaps are compacted
+// away, and the result does not depend on how the threads interleave.
+// ORDER BY ... LIMIT n BY in ClickHouse syntax lowers onto this, see
+// chsql_parser.cpp.
+//
+// With sorted := true the input arrives grouped by the keys, as
+// read_parquet_mergetree delivers its sort key, and only the current key is
+// kept. A run of a key must not be split between threads, so the input has to
+// come from a single thread.
+static constexpr idx_t LIMIT_BY_SHARDS = 64;
+
+struct LimitByData : public TableFunctionData {
+    uint64_t limit = 0;
+    uint64_t offset = 0;
+    vector<column_t> keys;
+    bool sorted = false;
+    vector<column_t> order_columns;
+    vector<OrderModifiers> order_modifiers;
+    vector<LogicalType> types;
+};
+
+// A row a key may keep under order_by: its sort key and its row in the payload
+struct LimitByRow {
+    string order;
+    idx_t row;
+};
+
+static bool LimitByRowBefore(const LimitByRow &a, const LimitByRow &b) {
+    return a.order < b.order;
+}
+
+struct LimitByShard {
+    explicit LimitByShard(Allocator &allocator) : heap(allocator) {
+    }
+
+    mutex lock;
+    StringHeap heap;
+    // rows seen per key
+    string_map_t<uint64_t> seen;
+    // per key, a max-heap of the rows that come first in the order
+    string_map_t<vector<LimitByRow>> top;
+    // the rows that entered a heap, under order_by
+    unique_ptr<ColumnDataCollection> payload;
+    // the ones of them still in a heap
+    idx_t live = 0;
+};
+
+struct LimitByState : public GlobalTableFunctionState {
+    explicit LimitByState(ClientContext &context) {
+        for (idx_t i = 0; i < LIMIT_BY_SHARDS; i++) {
+            shards.push_back(make_uniq<LimitByShard>(BufferAllocator::Get(context)));
+        }
+    }
+
+    vector<unique_ptr<LimitByShard>> shards;
+    // the threads that have not finished their input yet, under order_by. A
+    // thread that starts after the count dropped to zero finds the source
+    // drained, so it has no rows to add.
+    mutex finish_lock;
+    idx_t running = 0;
+    // the threads that received input, under sorted
+    atomic<idx_t> sorted_readers {0};
+};
+
+struct LimitByLocalState : public LocalTableFunctionState {
+    // the key of the current run, under sorted
+    bool reading = false;
+    string current;
+    uint64_t current_count = 0;
+    // the rows the last thread to finish emits, under order_by
+    bool finished = false;
+    unique_ptr<ColumnDataCollection> rows;
+    ColumnDataScanState scan;
+};
+
+static column_t LimitByColumn(TableFunctionBindInput &input, const string &name) {
+    auto column = std::find_if(input.input_table_names.begin(), input.input_table_names.end(),
+                               [&](const string &candidate) { return StringUtil::CIEquals(candidate, name); });
+    if (column == input.input_table_names.end()) {
+        throw BinderException("limit_by: column \"%s\" not found in the subquery", name);
+    }
+    return column - input.input_table_names.begin();
+}
+
+static void ParseLimitByOrder(TableFunctionBindInput &input, const string &order, LimitByData &data) {
+    for (auto &item : StringUtil::Split(order, ',')) {
+        vector<string> words;
+        for (auto &word : StringUtil::Split(item, ' ')) {
+            StringUtil::Trim(word);
+            if (!word.empty()) {
+                words.push_back(word);
+            }
+        }
+        if (words.empty()) {
+            throw BinderException("limit_by: order_by expects a list of columns");
+        }
+        auto name = words[0];
+        if (name.size() > 1 && name.front() == '"' && name.back() == '"') {
+            name = StringUtil::Replace(name.substr(1, name.size() - 2), "\"\"", "\"");
+        }
+        OrderModifiers modifiers(OrderType::ASCENDING, OrderByNullType::NULLS_LAST);
+        for (idx_t i = 1; i < words.size(); i++) {
+            auto word = StringUtil::Upper(words[i]);
+            if (word == "ASC" || word == "ASCENDING") {
+                modifiers.order_type = OrderType::ASCENDING;
+            } else if (word == "DESC" || word == "DESCENDING") {
+                modifiers.order_type = OrderType::DESCENDING;
+            } else if (word == "NULLS" && i + 1 < words.size() && StringUtil::CIEquals(words[i + 1], "FIRST")) {
+                modifiers.null_type = OrderByNullType::NULLS_FIRST;
+                i++;
+            } else if (word == "NULLS" && i + 1 < words.size() && StringUtil::CIEquals(words[i + 1], "LAST")) {
+                modifiers.null_type = OrderByNullType::NULLS_LAST;
+                i++;
+            } else {
+                throw BinderException("limit_by: unexpected \"%s\" in order_by", words[i]);
+            }
+        }
+        data.order_columns.push_back(LimitByColumn(input, name));
+        data.order_modifiers.push_back(modifiers);
+    }
+}
+
+static unique_ptr<FunctionData> LimitByBind(ClientContext &context, TableFunctionBindInput &input,
+                                            vector<LogicalType> &return_types, vector<string> &names) {
+    // inputs[0] stands for the subquery
+    if (input.inputs.size() < 3) {
+        throw BinderException("limit_by: expected a subquery, a limit and at least one key column");
+    }
+    auto data = make_uniq<LimitByData>();
+    if (input.inputs[1].IsNull()) {
+        throw BinderException("limit_by: the limit cannot be NULL");
+    }
+    data->limit = input.inputs[1].GetValue<uint64_t>();
+    for (idx_t i = 2; i < input.inputs.size(); i++) {
+        if (input.inputs[i].IsNull()) {
+            throw BinderException("limit_by: key columns cannot be NULL");
+        }
+        data->keys.push_back(LimitByColumn(input, input.inputs[i].GetValue<string>()));
+    }
+    for (auto &kv : input.named_parameters) {
+        if (kv.second.IsNull()) {
+            continue;
+        }
+        if (kv.first == "offset") {
+            data->offset = kv.second.GetValue<uint64_t>();
+        } else if (kv.first == "sorted") {
+            data->sorted = kv.second.GetValue<bool>();
+        } else if (kv.first == "order_by") {
+            ParseLimitByOrder(input, kv.second.GetValue<string>(), *data);
+        }
+    }
+    if (data->sorted && !data->order_columns.empty()) {
+        throw BinderException("limit_by: sorted and order_by cannot be combined");
+    }
+    data->types = input.input_table_types;
+    return_types = input.input_table_types;
+    names = input.input_table_names;
+    return std::move(data);
+}
+
+static unique_ptr<GlobalTableFunctionState> LimitByInitGlobal(ClientContext &context, TableFunctionInitInput &input) {
+    return make_uniq<LimitByState>(context);
+}
+
+static unique_ptr<LocalTableFunctionState> LimitByInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                            GlobalTableFunctionState *global_state) {
+    auto &state = global_state->Cast<LimitByState>();
+    lock_guard<mutex> guard(state.finish_lock);
+    state.running++;
+    return make_uniq<LimitByLocalState>();
+}
+
+// The given columns of every row, NULLs included, as one comparable blob
+static void LimitBySortKeys(DataChunk &input, const vector<column_t> &columns, vector<OrderModifiers> modifiers,
+                            Vector &result) {
+    vector<LogicalType> types;
+    for (auto column : columns) {
+        types.push_back(input.data[column].GetType());
+    }
+    DataChunk chunk;
+    chunk.InitializeEmpty(types);
+    for (idx_t i = 0; i < columns.size(); i++) {
+        chunk.data[i].Reference(input.data[columns[i]]);
+    }
+    chunk.SetCardinality(input.size());
+    CreateSortKeyHelpers::CreateSortKey(chunk, modifiers, result);
+    result.Flatten(input.size());
+}
+
+// Appends the rows of payload with the given ids, in ascending order, to result.
+// Appends fill every chunk of a collection before starting the next one, so
+// row r sits in chunk r / STANDARD_VECTOR_SIZE.
+static void LimitByGather(ColumnDataCollection &payload, const vector<idx_t> &ids, ColumnDataCollection &result) {
+    DataChunk chunk;
+    payload.InitializeScanChunk(chunk);
+    DataChunk slice;
+    slice.InitializeEmpty(payload.Types());
+    SelectionVector sel(STANDARD_VECTOR_SIZE);
+    for (idx_t i = 0; i < ids.size();) {
+        auto chunk_index = ids[i] / STANDARD_VECTOR_SIZE;
+        chunk.Reset();
+        payload.FetchChunk(chunk_index, chunk);
+        idx_t count = 0;
+        for (; i < ids.size() && ids[i] / STANDARD_VECTOR_SIZE == chunk_index; i++) {
+            sel.set_index(count++, ids[i] % STANDARD_VECTOR_SIZE);
+        }
+        slice.Slice(chunk, sel, count);
+        result.Append(slice);
+    }
+}
+
+// Drops the rows pushed out of the heaps from the payload once they outnumber the kept ones
+static void LimitByCompact(LimitByShard &shard) {
+    if (shard.payload->Count() < 2 * shard.live + STANDARD_VECTOR_SIZE) {
+        return;
+    }
+    vector<reference<LimitByRow>> rows;
+    for (auto &entry : shard.top) {
+        for (auto &row : entry.second) {
+            rows.push_back(row);
+        }
+    }
+    std::sort(rows.begin(), rows.end(),
+              [](const LimitByRow &a, const LimitByRow &b) { return a.row < b.row; });
+    vector<idx_t> ids;
+    for (idx_t i = 0; i < rows.size(); i++) {
+        ids.push_back(rows[i].get().row);
+        rows[i].get().row = i;
+    }
+    auto payload = make_uniq<ColumnDataCollection>(Allocator::DefaultAllocator(), shard.payload->Types());
+    LimitByGather(*shard.payload, ids, *payload);
+    shard.payload = std::move(payload);
+}
+
+static void LimitBySorted(const LimitByData &data, LimitByState &state, LimitByLocalState &local,
+                          const string_t *keys, idx_t rows, vector<bool> &pass) {
+    if (!local.reading) {
+        local.reading = true;
+        if (++state.sorted_readers > 1) {
+            throw InvalidInputException("limit_by: sorted := true needs input that a single thread reads, as "
+                                        "read_parquet_mergetree does");
+        }
+    }
+    for (idx_t i = 0; i < rows; i++) {
+        string_t current(local.current.data(), UnsafeNumericCast<uint32_t>(local.current.size()));
+        if (local.current_count == 0 || !Equals::Operation(current, keys[i])) {
+            local.current = keys[i].GetString();
+            local.current_count = 0;
+        }
+        auto position = local.current_count++;
+        pass[i] = position >= data.offset && position < data.offset + data.limit;
+    }
+}
+
+static OperatorResultType LimitByFunction(ExecutionContext &context, TableFunctionInput &data_p, DataChunk &input,
+                                          DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<LimitByData>();
+    auto &state = data_p.global_state->Cast<LimitByState>();
+    auto &local = data_p.local_state->Cast<LimitByLocalState>();
+    auto rows = input.size();
+    if (rows == 0) {
+        return OperatorResultType::NEED_MORE_INPUT;
+    }
+    vector<OrderModifiers> key_modifiers(data.keys.size(),
+                                         OrderModifiers(OrderType::ASCENDING, OrderByNullType::NULLS_LAST));
+    Vector key_vector(LogicalType::BLOB, rows);
+    LimitBySortKeys(input, data.keys, key_modifiers, key_vector);
+    auto keys = FlatVector::GetData<string_t>(key_vector);
+
+    vector<bool> pass(rows, false);
+    if (data.sorted) {
+        LimitBySorted(data, state, local, keys, rows, pass);
+    } else {
+        bool ordered = !data.order_columns.empty();
+        Vector order_vector(LogicalType::BLOB, rows);
+        if (ordered) {
+            LimitBySortKeys(input, data.order_columns, data.order_modifiers, order_vector);
+        }
+        auto orders = ordered ? FlatVector::GetData<string_t>(order_vector) : nullptr;
+        // the rows of each shard, so that every shard is locked once per chunk
+        idx_t shard_counts[LIMIT_BY_SHARDS + 1] = {0};
+        vector<uint8_t> row_shards(rows);
+        for (idx_t i = 0; i < rows; i++) {
+            row_shards[i] = UnsafeNumericCast<uint8_t>(Hash(keys[i].GetData(), keys[i].GetSize()) % LIMIT_BY_SHARDS);
+            shard_counts[row_shards[i] + 1]++;
+        }
+        for (idx_t s = 0; s < LIMIT_BY_SHARDS; s++) {
+            shard_counts[s + 1] += shard_counts[s];
+        }
+        vector<idx_t> by_shard(rows);
+        idx_t next[LIMIT_BY_SHARDS];
+        memcpy(next, shard_counts, sizeof(next));
+        for (idx_t i = 0; i < rows; i++) {
+            by_shard[next[row_shards[i]]++] = i;
+        }
+        auto capacity = data.offset + data.limit;
+        for (idx_t s = 0; s < LIMIT_BY_SHARDS; s++) {
+            if (shard_counts[s] == shard_counts[s + 1]) {
+                continue;
+            }
+            auto &shard = *state.shards[s];
+            lock_guard<mutex> guard(shard.lock);
+            // the rows entering a heap, appended to the payload in one go
+            SelectionVector entering(shard_counts[s + 1] - shard_counts[s]);
+            idx_t entered = 0;
+            if (ordered && !shard.payload) {
+                shard.payload = make_uniq<ColumnDataCollection>(Allocator::DefaultAllocator(), data.types);
+            }
+            for (idx_t r = shard_counts[s]; r < shard_counts[s + 1]; r++) {
+                auto i = by_shard[r];
+                if (!ordered) {
+                    auto entry = shard.seen.find(keys[i]);
+                    if (entry == shard.seen.end()) {
+                        entry = shard.seen.emplace(shard.heap.AddBlob(keys[i]), 0).first;
+                    }
+                    auto position = entry->second++;
+                    pass[i] = position >= data.offset && position < capacity;
+                    continue;
+                }
+                if (capacity == 0) {
+                    continue;
+                }
+                auto entry = shard.top.find(keys[i]);
+                if (entry == shard.top.end()) {
+                    entry = shard.top.emplace(shard.heap.AddBlob(keys[i]), vector<LimitByRow>()).first;
+                }
+                auto &top = entry->second;
+                if (top.size() == capacity) {
+                    // the key is full: the row only enters ahead of the last one
+                    auto &last = top.front().order;
+                    string_t last_order(last.data(), UnsafeNumericCast<uint32_t>(last.size()));
+                    if (!LessThan::Operation(orders[i], last_order)) {
+                        continue;
+                    }
+                    std::pop_heap(top.begin(), top.end(), LimitByRowBefore);
+                    top.pop_back();
+                    shard.live--;
+                }
+                top.push_back({orders[i].GetString(), shard.payload->Count() + entered});
+                std::push_heap(top.begin(), top.end(), LimitByRowBefore);
+                entering.set_index(entered++, i);
+                shard.live++;
+            }
+            if (entered > 0) {
+                DataChunk slice;
+                slice.InitializeEmpty(input.GetTypes());
+                slice.Slice(input, entering, entered);
+                shard.payload->Append(slice);
+                LimitByCompact(shard);
+            }
+        }
+        if (ordered) {
+            output.SetCardinality(0);
+            return OperatorResultType::NEED_MORE_INPUT;
+        }
+    }
+
+    SelectionVector sel(rows);
+    idx_t count = 0;
+    for (idx_t i = 0; i < rows; i++) {
+        if (pass[i]) {
+            sel.set_index(count++, i);
+        }
+    }
+    if (count == rows) {
+        output.Reference(input);
+    } else {
+        output.Slice(input, sel, count);
+    }
+    return OperatorResultType::NEED_MORE_INPUT;
+}
+
+// Under order_by, the last thread to finish its input emits the rows of all keys
+static OperatorFinalizeResultType LimitByFinal(ExecutionContext &context, TableFunctionInput &data_p,
+                                               DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<LimitByData>();
+    auto &state = data_p.global_state->Cast<LimitByState>();
+    auto &local = data_p.local_state->Cast<LimitByLocalState>();
+    if (data.order_columns.empty()) {
+        return OperatorFinalizeResultType::FINISHED;
+    }
+    if (!local.finished) {
+        local.finished = true;
+        lock_guard<mutex> guard(state.finish_lock);
+        if (--state.running > 0) {
+            return OperatorFinalizeResultType::FINISHED;
+        }
+        local.rows = make_uniq<ColumnDataCollection>(Allocator::DefaultAllocator(), data.types);
+        for (auto &shard : state.shards) {
+            lock_guard<mutex> shard_guard(shard->lock);
+            vector<idx_t> ids;
+            for (auto &entry : shard->top) {
+                auto &top = entry.second;
+                std::sort_heap(top.begin(), top.end(), LimitByRowBefore);
+                for (idx_t k = data.offset; k < top.size(); k++) {
+                    ids.push_back(top[k].row);
+                }
+            }
+            std::sort(ids.begin(), ids.end());
+            if (!ids.empty()) {
+                LimitByGather(*shard->payload, ids, *local.rows);
+            }
+            shard->top.clear();
+            shard->payload.reset();
+        }
+        local.rows->InitializeScan(local.scan);
+    }
+    if (!local.rows) {
+        return OperatorFinalizeResultType::FINISHED;
+    }
+    local.rows->Scan(local.scan, output);
+    return output.size() > 0 ? OperatorFinalizeResultType::HAVE_MORE_OUTPUT : OperatorFinalizeResultType::FINISHED;
+}
+
+TableFunction LimitByTableFunction() {
+    TableFunction function("limit_by", {LogicalType::TABLE, LogicalType::UBIGINT}, nullptr, LimitByBind,
+                           LimitByInitGlobal, LimitByInitLocal);
+    function.varargs = LogicalType::VARCHAR;
+    function.in_out_function = LimitByFunction;
+    function.in_out_function_final = LimitByFinal;
+    function.named_parameters["offset"] = LogicalType::UBIGINT;
+    function.named_parameters["sorted"] = LogicalType::BOOLEAN;
+    function.named_parameters["order_by"] = LogicalType::VARCHAR;
+    return function;
+}
+
+} // namespace duckdb
@@ -0,0 +1,327 @@
+#include "chsql_metrics.hpp"
+#include "chsql_query_cache.hpp"
+#include "chsql_query_log.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/connection_manager.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+namespace duckdb {
+
+struct ChMetricInfo {
+    const char *name;
+    const char *description;
+};
+
+static const ChMetricInfo CH_EVENTS[] = {
+    {"Query", "Queries started"},
+    {"ParquetMergeTreeRowsRead", "Rows returned by read_parquet_mergetree"},
+    {"ParquetMergeTreeBytesRead", "Bytes of the vectors returned by read_parquet_mergetree"},
+    {"ParquetMergeTreeComparisons", "Sort key comparisons made while merging in read_parquet_mergetree"},
+    {"ParquetPartsRowsRead", "Rows returned by read_parquet_parts"},
+    {"ParquetPartsBytesRead", "Bytes of the vectors returned by read_parquet_parts"},
+    {"URLFlockRequests", "Queries sent to remote nodes by url_flock"},
+    {"URLFlockRowsRead", "Rows received by url_flock"},
+    {"URLFlockBytesRead", "Bytes of the vectors received by url_flock"},
+    {"RemoteScanRequests", "Requests sent by ch_scan and url, one per slice"},
+    {"RemoteScanRowsRead", "Rows received by ch_scan and url"},
+    {"RemoteScanBytesRead", "Bytes of the vectors received by ch_scan and url"},
+    {"QueryCacheHits", "Remote results served from the query cache"},
+    {"QueryCacheMisses", "Remote results looked up in the query cache and not found"},
+};
+static_assert(sizeof(CH_EVENTS) / sizeof(CH_EVENTS[0]) == static_cast<idx_t>(ChEvent::COUNT),
+              "every event needs a name");
+
+// -- Sharded counters
+struct ChShardRegistry {
+    std::mutex lock;
+    unordered_set<ChMetrics::Shard *> shards;
+    idx_t retired_events[static_cast<idx_t>(ChEvent::COUNT)] {};
+    int64_t retired_gauges[static_cast<idx_t>(ChGauge::COUNT)] {};
+};
+
+// never destroyed, as threads may still exit after static destruction
+static ChShardRegistry &GetShardRegistry() {
+    static auto registry = new ChShardRegistry();
+    return *registry;
+}
+
+struct ChShardHandle {
+    ChShardHandle() : shard(make_uniq<ChMetrics::Shard>()) {
+        auto &registry = GetShardRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.shards.insert(shard.get());
+    }
+    ~ChShardHandle() {
+        auto &registry = GetShardRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        for (idx_t i = 0; i < static_cast<idx_t>(ChEvent::COUNT); i++) {
+            registry.retired_events[i] += shard->events[i].load(std::memory_order_relaxed);
+        }
+        for (idx_t i = 0; i < static_cast<idx_t>(ChGauge::COUNT); i++) {
+            registry.retired_gauges[i] += shard->gauges[i].load(std::memory_order_relaxed);
+        }
+        registry.shards.erase(shard.get());
+    }
+
+    unique_ptr<ChMetrics::Shard> shard;
+};
+
+ChMetrics::Shard &ChMetrics::LocalShard() {
+    thread_local ChShardHandle handle;
+    return *handle.shard;
+}
+
+vector<idx_t> ChMetrics::Events() {
+    auto &registry = GetShardRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    vector<idx_t> result(registry.retired_events, registry.retired_events + static_cast<idx_t>(ChEvent::COUNT));
+    for (auto shard : registry.shards) {
+        for (idx_t i = 0; i < result.size(); i++) {
+            result[i] += shard->events[i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+vector<int64_t> ChMetrics::Gauges() {
+    auto &registry = GetShardRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    vector<int64_t> result(registry.retired_gauges, registry.retired_gauges + static_cast<idx_t>(ChGauge::COUNT));
+    for (auto shard : registry.shards) {
+        for (idx_t i = 0; i < result.size(); i++) {
+            result[i] += shard->gauges[i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+// -- system.events, system.metrics and system.asynchronous_metrics share
+// one layout: a name, a value and a description per row
+struct SystemMetricRow {
+    string name;
+    Value value;
+    string description;
+};
+
+// Rows are collected at init, so each execution of a prepared statement
+// reads a fresh snapshot
+typedef vector<SystemMetricRow> (*metrics_snapshot_t)(ClientContext &context);
+
+struct SystemMetricsData : public TableFunctionData {
+    explicit SystemMetricsData(metrics_snapshot_t snapshot) : snapshot(snapshot) {
+    }
+    metrics_snapshot_t snapshot;
+};
+
+struct SystemMetricsState : public GlobalTableFunctionState {
+    vector<SystemMetricRow> rows;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> MetricsBind(const char *column, const LogicalType &type, metrics_snapshot_t snapshot,
+                                            vector<LogicalType> &return_types, vector<string> &names) {
+    names.emplace_back(column);
+    names.emplace_back("value");
+    names.emplace_back("description");
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(type);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return make_uniq<SystemMetricsData>(snapshot);
+}
+
+static unique_ptr<GlobalTableFunctionState> SystemMetricsInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto result = make_uniq<SystemMetricsState>();
+    result->rows = input.bind_data->Cast<SystemMetricsData>().snapshot(context);
+    return std::move(result);
+}
+
+static void SystemMetricsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<SystemMetricsState>();
+    idx_t count = 0;
+    while (state.offset < state.rows.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &row = state.rows[state.offset];
+        output.SetValue(0, count, Value(row.name));
+        output.SetValue(1, count, row.value);
+        output.SetValue(2, count, Value(row.description));
+        count++;
+        state.offset++;
+    }
+    output.SetCardinality(count);
+}
+
+static vector<SystemMetricRow> EventsSnapshot(ClientContext &context) {
+    vector<SystemMetricRow> rows;
+    auto events = ChMetrics::Events();
+    for (idx_t i = 0; i < events.size(); i++) {
+        rows.push_back({CH_EVENTS[i].name, Value::UBIGINT(events[i]), CH_EVENTS[i].description});
+    }
+    return rows;
+}
+
+static unique_ptr<FunctionData> SystemEventsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                 vector<LogicalType> &return_types, vector<string> &names) {
+    return MetricsBind("event", LogicalType::UBIGINT, EventsSnapshot, return_types, names);
+}
+
+static vector<SystemMetricRow> MetricsSnapshot(ClientContext &context) {
+    vector<SystemMetricRow> rows;
+    auto gauges = ChMetrics::Gauges();
+    auto &buffer_manager = BufferManager::GetBufferManager(context);
+    auto cache = RemoteResultCache::Get(context).GetStats();
+    auto add = [&](const char *name, int64_t value, const char *description) {
+        rows.push_back({name, Value::BIGINT(value), description});
+    };
+    add("Query", NumericCast<int64_t>(QueryLog::Get(context).GetRunning().size()), "Queries running");
+    add("Connection", NumericCast<int64_t>(ConnectionManager::Get(context).GetConnectionCount()),
+        "Open connections to the database");
+    add("GlobalThread", NumericCast<int64_t>(TaskScheduler::GetScheduler(context).NumberOfThreads()),
+        "Threads of the database's task scheduler");
+    add("MemoryTracking", NumericCast<int64_t>(buffer_manager.GetUsedMemory()),
+        "Bytes held by the buffer manager");
+    add("MemoryLimit", NumericCast<int64_t>(buffer_manager.GetMaxMemory()), "Memory limit of the buffer manager");
+    add("OpenParquetReaders", gauges[static_cast<idx_t>(ChGauge::OPEN_PARQUET_READERS)],
+        "Parquet files open in read_parquet_mergetree and read_parquet_parts");
+    add("QueryCacheEntries", NumericCast<int64_t>(cache.entries), "Results held by the remote query cache");
+    add("QueryCacheBytes", NumericCast<int64_t>(cache.bytes), "Bytes held by the remote query cache");
+    return rows;
+}
+
+static unique_ptr<FunctionData> SystemMetricsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                  vector<LogicalType> &return_types, vector<string> &names) {
+    return MetricsBind("metric", LogicalType::BIGINT, MetricsSnapshot, return_types, names);
+}
+
+// -- Process statistics from /proc, sampled at most once per second
+struct ProcessSample {
+    std::chrono::steady_clock::time_point time;
+    bool valid = false;
+    double resident = 0;
+    double virtual_memory = 0;
+    double user_seconds = 0;
+    double system_seconds = 0;
+    double threads = 0;
+    double file_descriptors = 0;
+};
+
+static ProcessSample ReadProcessSample() {
+    ProcessSample sample;
+    sample.time = std::chrono::steady_clock::now();
+#ifdef __linux__
+    double page_size = static_cast<double>(sysconf(_SC_PAGESIZE));
+    double ticks = static_cast<double>(sysconf(_SC_CLK_TCK));
+    std::ifstream statm("/proc/self/statm");
+    double pages_virtual, pages_resident;
+    if (!(statm >> pages_virtual >> pages_resident)) {
+        return sample;
+    }
+    sample.virtual_memory = pages_virtual * page_size;
+    sample.resident = pages_resident * page_size;
+
+    std::ifstream stat_file("/proc/self/stat");
+    std::stringstream buffer;
+    buffer << stat_file.rdbuf();
+    auto stat = buffer.str();
+    // the fields after the parenthesized command name, starting with field 3
+    auto close = stat.rfind(')');
+    if (close == string::npos) {
+        return sample;
+    }
+    auto fields = StringUtil::Split(stat.substr(close + 2), ' ');
+    if (fields.size() < 18) {
+        return sample;
+    }
+    sample.user_seconds = std::stod(fields[11]) / ticks;
+    sample.system_seconds = std::stod(fields[12]) / ticks;
+    sample.threads = std::stod(fields[17]);
+
+    auto directory = opendir("/proc/self/fd");
+    if (directory) {
+        idx_t count = 0;
+        while (auto entry = readdir(directory)) {
+            count += entry->d_name[0] != '.';
+        }
+        closedir(directory);
+        // not counting the descriptor of the listing itself
+        sample.file_descriptors = static_cast<double>(count > 0 ? count - 1 : 0);
+    }
+    sample.valid = true;
+#endif
+    return sample;
+}
+
+struct ProcessSampler {
+    std::mutex lock;
+    ProcessSample previous;
+    ProcessSample last;
+};
+
+static vector<SystemMetricRow> AsynchronousMetricsSnapshot(ClientContext &context) {
+    vector<SystemMetricRow> rows;
+    static ProcessSampler sampler;
+    ProcessSample previous, last;
+    {
+        std::lock_guard<std::mutex> guard(sampler.lock);
+        auto now = std::chrono::steady_clock::now();
+        if (!sampler.last.valid || now - sampler.last.time >= std::chrono::seconds(1)) {
+            auto sample = ReadProcessSample();
+            if (sample.valid) {
+                sampler.previous = sampler.last;
+                sampler.last = sample;
+            }
+        }
+        previous = sampler.previous;
+        last = sampler.last;
+    }
+    if (!last.valid) {
+        return rows;
+    }
+    auto add = [&](const char *name, double value, const char *description) {
+        rows.push_back({name, Value::DOUBLE(value), description});
+    };
+    add("MemoryResident", last.resident, "Resident set size of the process in bytes");
+    add("MemoryVirtual", last.virtual_memory, "Virtual memory of the process in bytes");
+    add("OSUserTimeCPU", last.user_seconds, "CPU seconds the process spent in user mode");
+    add("OSSystemTimeCPU", last.system_seconds, "CPU seconds the process spent in the kernel");
+    add("OSThreads", last.threads, "Threads of the process");
+    add("OpenFileDescriptors", last.file_descriptors, "File descriptors open in the process");
+    if (previous.valid) {
+        auto wall = std::chrono::duration<double>(last.time - previous.time).count();
+        auto cpu = last.user_seconds + last.system_seconds - previous.user_seconds - previous.system_seconds;
+        add("ProcessCPUUsage", wall > 0 ? cpu / wall : 0,
+            "CPU cores in use by the process between the last two samples");
+    }
+    return rows;
+}
+
+static unique_ptr<FunctionData> SystemAsynchronousMetricsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                              vector<LogicalType> &return_types,
+                                                              vector<string> &names) {
+    return MetricsBind("metric", LogicalType::DOUBLE, AsynchronousMetricsSnapshot, return_types, names);
+}
+
+void RegisterMetricsFunctions(DatabaseInstance &instance) {
+    auto events_func = TableFunction("system_events", {}, SystemMetricsFunction, SystemEventsBind, SystemMetricsInit);
+    ExtensionUtil::RegisterFunction(instance, events_func);
+
+    auto metrics_func =
+        TableFunction("system_metrics", {}, SystemMetricsFunction, SystemMetricsBind, SystemMetricsInit);
+    ExtensionUtil::RegisterFunction(instance, metrics_func);
+
+    auto async_func = TableFunction("system_asynchronous_metrics", {}, SystemMetricsFunction,
+                                    SystemAsynchronousMetricsBind, SystemMetricsInit);
+    ExtensionUtil::RegisterFunction(instance, async_func);
+}
+
+} // namespace duckdb
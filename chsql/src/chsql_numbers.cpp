@@ -0,0 +1,121 @@
+#include "chsql_extension.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+namespace duckdb {
+
+// Threads claim the range in morsels of one row group each
+static constexpr idx_t NUMBERS_MORSEL_SIZE = 60 * STANDARD_VECTOR_SIZE;
+
+struct NumbersData : public TableFunctionData {
+    uint64_t offset = 0;
+    uint64_t count = 0;
+};
+
+struct NumbersState : public GlobalTableFunctionState {
+    idx_t morsels = 0;
+    atomic<idx_t> next_morsel {0};
+
+    idx_t MaxThreads() const override {
+        return MaxValue<idx_t>(morsels, 1);
+    }
+};
+
+struct NumbersLocalState : public LocalTableFunctionState {
+    // also the batch index, so DuckDB can put the morsels back in order
+    idx_t morsel = DConstants::INVALID_INDEX;
+    uint64_t position = 0;
+    uint64_t end = 0;
+};
+
+static uint64_t NumbersParameter(const string &name, const Value &value) {
+    if (value.IsNull()) {
+        throw BinderException("%s: arguments cannot be NULL", name);
+    }
+    return value.GetValue<uint64_t>();
+}
+
+// numbers() counts up without end, numbers(count) from 0 and
+// numbers(offset, count) from offset
+static unique_ptr<FunctionData> NumbersBind(ClientContext &context, TableFunctionBindInput &input,
+                                            vector<LogicalType> &return_types, vector<string> &names) {
+    auto &name = input.table_function.name;
+    auto data = make_uniq<NumbersData>();
+    data->count = NumericLimits<uint64_t>::Maximum();
+    if (input.inputs.size() == 1) {
+        data->count = NumbersParameter(name, input.inputs[0]);
+    } else if (input.inputs.size() == 2) {
+        data->offset = NumbersParameter(name, input.inputs[0]);
+        data->count = NumbersParameter(name, input.inputs[1]);
+    }
+    data->count = MinValue(data->count, NumericLimits<uint64_t>::Maximum() - data->offset);
+    return_types.push_back(LogicalType::UBIGINT);
+    names.emplace_back("number");
+    return std::move(data);
+}
+
+static unique_ptr<GlobalTableFunctionState> NumbersInitGlobal(ClientContext &context, TableFunctionInitInput &input) {
+    auto &data = input.bind_data->Cast<NumbersData>();
+    auto state = make_uniq<NumbersState>();
+    state->morsels = data.count / NUMBERS_MORSEL_SIZE + (data.count % NUMBERS_MORSEL_SIZE != 0);
+    return std::move(state);
+}
+
+static unique_ptr<LocalTableFunctionState> NumbersInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                            GlobalTableFunctionState *global_state) {
+    return make_uniq<NumbersLocalState>();
+}
+
+static void NumbersFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<NumbersData>();
+    auto &state = data_p.global_state->Cast<NumbersState>();
+    auto &local = data_p.local_state->Cast<NumbersLocalState>();
+    if (local.position == local.end) {
+        auto morsel = state.next_morsel++;
+        if (morsel >= state.morsels) {
+            return;
+        }
+        auto begin = morsel * NUMBERS_MORSEL_SIZE;
+        local.morsel = morsel;
+        local.position = data.offset + begin;
+        local.end = data.offset + begin + MinValue<uint64_t>(NUMBERS_MORSEL_SIZE, data.count - begin);
+    }
+    auto rows = MinValue<uint64_t>(STANDARD_VECTOR_SIZE, local.end - local.position);
+    auto values = FlatVector::GetData<uint64_t>(output.data[0]);
+    auto start = local.position;
+    for (idx_t i = 0; i < rows; i++) {
+        values[i] = start + i;
+    }
+    local.position += rows;
+    output.SetCardinality(rows);
+}
+
+static OperatorPartitionData NumbersPartitionData(ClientContext &context, TableFunctionGetPartitionInput &input) {
+    if (input.partition_info.RequiresPartitionColumns()) {
+        throw InternalException("numbers: partition columns are not supported");
+    }
+    return OperatorPartitionData(input.local_state->Cast<NumbersLocalState>().morsel);
+}
+
+static unique_ptr<NodeStatistics> NumbersCardinality(ClientContext &context, const FunctionData *bind_data) {
+    auto &data = bind_data->Cast<NumbersData>();
+    return make_uniq<NodeStatistics>(data.count, data.count);
+}
+
+void RegisterNumbersFunctions(DatabaseInstance &instance) {
+    // numbers_mt is the same scan: both run on all threads and DuckDB keeps
+    // the order where the query needs it
+    for (auto name : {"numbers", "numbers_mt"}) {
+        TableFunctionSet set(name);
+        for (idx_t args = 0; args <= 2; args++) {
+            TableFunction function(vector<LogicalType>(args, LogicalType::UBIGINT), NumbersFunction, NumbersBind,
+                                   NumbersInitGlobal, NumbersInitLocal);
+            function.cardinality = NumbersCardinality;
+            function.get_partition_data = NumbersPartitionData;
+            set.AddFunction(function);
+        }
+        ExtensionUtil::RegisterFunction(instance, set);
+    }
+}
+
+} // namespace duckdb
@@ -0,0 +1,888 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/string_util.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/prepared_statement.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/parser/parser.hpp"
+#include "duckdb/parser/parser_extension.hpp"
+
+namespace duckdb {
+
+// DuckDB hands every statement its own parser rejects to the parser
+// extensions. This one rewrites the ClickHouse-only clauses into DuckDB SQL
+// over the extension's operators and parses the result again. The planner
+// scans it through chsql_statement, which runs it on a connection of its own
+// to the same database: it sees the committed data and the settings of the
+// client, not its temporary tables or open transaction.
+//
+//   FROM t FINAL                  the modifier is dropped
+//   FROM t SAMPLE k [OFFSET m]    sample := k of read_parquet_mergetree and
+//                                 read_parquet_parts, else TABLESAMPLE
+//   PREWHERE cond                 prewhere := 'cond' of the Parquet scans,
+//                                 else a conjunct of WHERE
+//   [LEFT] ARRAY JOIN a [AS x]    array_join((...), 'a', left := true)
+//   GROUP BY k WITH TOTALS        GROUPING SETS ((k), ()); WITH ROLLUP and
+//                                 WITH CUBE become ROLLUP (k) and CUBE (k)
+//   LIMIT n [OFFSET m] BY k       limit_by((...), n, 'k', offset := m), in
+//                                 sorted mode over the sort key of
+//                                 read_parquet_mergetree; after ORDER BY the
+//                                 ORDER BY expressions, positions resolved
+//                                 against the select list, become hidden
+//                                 columns that limit_by orders by and the
+//                                 result is sorted by
+//   LIMIT m, n                    LIMIT n OFFSET m
+//   FORMAT f, SETTINGS k = v      dropped: results go to the client as is
+//   `identifier`                  "identifier"
+
+enum class ChTokenType : uint8_t { WORD, STRING, IDENTIFIER, NUMBER, SYMBOL, SPACE };
+
+struct ChToken {
+    ChTokenType type;
+    string text;
+};
+
+static vector<ChToken> TokenizeClickHouse(const string &query, bool &changed) {
+    vector<ChToken> result;
+    idx_t i = 0;
+    auto n = query.size();
+    auto is_word = [](char c) { return StringUtil::CharacterIsAlphaNumeric(c) || c == '_' || c == '$'; };
+    while (i < n) {
+        auto c = query[i];
+        auto start = i;
+        ChTokenType type;
+        if (StringUtil::CharacterIsSpace(c)) {
+            while (i < n && StringUtil::CharacterIsSpace(query[i])) {
+                i++;
+            }
+            type = ChTokenType::SPACE;
+        } else if (c == '-' && i + 1 < n && query[i + 1] == '-') {
+            while (i < n && query[i] != '\n') {
+                i++;
+            }
+            type = ChTokenType::SPACE;
+        } else if (c == '/' && i + 1 < n && query[i + 1] == '*') {
+            auto close = query.find("*/", i + 2);
+            i = close == string::npos ? n : close + 2;
+            type = ChTokenType::SPACE;
+        } else if (c == '\'' || c == '"' || c == '`') {
+            i++;
+            while (i < n) {
+                if (query[i] == '\\' && c == '\'' && i + 1 < n) {
+                    i += 2;
+                } else if (query[i] == c && i + 1 < n && query[i + 1] == c) {
+                    i += 2;
+                } else if (query[i] == c) {
+                    i++;
+                    break;
+                } else {
+                    i++;
+                }
+            }
+            type = c == '\'' ? ChTokenType::STRING : ChTokenType::IDENTIFIER;
+        } else if (StringUtil::CharacterIsDigit(c) || (c == '.' && i + 1 < n && StringUtil::CharacterIsDigit(query[i + 1]))) {
+            while (i < n && (is_word(query[i]) || query[i] == '.' ||
+                             ((query[i] == '+' || query[i] == '-') && (query[i - 1] == 'e' || query[i - 1] == 'E')))) {
+                i++;
+            }
+            type = ChTokenType::NUMBER;
+        } else if (is_word(c)) {
+            while (i < n && is_word(query[i])) {
+                i++;
+            }
+            type = ChTokenType::WORD;
+        } else {
+            i++;
+            type = ChTokenType::SYMBOL;
+        }
+        auto text = query.substr(start, i - start);
+        if (c == '`') {
+            // backquoted identifiers are double quoted in DuckDB
+            auto inner = text.substr(1, text.size() > 1 ? text.size() - 2 : 0);
+            inner = StringUtil::Replace(inner, "``", "`");
+            text = "\"" + StringUtil::Replace(inner, "\"", "\"\"") + "\"";
+            changed = true;
+        }
+        result.push_back(ChToken {type, std::move(text)});
+    }
+    return result;
+}
+
+// A token, or a parenthesized group that is already rewritten
+struct ChNode {
+    ChTokenType type;
+    string text;
+    // upper case, for words
+    string word;
+    bool group = false;
+    vector<ChNode> children;
+};
+
+static string RenderNodes(const vector<ChNode> &nodes, idx_t begin, idx_t end) {
+    string result;
+    for (idx_t i = begin; i < end && i < nodes.size(); i++) {
+        result += nodes[i].text;
+    }
+    return result;
+}
+
+static idx_t NextSignificant(const vector<ChNode> &nodes, idx_t i, idx_t end) {
+    for (i++; i < end; i++) {
+        if (nodes[i].type != ChTokenType::SPACE) {
+            return i;
+        }
+    }
+    return DConstants::INVALID_INDEX;
+}
+
+static idx_t PreviousSignificant(const vector<ChNode> &nodes, idx_t i, idx_t begin) {
+    while (i > begin) {
+        i--;
+        if (nodes[i].type != ChTokenType::SPACE) {
+            return i;
+        }
+    }
+    return DConstants::INVALID_INDEX;
+}
+
+static bool IsQuery(const vector<ChNode> &nodes) {
+    auto first = NextSignificant(nodes, DConstants::INVALID_INDEX, nodes.size());
+    if (nodes.empty() || first == DConstants::INVALID_INDEX) {
+        return false;
+    }
+    auto &word = nodes[first].word;
+    return word == "SELECT" || word == "WITH" || word == "FROM";
+}
+
+static string RewriteQuery(vector<ChNode> &nodes, bool &changed);
+
+static vector<ChNode> ReadNodes(const vector<ChToken> &tokens, idx_t &position, bool &changed) {
+    vector<ChNode> nodes;
+    while (position < tokens.size()) {
+        auto &token = tokens[position];
+        if (token.type == ChTokenType::SYMBOL && token.text == ")") {
+            return nodes;
+        }
+        position++;
+        ChNode node;
+        node.type = token.type;
+        if (token.type == ChTokenType::SYMBOL && token.text == "(") {
+            node.children = ReadNodes(tokens, position, changed);
+            if (position < tokens.size()) {
+                position++;
+            }
+            node.group = true;
+            node.text = "(" +
+                        (IsQuery(node.children) ? RewriteQuery(node.children, changed)
+                                                : RenderNodes(node.children, 0, node.children.size())) +
+                        ")";
+        } else {
+            node.text = token.text;
+            if (token.type == ChTokenType::WORD) {
+                node.word = StringUtil::Upper(token.text);
+            }
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+static string QuoteString(const string &text) {
+    return "'" + StringUtil::Replace(text, "'", "''") + "'";
+}
+
+static string IdentifierName(const ChNode &node) {
+    if (node.type == ChTokenType::IDENTIFIER) {
+        return StringUtil::Replace(node.text.substr(1, node.text.size() - 2), "\"\"", "\"");
+    }
+    return node.text;
+}
+
+// The ratio or row count of SAMPLE and OFFSET, written as k or a/b
+static double ParseSampleNumber(const vector<ChNode> &nodes, idx_t &i, idx_t end) {
+    if (i == DConstants::INVALID_INDEX || nodes[i].type != ChTokenType::NUMBER) {
+        throw ParserException("SAMPLE expects a number");
+    }
+    auto value = std::stod(nodes[i].text);
+    auto next = NextSignificant(nodes, i, end);
+    if (next != DConstants::INVALID_INDEX && nodes[next].text == "/") {
+        auto divisor = NextSignificant(nodes, next, end);
+        if (divisor == DConstants::INVALID_INDEX || nodes[divisor].type != ChTokenType::NUMBER) {
+            throw ParserException("SAMPLE expects a number");
+        }
+        value /= std::stod(nodes[divisor].text);
+        next = NextSignificant(nodes, divisor, end);
+    }
+    i = next;
+    return value;
+}
+
+// The group of read_parquet_mergetree(...) or read_parquet_parts(...) that
+// the table reference ending before end consists of, if it does
+static idx_t FindParquetScan(const vector<ChNode> &nodes, idx_t begin, idx_t end) {
+    auto i = PreviousSignificant(nodes, end, begin);
+    // alias
+    if (i != DConstants::INVALID_INDEX && !nodes[i].group &&
+        (nodes[i].type == ChTokenType::WORD || nodes[i].type == ChTokenType::IDENTIFIER)) {
+        i = PreviousSignificant(nodes, i, begin);
+        if (i != DConstants::INVALID_INDEX && nodes[i].word == "AS") {
+            i = PreviousSignificant(nodes, i, begin);
+        }
+    }
+    if (i == DConstants::INVALID_INDEX || !nodes[i].group) {
+        return DConstants::INVALID_INDEX;
+    }
+    auto function = PreviousSignificant(nodes, i, begin);
+    if (function == DConstants::INVALID_INDEX ||
+        (nodes[function].word != "READ_PARQUET_MERGETREE" && nodes[function].word != "READ_PARQUET_PARTS")) {
+        return DConstants::INVALID_INDEX;
+    }
+    return i;
+}
+
+static void AddNamedParameter(ChNode &call, const string &parameter) {
+    call.text.pop_back();
+    call.text += ", " + parameter + ")";
+}
+
+// The sort key argument of read_parquet_mergetree, empty for other scans
+static string ParquetSortKey(const vector<ChNode> &nodes, idx_t call) {
+    if (nodes[PreviousSignificant(nodes, call, 0)].word != "READ_PARQUET_MERGETREE") {
+        return "";
+    }
+    auto &arguments = nodes[call].children;
+    idx_t commas = 0;
+    for (idx_t i = 0; i < arguments.size(); i++) {
+        if (arguments[i].text == ",") {
+            commas++;
+        } else if (commas == 1 && arguments[i].type == ChTokenType::STRING) {
+            auto &text = arguments[i].text;
+            return StringUtil::Replace(text.substr(1, text.size() - 2), "''", "'");
+        }
+    }
+    return "";
+}
+
+struct ChClause {
+    string kind;
+    // the keywords
+    idx_t start;
+    // the body
+    idx_t begin;
+    idx_t end;
+};
+
+struct ChLimit {
+    string limit;
+    string offset;
+    bool comma = false;
+    vector<string> by;
+};
+
+static ChLimit ParseLimit(const vector<ChNode> &nodes, idx_t begin, idx_t end) {
+    ChLimit result;
+    idx_t by = end;
+    idx_t comma = DConstants::INVALID_INDEX;
+    idx_t offset = DConstants::INVALID_INDEX;
+    for (idx_t i = begin; i < end; i++) {
+        if (nodes[i].word == "BY") {
+            by = i;
+            break;
+        }
+        if (nodes[i].text == "," && comma == DConstants::INVALID_INDEX) {
+            comma = i;
+        } else if (nodes[i].word == "OFFSET") {
+            offset = i;
+        }
+    }
+    if (comma != DConstants::INVALID_INDEX) {
+        result.comma = true;
+        result.offset = RenderNodes(nodes, begin, comma);
+        result.limit = RenderNodes(nodes, comma + 1, by);
+    } else if (offset != DConstants::INVALID_INDEX) {
+        result.limit = RenderNodes(nodes, begin, offset);
+        result.offset = RenderNodes(nodes, offset + 1, by);
+    } else {
+        result.limit = RenderNodes(nodes, begin, by);
+    }
+    StringUtil::Trim(result.limit);
+    StringUtil::Trim(result.offset);
+    if (by == end) {
+        return result;
+    }
+    // BY takes output columns, which limit_by finds by name
+    string key;
+    for (idx_t i = by + 1; i <= end; i++) {
+        if (i == end || nodes[i].text == ",") {
+            if (key.empty()) {
+                throw ParserException("LIMIT BY expects a list of columns");
+            }
+            result.by.push_back(key);
+            key.clear();
+            continue;
+        }
+        if (nodes[i].type == ChTokenType::SPACE || nodes[i].text == ".") {
+            continue;
+        }
+        if ((nodes[i].type != ChTokenType::WORD && nodes[i].type != ChTokenType::IDENTIFIER) || nodes[i].group) {
+            throw ParserException("LIMIT BY supports column names only, got %s", nodes[i].text);
+        }
+        // the last part of a qualified name
+        key = IdentifierName(nodes[i]);
+    }
+    return result;
+}
+
+// The [begin, end) ranges of the items of a comma separated list
+static vector<pair<idx_t, idx_t>> SplitList(const vector<ChNode> &nodes, idx_t begin, idx_t end) {
+    vector<pair<idx_t, idx_t>> result;
+    idx_t item_begin = begin;
+    for (idx_t i = begin; i <= end; i++) {
+        if (i == end || nodes[i].text == ",") {
+            result.emplace_back(item_begin, i);
+            item_begin = i + 1;
+        }
+    }
+    return result;
+}
+
+// The expressions of the select list, without their aliases
+static vector<string> SelectExpressions(const vector<ChNode> &nodes, idx_t end) {
+    idx_t begin = 0;
+    while (begin < end && nodes[begin].word != "SELECT") {
+        begin++;
+    }
+    if (begin == end) {
+        return vector<string>();
+    }
+    auto next = NextSignificant(nodes, begin, end);
+    begin = next != DConstants::INVALID_INDEX && (nodes[next].word == "DISTINCT" || nodes[next].word == "ALL")
+                ? next + 1
+                : begin + 1;
+    vector<string> result;
+    for (auto &item : SplitList(nodes, begin, end)) {
+        auto expression_end = item.second;
+        auto last = PreviousSignificant(nodes, item.second, item.first);
+        auto before = last == DConstants::INVALID_INDEX ? last : PreviousSignificant(nodes, last, item.first);
+        if (before != DConstants::INVALID_INDEX && !nodes[last].group &&
+            (nodes[last].type == ChTokenType::IDENTIFIER ||
+             (nodes[last].type == ChTokenType::WORD && !KeywordHelper::IsKeyword(nodes[last].text)))) {
+            if (nodes[before].word == "AS") {
+                expression_end = before;
+            } else if (nodes[before].group || nodes[before].type == ChTokenType::NUMBER ||
+                       nodes[before].type == ChTokenType::STRING || nodes[before].type == ChTokenType::IDENTIFIER ||
+                       (nodes[before].type == ChTokenType::WORD && !KeywordHelper::IsKeyword(nodes[before].text))) {
+                // expression alias, without AS
+                expression_end = last;
+            }
+        }
+        auto expression = RenderNodes(nodes, item.first, expression_end);
+        StringUtil::Trim(expression);
+        result.push_back(expression);
+    }
+    return result;
+}
+
+struct ChOrderItem {
+    string expression;
+    // ASC, DESC, NULLS FIRST and NULLS LAST as written
+    string modifiers;
+};
+
+// The items of ORDER BY, positions replaced by the expressions of the select list
+static vector<ChOrderItem> ParseOrderBy(const vector<ChNode> &nodes, idx_t head_end, idx_t begin, idx_t end) {
+    vector<ChOrderItem> result;
+    vector<string> select;
+    for (auto &item : SplitList(nodes, begin, end)) {
+        auto expression_end = item.second;
+        while (true) {
+            auto last = PreviousSignificant(nodes, expression_end, item.first);
+            if (last == DConstants::INVALID_INDEX) {
+                break;
+            }
+            auto &word = nodes[last].word;
+            if (word != "ASC" && word != "DESC" && word != "ASCENDING" && word != "DESCENDING" && word != "NULLS" &&
+                word != "FIRST" && word != "LAST") {
+                break;
+            }
+            expression_end = last;
+        }
+        ChOrderItem order;
+        order.expression = RenderNodes(nodes, item.first, expression_end);
+        order.modifiers = RenderNodes(nodes, expression_end, item.second);
+        StringUtil::Trim(order.expression);
+        StringUtil::Trim(order.modifiers);
+        if (order.expression.empty()) {
+            throw ParserException("ORDER BY expects a list of expressions");
+        }
+        auto first = NextSignificant(nodes, item.first - 1, expression_end);
+        auto second = NextSignificant(nodes, first, expression_end);
+        if (nodes[first].type == ChTokenType::NUMBER && second == DConstants::INVALID_INDEX) {
+            // ORDER BY 2 is the second column of the result
+            if (select.empty()) {
+                select = SelectExpressions(nodes, head_end);
+            }
+            auto position = std::stoull(nodes[first].text);
+            if (position == 0 || position > select.size()) {
+                throw ParserException("ORDER BY position %s is not in the select list", nodes[first].text);
+            }
+            auto &expression = select[position - 1];
+            if (StringUtil::StartsWith(expression, "*") || StringUtil::EndsWith(expression, ".*") ||
+                StringUtil::StartsWith(StringUtil::Upper(expression), "COLUMNS(")) {
+                throw ParserException("ORDER BY position %s refers to a star expression", nodes[first].text);
+            }
+            order.expression = expression;
+        }
+        result.push_back(order);
+    }
+    return result;
+}
+
+static string LowerArrayJoin(const string &source, const string &source_alias, const vector<ChNode> &nodes,
+                             idx_t begin, idx_t end, bool left, const string &condition) {
+    // the arrays become columns of the subquery, which array_join expands
+    string added;
+    string columns;
+    idx_t item_begin = begin;
+    for (idx_t i = begin; i <= end; i++) {
+        if (i != end && nodes[i].text != ",") {
+            continue;
+        }
+        // expression [AS alias]
+        idx_t expression_end = i;
+        string alias;
+        auto last = PreviousSignificant(nodes, i, item_begin);
+        auto as = last == DConstants::INVALID_INDEX ? last : PreviousSignificant(nodes, last, item_begin);
+        if (as != DConstants::INVALID_INDEX && nodes[as].word == "AS") {
+            alias = nodes[last].text;
+            columns += ", " + QuoteString(IdentifierName(nodes[last]));
+            expression_end = as;
+        }
+        auto expression = StringUtil::Replace(RenderNodes(nodes, item_begin, expression_end), "\n", " ");
+        StringUtil::Trim(expression);
+        if (expression.empty()) {
+            throw ParserException("ARRAY JOIN expects a list of arrays");
+        }
+        if (alias.empty()) {
+            // the array column itself turns into its elements
+            auto name = PreviousSignificant(nodes, expression_end, item_begin);
+            if (name == DConstants::INVALID_INDEX ||
+                (nodes[name].type != ChTokenType::WORD && nodes[name].type != ChTokenType::IDENTIFIER)) {
+                throw ParserException("ARRAY JOIN of an expression needs an alias: %s", expression);
+            }
+            columns += ", " + QuoteString(IdentifierName(nodes[name]));
+        } else {
+            added += ", " + expression + " AS " + alias;
+        }
+        item_begin = i + 1;
+    }
+    string result = "array_join((SELECT *" + added + " FROM " + source;
+    if (!condition.empty()) {
+        result += " WHERE " + condition;
+    }
+    result += ")" + columns;
+    if (left) {
+        result += ", left := true";
+    }
+    return result + ") AS " + (source_alias.empty() ? "array_join" : source_alias);
+}
+
+static string RewriteSelect(vector<ChNode> &nodes, bool &changed) {
+    auto end = nodes.size();
+    vector<ChClause> clauses;
+    for (idx_t i = 0; i < end; i++) {
+        auto &word = nodes[i].word;
+        if (word.empty()) {
+            continue;
+        }
+        auto next = NextSignificant(nodes, i, end);
+        auto previous = PreviousSignificant(nodes, i, 0);
+        if (previous != DConstants::INVALID_INDEX && nodes[previous].text == ".") {
+            continue;
+        }
+        bool call = next != DConstants::INVALID_INDEX && nodes[next].group;
+        string kind;
+        idx_t start = i;
+        idx_t begin = i + 1;
+        if (word == "FROM") {
+            if (std::any_of(clauses.begin(), clauses.end(), [](const ChClause &c) { return c.kind == "FROM"; })) {
+                continue;
+            }
+            kind = word;
+        } else if ((word == "PREWHERE" || word == "WHERE" || word == "HAVING" || word == "QUALIFY" ||
+                    word == "WINDOW" || word == "FORMAT" || word == "SETTINGS" || word == "LIMIT") &&
+                   !call) {
+            kind = word;
+        } else if ((word == "GROUP" || word == "ORDER") && next != DConstants::INVALID_INDEX &&
+                   nodes[next].word == "BY") {
+            kind = word + " BY";
+            begin = next + 1;
+        } else if (word == "ARRAY" && next != DConstants::INVALID_INDEX && nodes[next].word == "JOIN") {
+            kind = "ARRAY JOIN";
+            begin = next + 1;
+            if (previous != DConstants::INVALID_INDEX && (nodes[previous].word == "LEFT" || nodes[previous].word == "INNER")) {
+                if (nodes[previous].word == "LEFT") {
+                    kind = "LEFT ARRAY JOIN";
+                }
+                start = previous;
+            }
+        } else {
+            continue;
+        }
+        if (!clauses.empty()) {
+            clauses.back().end = start;
+        }
+        clauses.push_back(ChClause {kind, start, begin, end});
+        i = begin - 1;
+    }
+    auto head_end = clauses.empty() ? end : clauses[0].start;
+
+    const ChClause *from = nullptr, *array_join = nullptr, *prewhere = nullptr, *where = nullptr, *group_by = nullptr,
+                   *order_by = nullptr;
+    vector<const ChClause *> passed;
+    vector<ChLimit> limits;
+    for (auto &clause : clauses) {
+        if (clause.kind == "FROM") {
+            from = &clause;
+        } else if (clause.kind == "ARRAY JOIN" || clause.kind == "LEFT ARRAY JOIN") {
+            array_join = &clause;
+            changed = true;
+        } else if (clause.kind == "PREWHERE") {
+            prewhere = &clause;
+            changed = true;
+        } else if (clause.kind == "WHERE") {
+            where = &clause;
+        } else if (clause.kind == "GROUP BY") {
+            group_by = &clause;
+        } else if (clause.kind == "LIMIT") {
+            limits.push_back(ParseLimit(nodes, clause.begin, clause.end));
+            changed |= limits.back().comma || !limits.back().by.empty();
+        } else if (clause.kind == "FORMAT" || clause.kind == "SETTINGS") {
+            changed = true;
+        } else {
+            if (clause.kind == "ORDER BY") {
+                order_by = &clause;
+            }
+            passed.push_back(&clause);
+        }
+    }
+    // under LIMIT BY the ORDER BY picks the rows of every key, see below
+    vector<ChOrderItem> order_items;
+    if (order_by &&
+        std::any_of(limits.begin(), limits.end(), [](const ChLimit &limit) { return !limit.by.empty(); })) {
+        order_items = ParseOrderBy(nodes, head_end, order_by->begin, order_by->end);
+        passed.erase(std::find(passed.begin(), passed.end(), order_by));
+        changed = true;
+    }
+
+    // FINAL and SAMPLE in the FROM clause
+    idx_t scan = DConstants::INVALID_INDEX;
+    string source;
+    string source_alias;
+    if (from) {
+        for (idx_t i = from->begin; i < from->end; i++) {
+            auto next = NextSignificant(nodes, i, from->end);
+            if (nodes[i].word == "FINAL" && (next == DConstants::INVALID_INDEX || !nodes[next].group)) {
+                nodes[i].text = "";
+                changed = true;
+            } else if (nodes[i].word == "SAMPLE" && next != DConstants::INVALID_INDEX &&
+                       nodes[next].type == ChTokenType::NUMBER) {
+                auto table_end = i;
+                auto position = next;
+                auto ratio = ParseSampleNumber(nodes, position, from->end);
+                double offset = 0;
+                bool has_offset = position != DConstants::INVALID_INDEX && nodes[position].word == "OFFSET";
+                if (has_offset) {
+                    position = NextSignificant(nodes, position, from->end);
+                    offset = ParseSampleNumber(nodes, position, from->end);
+                }
+                auto sample_end = position == DConstants::INVALID_INDEX ? from->end : position;
+                for (idx_t j = i; j < sample_end; j++) {
+                    nodes[j].text = "";
+                }
+                auto call = FindParquetScan(nodes, from->begin, table_end);
+                if (call != DConstants::INVALID_INDEX) {
+                    AddNamedParameter(nodes[call], "sample := " + std::to_string(ratio));
+                    if (has_offset) {
+                        AddNamedParameter(nodes[call], "sample_offset := " + std::to_string(offset));
+                    }
+                } else if (ratio > 1) {
+                    nodes[i].text = "TABLESAMPLE reservoir(" + std::to_string(static_cast<int64_t>(ratio)) + " ROWS) ";
+                } else {
+                    nodes[i].text = "TABLESAMPLE system(" + std::to_string(ratio * 100) + "%) ";
+                }
+                changed = true;
+                i = sample_end - 1;
+            }
+        }
+        // a single table reference is what PREWHERE, LIMIT BY and ARRAY JOIN can see through
+        bool single = true;
+        for (idx_t i = from->begin; i < from->end; i++) {
+            if (nodes[i].text == "," || nodes[i].word == "JOIN") {
+                single = false;
+            }
+        }
+        if (single) {
+            scan = FindParquetScan(nodes, from->begin, from->end);
+            auto last = PreviousSignificant(nodes, from->end, from->begin);
+            // the alias, or the name of a table without one
+            if (last != DConstants::INVALID_INDEX && !nodes[last].group &&
+                (nodes[last].type == ChTokenType::WORD || nodes[last].type == ChTokenType::IDENTIFIER)) {
+                source_alias = nodes[last].text;
+            }
+        }
+    }
+
+    string condition = prewhere ? StringUtil::Replace(RenderNodes(nodes, prewhere->begin, prewhere->end), "\n", " ") : "";
+    StringUtil::Trim(condition);
+    string where_condition = where ? RenderNodes(nodes, where->begin, where->end) : "";
+    StringUtil::Trim(where_condition);
+    if (!condition.empty() && scan != DConstants::INVALID_INDEX) {
+        // the scan evaluates it before decoding the other columns
+        AddNamedParameter(nodes[scan], "prewhere := " + QuoteString(condition));
+        condition.clear();
+    }
+    if (from) {
+        source = RenderNodes(nodes, from->begin, from->end);
+        StringUtil::Trim(source);
+    }
+
+    string result = RenderNodes(nodes, 0, head_end);
+    StringUtil::RTrim(result);
+    // the ORDER BY expressions become hidden columns, which need not be in the select list
+    string hidden;
+    string order;
+    for (idx_t i = 0; i < order_items.size(); i++) {
+        auto name = "__chsql_order_" + std::to_string(i);
+        result += ", " + order_items[i].expression + " AS " + name;
+        hidden += (i == 0 ? "" : ", ") + name;
+        order += (i == 0 ? "" : ", ") + name;
+        if (!order_items[i].modifiers.empty()) {
+            order += " " + order_items[i].modifiers;
+        }
+    }
+    if (from) {
+        if (array_join) {
+            result += " FROM " + LowerArrayJoin(source, source_alias, nodes, array_join->begin, array_join->end,
+                                                array_join->kind == "LEFT ARRAY JOIN", condition);
+            condition.clear();
+        } else {
+            result += " FROM " + source;
+        }
+    }
+    if (!condition.empty()) {
+        where_condition = where_condition.empty() ? condition : "(" + condition + ") AND (" + where_condition + ")";
+    }
+    if (!where_condition.empty()) {
+        result += " WHERE " + where_condition;
+    }
+    if (group_by) {
+        auto last = PreviousSignificant(nodes, group_by->end, group_by->begin);
+        auto with = last == DConstants::INVALID_INDEX ? last : PreviousSignificant(nodes, last, group_by->begin);
+        auto keys = RenderNodes(nodes, group_by->begin, group_by->end);
+        if (with != DConstants::INVALID_INDEX && nodes[with].word == "WITH" &&
+            (nodes[last].word == "TOTALS" || nodes[last].word == "ROLLUP" || nodes[last].word == "CUBE")) {
+            keys = RenderNodes(nodes, group_by->begin, with);
+            StringUtil::Trim(keys);
+            if (nodes[last].word == "TOTALS") {
+                keys = "GROUPING SETS ((" + keys + "), ())";
+            } else {
+                keys = nodes[last].word + " (" + keys + ")";
+            }
+            changed = true;
+        }
+        StringUtil::Trim(keys);
+        result += " GROUP BY " + keys;
+    }
+    for (auto clause : passed) {
+        auto text = RenderNodes(nodes, clause->start, clause->end);
+        StringUtil::Trim(text);
+        result += " " + text;
+    }
+
+    // LIMIT n BY wraps everything before it, a plain LIMIT after it applies to the result
+    for (auto &limit : limits) {
+        if (limit.by.empty()) {
+            result += " LIMIT " + limit.limit;
+            if (!limit.offset.empty()) {
+                result += " OFFSET " + limit.offset;
+            }
+            continue;
+        }
+        string arguments;
+        for (auto &key : limit.by) {
+            arguments += ", " + QuoteString(key);
+        }
+        if (!limit.offset.empty()) {
+            arguments += ", offset := " + limit.offset;
+        }
+        // the merge delivers rows grouped by the sort key, so no keys are hashed
+        bool plain = !array_join && !group_by && passed.empty() && order.empty();
+        if (plain && scan != DConstants::INVALID_INDEX && limit.by.size() == 1 &&
+            StringUtil::CIEquals(limit.by[0], ParquetSortKey(nodes, scan))) {
+            arguments += ", sorted := true";
+        }
+        if (!order.empty()) {
+            // every key keeps the rows that come first in the ORDER BY, however the threads deliver them
+            result = "SELECT * EXCLUDE (" + hidden + ") FROM limit_by((" + result + "), " + limit.limit + arguments +
+                     ", order_by := " + QuoteString(order) + ") ORDER BY " + order;
+            order.clear();
+            continue;
+        }
+        result = "SELECT * FROM limit_by((" + result + "), " + limit.limit + arguments + ")";
+    }
+    return result;
+}
+
+static string RewriteQuery(vector<ChNode> &nodes, bool &changed) {
+    // the parts of UNION, INTERSECT and EXCEPT each have their own clauses
+    string result;
+    idx_t begin = 0;
+    for (idx_t i = 0; i <= nodes.size(); i++) {
+        if (i < nodes.size() && nodes[i].word != "UNION" && nodes[i].word != "INTERSECT" && nodes[i].word != "EXCEPT") {
+            continue;
+        }
+        vector<ChNode> part(std::make_move_iterator(nodes.begin() + begin), std::make_move_iterator(nodes.begin() + i));
+        result += RewriteSelect(part, changed);
+        if (i == nodes.size()) {
+            break;
+        }
+        result += " " + nodes[i].text;
+        begin = i + 1;
+        auto next = NextSignificant(nodes, i, nodes.size());
+        while (next != DConstants::INVALID_INDEX &&
+               (nodes[next].word == "ALL" || nodes[next].word == "DISTINCT" || nodes[next].word == "BY" ||
+                nodes[next].word == "NAME")) {
+            result += " " + nodes[next].text;
+            begin = next + 1;
+            next = NextSignificant(nodes, next, nodes.size());
+        }
+        result += " ";
+        i = begin - 1;
+    }
+    return result;
+}
+
+struct ClickHouseParseData : ParserExtensionParseData {
+    ClickHouseParseData(string sql_p, unique_ptr<SQLStatement> statement_p)
+        : sql(std::move(sql_p)), statement(std::move(statement_p)) {
+    }
+
+    // the rewritten DuckDB SQL, parsed into statement
+    string sql;
+    unique_ptr<SQLStatement> statement;
+
+    unique_ptr<ParserExtensionParseData> Copy() const override {
+        return make_uniq<ClickHouseParseData>(sql, statement->Copy());
+    }
+    string ToString() const override {
+        return statement->ToString();
+    }
+};
+
+static ParserExtensionParseResult ClickHouseParse(ParserExtensionInfo *, const string &query) {
+    bool changed = false;
+    string sql;
+    try {
+        auto tokens = TokenizeClickHouse(query, changed);
+        while (!tokens.empty() &&
+               (tokens.back().type == ChTokenType::SPACE || tokens.back().text == ";")) {
+            tokens.pop_back();
+        }
+        idx_t position = 0;
+        auto nodes = ReadNodes(tokens, position, changed);
+        if (position != tokens.size()) {
+            return ParserExtensionParseResult();
+        }
+        sql = IsQuery(nodes) ? RewriteQuery(nodes, changed) : RenderNodes(nodes, 0, nodes.size());
+    } catch (std::exception &ex) {
+        return ParserExtensionParseResult(ErrorData(ex).RawMessage());
+    }
+    if (!changed) {
+        // not ClickHouse syntax either
+        return ParserExtensionParseResult();
+    }
+    Parser parser;
+    try {
+        parser.ParseQuery(sql);
+    } catch (ParserException &ex) {
+        return ParserExtensionParseResult(ErrorData(ex).RawMessage() + "\nRewritten query: " + sql);
+    }
+    if (parser.statements.size() != 1) {
+        return ParserExtensionParseResult();
+    }
+    return ParserExtensionParseResult(make_uniq<ClickHouseParseData>(sql, std::move(parser.statements[0])));
+}
+
+struct ClickHouseStatementData : public TableFunctionData {
+    unique_ptr<Connection> conn;
+    unique_ptr<PreparedStatement> prepared;
+};
+
+struct ClickHouseStatementState : public GlobalTableFunctionState {
+    unique_ptr<QueryResult> result;
+};
+
+// Prepares the rewritten statement to bind its result columns, with the
+// settings and variables the client has set
+static unique_ptr<FunctionData> ClickHouseStatementBind(ClientContext &context, TableFunctionBindInput &input,
+                                                        vector<LogicalType> &return_types, vector<string> &names) {
+    auto data = make_uniq<ClickHouseStatementData>();
+    data->conn = make_uniq<Connection>(*context.db);
+    data->conn->context->config.set_variables = context.config.set_variables;
+    data->conn->context->config.user_variables = context.config.user_variables;
+    data->prepared = data->conn->Prepare(input.inputs[0].GetValue<string>());
+    if (data->prepared->HasError()) {
+        data->prepared->error.Throw();
+    }
+    return_types = data->prepared->GetTypes();
+    names = data->prepared->GetNames();
+    return std::move(data);
+}
+
+// Every execution, e.g. of a prepared statement, runs the statement anew
+static unique_ptr<GlobalTableFunctionState> ClickHouseStatementInit(ClientContext &context,
+                                                                    TableFunctionInitInput &input) {
+    auto &data = input.bind_data->Cast<ClickHouseStatementData>();
+    auto state = make_uniq<ClickHouseStatementState>();
+    vector<Value> values;
+    state->result = data.prepared->Execute(values);
+    if (state->result->HasError()) {
+        state->result->ThrowError();
+    }
+    return std::move(state);
+}
+
+static void ClickHouseStatementFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<ClickHouseStatementState>();
+    auto chunk = state.result->Fetch();
+    if (state.result->HasError()) {
+        state.result->ThrowError();
+    }
+    if (chunk) {
+        output.Reference(*chunk);
+    }
+}
+
+static ParserExtensionPlanResult ClickHousePlan(ParserExtensionInfo *, ClientContext &context,
+                                                unique_ptr<ParserExtensionParseData> parse_data) {
+    auto &data = parse_data->Cast<ClickHouseParseData>();
+    ParserExtensionPlanResult result;
+    result.function = TableFunction("chsql_statement", {LogicalType::VARCHAR}, ClickHouseStatementFunction,
+                                    ClickHouseStatementBind, ClickHouseStatementInit);
+    result.parameters.push_back(Value(data.sql));
+    result.requires_valid_transaction = true;
+    return result;
+}
+
+void RegisterClickHouseParser(DatabaseInstance &instance) {
+    auto &config = DBConfig::GetConfig(instance);
+    ParserExtension parser;
+    parser.parse_function = ClickHouseParse;
+    parser.plan_function = ClickHousePlan;
+    config.parser_extensions.push_back(parser);
+}
+
+} // namespace duckdb
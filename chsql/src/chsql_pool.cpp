@@ -0,0 +1,276 @@
+#include "chsql_pool.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/prepared_statement.hpp"
+
+namespace duckdb {
+
+PreparedStatement &PooledConnection::Prepare(const string &sql) {
+    auto entry = statements.find(sql);
+    if (entry != statements.end()) {
+        return *entry->second;
+    }
+    auto statement = conn->Prepare(sql);
+    if (statement->HasError()) {
+        throw InvalidInputException(statement->GetError());
+    }
+    auto &result = *statement;
+    statements[sql] = std::move(statement);
+    return result;
+}
+
+RemoteConnectionLease::RemoteConnectionLease(shared_ptr<RemoteConnectionPool> pool, string host,
+                                             unique_ptr<PooledConnection> conn)
+    : pool(std::move(pool)), host(std::move(host)), conn(std::move(conn)) {
+}
+
+RemoteConnectionLease::~RemoteConnectionLease() {
+    pool->Release(host, std::move(conn));
+}
+
+shared_ptr<RemoteConnectionPool> RemoteConnectionPool::Get(ClientContext &context) {
+    return context.registered_state->GetOrCreate<RemoteConnectionPool>("chsql_connection_pool");
+}
+
+// scheme://authority of a node URL, lower-cased
+string RemoteConnectionPool::HostKey(const string &url) {
+    auto scheme_end = url.find("://");
+    auto authority_start = scheme_end == string::npos ? 0 : scheme_end + 3;
+    auto authority_end = url.find_first_of("/?#", authority_start);
+    return StringUtil::Lower(url.substr(0, authority_end));
+}
+
+// chsql_pool_size and chsql_pool_idle_timeout, read outside of the pool locks
+// and stored under them: scan threads acquire concurrently
+struct RemotePoolSettings {
+    explicit RemotePoolSettings(ClientContext &context) {
+        has_pool_size = context.TryGetCurrentSetting("chsql_pool_size", pool_size) && !pool_size.IsNull();
+        has_idle_timeout =
+            context.TryGetCurrentSetting("chsql_pool_idle_timeout", pool_idle_timeout) && !pool_idle_timeout.IsNull();
+    }
+
+    void Apply(idx_t &max_idle, std::chrono::seconds &idle_timeout) const {
+        if (has_pool_size) {
+            max_idle = pool_size.GetValue<idx_t>();
+        }
+        if (has_idle_timeout) {
+            idle_timeout = std::chrono::seconds(pool_idle_timeout.GetValue<idx_t>());
+        }
+    }
+
+    Value pool_size;
+    Value pool_idle_timeout;
+    bool has_pool_size;
+    bool has_idle_timeout;
+};
+
+unique_ptr<RemoteConnectionLease> RemoteConnectionPool::Acquire(ClientContext &context, const string &url) {
+    RemotePoolSettings settings(context);
+    auto host = HostKey(url);
+    auto now = std::chrono::steady_clock::now();
+    unique_ptr<PooledConnection> conn;
+    {
+        lock_guard<mutex> guard(lock);
+        settings.Apply(max_idle, idle_timeout);
+        EvictExpired(now);
+        auto &pool = hosts[host];
+        if (!pool.idle.empty()) {
+            conn = std::move(pool.idle.back());
+            pool.idle.pop_back();
+            pool.hits++;
+        } else {
+            pool.misses++;
+        }
+        pool.in_use++;
+    }
+    if (!conn) {
+        try {
+            conn = make_uniq<PooledConnection>();
+            conn->conn = make_uniq<Connection>(*context.db);
+            auto settings = conn->conn->Query("SET autoload_known_extensions=1;SET autoinstall_known_extensions=1;");
+            if (settings->HasError()) {
+                settings->ThrowError();
+            }
+        } catch (...) {
+            lock_guard<mutex> guard(lock);
+            hosts[host].in_use--;
+            throw;
+        }
+    }
+    conn->last_used = now;
+    return make_uniq<RemoteConnectionLease>(shared_from_this(), std::move(host), std::move(conn));
+}
+
+void RemoteConnectionPool::Release(const string &host, unique_ptr<PooledConnection> conn) {
+    lock_guard<mutex> guard(lock);
+    auto &pool = hosts[host];
+    pool.in_use--;
+    if (!conn || pool.idle.size() >= max_idle) {
+        pool.evictions++;
+        return;
+    }
+    conn->last_used = std::chrono::steady_clock::now();
+    pool.idle.push_back(std::move(conn));
+}
+
+void RemoteConnectionPool::EvictExpired(std::chrono::steady_clock::time_point now) {
+    for (auto &entry : hosts) {
+        auto &idle = entry.second.idle;
+        for (idx_t i = idle.size(); i > 0; i--) {
+            if (now - idle[i - 1]->last_used < idle_timeout) {
+                continue;
+            }
+            idle.erase(idle.begin() + static_cast<int64_t>(i - 1));
+            entry.second.evictions++;
+        }
+    }
+}
+
+void RemoteConnectionPool::QueryEnd(ClientContext &context) {
+    lock_guard<mutex> guard(lock);
+    EvictExpired(std::chrono::steady_clock::now());
+}
+
+vector<RemoteHostPoolStats> RemoteConnectionPool::GetStats() {
+    lock_guard<mutex> guard(lock);
+    vector<RemoteHostPoolStats> result;
+    for (auto &entry : hosts) {
+        auto &pool = entry.second;
+        result.push_back({entry.first, pool.idle.size(), pool.in_use, pool.hits, pool.misses, pool.evictions, 0, 0, 0});
+    }
+    return result;
+}
+
+shared_ptr<RemoteHttpClientPool> RemoteHttpClientPool::Get(ClientContext &context) {
+    return ObjectCache::GetObjectCache(context).GetOrCreate<RemoteHttpClientPool>(ObjectType());
+}
+
+unique_ptr<HTTPClient> RemoteHttpClientPool::Acquire(ClientContext &context, HTTPUtil &http, HTTPParams &params,
+                                                     const string &proto_host_port) {
+    RemotePoolSettings settings(context);
+    unique_ptr<HTTPClient> client;
+    {
+        lock_guard<mutex> guard(lock);
+        settings.Apply(max_idle, idle_timeout);
+        EvictExpired(std::chrono::steady_clock::now());
+        auto &host = hosts[proto_host_port];
+        if (!host.idle.empty()) {
+            client = std::move(host.idle.back().client);
+            host.idle.pop_back();
+            host.hits++;
+        } else {
+            host.misses++;
+        }
+    }
+    if (!client) {
+        return http.InitializeClient(params, proto_host_port);
+    }
+    // timeouts and the per-query HTTP state come from this request's parameters
+    client->Initialize(params);
+    return client;
+}
+
+void RemoteHttpClientPool::Release(const string &proto_host_port, unique_ptr<HTTPClient> client) {
+    lock_guard<mutex> guard(lock);
+    auto &host = hosts[proto_host_port];
+    if (!client || host.idle.size() >= max_idle) {
+        return;
+    }
+    host.idle.push_back({std::move(client), std::chrono::steady_clock::now()});
+}
+
+void RemoteHttpClientPool::EvictExpired(std::chrono::steady_clock::time_point now) {
+    for (auto &entry : hosts) {
+        auto &idle = entry.second.idle;
+        auto expired = [&](const PooledHttpClient &client) { return now - client.last_used >= idle_timeout; };
+        idle.erase(std::remove_if(idle.begin(), idle.end(), expired), idle.end());
+    }
+}
+
+void RemoteHttpClientPool::AddStats(vector<RemoteHostPoolStats> &stats) {
+    lock_guard<mutex> guard(lock);
+    for (auto &entry : hosts) {
+        auto host = RemoteConnectionPool::HostKey(entry.first);
+        auto row = std::find_if(stats.begin(), stats.end(),
+                                [&](const RemoteHostPoolStats &candidate) { return candidate.host == host; });
+        if (row == stats.end()) {
+            stats.push_back({host, 0, 0, 0, 0, 0, 0, 0, 0});
+            row = stats.end() - 1;
+        }
+        row->http_idle += entry.second.idle.size();
+        row->http_hits += entry.second.hits;
+        row->http_misses += entry.second.misses;
+    }
+}
+
+// -- system.connection_pool
+struct SystemConnectionPoolState : public GlobalTableFunctionState {
+    vector<RemoteHostPoolStats> stats;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> SystemConnectionPoolBind(ClientContext &context, TableFunctionBindInput &input,
+                                                         vector<LogicalType> &return_types, vector<string> &names) {
+    names.emplace_back("host");
+    names.emplace_back("idle");
+    names.emplace_back("in_use");
+    names.emplace_back("hits");
+    names.emplace_back("misses");
+    names.emplace_back("evictions");
+    names.emplace_back("http_idle");
+    names.emplace_back("http_hits");
+    names.emplace_back("http_misses");
+
+    return_types.emplace_back(LogicalType::VARCHAR);
+    for (idx_t i = 1; i < names.size(); i++) {
+        return_types.emplace_back(LogicalType::UBIGINT);
+    }
+    return make_uniq<TableFunctionData>();
+}
+
+// snapshot when the scan starts, so that a prepared statement reports the pool as it is then
+static unique_ptr<GlobalTableFunctionState> SystemConnectionPoolInit(ClientContext &context,
+                                                                     TableFunctionInitInput &input) {
+    auto result = make_uniq<SystemConnectionPoolState>();
+    result->stats = RemoteConnectionPool::Get(context)->GetStats();
+    RemoteHttpClientPool::Get(context)->AddStats(result->stats);
+    return std::move(result);
+}
+
+static void SystemConnectionPoolFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.global_state->Cast<SystemConnectionPoolState>();
+    idx_t count = 0;
+    while (data.offset < data.stats.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &entry = data.stats[data.offset];
+        output.SetValue(0, count, Value(entry.host));
+        output.SetValue(1, count, Value::UBIGINT(entry.idle));
+        output.SetValue(2, count, Value::UBIGINT(entry.in_use));
+        output.SetValue(3, count, Value::UBIGINT(entry.hits));
+        output.SetValue(4, count, Value::UBIGINT(entry.misses));
+        output.SetValue(5, count, Value::UBIGINT(entry.evictions));
+        output.SetValue(6, count, Value::UBIGINT(entry.http_idle));
+        output.SetValue(7, count, Value::UBIGINT(entry.http_hits));
+        output.SetValue(8, count, Value::UBIGINT(entry.http_misses));
+        count++;
+        data.offset++;
+    }
+    output.SetCardinality(count);
+}
+
+void RegisterConnectionPoolFunctions(DatabaseInstance &instance) {
+    auto &config = DBConfig::GetConfig(instance);
+    config.AddExtensionOption("chsql_pool_size",
+                              "Idle remote connections and HTTP clients kept per host by url_flock and ch_scan",
+                              LogicalType::UBIGINT, Value::UBIGINT(4));
+    config.AddExtensionOption("chsql_pool_idle_timeout",
+                              "Seconds an idle pooled remote connection is kept before it is closed",
+                              LogicalType::UBIGINT, Value::UBIGINT(60));
+
+    auto pool_func = TableFunction("system_connection_pool", {}, SystemConnectionPoolFunction, SystemConnectionPoolBind,
+                                   SystemConnectionPoolInit);
+    ExtensionUtil::RegisterFunction(instance, pool_func);
+}
+
+} // namespace duckdb
@@ -0,0 +1,446 @@
+#include "chsql_query_cache.hpp"
+#include "chsql_compression.hpp"
+#include "chsql_metrics.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/connection.hpp"
+#include "duckdb/main/materialized_query_result.hpp"
+#include "duckdb/main/appender.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+
+namespace duckdb {
+
+RemoteResultCache &RemoteResultCache::Get(ClientContext &context) {
+    return *ObjectCache::GetObjectCache(context).GetOrCreate<RemoteResultCache>(ObjectType());
+}
+
+static idx_t GetUnsignedSetting(ClientContext &context, const string &name, idx_t default_value) {
+    Value setting;
+    if (context.TryGetCurrentSetting(name, setting) && !setting.IsNull()) {
+        return setting.GetValue<idx_t>();
+    }
+    return default_value;
+}
+
+bool RemoteResultCache::Enabled(ClientContext &context) {
+    return GetUnsignedSetting(context, "chsql_query_cache_ttl", 0) > 0;
+}
+
+idx_t RemoteResultCache::MemoryLimit(ClientContext &context) {
+    return GetUnsignedSetting(context, "chsql_query_cache_size", 256ULL * 1024 * 1024);
+}
+
+// Collapses whitespace runs outside of quoted literals and drops a trailing ';',
+// so that reformatted dashboard queries share a cache entry.
+string RemoteResultCache::NormalizeQuery(const string &query) {
+    string result;
+    result.reserve(query.size());
+    char quote = '\0';
+    bool pending_space = false;
+    for (auto c : query) {
+        if (quote != '\0') {
+            result += c;
+            if (c == quote) {
+                quote = '\0';
+            }
+            continue;
+        }
+        if (StringUtil::CharacterIsSpace(c)) {
+            pending_space = !result.empty();
+            continue;
+        }
+        if (pending_space) {
+            result += ' ';
+            pending_space = false;
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            quote = c;
+        }
+        result += c;
+    }
+    while (!result.empty() && (result.back() == ';' || result.back() == ' ')) {
+        result.pop_back();
+    }
+    return result;
+}
+
+string RemoteResultCache::MakeKey(ClientContext &context, const string &query, const vector<string> &servers,
+                                  const string &format) {
+    auto key = NormalizeQuery(query) + '\0' + StringUtil::Join(servers, ",") + '\0' + StringUtil::Lower(format);
+    for (auto &server : servers) {
+        key += '\0' + RemoteHttpAuth::Lookup(context, server).identity;
+    }
+    return key;
+}
+
+shared_ptr<CachedRemoteResult> RemoteResultCache::Lookup(ClientContext &context, const string &key) {
+    shared_ptr<CachedRemoteResult> hit;
+    shared_ptr<CachedRemoteResult> expired;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto entry = entries.find(key);
+        if (entry == entries.end()) {
+            stats.misses++;
+            ChMetrics::Increment(ChEvent::QUERY_CACHE_MISSES);
+            return nullptr;
+        }
+        auto &cached = entry->second.first;
+        if (std::chrono::system_clock::now() < cached->expires) {
+            stats.hits++;
+            cached->hits++;
+            ChMetrics::Increment(ChEvent::QUERY_CACHE_HITS);
+            if (entry->second.second != lru.end()) {
+                lru.splice(lru.begin(), lru, entry->second.second);
+            }
+            hit = cached;
+        } else {
+            stats.misses++;
+            ChMetrics::Increment(ChEvent::QUERY_CACHE_MISSES);
+            if (entry->second.second != lru.end()) {
+                stats.bytes -= cached->bytes;
+                lru.erase(entry->second.second);
+            }
+            expired = std::move(cached);
+            entries.erase(entry);
+            stats.entries = entries.size();
+        }
+    }
+    if (expired) {
+        RemoveSpillFile(context, *expired);
+        return nullptr;
+    }
+    if (!hit->data) {
+        return ReadSpilled(context, key, hit);
+    }
+    return hit;
+}
+
+shared_ptr<CachedRemoteResult> RemoteResultCache::Peek(const string &key) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto entry = entries.find(key);
+    if (entry == entries.end() || std::chrono::system_clock::now() >= entry->second.first->expires) {
+        return nullptr;
+    }
+    return entry->second.first;
+}
+
+// Loads a spilled entry back into memory, cast back to the types it was cached
+// with. It takes the front of the LRU list again, so later hits scan the
+// decoded rows rather than reading the file anew.
+shared_ptr<CachedRemoteResult> RemoteResultCache::ReadSpilled(ClientContext &context, const string &key,
+                                                              shared_ptr<CachedRemoteResult> entry) {
+    string columns;
+    for (idx_t i = 0; i < entry->names.size(); i++) {
+        columns += (i == 0 ? "" : ", ") + KeywordHelper::WriteOptionallyQuoted(entry->names[i]) +
+                   "::" + entry->types[i].ToString();
+    }
+    Connection con(*context.db);
+    auto result = con.Query("SELECT " + columns + " FROM read_parquet(" +
+                            KeywordHelper::WriteQuoted(entry->spill_path, '\'') + ")");
+    if (result->HasError()) {
+        return nullptr;
+    }
+    auto loaded = make_shared_ptr<CachedRemoteResult>();
+    loaded->query = entry->query;
+    loaded->server = entry->server;
+    loaded->format = entry->format;
+    loaded->names = entry->names;
+    loaded->types = entry->types;
+    loaded->rows = entry->rows;
+    loaded->bytes = entry->bytes;
+    loaded->created = entry->created;
+    loaded->expires = entry->expires;
+    loaded->hits = entry->hits.load();
+    loaded->data = result->TakeCollection();
+
+    auto limit = MemoryLimit(context);
+    vector<pair<string, shared_ptr<CachedRemoteResult>>> evicted;
+    bool promoted = false;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto current = entries.find(key);
+        // unless another scan promoted or replaced it meanwhile
+        if (current != entries.end() && current->second.first == entry) {
+            lru.push_front(key);
+            current->second = make_pair(loaded, lru.begin());
+            stats.bytes += loaded->bytes;
+            promoted = true;
+            while (stats.bytes > limit && lru.size() > 1) {
+                auto victim = entries.find(lru.back());
+                lru.pop_back();
+                stats.bytes -= victim->second.first->bytes;
+                stats.evictions++;
+                evicted.emplace_back(victim->first, std::move(victim->second.first));
+                entries.erase(victim);
+            }
+            stats.entries = entries.size();
+        }
+    }
+    if (promoted) {
+        RemoveSpillFile(context, *entry);
+    }
+    SpillEntries(context, evicted);
+    return loaded;
+}
+
+void RemoteResultCache::Insert(ClientContext &context, const string &key, shared_ptr<CachedRemoteResult> entry) {
+    auto ttl = std::chrono::seconds(GetUnsignedSetting(context, "chsql_query_cache_ttl", 0));
+    auto limit = MemoryLimit(context);
+    entry->created = std::chrono::system_clock::now();
+    entry->expires = entry->created + ttl;
+
+    vector<pair<string, shared_ptr<CachedRemoteResult>>> evicted;
+    vector<shared_ptr<CachedRemoteResult>> expired;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->first != key && entry->created < it->second.first->expires) {
+                it++;
+                continue;
+            }
+            if (it->second.second != lru.end()) {
+                stats.bytes -= it->second.first->bytes;
+                lru.erase(it->second.second);
+            }
+            expired.push_back(std::move(it->second.first));
+            it = entries.erase(it);
+        }
+        lru.push_front(key);
+        entries[key] = make_pair(entry, lru.begin());
+        stats.bytes += entry->bytes;
+        while (stats.bytes > limit && !lru.empty()) {
+            auto victim = entries.find(lru.back());
+            lru.pop_back();
+            stats.bytes -= victim->second.first->bytes;
+            stats.evictions++;
+            evicted.emplace_back(victim->first, std::move(victim->second.first));
+            entries.erase(victim);
+        }
+        stats.entries = entries.size();
+    }
+    for (auto &old_entry : expired) {
+        RemoveSpillFile(context, *old_entry);
+    }
+    SpillEntries(context, evicted);
+}
+
+// Evicted results are written to Parquet when chsql_query_cache_spill_path is
+// set, and stay in the cache (outside of the memory limit) until they expire.
+void RemoteResultCache::SpillEntries(ClientContext &context,
+                                     vector<pair<string, shared_ptr<CachedRemoteResult>>> &evicted) {
+    Value setting;
+    if (evicted.empty() || !context.TryGetCurrentSetting("chsql_query_cache_spill_path", setting) ||
+        setting.IsNull() || setting.ToString().empty()) {
+        return;
+    }
+    auto &fs = FileSystem::GetFileSystem(context);
+    auto directory = setting.ToString();
+    if (!fs.DirectoryExists(directory)) {
+        fs.CreateDirectory(directory);
+    }
+    Connection con(*context.db);
+    for (auto &victim : evicted) {
+        auto &entry = *victim.second;
+        if (!entry.data) {
+            continue;
+        }
+        auto path = fs.JoinPath(directory, "chsql_cache_" + std::to_string(Hash(victim.first.c_str(), victim.first.size())) +
+                                               "_" + std::to_string(entry.created.time_since_epoch().count()) + ".parquet");
+        string columns;
+        for (idx_t i = 0; i < entry.names.size(); i++) {
+            columns += (i == 0 ? "" : ", ") + KeywordHelper::WriteOptionallyQuoted(entry.names[i]) + " " +
+                       entry.types[i].ToString();
+        }
+        auto create = con.Query("CREATE OR REPLACE TEMPORARY TABLE __chsql_spill (" + columns + ")");
+        if (create->HasError()) {
+            continue;
+        }
+        {
+            Appender appender(con, TEMP_CATALOG, DEFAULT_SCHEMA, "__chsql_spill");
+            for (auto &chunk : entry.data->Chunks()) {
+                appender.AppendDataChunk(chunk);
+            }
+            appender.Close();
+        }
+        auto copy = con.Query("COPY __chsql_spill TO '" + StringUtil::Replace(path, "'", "''") + "' (FORMAT parquet)");
+        con.Query("DROP TABLE __chsql_spill");
+        if (copy->HasError()) {
+            continue;
+        }
+
+        auto spilled = make_shared_ptr<CachedRemoteResult>();
+        spilled->query = entry.query;
+        spilled->server = entry.server;
+        spilled->format = entry.format;
+        spilled->names = entry.names;
+        spilled->types = entry.types;
+        spilled->spill_path = path;
+        spilled->rows = entry.rows;
+        spilled->bytes = entry.bytes;
+        spilled->created = entry.created;
+        spilled->expires = entry.expires;
+        spilled->hits = entry.hits.load();
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (entries.find(victim.first) == entries.end()) {
+            entries[victim.first] = make_pair(std::move(spilled), lru.end());
+            stats.spills++;
+            stats.entries = entries.size();
+        }
+    }
+}
+
+void RemoteResultCache::RemoveSpillFile(ClientContext &context, const CachedRemoteResult &entry) {
+    if (entry.spill_path.empty()) {
+        return;
+    }
+    try {
+        FileSystem::GetFileSystem(context).RemoveFile(entry.spill_path);
+    } catch (...) {
+        // a missing spill file only means the entry is gone already
+    }
+}
+
+vector<shared_ptr<CachedRemoteResult>> RemoteResultCache::GetEntries() {
+    std::lock_guard<std::mutex> guard(lock);
+    vector<shared_ptr<CachedRemoteResult>> result;
+    for (auto &entry : entries) {
+        result.push_back(entry.second.first);
+    }
+    return result;
+}
+
+RemoteResultCacheStats RemoteResultCache::GetStats() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
+
+// -- system.query_cache
+struct SystemQueryCacheState : public GlobalTableFunctionState {
+    vector<shared_ptr<CachedRemoteResult>> entries;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> SystemQueryCacheBind(ClientContext &context, TableFunctionBindInput &input,
+                                                     vector<LogicalType> &return_types, vector<string> &names) {
+    names.emplace_back("query");
+    names.emplace_back("server");
+    names.emplace_back("format");
+    names.emplace_back("rows");
+    names.emplace_back("result_size");
+    names.emplace_back("spilled");
+    names.emplace_back("hits");
+    names.emplace_back("created_at");
+    names.emplace_back("expires_at");
+
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::BOOLEAN);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::TIMESTAMP);
+    return_types.emplace_back(LogicalType::TIMESTAMP);
+    return make_uniq<TableFunctionData>();
+}
+
+// snapshot when the scan starts, so that a prepared statement reports the cache as it is then
+static unique_ptr<GlobalTableFunctionState> SystemQueryCacheInit(ClientContext &context,
+                                                                 TableFunctionInitInput &input) {
+    auto result = make_uniq<SystemQueryCacheState>();
+    result->entries = RemoteResultCache::Get(context).GetEntries();
+    return std::move(result);
+}
+
+static Value CacheTimestamp(std::chrono::system_clock::time_point time) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+    return Value::TIMESTAMP(timestamp_t(micros));
+}
+
+static void SystemQueryCacheFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.global_state->Cast<SystemQueryCacheState>();
+    idx_t count = 0;
+    while (data.offset < data.entries.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &entry = *data.entries[data.offset];
+        output.SetValue(0, count, Value(entry.query));
+        output.SetValue(1, count, Value(entry.server));
+        output.SetValue(2, count, Value(entry.format));
+        output.SetValue(3, count, Value::UBIGINT(entry.rows));
+        output.SetValue(4, count, Value::UBIGINT(entry.bytes));
+        output.SetValue(5, count, Value::BOOLEAN(!entry.spill_path.empty()));
+        output.SetValue(6, count, Value::UBIGINT(entry.hits.load()));
+        output.SetValue(7, count, CacheTimestamp(entry.created));
+        output.SetValue(8, count, CacheTimestamp(entry.expires));
+        count++;
+        data.offset++;
+    }
+    output.SetCardinality(count);
+}
+
+// -- system.query_cache_stats
+struct SystemQueryCacheStatsState : public GlobalTableFunctionState {
+    RemoteResultCacheStats stats;
+    bool done = false;
+};
+
+static unique_ptr<FunctionData> SystemQueryCacheStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                          vector<LogicalType> &return_types, vector<string> &names) {
+    names.emplace_back("entries");
+    names.emplace_back("bytes");
+    names.emplace_back("hits");
+    names.emplace_back("misses");
+    names.emplace_back("evictions");
+    names.emplace_back("spills");
+    for (idx_t i = 0; i < names.size(); i++) {
+        return_types.emplace_back(LogicalType::UBIGINT);
+    }
+    return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> SystemQueryCacheStatsInit(ClientContext &context,
+                                                                      TableFunctionInitInput &input) {
+    auto result = make_uniq<SystemQueryCacheStatsState>();
+    result->stats = RemoteResultCache::Get(context).GetStats();
+    return std::move(result);
+}
+
+static void SystemQueryCacheStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.global_state->Cast<SystemQueryCacheStatsState>();
+    if (data.done) {
+        return;
+    }
+    output.SetValue(0, 0, Value::UBIGINT(data.stats.entries));
+    output.SetValue(1, 0, Value::UBIGINT(data.stats.bytes));
+    output.SetValue(2, 0, Value::UBIGINT(data.stats.hits));
+    output.SetValue(3, 0, Value::UBIGINT(data.stats.misses));
+    output.SetValue(4, 0, Value::UBIGINT(data.stats.evictions));
+    output.SetValue(5, 0, Value::UBIGINT(data.stats.spills));
+    output.SetCardinality(1);
+    data.done = true;
+}
+
+void RegisterQueryCacheFunctions(DatabaseInstance &instance) {
+    auto &config = DBConfig::GetConfig(instance);
+    config.AddExtensionOption("chsql_query_cache_ttl",
+                              "Seconds a ch_scan, url or url_flock result is served from the cache (0 disables it)",
+                              LogicalType::UBIGINT, Value::UBIGINT(0));
+    config.AddExtensionOption("chsql_query_cache_size", "Memory limit in bytes of the remote query cache",
+                              LogicalType::UBIGINT, Value::UBIGINT(256ULL * 1024 * 1024));
+    config.AddExtensionOption("chsql_query_cache_spill_path",
+                              "Directory where results evicted from the remote query cache are kept as Parquet",
+                              LogicalType::VARCHAR, Value(""));
+
+    auto cache_func = TableFunction("system_query_cache", {}, SystemQueryCacheFunction, SystemQueryCacheBind,
+                                    SystemQueryCacheInit);
+    ExtensionUtil::RegisterFunction(instance, cache_func);
+
+    auto stats_func = TableFunction("system_query_cache_stats", {}, SystemQueryCacheStatsFunction,
+                                    SystemQueryCacheStatsBind, SystemQueryCacheStatsInit);
+    ExtensionUtil::RegisterFunction(instance, stats_func);
+}
+
+} // namespace duckdb
@@ -0,0 +1,365 @@
+#include "chsql_query_log.hpp"
+#include "chsql_metrics.hpp"
+#include "duckdb/common/types/hash.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/client_context.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/main/connection_manager.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/main/profiling_node.hpp"
+#include "duckdb/main/query_profiler.hpp"
+#include "duckdb/planner/extension_callback.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+
+namespace duckdb {
+
+QueryLog &QueryLog::Get(ClientContext &context) {
+    return *ObjectCache::GetObjectCache(context).GetOrCreate<QueryLog>(ObjectType());
+}
+
+void QueryLog::AddReadBytes(ClientContext &context, idx_t bytes) {
+    auto state = context.registered_state->Get<QueryLogState>("chsql_query_log");
+    if (state) {
+        state->read_bytes += bytes;
+    }
+}
+
+// Replaces string and number literals by '?', collapses whitespace and
+// lowercases the rest, so the same query with other constants hashes alike.
+hash_t QueryLog::NormalizedQueryHash(const string &query) {
+    string result;
+    result.reserve(query.size());
+    bool pending_space = false;
+    for (idx_t i = 0; i < query.size(); i++) {
+        auto c = query[i];
+        if (StringUtil::CharacterIsSpace(c)) {
+            pending_space = !result.empty();
+            continue;
+        }
+        if (pending_space) {
+            result += ' ';
+            pending_space = false;
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            auto end = i + 1;
+            while (end < query.size() && query[end] != c) {
+                end += query[end] == '\\' ? 2 : 1;
+            }
+            if (c == '\'') {
+                result += '?';
+            } else {
+                result += query.substr(i, end - i + 1);
+            }
+            i = end;
+            continue;
+        }
+        auto previous = result.empty() ? ' ' : result.back();
+        bool in_word = StringUtil::CharacterIsAlphaNumeric(previous) || previous == '_';
+        if (StringUtil::CharacterIsDigit(c) && !in_word) {
+            while (i + 1 < query.size() &&
+                   (StringUtil::CharacterIsAlphaNumeric(query[i + 1]) || query[i + 1] == '.')) {
+                i++;
+            }
+            result += '?';
+            continue;
+        }
+        result += StringUtil::CharacterToLower(c);
+    }
+    while (!result.empty() && (result.back() == ';' || result.back() == ' ')) {
+        result.pop_back();
+    }
+    return Hash(result.c_str(), result.size());
+}
+
+idx_t QueryLog::Begin(ClientContext &context) {
+    ChMetrics::Increment(ChEvent::QUERY);
+    RunningQuery query;
+    query.connection_id = context.GetConnectionId();
+    query.query = context.GetCurrentQuery();
+    query.start_time = std::chrono::system_clock::now();
+    query.started = std::chrono::steady_clock::now();
+    query.context = context.shared_from_this();
+    std::lock_guard<std::mutex> guard(lock);
+    query.query_id = next_query_id++;
+    auto query_id = query.query_id;
+    running[query_id] = std::move(query);
+    return query_id;
+}
+
+static idx_t ProfilerMetric(const profiler_metrics_t &metrics, MetricsType type) {
+    auto entry = metrics.find(type);
+    if (entry == metrics.end() || entry->second.IsNull()) {
+        return 0;
+    }
+    return entry->second.GetValue<idx_t>();
+}
+
+void QueryLog::Finish(ClientContext &context, idx_t query_id) {
+    QueryLogEntry entry;
+    auto &profiler = QueryProfiler::Get(context);
+    if (profiler.IsEnabled()) {
+        auto root = profiler.GetRoot();
+        if (root) {
+            auto &metrics = root->GetProfilingInfo().metrics;
+            entry.read_rows = ProfilerMetric(metrics, MetricsType::CUMULATIVE_ROWS_SCANNED);
+            entry.read_bytes = ProfilerMetric(metrics, MetricsType::TOTAL_BYTES_READ);
+            entry.written_bytes = ProfilerMetric(metrics, MetricsType::TOTAL_BYTES_WRITTEN);
+            entry.result_rows = ProfilerMetric(metrics, MetricsType::ROWS_RETURNED);
+            entry.peak_memory = ProfilerMetric(metrics, MetricsType::SYSTEM_PEAK_BUFFER_MEMORY);
+        }
+    }
+    Value setting;
+    idx_t capacity = 1000;
+    if (context.TryGetCurrentSetting("chsql_query_log_size", setting) && !setting.IsNull()) {
+        capacity = setting.GetValue<idx_t>();
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto query = running.find(query_id);
+    if (query == running.end()) {
+        return;
+    }
+    entry.query_id = query_id;
+    entry.connection_id = query->second.connection_id;
+    entry.normalized_query_hash = NormalizedQueryHash(query->second.query);
+    entry.query = std::move(query->second.query);
+    entry.start_time = query->second.start_time;
+    entry.end_time = std::chrono::system_clock::now();
+    entry.duration_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - query->second.started).count();
+    running.erase(query);
+    entries.push_back(std::move(entry));
+    while (entries.size() > capacity) {
+        entries.pop_front();
+    }
+}
+
+vector<QueryLogEntry> QueryLog::GetEntries() {
+    std::lock_guard<std::mutex> guard(lock);
+    return vector<QueryLogEntry>(entries.begin(), entries.end());
+}
+
+vector<RunningQuery> QueryLog::GetRunning() {
+    std::lock_guard<std::mutex> guard(lock);
+    vector<RunningQuery> result;
+    for (auto &entry : running) {
+        result.push_back(entry.second);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const RunningQuery &a, const RunningQuery &b) { return a.query_id < b.query_id; });
+    return result;
+}
+
+void QueryLogState::QueryBegin(ClientContext &context) {
+    read_bytes = 0;
+    query_id = QueryLog::Get(context).Begin(context);
+}
+
+void QueryLogState::QueryEnd(ClientContext &context) {
+    if (query_id == DConstants::INVALID_INDEX) {
+        // the query that loaded the extension
+        return;
+    }
+    QueryLog::Get(context).Finish(context, query_id);
+    query_id = DConstants::INVALID_INDEX;
+}
+
+static void AttachQueryLog(ClientContext &context) {
+    context.registered_state->GetOrCreate<QueryLogState>("chsql_query_log");
+}
+
+// Connections opened after the extension is loaded report to the log too
+class QueryLogExtensionCallback : public ExtensionCallback {
+public:
+    void OnConnectionOpened(ClientContext &context) override {
+        AttachQueryLog(context);
+    }
+};
+
+static Value LogTimestamp(std::chrono::system_clock::time_point time) {
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+    return Value::TIMESTAMP(timestamp_t(micros));
+}
+
+// -- system.query_log
+// The log is read at init, so each execution of a prepared statement sees
+// the queries finished up to then
+struct SystemQueryLogState : public GlobalTableFunctionState {
+    vector<QueryLogEntry> entries;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> SystemQueryLogBind(ClientContext &context, TableFunctionBindInput &input,
+                                                   vector<LogicalType> &return_types, vector<string> &names) {
+    names.emplace_back("query_id");
+    names.emplace_back("connection_id");
+    names.emplace_back("type");
+    names.emplace_back("event_time");
+    names.emplace_back("query_start_time");
+    names.emplace_back("query_duration_ms");
+    names.emplace_back("read_rows");
+    names.emplace_back("read_bytes");
+    names.emplace_back("written_bytes");
+    names.emplace_back("result_rows");
+    names.emplace_back("memory_usage");
+    names.emplace_back("query");
+    names.emplace_back("normalized_query_hash");
+
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::TIMESTAMP);
+    return_types.emplace_back(LogicalType::TIMESTAMP);
+    return_types.emplace_back(LogicalType::DOUBLE);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::UBIGINT);
+
+    return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> SystemQueryLogInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto result = make_uniq<SystemQueryLogState>();
+    result->entries = QueryLog::Get(context).GetEntries();
+    return std::move(result);
+}
+
+static void SystemQueryLogFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<SystemQueryLogState>();
+    idx_t count = 0;
+    while (state.offset < state.entries.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &entry = state.entries[state.offset];
+        output.SetValue(0, count, Value::UBIGINT(entry.query_id));
+        output.SetValue(1, count, Value::UBIGINT(entry.connection_id));
+        output.SetValue(2, count, Value("QueryFinish"));
+        output.SetValue(3, count, LogTimestamp(entry.end_time));
+        output.SetValue(4, count, LogTimestamp(entry.start_time));
+        output.SetValue(5, count, Value::DOUBLE(entry.duration_ms));
+        output.SetValue(6, count, Value::UBIGINT(entry.read_rows));
+        output.SetValue(7, count, Value::UBIGINT(entry.read_bytes));
+        output.SetValue(8, count, Value::UBIGINT(entry.written_bytes));
+        output.SetValue(9, count, Value::UBIGINT(entry.result_rows));
+        output.SetValue(10, count, Value::UBIGINT(entry.peak_memory));
+        output.SetValue(11, count, Value(entry.query));
+        output.SetValue(12, count, Value::UBIGINT(entry.normalized_query_hash));
+        count++;
+        state.offset++;
+    }
+    output.SetCardinality(count);
+}
+
+// -- system.processes
+struct ProcessInfo {
+    RunningQuery query;
+    double elapsed = 0;
+    idx_t read_rows = 0;
+    idx_t read_bytes = 0;
+    idx_t total_rows_approx = 0;
+    double progress = 0;
+    idx_t database_memory_usage = 0;
+};
+
+// Like the query log, the running queries are sampled at init
+struct SystemProcessesState : public GlobalTableFunctionState {
+    vector<ProcessInfo> processes;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> SystemProcessesBind(ClientContext &context, TableFunctionBindInput &input,
+                                                    vector<LogicalType> &return_types, vector<string> &names) {
+    names.emplace_back("query_id");
+    names.emplace_back("connection_id");
+    names.emplace_back("elapsed");
+    names.emplace_back("read_rows");
+    names.emplace_back("read_bytes");
+    names.emplace_back("total_rows_approx");
+    names.emplace_back("progress");
+    names.emplace_back("database_memory_usage");
+    names.emplace_back("query_start_time");
+    names.emplace_back("query");
+
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::DOUBLE);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::DOUBLE);
+    return_types.emplace_back(LogicalType::UBIGINT);
+    return_types.emplace_back(LogicalType::TIMESTAMP);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return make_uniq<TableFunctionData>();
+}
+
+static unique_ptr<GlobalTableFunctionState> SystemProcessesInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto result = make_uniq<SystemProcessesState>();
+    auto now = std::chrono::steady_clock::now();
+    // DuckDB does not account memory per query: this is the buffer memory of
+    // the whole database, the same on every row
+    auto database_memory_usage = BufferManager::GetBufferManager(context).GetUsedMemory();
+    for (auto &query : QueryLog::Get(context).GetRunning()) {
+        ProcessInfo process;
+        process.elapsed = std::chrono::duration<double>(now - query.started).count();
+        process.database_memory_usage = database_memory_usage;
+        auto query_context = query.context.lock();
+        if (query_context) {
+            auto state = query_context->registered_state->Get<QueryLogState>("chsql_query_log");
+            if (state) {
+                process.read_bytes = state->read_bytes;
+            }
+            // the executor's progress over the scans, kept up to date while the progress bar is enabled
+            auto progress = query_context->GetQueryProgress();
+            process.read_rows = progress.GetRowsProcesseed();
+            process.total_rows_approx = progress.GetTotalRowsToProcess();
+            process.progress = MaxValue<double>(progress.GetPercentage(), 0);
+        }
+        process.query = std::move(query);
+        result->processes.push_back(std::move(process));
+    }
+    return std::move(result);
+}
+
+static void SystemProcessesFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<SystemProcessesState>();
+    idx_t count = 0;
+    while (state.offset < state.processes.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &process = state.processes[state.offset];
+        output.SetValue(0, count, Value::UBIGINT(process.query.query_id));
+        output.SetValue(1, count, Value::UBIGINT(process.query.connection_id));
+        output.SetValue(2, count, Value::DOUBLE(process.elapsed));
+        output.SetValue(3, count, Value::UBIGINT(process.read_rows));
+        output.SetValue(4, count, Value::UBIGINT(process.read_bytes));
+        output.SetValue(5, count, Value::UBIGINT(process.total_rows_approx));
+        output.SetValue(6, count, Value::DOUBLE(process.progress));
+        output.SetValue(7, count, Value::UBIGINT(process.database_memory_usage));
+        output.SetValue(8, count, LogTimestamp(process.query.start_time));
+        output.SetValue(9, count, Value(process.query.query));
+        count++;
+        state.offset++;
+    }
+    output.SetCardinality(count);
+}
+
+void RegisterQueryLogFunctions(DatabaseInstance &instance) {
+    auto &config = DBConfig::GetConfig(instance);
+    config.AddExtensionOption("chsql_query_log_size", "Finished queries kept in system.query_log",
+                              LogicalType::UBIGINT, Value::UBIGINT(1000));
+    config.extension_callbacks.push_back(make_uniq<QueryLogExtensionCallback>());
+    for (auto &context : ConnectionManager::Get(instance).GetConnectionList()) {
+        AttachQueryLog(*context);
+    }
+
+    auto query_log_func =
+        TableFunction("system_query_log", {}, SystemQueryLogFunction, SystemQueryLogBind, SystemQueryLogInit);
+    ExtensionUtil::RegisterFunction(instance, query_log_func);
+
+    auto processes_func =
+        TableFunction("system_processes", {}, SystemProcessesFunction, SystemProcessesBind, SystemProcessesInit);
+    ExtensionUtil::RegisterFunction(instance, processes_func);
+}
+
+} // namespace duckdb
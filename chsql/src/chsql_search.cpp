@@ -0,0 +1,422 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/execution/expression_executor.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+#include "duckdb/planner/expression/bound_function_expression.hpp"
+#include "re2/re2.h"
+
+#include <cstring>
+
+namespace duckdb {
+
+// -- Aho-Corasick
+
+// A deterministic automaton over all needles, so a haystack is scanned once
+// however many needles there are. Bytes that occur in no needle share one
+// input class, which keeps the transition table small for large needle sets.
+class AhoCorasick {
+public:
+    explicit AhoCorasick(const vector<string> &needles) {
+        memset(classes, 0, sizeof(classes));
+        class_count = 1;
+        for (auto &needle : needles) {
+            for (auto c : needle) {
+                auto &byte_class = classes[static_cast<uint8_t>(c)];
+                if (byte_class == 0) {
+                    byte_class = class_count++;
+                }
+            }
+        }
+        AddNode();
+        for (idx_t i = 0; i < needles.size(); i++) {
+            auto &needle = needles[i];
+            if (needle.empty()) {
+                empty_needle = MinValue(empty_needle, i);
+                continue;
+            }
+            uint32_t node = 0;
+            for (auto c : needle) {
+                auto edge = node * class_count + classes[static_cast<uint8_t>(c)];
+                if (transitions[edge] == NONE) {
+                    // AddNode grows the table, so no reference is held across it
+                    auto child = AddNode();
+                    transitions[edge] = child;
+                }
+                node = transitions[edge];
+            }
+            if (match[node] == NONE) {
+                match[node] = UnsafeNumericCast<uint32_t>(i);
+            }
+            max_length = MaxValue<idx_t>(max_length, needle.size());
+        }
+        lengths.reserve(needles.size());
+        for (auto &needle : needles) {
+            lengths.push_back(needle.size());
+        }
+        Link();
+    }
+
+    bool Any(const char *data, idx_t size) const {
+        if (empty_needle != DConstants::INVALID_INDEX) {
+            return true;
+        }
+        uint32_t node = 0;
+        for (idx_t i = 0; i < size; i++) {
+            node = Next(node, data[i]);
+            if (accepting[node]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 1-based index of the needle found leftmost in the haystack, the
+    // earlier needle when several start at the same byte; 0 if none is found
+    idx_t FirstIndex(const char *data, idx_t size) const {
+        idx_t best_start = empty_needle == DConstants::INVALID_INDEX ? NumericLimits<idx_t>::Maximum() : 0;
+        idx_t best = empty_needle;
+        uint32_t node = 0;
+        for (idx_t i = 0; i < size; i++) {
+            node = Next(node, data[i]);
+            if (accepting[node]) {
+                for (auto t = match[node] != NONE ? node : suffix_match[node]; t != 0; t = suffix_match[t]) {
+                    auto needle = match[t];
+                    auto start = i + 1 - lengths[needle];
+                    if (start < best_start || (start == best_start && needle < best)) {
+                        best_start = start;
+                        best = needle;
+                    }
+                }
+            }
+            // a match ending later starts after the best one
+            if (best != DConstants::INVALID_INDEX && i + 2 > best_start + max_length) {
+                break;
+            }
+        }
+        return best == DConstants::INVALID_INDEX ? 0 : best + 1;
+    }
+
+private:
+    static constexpr uint32_t NONE = NumericLimits<uint32_t>::Maximum();
+
+    // up to 257 classes: one per distinct needle byte, plus class 0
+    uint16_t classes[256];
+    idx_t class_count;
+    // class_count entries per node
+    vector<uint32_t> transitions;
+    // a needle ends at the node or at one of its suffixes
+    vector<bool> accepting;
+    // the needle ending exactly at the node, NONE if none does
+    vector<uint32_t> match;
+    // the longest proper suffix node that a needle ends at, 0 if none
+    vector<uint32_t> suffix_match;
+    vector<uint32_t> failure;
+    vector<idx_t> lengths;
+    idx_t max_length = 0;
+    idx_t empty_needle = DConstants::INVALID_INDEX;
+
+    uint32_t AddNode() {
+        auto node = UnsafeNumericCast<uint32_t>(match.size());
+        transitions.resize(transitions.size() + class_count, NONE);
+        accepting.push_back(false);
+        match.push_back(NONE);
+        suffix_match.push_back(0);
+        failure.push_back(0);
+        return node;
+    }
+
+    uint32_t Next(uint32_t node, char c) const {
+        return transitions[node * class_count + classes[static_cast<uint8_t>(c)]];
+    }
+
+    // Breadth first, so every failure target is complete before it is used
+    void Link() {
+        vector<uint32_t> queue;
+        for (idx_t c = 0; c < class_count; c++) {
+            auto &next = transitions[c];
+            if (next == NONE) {
+                next = 0;
+            } else {
+                queue.push_back(next);
+            }
+        }
+        for (idx_t head = 0; head < queue.size(); head++) {
+            auto node = queue[head];
+            auto fail = failure[node];
+            accepting[node] = match[node] != NONE || accepting[fail];
+            suffix_match[node] = match[fail] != NONE ? fail : suffix_match[fail];
+            for (idx_t c = 0; c < class_count; c++) {
+                auto &next = transitions[node * class_count + c];
+                auto fail_next = transitions[fail * class_count + c];
+                if (next == NONE) {
+                    next = fail_next;
+                } else {
+                    failure[next] = fail_next;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+};
+
+static vector<string> ConstantStrings(ClientContext &context, const string &function, Expression &expr,
+                                      const char *what) {
+    if (!expr.IsFoldable()) {
+        throw BinderException("%s: the %s must be a constant array", function, what);
+    }
+    auto value = ExpressionExecutor::EvaluateScalar(context, expr);
+    value = value.DefaultCastAs(LogicalType::LIST(LogicalType::VARCHAR));
+    if (value.IsNull()) {
+        throw BinderException("%s: the %s cannot be NULL", function, what);
+    }
+    vector<string> result;
+    for (auto &child : ListValue::GetChildren(value)) {
+        if (child.IsNull()) {
+            throw BinderException("%s: the %s cannot contain NULL", function, what);
+        }
+        result.push_back(StringValue::Get(child));
+    }
+    return result;
+}
+
+struct MultiSearchBindData : public FunctionData {
+    vector<string> needles;
+    shared_ptr<AhoCorasick> automaton;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<MultiSearchBindData>();
+        result->needles = needles;
+        result->automaton = automaton;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        return needles == other_p.Cast<MultiSearchBindData>().needles;
+    }
+};
+
+static unique_ptr<FunctionData> MultiSearchBind(ClientContext &context, ScalarFunction &bound_function,
+                                                vector<unique_ptr<Expression>> &arguments) {
+    auto data = make_uniq<MultiSearchBindData>();
+    data->needles = ConstantStrings(context, bound_function.name, *arguments[1], "needles");
+    data->automaton = make_shared_ptr<AhoCorasick>(data->needles);
+    Function::EraseArgument(bound_function, arguments, 1);
+    return std::move(data);
+}
+
+static void MultiSearchAnyFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<MultiSearchBindData>();
+    auto &automaton = *data.automaton;
+    UnaryExecutor::Execute<string_t, bool>(args.data[0], result, args.size(), [&](string_t haystack) {
+        return automaton.Any(haystack.GetData(), haystack.GetSize());
+    });
+}
+
+static void MultiSearchFirstIndexFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<MultiSearchBindData>();
+    auto &automaton = *data.automaton;
+    UnaryExecutor::Execute<string_t, uint64_t>(args.data[0], result, args.size(), [&](string_t haystack) {
+        return automaton.FirstIndex(haystack.GetData(), haystack.GetSize());
+    });
+}
+
+// -- multiMatchAny
+
+// The patterns as one alternation, so RE2 matches all of them in one pass
+struct MultiMatchBindData : public FunctionData {
+    vector<string> patterns;
+    shared_ptr<duckdb_re2::RE2> regex;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<MultiMatchBindData>();
+        result->patterns = patterns;
+        result->regex = regex;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        return patterns == other_p.Cast<MultiMatchBindData>().patterns;
+    }
+};
+
+static unique_ptr<FunctionData> MultiMatchBind(ClientContext &context, ScalarFunction &bound_function,
+                                               vector<unique_ptr<Expression>> &arguments) {
+    auto data = make_uniq<MultiMatchBindData>();
+    data->patterns = ConstantStrings(context, bound_function.name, *arguments[1], "patterns");
+    vector<string> groups;
+    for (auto &pattern : data->patterns) {
+        groups.push_back("(?:" + pattern + ")");
+    }
+    duckdb_re2::RE2::Options options;
+    options.set_log_errors(false);
+    // large pattern sets need more than the default 8MB to stay on the DFA
+    options.set_max_mem(int64_t(256) << 20);
+    // with no patterns nothing matches and regex stays null
+    if (!groups.empty()) {
+        data->regex = make_shared_ptr<duckdb_re2::RE2>(StringUtil::Join(groups, "|"), options);
+    }
+    if (data->regex && !data->regex->ok()) {
+        throw BinderException("%s: %s", bound_function.name, data->regex->error());
+    }
+    Function::EraseArgument(bound_function, arguments, 1);
+    return std::move(data);
+}
+
+static void MultiMatchAnyFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &data = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<MultiMatchBindData>();
+    if (!data.regex) {
+        UnaryExecutor::Execute<string_t, bool>(args.data[0], result, args.size(), [&](string_t) { return false; });
+        return;
+    }
+    auto &regex = *data.regex;
+    UnaryExecutor::Execute<string_t, bool>(args.data[0], result, args.size(), [&](string_t haystack) {
+        return duckdb_re2::RE2::PartialMatch(duckdb_re2::StringPiece(haystack.GetData(), haystack.GetSize()),
+                                             regex);
+    });
+}
+
+// -- hasToken
+
+// Tokens are maximal runs of ASCII letters and digits and non-ASCII bytes
+static bool IsTokenSeparator(char c) {
+    auto byte = static_cast<uint8_t>(c);
+    return byte < 0x80 && !StringUtil::CharacterIsAlphaNumeric(c);
+}
+
+struct HasTokenBindData : public FunctionData {
+    string token;
+
+    unique_ptr<FunctionData> Copy() const override {
+        auto result = make_uniq<HasTokenBindData>();
+        result->token = token;
+        return std::move(result);
+    }
+    bool Equals(const FunctionData &other_p) const override {
+        return token == other_p.Cast<HasTokenBindData>().token;
+    }
+};
+
+template <bool CASE_INSENSITIVE>
+static unique_ptr<FunctionData> HasTokenBind(ClientContext &context, ScalarFunction &bound_function,
+                                             vector<unique_ptr<Expression>> &arguments) {
+    auto &name = bound_function.name;
+    if (!arguments[1]->IsFoldable()) {
+        throw BinderException("%s: the token must be a constant", name);
+    }
+    auto value = ExpressionExecutor::EvaluateScalar(context, *arguments[1]);
+    if (value.IsNull()) {
+        throw BinderException("%s: the token cannot be NULL", name);
+    }
+    auto data = make_uniq<HasTokenBindData>();
+    data->token = StringValue::Get(value);
+    for (auto c : data->token) {
+        if (IsTokenSeparator(c)) {
+            throw BinderException("%s: the token '%s' must not contain whitespace or separator characters", name,
+                                  data->token);
+        }
+    }
+    if (CASE_INSENSITIVE) {
+        data->token = StringUtil::Lower(data->token);
+    }
+    Function::EraseArgument(bound_function, arguments, 1);
+    return std::move(data);
+}
+
+// Candidates come from memchr on the first byte, which libc scans with SIMD;
+// a candidate counts when the bytes around it are separators
+static bool HasToken(const char *data, idx_t size, const string &token) {
+    auto length = token.size();
+    if (length == 0 || length > size) {
+        return false;
+    }
+    auto first = token[0];
+    auto end = data + size - length;
+    for (auto pos = data; pos <= end;) {
+        auto found = static_cast<const char *>(memchr(pos, first, UnsafeNumericCast<size_t>(end - pos + 1)));
+        if (!found) {
+            return false;
+        }
+        if ((found == data || IsTokenSeparator(found[-1])) && memcmp(found, token.data(), length) == 0 &&
+            (found == end || IsTokenSeparator(found[length]))) {
+            return true;
+        }
+        pos = found + 1;
+    }
+    return false;
+}
+
+static const char *FindByte(const char *pos, const char *end, char c) {
+    if (pos > end) {
+        return end + 1;
+    }
+    auto found = static_cast<const char *>(memchr(pos, c, UnsafeNumericCast<size_t>(end - pos + 1)));
+    return found ? found : end + 1;
+}
+
+// As HasToken, with one memchr per case of the first byte; the token is
+// already lowercase
+static bool HasTokenCaseInsensitive(const char *data, idx_t size, const string &token) {
+    auto length = token.size();
+    if (length == 0 || length > size) {
+        return false;
+    }
+    auto lower = token[0];
+    auto upper = StringUtil::CharacterToUpper(lower);
+    auto end = data + size - length;
+    auto next_lower = FindByte(data, end, lower);
+    auto next_upper = upper == lower ? end + 1 : FindByte(data, end, upper);
+    while (true) {
+        auto found = MinValue(next_lower, next_upper);
+        if (found > end) {
+            return false;
+        }
+        if ((found == data || IsTokenSeparator(found[-1])) && (found == end || IsTokenSeparator(found[length]))) {
+            idx_t k = 1;
+            while (k < length && StringUtil::CharacterToLower(found[k]) == token[k]) {
+                k++;
+            }
+            if (k == length) {
+                return true;
+            }
+        }
+        if (found == next_lower) {
+            next_lower = FindByte(found + 1, end, lower);
+        } else {
+            next_upper = FindByte(found + 1, end, upper);
+        }
+    }
+}
+
+template <bool CASE_INSENSITIVE>
+static void HasTokenFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    auto &token = state.expr.Cast<BoundFunctionExpression>().bind_info->Cast<HasTokenBindData>().token;
+    UnaryExecutor::Execute<string_t, bool>(args.data[0], result, args.size(), [&](string_t haystack) {
+        if (CASE_INSENSITIVE) {
+            return HasTokenCaseInsensitive(haystack.GetData(), haystack.GetSize(), token);
+        }
+        return HasToken(haystack.GetData(), haystack.GetSize(), token);
+    });
+}
+
+void RegisterSearchFunctions(DatabaseInstance &instance) {
+    auto strings = LogicalType::LIST(LogicalType::VARCHAR);
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("multiSearchAny", {LogicalType::VARCHAR, strings},
+                                                             LogicalType::BOOLEAN, MultiSearchAnyFunction,
+                                                             MultiSearchBind));
+    ExtensionUtil::RegisterFunction(instance,
+                                    ScalarFunction("multiSearchFirstIndex", {LogicalType::VARCHAR, strings},
+                                                   LogicalType::UBIGINT, MultiSearchFirstIndexFunction,
+                                                   MultiSearchBind));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("multiMatchAny", {LogicalType::VARCHAR, strings},
+                                                             LogicalType::BOOLEAN, MultiMatchAnyFunction,
+                                                             MultiMatchBind));
+    ExtensionUtil::RegisterFunction(instance,
+                                    ScalarFunction("hasToken", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                                                   LogicalType::BOOLEAN, HasTokenFunction<false>,
+                                                   HasTokenBind<false>));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("hasTokenCaseInsensitive",
+                                                             {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                                                             LogicalType::BOOLEAN, HasTokenFunction<true>,
+                                                             HasTokenBind<true>));
+}
+
+} // namespace duckdb
@@ -4,6 +4,15 @@
 #include "duckdb/main/extension_util.hpp"
 #include "duckdb/main/client_context.hpp"
 #include "duckdb/catalog/catalog.hpp"
+#include "duckdb/catalog/catalog_entry/schema_catalog_entry.hpp"
+#include "duckdb/catalog/catalog_entry/table_catalog_entry.hpp"
+#include "duckdb/catalog/catalog_entry/view_catalog_entry.hpp"
+#include "duckdb/main/attached_database.hpp"
+#include "duckdb/main/database_manager.hpp"
+#include "duckdb/planner/expression/list.hpp"
+#include "duckdb/planner/operator/logical_get.hpp"
+#include "duckdb/storage/database_size.hpp"
+#include "duckdb/common/types/hash.hpp"
 #include "duckdb/main/connection.hpp"
 #include "duckdb/main/query_result.hpp"
 #include "duckdb/main/materialized_query_result.hpp"
@@ -28,140 +37,168 @@
 
 namespace duckdb {
 // -- System code from chsql_system
-struct SystemDatabasesData : public TableFunctionData {
-    vector<Value> names;
-    vector<Value> engines;
-    vector<Value> data_paths;
-    vector<Value> metadata_paths;
-    vector<Value> uuids;
-    vector<Value> engine_full;
-    vector<Value> comments;
-    idx_t offset = 0;
-};
-
-struct SystemTablesData : public TableFunctionData {
-    vector<Value> databases;
-    vector<Value> names;
-    vector<Value> uuids;
-    vector<Value> engines;
-    vector<Value> is_temporary;
-    vector<Value> data_paths;
-    vector<Value> metadata_paths;
-    vector<Value> metadata_modification_times;
-    vector<Value> metadata_versions;
-    vector<Value> create_table_queries;
-    idx_t offset = 0;
+// system.databases, system.tables, system.columns and system.disks walk the
+// catalog while they are scanned and write their vectors directly, one batch
+// at a time. Equality and IN filters on the database and table names are
+// pushed down so that the catalogs and tables not asked for are never walked;
+// the filters also stay in the plan, the pushdown only prunes.
+struct SystemCatalogData : public TableFunctionData {
+    // the columns holding database and table names, or INVALID_INDEX
+    column_t database_column = DConstants::INVALID_INDEX;
+    column_t table_column = DConstants::INVALID_INDEX;
+    // accepted names per filtered column; other columns accept everything
+    unordered_map<column_t, unordered_set<string>> accepted;
+
+    bool Accepts(column_t column, const string &name) const {
+        auto entry = accepted.find(column);
+        return entry == accepted.end() || entry->second.count(name) > 0;
+    }
 };
 
-struct SystemColumnsData : public TableFunctionData {
-    vector<Value> databases;
-    vector<Value> tables;
-    vector<Value> column_names;
-    vector<Value> column_types;
-    vector<Value> positions;
-    vector<Value> comments;
-    idx_t offset = 0;
+struct SystemCatalogState : public GlobalTableFunctionState {
+    vector<column_t> column_ids;
+    vector<reference<AttachedDatabase>> databases;
+    idx_t database_idx = 0;
+    // the tables of the database walked last
+    vector<reference<CatalogEntry>> entries;
+    idx_t entry_idx = 0;
+    // the next column of the current entry, for system.columns
+    idx_t column_idx = 0;
 };
 
-struct SystemFunctionsData : public TableFunctionData {
-    vector<Value> names;
-    vector<Value> is_aggregate;
-    vector<Value> case_insensitive;
-    vector<Value> descriptions;
-    idx_t offset = 0;
-};
-
-static void SystemDatabasesFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
-    auto &data = (SystemDatabasesData &)*data_p.bind_data;
-    if (data.offset >= data.names.size()) {
-        return;
+static bool NameFilterColumn(LogicalGet &get, Expression &expr, column_t &column) {
+    if (expr.GetExpressionClass() != ExpressionClass::BOUND_COLUMN_REF) {
+        return false;
     }
-
-    idx_t count = 0;
-    while (data.offset < data.names.size() && count < STANDARD_VECTOR_SIZE) {
-        output.SetValue(0, count, data.names[data.offset]);           // name
-        output.SetValue(1, count, data.engines[data.offset]);         // engine
-        output.SetValue(2, count, data.data_paths[data.offset]);      // data_path
-        output.SetValue(3, count, data.metadata_paths[data.offset]);  // metadata_path
-        output.SetValue(4, count, data.uuids[data.offset]);           // uuid
-        output.SetValue(5, count, data.engine_full[data.offset]);     // engine_full
-        output.SetValue(6, count, data.comments[data.offset]);        // comment
-        
-        count++;
-        data.offset++;
+    auto &ref = expr.Cast<BoundColumnRefExpression>();
+    if (ref.binding.table_index != get.table_index) {
+        return false;
     }
-
-    output.SetCardinality(count);
+    column = get.GetColumnIds()[ref.binding.column_index].GetPrimaryIndex();
+    return true;
 }
 
-static void SystemTablesFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
-    auto &data = (SystemTablesData &)*data_p.bind_data;
-    if (data.offset >= data.databases.size()) {
-        return;
+static bool NameFilterValue(Expression &expr, vector<string> &values) {
+    if (expr.GetExpressionClass() != ExpressionClass::BOUND_CONSTANT) {
+        return false;
+    }
+    auto &value = expr.Cast<BoundConstantExpression>().value;
+    if (value.IsNull() || value.type().id() != LogicalTypeId::VARCHAR) {
+        return false;
     }
+    values.push_back(StringValue::Get(value));
+    return true;
+}
 
-    idx_t count = 0;
-    while (data.offset < data.databases.size() && count < STANDARD_VECTOR_SIZE) {
-        output.SetValue(0, count, data.databases[data.offset]);       // database
-        output.SetValue(1, count, data.names[data.offset]);           // name
-        output.SetValue(2, count, data.uuids[data.offset]);           // uuid
-        output.SetValue(3, count, data.engines[data.offset]);         // engine
-        output.SetValue(4, count, data.is_temporary[data.offset]);    // is_temporary
-        output.SetValue(5, count, data.data_paths[data.offset]);      // data_path
-        output.SetValue(6, count, data.metadata_paths[data.offset]);  // metadata_path
-        output.SetValue(7, count, data.metadata_modification_times[data.offset]); // metadata_modification_time
-        output.SetValue(8, count, data.metadata_versions[data.offset]); // metadata_version
-        output.SetValue(9, count, data.create_table_queries[data.offset]); // create_table_query
-        
-        count++;
-        data.offset++;
+// name = 'x', 'x' = name and name IN ('x', 'y')
+static bool ExtractNameFilter(LogicalGet &get, Expression &expr, column_t &column, vector<string> &values) {
+    if (expr.GetExpressionType() == ExpressionType::COMPARE_EQUAL) {
+        auto &comparison = expr.Cast<BoundComparisonExpression>();
+        if (NameFilterColumn(get, *comparison.left, column)) {
+            return NameFilterValue(*comparison.right, values);
+        }
+        return NameFilterColumn(get, *comparison.right, column) && NameFilterValue(*comparison.left, values);
     }
+    if (expr.GetExpressionType() == ExpressionType::COMPARE_IN) {
+        auto &op = expr.Cast<BoundOperatorExpression>();
+        if (!NameFilterColumn(get, *op.children[0], column)) {
+            return false;
+        }
+        for (idx_t i = 1; i < op.children.size(); i++) {
+            if (!NameFilterValue(*op.children[i], values)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
 
-    output.SetCardinality(count);
+static void SystemCatalogPushdown(ClientContext &context, LogicalGet &get, FunctionData *bind_data_p,
+                                  vector<unique_ptr<Expression>> &filters) {
+    auto &data = bind_data_p->Cast<SystemCatalogData>();
+    for (auto &filter : filters) {
+        column_t column;
+        vector<string> values;
+        if (!ExtractNameFilter(get, *filter, column, values)) {
+            continue;
+        }
+        if (column != data.database_column && column != data.table_column) {
+            continue;
+        }
+        unordered_set<string> accepted;
+        for (auto &value : values) {
+            if (data.Accepts(column, value)) {
+                accepted.insert(value);
+            }
+        }
+        data.accepted[column] = std::move(accepted);
+    }
 }
 
-static void SystemFunctionsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
-    auto &data = (SystemFunctionsData &)*data_p.bind_data;
-    if (data.offset >= data.names.size()) {
-        return;
+static unique_ptr<GlobalTableFunctionState> SystemCatalogInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto &data = input.bind_data->Cast<SystemCatalogData>();
+    auto result = make_uniq<SystemCatalogState>();
+    result->column_ids = input.column_ids;
+    for (auto &database : DatabaseManager::Get(context).GetDatabases(context)) {
+        if (data.Accepts(data.database_column, database.get().GetName())) {
+            result->databases.push_back(database);
+        }
     }
+    return std::move(result);
+}
 
-    idx_t count = 0;
-    while (data.offset < data.names.size() && count < STANDARD_VECTOR_SIZE) {
-        output.SetValue(0, count, data.names[data.offset]);           // name
-        output.SetValue(1, count, data.is_aggregate[data.offset]);    // is_aggregate
-        output.SetValue(2, count, data.case_insensitive[data.offset]); // case_insensitive
-        output.SetValue(3, count, data.descriptions[data.offset]);    // description
-        
-        count++;
-        data.offset++;
+// Moves to the next table, walking the next database once the tables of the
+// current one are done. Views are only listed when asked for, and DuckDB's
+// internal ones, e.g. information_schema and pg_catalog, never.
+static bool NextCatalogEntry(ClientContext &context, const SystemCatalogData &data, SystemCatalogState &state,
+                             bool views) {
+    while (state.entry_idx >= state.entries.size()) {
+        if (state.database_idx >= state.databases.size()) {
+            return false;
+        }
+        auto &catalog = state.databases[state.database_idx++].get().GetCatalog();
+        state.entries.clear();
+        state.entry_idx = 0;
+        state.column_idx = 0;
+        for (auto &schema : catalog.GetSchemas(context)) {
+            schema.get().Scan(context, CatalogType::TABLE_ENTRY, [&](CatalogEntry &entry) {
+                if (entry.internal ||
+                    (entry.type != CatalogType::TABLE_ENTRY && !(views && entry.type == CatalogType::VIEW_ENTRY))) {
+                    return;
+                }
+                if (data.Accepts(data.table_column, entry.name)) {
+                    state.entries.push_back(entry);
+                }
+            });
+        }
     }
+    return true;
+}
 
-    output.SetCardinality(count);
+static void SetString(Vector &vector, idx_t row, const string &value) {
+    FlatVector::GetData<string_t>(vector)[row] = StringVector::AddString(vector, value);
 }
 
-static void SystemColumnsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
-    auto &data = (SystemColumnsData &)*data_p.bind_data;
-    if (data.offset >= data.databases.size()) {
-        return;
-    }
+template <class T>
+static void SetData(Vector &vector, idx_t row, T value) {
+    FlatVector::GetData<T>(vector)[row] = value;
+}
 
-    idx_t count = 0;
-    while (data.offset < data.databases.size() && count < STANDARD_VECTOR_SIZE) {
-        output.SetValue(0, count, data.databases[data.offset]);    // database
-        output.SetValue(1, count, data.tables[data.offset]);       // table
-        output.SetValue(2, count, data.column_names[data.offset]); // column name
-        output.SetValue(3, count, data.column_types[data.offset]); // column type
-        output.SetValue(4, count, data.positions[data.offset]);    // position
-        output.SetValue(5, count, data.comments[data.offset]);     // comment
-        
-        count++;
-        data.offset++;
-    }
+// A stable uuid for catalog objects, which have none in DuckDB
+static hugeint_t CatalogUUID(const string &scope, const string &name) {
+    return hugeint_t(static_cast<int64_t>(Hash(scope.c_str())), Hash(name.c_str()));
+}
 
-    output.SetCardinality(count);
+static TableFunction SystemCatalogFunction(const string &name, table_function_t function,
+                                           table_function_bind_t bind) {
+    TableFunction result(name, {}, function, bind, SystemCatalogInit);
+    result.projection_pushdown = true;
+    result.pushdown_complex_filter = SystemCatalogPushdown;
+    return result;
 }
 
+// system.databases
 static unique_ptr<FunctionData> SystemDatabasesBind(ClientContext &context, TableFunctionBindInput &input,
                                                   vector<LogicalType> &return_types, vector<string> &names) {
     // Define columns
@@ -181,29 +218,68 @@ static unique_ptr<FunctionData> SystemDatabasesBind(ClientContext &context, Tabl
     return_types.emplace_back(LogicalType::VARCHAR);
     return_types.emplace_back(LogicalType::VARCHAR);
 
-    auto result = make_uniq<SystemDatabasesData>();
+    auto result = make_uniq<SystemCatalogData>();
+    result->database_column = 0;
+    return std::move(result);
+}
 
-    // Get databases using duckdb_databases()
-    Connection con(Catalog::GetSystemCatalog(context).GetDatabase());
-    auto database_result = con.Query("SELECT database_name, 'duckdb' as engine, path as data_path, '' as metadata_path, "
-                                     "database_name as uuid, 'DuckDB' as engine_full, comment "
-                                     "FROM duckdb_databases()");
+// the file of a database, NULL for in-memory and internal ones
+static Value DatabasePath(AttachedDatabase &database) {
+    if (database.IsSystem() || database.IsTemporary() || database.GetCatalog().InMemory()) {
+        return Value();
+    }
+    return Value(database.GetCatalog().GetDBPath());
+}
 
-    if (!database_result->HasError()) {
-        for (auto &row : *database_result) {
-            result->names.push_back(row.GetValue<std::string>(0));          // name
-            result->engines.push_back(row.GetValue<std::string>(1));        // engine
-            result->data_paths.push_back(row.GetValue<std::string>(2));     // data_path
-            result->metadata_paths.push_back(row.GetValue<std::string>(3)); // metadata_path
-            result->uuids.push_back(Value::UUID(row.GetValue<std::string>(4))); // uuid
-            result->engine_full.push_back(row.GetValue<std::string>(5));    // engine_full
-            result->comments.push_back(row.GetValue<std::string>(6));       // comment
+static void SystemDatabasesFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<SystemCatalogState>();
+    idx_t count = 0;
+    while (state.database_idx < state.databases.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &database = state.databases[state.database_idx++].get();
+        for (idx_t col = 0; col < state.column_ids.size(); col++) {
+            auto &vector = output.data[col];
+            switch (state.column_ids[col]) {
+            case 0: // name
+                SetString(vector, count, database.GetName());
+                break;
+            case 1: // engine
+                SetString(vector, count, "duckdb");
+                break;
+            case 2: { // data_path
+                auto path = DatabasePath(database);
+                if (path.IsNull()) {
+                    FlatVector::SetNull(vector, count, true);
+                } else {
+                    SetString(vector, count, StringValue::Get(path));
+                }
+                break;
+            }
+            case 3: // metadata_path
+                SetString(vector, count, "");
+                break;
+            case 4: // uuid
+                SetData(vector, count, CatalogUUID("", database.GetName()));
+                break;
+            case 5: // engine_full
+                SetString(vector, count, "DuckDB");
+                break;
+            case 6: // comment
+                if (database.comment.IsNull()) {
+                    FlatVector::SetNull(vector, count, true);
+                } else {
+                    SetString(vector, count, database.comment.ToString());
+                }
+                break;
+            default:
+                FlatVector::SetNull(vector, count, true);
+            }
         }
+        count++;
     }
-
-    return std::move(result);
+    output.SetCardinality(count);
 }
 
+// system.tables
 static unique_ptr<FunctionData> SystemTablesBind(ClientContext &context, TableFunctionBindInput &input,
                                                vector<LogicalType> &return_types, vector<string> &names) {
     // Define columns
@@ -229,34 +305,290 @@ static unique_ptr<FunctionData> SystemTablesBind(ClientContext &context, TableFu
     return_types.emplace_back(LogicalType::INTEGER);
     return_types.emplace_back(LogicalType::VARCHAR);
 
-    auto result = make_uniq<SystemTablesData>();
+    auto result = make_uniq<SystemCatalogData>();
+    result->database_column = 0;
+    result->table_column = 1;
+    return std::move(result);
+}
 
-    // Get tables using duckdb_tables()
-    Connection con(Catalog::GetSystemCatalog(context).GetDatabase());
-    auto table_result = con.Query("SELECT database_name, table_name, table_name as uuid, "
-                                  "'BASE TABLE' as engine, false as is_temporary, '' as data_path, "
-                                  "'' as metadata_path, '1970-01-01 00:00:00' as metadata_modification_time, "
-                                  "0 as metadata_version, sql as create_table_query "
-                                  "FROM duckdb_tables()");
-
-    if (!table_result->HasError()) {
-        for (auto &row : *table_result) {
-            result->databases.push_back(row.GetValue<std::string>(0));      // database
-            result->names.push_back(row.GetValue<std::string>(1));          // name
-            result->uuids.push_back(Value::UUID(row.GetValue<std::string>(2))); // uuid (placeholder using table name hash)
-            result->engines.push_back(row.GetValue<std::string>(3));        // engine
-            result->is_temporary.push_back(row.GetValue<bool>(4));          // is_temporary
-            result->data_paths.push_back(row.GetValue<std::string>(5));     // data_path
-            result->metadata_paths.push_back(row.GetValue<std::string>(6)); // metadata_path
-            result->metadata_modification_times.push_back(Value::TIMESTAMP(row.GetValue<timestamp_t>(7))); // metadata_modification_time
-            result->metadata_versions.push_back(row.GetValue<int32_t>(8));  // metadata_version
-            result->create_table_queries.push_back(row.GetValue<std::string>(9)); // create_table_query
+static void SystemTablesFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<SystemCatalogData>();
+    auto &state = data_p.global_state->Cast<SystemCatalogState>();
+    idx_t count = 0;
+    while (count < STANDARD_VECTOR_SIZE && NextCatalogEntry(context, data, state, false)) {
+        auto &table = state.entries[state.entry_idx++].get().Cast<TableCatalogEntry>();
+        auto &database = table.ParentCatalog().GetName();
+        for (idx_t col = 0; col < state.column_ids.size(); col++) {
+            auto &vector = output.data[col];
+            switch (state.column_ids[col]) {
+            case 0: // database
+                SetString(vector, count, database);
+                break;
+            case 1: // name
+                SetString(vector, count, table.name);
+                break;
+            case 2: // uuid
+                SetData(vector, count, CatalogUUID(database + "." + table.ParentSchema().name, table.name));
+                break;
+            case 3: // engine
+                SetString(vector, count, "BASE TABLE");
+                break;
+            case 4: // is_temporary
+                SetData(vector, count, table.temporary);
+                break;
+            case 5: // data_path
+            case 6: // metadata_path
+                SetString(vector, count, "");
+                break;
+            case 7: // metadata_modification_time
+                SetData(vector, count, timestamp_t(0));
+                break;
+            case 8: // metadata_version
+                SetData(vector, count, int32_t(0));
+                break;
+            case 9: // create_table_query
+                SetString(vector, count, table.ToSQL());
+                break;
+            default:
+                FlatVector::SetNull(vector, count, true);
+            }
+        }
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+// system.columns, of tables and views
+static unique_ptr<FunctionData> SystemColumnsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                 vector<LogicalType> &return_types, vector<string> &names) {
+    // Core columns
+    names.emplace_back("database");
+    names.emplace_back("table");
+    names.emplace_back("name");
+    names.emplace_back("type");
+    names.emplace_back("position");
+    names.emplace_back("comment");
+
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::VARCHAR);
+    return_types.emplace_back(LogicalType::INTEGER);
+    return_types.emplace_back(LogicalType::VARCHAR);
+
+    auto result = make_uniq<SystemCatalogData>();
+    result->database_column = 0;
+    result->table_column = 1;
+    return std::move(result);
+}
+
+static void SystemColumnsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = data_p.bind_data->Cast<SystemCatalogData>();
+    auto &state = data_p.global_state->Cast<SystemCatalogState>();
+    idx_t count = 0;
+    while (count < STANDARD_VECTOR_SIZE && NextCatalogEntry(context, data, state, true)) {
+        auto &entry = state.entries[state.entry_idx].get();
+        optional_ptr<TableCatalogEntry> table;
+        optional_ptr<ViewCatalogEntry> view;
+        idx_t column_count;
+        if (entry.type == CatalogType::TABLE_ENTRY) {
+            table = entry.Cast<TableCatalogEntry>();
+            column_count = table->GetColumns().LogicalColumnCount();
+        } else {
+            view = entry.Cast<ViewCatalogEntry>();
+            column_count = view->names.size();
+        }
+        for (; state.column_idx < column_count && count < STANDARD_VECTOR_SIZE; state.column_idx++, count++) {
+            auto column_idx = state.column_idx;
+            for (idx_t col = 0; col < state.column_ids.size(); col++) {
+                auto &vector = output.data[col];
+                switch (state.column_ids[col]) {
+                case 0: // database
+                    SetString(vector, count, entry.ParentCatalog().GetName());
+                    break;
+                case 1: // table
+                    SetString(vector, count, entry.name);
+                    break;
+                case 2: // name
+                    SetString(vector, count,
+                              table ? table->GetColumn(LogicalIndex(column_idx)).Name() : view->names[column_idx]);
+                    break;
+                case 3: // type
+                    SetString(vector, count,
+                              table ? table->GetColumn(LogicalIndex(column_idx)).Type().ToString()
+                                    : view->types[column_idx].ToString());
+                    break;
+                case 4: // position
+                    SetData(vector, count, NumericCast<int32_t>(column_idx));
+                    break;
+                case 5: { // comment
+                    Value comment;
+                    if (table) {
+                        comment = table->GetColumn(LogicalIndex(column_idx)).Comment();
+                    } else if (column_idx < view->column_comments.size()) {
+                        comment = view->column_comments[column_idx];
+                    }
+                    SetString(vector, count, comment.IsNull() ? "" : comment.ToString());
+                    break;
+                }
+                default:
+                    FlatVector::SetNull(vector, count, true);
+                }
+            }
+        }
+        if (state.column_idx >= column_count) {
+            state.entry_idx++;
+            state.column_idx = 0;
         }
     }
+    output.SetCardinality(count);
+}
+
+// system.disks, one per database
+static unique_ptr<FunctionData> SystemDisksBind(ClientContext &context, TableFunctionBindInput &input, vector<LogicalType> &return_types, vector<string> &names) {
+    return_types.emplace_back(LogicalType::VARCHAR); // name
+    names.emplace_back("name");
+
+    return_types.emplace_back(LogicalType::VARCHAR); // path
+    names.emplace_back("path");
+
+    return_types.emplace_back(LogicalType::BIGINT); // free_space
+    names.emplace_back("free_space");
+
+    return_types.emplace_back(LogicalType::BIGINT); // total_space
+    names.emplace_back("total_space");
+
+    return_types.emplace_back(LogicalType::BIGINT); // unreserved_space
+    names.emplace_back("unreserved_space");
+
+    return_types.emplace_back(LogicalType::BIGINT); // keep_free_space
+    names.emplace_back("keep_free_space");
+
+    return_types.emplace_back(LogicalType::VARCHAR); // type
+    names.emplace_back("type");
+
+    return_types.emplace_back(LogicalType::VARCHAR); // object_storage_type
+    names.emplace_back("object_storage_type");
+
+    return_types.emplace_back(LogicalType::VARCHAR); // metadata_type
+    names.emplace_back("metadata_type");
+
+    return_types.emplace_back(LogicalType::BOOLEAN); // is_encrypted
+    names.emplace_back("is_encrypted");
+
+    return_types.emplace_back(LogicalType::BOOLEAN); // is_read_only
+    names.emplace_back("is_read_only");
+
+    return_types.emplace_back(LogicalType::BOOLEAN); // is_write_once
+    names.emplace_back("is_write_once");
 
+    return_types.emplace_back(LogicalType::BOOLEAN); // is_remote
+    names.emplace_back("is_remote");
+
+    return_types.emplace_back(LogicalType::BOOLEAN); // is_broken
+    names.emplace_back("is_broken");
+
+    return_types.emplace_back(LogicalType::VARCHAR); // cache_path
+    names.emplace_back("cache_path");
+
+    auto result = make_uniq<SystemCatalogData>();
+    result->database_column = 0;
     return std::move(result);
 }
 
+static void SystemDisksFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<SystemCatalogState>();
+    idx_t count = 0;
+    while (state.database_idx < state.databases.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &database = state.databases[state.database_idx++].get();
+        // only computed when a size column is read
+        optional_ptr<DatabaseSize> size;
+        DatabaseSize database_size;
+        auto get_size = [&]() -> DatabaseSize & {
+            if (!size) {
+                database_size = database.GetCatalog().GetDatabaseSize(context);
+                size = database_size;
+            }
+            return *size;
+        };
+        for (idx_t col = 0; col < state.column_ids.size(); col++) {
+            auto &vector = output.data[col];
+            switch (state.column_ids[col]) {
+            case 0: // name
+                SetString(vector, count, database.GetName());
+                break;
+            case 1: { // path
+                auto path = DatabasePath(database);
+                SetString(vector, count, path.IsNull() ? "" : StringValue::Get(path));
+                break;
+            }
+            case 2: // free_space
+            case 4: // unreserved_space
+                SetData(vector, count, NumericCast<int64_t>(get_size().free_blocks * get_size().block_size));
+                break;
+            case 3: // total_space
+                SetData(vector, count, NumericCast<int64_t>(get_size().total_blocks * get_size().block_size));
+                break;
+            case 5: // keep_free_space, no equivalent in DuckDB
+                SetData(vector, count, int64_t(0));
+                break;
+            case 6: // type
+                SetString(vector, count, "Local");
+                break;
+            case 7: // object_storage_type
+            case 8: // metadata_type
+                SetString(vector, count, "None");
+                break;
+            case 10: // is_read_only
+                SetData(vector, count, database.IsReadOnly());
+                break;
+            case 9:  // is_encrypted
+            case 11: // is_write_once
+            case 12: // is_remote
+            case 13: // is_broken
+                SetData(vector, count, false);
+                break;
+            case 14: // cache_path
+                SetString(vector, count, "");
+                break;
+            default:
+                FlatVector::SetNull(vector, count, true);
+            }
+        }
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+// system.functions
+struct SystemFunctionsData : public TableFunctionData {
+    vector<Value> names;
+    vector<Value> is_aggregate;
+    vector<Value> case_insensitive;
+    vector<Value> descriptions;
+    idx_t offset = 0;
+};
+
+static void SystemFunctionsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &data = (SystemFunctionsData &)*data_p.bind_data;
+    if (data.offset >= data.names.size()) {
+        return;
+    }
+
+    idx_t count = 0;
+    while (data.offset < data.names.size() && count < STANDARD_VECTOR_SIZE) {
+        output.SetValue(0, count, data.names[data.offset]);           // name
+        output.SetValue(1, count, data.is_aggregate[data.offset]);    // is_aggregate
+        output.SetValue(2, count, data.case_insensitive[data.offset]); // case_insensitive
+        output.SetValue(3, count, data.descriptions[data.offset]);    // description
+        
+        count++;
+        data.offset++;
+    }
+
+    output.SetCardinality(count);
+}
+
 static unique_ptr<FunctionData> SystemFunctionsBind(ClientContext &context, TableFunctionBindInput &input,
                                                   vector<LogicalType> &return_types, vector<string> &names) {
     // Define columns
@@ -290,53 +622,6 @@ static unique_ptr<FunctionData> SystemFunctionsBind(ClientContext &context, Tabl
     return std::move(result);
 }
 
-static unique_ptr<FunctionData> SystemColumnsBind(ClientContext &context, TableFunctionBindInput &input,
-                                                 vector<LogicalType> &return_types, vector<string> &names) {
-    // Core columns
-    names.emplace_back("database");
-    names.emplace_back("table");
-    names.emplace_back("name");
-    names.emplace_back("type");
-    names.emplace_back("position");
-    names.emplace_back("comment");
-
-    return_types.emplace_back(LogicalType::VARCHAR);
-    return_types.emplace_back(LogicalType::VARCHAR);
-    return_types.emplace_back(LogicalType::VARCHAR);
-    return_types.emplace_back(LogicalType::VARCHAR);
-    return_types.emplace_back(LogicalType::INTEGER);
-    return_types.emplace_back(LogicalType::VARCHAR);
-
-    auto result = make_uniq<SystemColumnsData>();
-    
-    // Get tables using SHOW ALL TABLES
-    Connection con(Catalog::GetSystemCatalog(context).GetDatabase());
-    auto table_result = con.Query("SHOW ALL TABLES");
-    
-    if (!table_result->HasError()) {
-        for (auto &row : *table_result) {
-            string database = row.GetValue<std::string>(0); // database
-            string schema = row.GetValue<std::string>(1);   // schema
-            string table = row.GetValue<std::string>(2);    // table
-            
-            // Get columns for each table
-            auto column_result = con.Query("PRAGMA table_info(" + schema + "." + table + ")");
-            if (!column_result->HasError()) {
-                for (auto &col_row : *column_result) {
-                    result->databases.push_back(Value(database));          // database
-                    result->tables.push_back(Value(table));                // table
-                    result->column_names.push_back(col_row.GetValue<Value>(1)); // column name
-                    result->column_types.push_back(col_row.GetValue<Value>(2)); // column type
-                    result->positions.push_back(col_row.GetValue<Value>(0));    // position
-                    result->comments.push_back(Value("")); // comment (placeholder)
-                }
-            }
-        }
-    }
-
-    return std::move(result);
-}
-
 // Function to get the process uptime in seconds for Linux
 #if defined(__linux__)
 int64_t GetProcessUptime() {
@@ -404,172 +689,18 @@ static void SystemUptimeFunction(DataChunk &input, ExpressionState &state, Vecto
     FlatVector::SetNull(result, 0, false);
 }
 
-// system.disks
-struct SystemDisksData : public TableFunctionData {
-    vector<Value> names;
-    vector<Value> paths;
-    vector<Value> free_spaces;
-    vector<Value> total_spaces;
-    vector<Value> unreserved_spaces;
-    vector<Value> keep_free_spaces;
-    vector<Value> types;
-    vector<Value> object_storage_types;
-    vector<Value> metadata_types;
-    vector<Value> is_encrypteds;
-    vector<Value> is_read_onlys;
-    vector<Value> is_write_onces;
-    vector<Value> is_remotes;
-    vector<Value> is_brokens;
-    vector<Value> cache_paths;
-    idx_t offset = 0;
-};
-
-static void SystemDisksFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
-    auto &data = (SystemDisksData &)*data_p.bind_data;
-    if (data.offset >= data.names.size()) {
-        return;
-    }
-
-    idx_t count = 0;
-    while (data.offset < data.names.size() && count < STANDARD_VECTOR_SIZE) {
-        output.SetValue(0, count, data.names[data.offset]);                  // name
-        output.SetValue(1, count, data.paths[data.offset]);                  // path
-        output.SetValue(2, count, data.free_spaces[data.offset]);            // free_space
-        output.SetValue(3, count, data.total_spaces[data.offset]);           // total_space
-        output.SetValue(4, count, data.unreserved_spaces[data.offset]);      // unreserved_space
-        output.SetValue(5, count, data.keep_free_spaces[data.offset]);       // keep_free_space
-        output.SetValue(6, count, data.types[data.offset]);                  // type
-        output.SetValue(7, count, data.object_storage_types[data.offset]);   // object_storage_type
-        output.SetValue(8, count, data.metadata_types[data.offset]);         // metadata_type
-        output.SetValue(9, count, data.is_encrypteds[data.offset]);          // is_encrypted
-        output.SetValue(10, count, data.is_read_onlys[data.offset]);         // is_read_only
-        output.SetValue(11, count, data.is_write_onces[data.offset]);        // is_write_once
-        output.SetValue(12, count, data.is_remotes[data.offset]);            // is_remote
-        output.SetValue(13, count, data.is_brokens[data.offset]);            // is_broken
-        output.SetValue(14, count, data.cache_paths[data.offset]);           // cache_path
-        
-        count++;
-        data.offset++;
-    }
-
-    output.SetCardinality(count);
-}
-
-static unique_ptr<FunctionData> SystemDisksBind(ClientContext &context, TableFunctionBindInput &input, vector<LogicalType> &return_types, vector<string> &names) {
-    return_types.emplace_back(LogicalType::VARCHAR); // name
-    names.emplace_back("name");
-
-    return_types.emplace_back(LogicalType::VARCHAR); // path
-    names.emplace_back("path");
-
-    return_types.emplace_back(LogicalType::BIGINT); // free_space
-    names.emplace_back("free_space");
-
-    return_types.emplace_back(LogicalType::BIGINT); // total_space
-    names.emplace_back("total_space");
-
-    return_types.emplace_back(LogicalType::BIGINT); // unreserved_space
-    names.emplace_back("unreserved_space");
-
-    return_types.emplace_back(LogicalType::BIGINT); // keep_free_space
-    names.emplace_back("keep_free_space");
-
-    return_types.emplace_back(LogicalType::VARCHAR); // type
-    names.emplace_back("type");
-
-    return_types.emplace_back(LogicalType::VARCHAR); // object_storage_type
-    names.emplace_back("object_storage_type");
-
-    return_types.emplace_back(LogicalType::VARCHAR); // metadata_type
-    names.emplace_back("metadata_type");
-
-    return_types.emplace_back(LogicalType::BOOLEAN); // is_encrypted
-    names.emplace_back("is_encrypted");
-
-    return_types.emplace_back(LogicalType::BOOLEAN); // is_read_only
-    names.emplace_back("is_read_only");
-
-    return_types.emplace_back(LogicalType::BOOLEAN); // is_write_once
-    names.emplace_back("is_write_once");
-
-    return_types.emplace_back(LogicalType::BOOLEAN); // is_remote
-    names.emplace_back("is_remote");
-
-    return_types.emplace_back(LogicalType::BOOLEAN); // is_broken
-    names.emplace_back("is_broken");
-
-    return_types.emplace_back(LogicalType::VARCHAR); // cache_path
-    names.emplace_back("cache_path");
-
-    auto result = make_uniq<SystemDisksData>();
-    
-    // Assuming we are using the DuckDB database path
-    auto &db_instance = DatabaseInstance::GetDatabase(context);
-    DuckDB db(db_instance);
-    Connection con(db);
-    
-    // Query the duckdb_databases to get the database paths
-    auto db_paths_query = con.Query("SELECT * FROM duckdb_databases();");
-
-    if (db_paths_query->HasError()) {
-        throw Exception(ExceptionType::EXECUTOR, "Failed to query duckdb_databases");
-    }
-
-    auto collection_paths = db_paths_query->Fetch();
-
-    for (idx_t row_idx = 0; row_idx < collection_paths->size(); row_idx++) {
-        auto name = collection_paths->GetValue(0, row_idx).ToString(); // database_name
-        auto path = collection_paths->GetValue(2, row_idx).ToString(); // path
-
-        // Query the pragma_database_size to get the database size details
-        auto size_query = con.Query("CALL pragma_database_size();");
-
-        if (size_query->HasError()) {
-            throw Exception(ExceptionType::EXECUTOR, "Failed to query pragma_database_size");
-        }
-
-        auto collection_size = size_query->Fetch();
-        for (idx_t size_row_idx = 0; size_row_idx < collection_size->size(); size_row_idx++) {
-            if (collection_size->GetValue(0, size_row_idx).ToString() == name) {
-                int64_t block_size = collection_size->GetValue(2, size_row_idx).GetValue<int64_t>();
-                int64_t total_blocks = collection_size->GetValue(3, size_row_idx).GetValue<int64_t>();
-                int64_t free_blocks = collection_size->GetValue(5, size_row_idx).GetValue<int64_t>();
-
-                result->names.push_back(name);
-                result->paths.push_back(path.empty() ? Value("") : Value(path));
-                result->free_spaces.push_back(Value::BIGINT(free_blocks * block_size)); // free_blocks * block_size
-                result->total_spaces.push_back(Value::BIGINT(total_blocks * block_size)); // total_blocks * block_size
-                result->unreserved_spaces.push_back(Value::BIGINT(free_blocks * block_size)); // free_blocks * block_size
-                result->keep_free_spaces.push_back(Value::BIGINT(0)); // No equivalent in DuckDB, setting to 0
-                result->types.push_back(Value("Local")); // Assuming Local type
-                result->object_storage_types.push_back(Value("None")); // No equivalent in DuckDB, setting to None
-                result->metadata_types.push_back(Value("None")); // No equivalent in DuckDB, setting to None
-                result->is_encrypteds.push_back(Value::BOOLEAN(false)); // Assuming no encryption
-                result->is_read_onlys.push_back(Value::BOOLEAN(false)); // Assuming not read-only
-                result->is_write_onces.push_back(Value::BOOLEAN(false)); // Assuming not write-once
-                result->is_remotes.push_back(Value::BOOLEAN(false)); // Assuming not remote
-                result->is_brokens.push_back(Value::BOOLEAN(false)); // Assuming not broken
-                result->cache_paths.push_back(Value("")); // No equivalent in DuckDB, setting to empty
-                break;
-            }
-        }
-    }
-
-    return std::move(result);
-}
-
 // -- Registration function
 void RegisterSystemFunctions(DatabaseInstance &instance) {
     // Register system.databases table function
-    auto databases_func = TableFunction("system_databases", {}, SystemDatabasesFunction, SystemDatabasesBind);
+    auto databases_func = SystemCatalogFunction("system_databases", SystemDatabasesFunction, SystemDatabasesBind);
     ExtensionUtil::RegisterFunction(instance, databases_func);
 
     // Register system.tables table function
-    auto tables_func = TableFunction("system_tables", {}, SystemTablesFunction, SystemTablesBind);
+    auto tables_func = SystemCatalogFunction("system_tables", SystemTablesFunction, SystemTablesBind);
     ExtensionUtil::RegisterFunction(instance, tables_func);
 
     // Register system.columns table function
-    auto columns_func = TableFunction("system_columns", {}, SystemColumnsFunction, SystemColumnsBind);
+    auto columns_func = SystemCatalogFunction("system_columns", SystemColumnsFunction, SystemColumnsBind);
     ExtensionUtil::RegisterFunction(instance, columns_func);
 
     // Register system.functions table function
@@ -581,7 +712,7 @@ void RegisterSystemFunctions(DatabaseInstance &instance) {
     ExtensionUtil::RegisterFunction(instance, uptime_func);
 
     // Register system.disks table function
-    auto disks_func = TableFunction("system_disks", {}, SystemDisksFunction, SystemDisksBind);
+    auto disks_func = SystemCatalogFunction("system_disks", SystemDisksFunction, SystemDisksBind);
     ExtensionUtil::RegisterFunction(instance, disks_func);
 }
 
@@ -596,6 +727,15 @@ void CreateSystemViews(Connection &con) {
     con.Query("CREATE OR REPLACE VIEW system.functions AS SELECT * FROM system_functions();");
     con.Query("CREATE OR REPLACE VIEW system.uptime AS SELECT uptime();");
     con.Query("CREATE OR REPLACE VIEW system.disks AS SELECT * FROM system_disks();");
+    con.Query("CREATE OR REPLACE VIEW system.connection_pool AS SELECT * FROM system_connection_pool();");
+    con.Query("CREATE OR REPLACE VIEW system.query_cache AS SELECT * FROM system_query_cache();");
+    con.Query("CREATE OR REPLACE VIEW system.query_cache_stats AS SELECT * FROM system_query_cache_stats();");
+    con.Query("CREATE OR REPLACE VIEW system.dictionaries AS SELECT * FROM system_dictionaries();");
+    con.Query("CREATE OR REPLACE VIEW system.query_log AS SELECT * FROM system_query_log();");
+    con.Query("CREATE OR REPLACE VIEW system.processes AS SELECT * FROM system_processes();");
+    con.Query("CREATE OR REPLACE VIEW system.metrics AS SELECT * FROM system_metrics();");
+    con.Query("CREATE OR REPLACE VIEW system.events AS SELECT * FROM system_events();");
+    con.Query("CREATE OR REPLACE VIEW system.asynchronous_metrics AS SELECT * FROM system_asynchronous_metrics();");
 }
 
 } // namespace duckdb
@@ -0,0 +1,285 @@
+#include "chsql_extension.hpp"
+#include "duckdb/common/vector_operations/binary_executor.hpp"
+#include "duckdb/common/vector_operations/unary_executor.hpp"
+#include "duckdb/function/scalar_function.hpp"
+#include "duckdb/main/extension_util.hpp"
+
+#include <cstring>
+
+namespace duckdb {
+
+// Offsets of the components of a URL, found in a single pass. Every component
+// is a [begin, end) range of the input, so results are slices of it.
+struct URLParts {
+    idx_t scheme_end = 0;
+    idx_t host_begin = 0;
+    idx_t host_end = 0;
+    idx_t port_begin = 0;
+    idx_t port_end = 0;
+    idx_t path_begin = 0;
+    idx_t path_end = 0;
+    // position of '?' and '#', or the URL length when absent
+    idx_t query_mark = 0;
+    idx_t fragment_mark = 0;
+    idx_t length = 0;
+
+    static bool IsSchemeChar(char c) {
+        return StringUtil::CharacterIsAlphaNumeric(c) || c == '+' || c == '-' || c == '.';
+    }
+
+    static URLParts Parse(const char *s, idx_t len) {
+        URLParts parts;
+        parts.length = len;
+
+        // scheme ':' ['//' authority], or '//' authority, or a bare host as ClickHouse accepts
+        idx_t pos = 0;
+        bool has_authority = false;
+        idx_t i = 0;
+        if (len > 0 && StringUtil::CharacterIsAlpha(s[0])) {
+            for (i = 1; i < len && IsSchemeChar(s[i]); i++) {
+            }
+        }
+        if (i > 0 && i < len && s[i] == ':') {
+            if (i + 2 < len && s[i + 1] == '/' && s[i + 2] == '/') {
+                parts.scheme_end = i;
+                pos = i + 3;
+                has_authority = true;
+            } else if (i + 1 < len && StringUtil::CharacterIsDigit(s[i + 1])) {
+                // host:port without a scheme
+                has_authority = true;
+            } else {
+                // opaque URL such as mailto:
+                parts.scheme_end = i;
+                pos = i + 1;
+            }
+        } else if (len >= 2 && s[0] == '/' && s[1] == '/') {
+            pos = 2;
+            has_authority = true;
+        } else if (len > 0 && s[0] != '/' && s[0] != '?' && s[0] != '#') {
+            has_authority = true;
+        }
+
+        if (has_authority) {
+            idx_t auth_end = pos;
+            while (auth_end < len && s[auth_end] != '/' && s[auth_end] != '?' && s[auth_end] != '#') {
+                auth_end++;
+            }
+            // the host follows the last '@' of the userinfo
+            parts.host_begin = pos;
+            for (idx_t j = pos; j < auth_end; j++) {
+                if (s[j] == '@') {
+                    parts.host_begin = j + 1;
+                }
+            }
+            parts.host_end = auth_end;
+            idx_t port_search = parts.host_begin;
+            if (parts.host_begin < auth_end && s[parts.host_begin] == '[') {
+                // IPv6 literal, the port can only follow the closing bracket
+                auto close = static_cast<const char *>(memchr(s + parts.host_begin, ']', auth_end - parts.host_begin));
+                port_search = close ? idx_t(close - s) : auth_end;
+            }
+            auto colon = static_cast<const char *>(memchr(s + port_search, ':', auth_end - port_search));
+            if (colon) {
+                parts.host_end = idx_t(colon - s);
+                parts.port_begin = parts.host_end + 1;
+                parts.port_end = auth_end;
+            }
+            pos = auth_end;
+        }
+
+        // memchr is vectorized by libc, so the tail is located without a byte loop
+        auto hash = static_cast<const char *>(memchr(s + pos, '#', len - pos));
+        parts.fragment_mark = hash ? idx_t(hash - s) : len;
+        auto question = static_cast<const char *>(memchr(s + pos, '?', parts.fragment_mark - pos));
+        parts.query_mark = question ? idx_t(question - s) : parts.fragment_mark;
+        parts.path_begin = pos;
+        parts.path_end = parts.query_mark;
+        return parts;
+    }
+};
+
+static inline string_t Slice(const string_t &url, idx_t begin, idx_t end) {
+    return string_t(url.GetData() + begin, UnsafeNumericCast<uint32_t>(end - begin));
+}
+
+struct ProtocolOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        return Slice(url, 0, parts.scheme_end);
+    }
+};
+
+struct DomainOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        return Slice(url, parts.host_begin, parts.host_end);
+    }
+};
+
+struct DomainWithoutWWWOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        auto begin = parts.host_begin;
+        if (parts.host_end - begin > 4 && memcmp(url.GetData() + begin, "www.", 4) == 0) {
+            begin += 4;
+        }
+        return Slice(url, begin, parts.host_end);
+    }
+};
+
+struct TopLevelDomainOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        auto data = url.GetData();
+        auto end = parts.host_end;
+        // a fully qualified host may end with a dot
+        if (end > parts.host_begin && data[end - 1] == '.') {
+            end--;
+        }
+        for (idx_t i = end; i > parts.host_begin; i--) {
+            if (data[i - 1] == '.') {
+                return Slice(url, i, end);
+            }
+        }
+        return Slice(url, 0, 0);
+    }
+};
+
+struct PortOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        return Slice(url, parts.port_begin, parts.port_end);
+    }
+};
+
+struct PathOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        return Slice(url, parts.path_begin, parts.path_end);
+    }
+};
+
+struct PathFullOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        return Slice(url, parts.path_begin, parts.length);
+    }
+};
+
+struct QueryStringOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        if (parts.query_mark == parts.fragment_mark) {
+            return Slice(url, 0, 0);
+        }
+        return Slice(url, parts.query_mark + 1, parts.fragment_mark);
+    }
+};
+
+struct FragmentOperator {
+    static string_t Extract(const string_t &url, const URLParts &parts) {
+        if (parts.fragment_mark == parts.length) {
+            return Slice(url, 0, 0);
+        }
+        return Slice(url, parts.fragment_mark + 1, parts.length);
+    }
+};
+
+template <class OP>
+static void URLPartFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    UnaryExecutor::Execute<string_t, string_t>(args.data[0], result, args.size(), [&](string_t url) {
+        return OP::Extract(url, URLParts::Parse(url.GetData(), url.GetSize()));
+    });
+    // the results point into the input strings
+    StringVector::AddHeapReference(result, args.data[0]);
+}
+
+static void CutQueryStringFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    UnaryExecutor::Execute<string_t, string_t>(args.data[0], result, args.size(), [&](string_t url) {
+        auto parts = URLParts::Parse(url.GetData(), url.GetSize());
+        if (parts.fragment_mark == parts.length) {
+            return Slice(url, 0, parts.query_mark);
+        }
+        // the fragment is kept, which is the one case needing a copy
+        auto fragment = parts.length - parts.fragment_mark;
+        auto target = StringVector::EmptyString(result, parts.query_mark + fragment);
+        auto data = target.GetDataWriteable();
+        memcpy(data, url.GetData(), parts.query_mark);
+        memcpy(data + parts.query_mark, url.GetData() + parts.fragment_mark, fragment);
+        target.Finalize();
+        return target;
+    });
+    StringVector::AddHeapReference(result, args.data[0]);
+}
+
+// Value of the first name=value pair after '?' or '#', separated by '&'
+static string_t ExtractURLParameter(const string_t &url, const string_t &name) {
+    auto data = url.GetData();
+    auto len = url.GetSize();
+    auto name_data = name.GetData();
+    auto name_len = name.GetSize();
+    auto parts = URLParts::Parse(data, len);
+    idx_t pos = MinValue(parts.query_mark, parts.fragment_mark);
+    while (pos < len) {
+        auto begin = pos + 1;
+        auto end = begin;
+        while (end < len && data[end] != '&' && data[end] != '#') {
+            end++;
+        }
+        if (end - begin > name_len && data[begin + name_len] == '=' && memcmp(data + begin, name_data, name_len) == 0) {
+            return Slice(url, begin + name_len + 1, end);
+        }
+        pos = end;
+    }
+    return Slice(url, 0, 0);
+}
+
+static void ExtractURLParameterFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    BinaryExecutor::Execute<string_t, string_t, string_t>(args.data[0], args.data[1], result, args.size(),
+                                                          ExtractURLParameter);
+    StringVector::AddHeapReference(result, args.data[0]);
+}
+
+// An unknown part is NULL, as it was for the macro this replaces
+static void ParseURLFunction(DataChunk &args, ExpressionState &state, Vector &result) {
+    BinaryExecutor::ExecuteWithNulls<string_t, string_t, string_t>(
+        args.data[0], args.data[1], result, args.size(),
+        [&](string_t url, string_t part, ValidityMask &mask, idx_t idx) {
+            auto parts = URLParts::Parse(url.GetData(), url.GetSize());
+            auto name = part.GetString();
+            if (name == "protocol") {
+                return ProtocolOperator::Extract(url, parts);
+            } else if (name == "domain" || name == "host") {
+                return DomainOperator::Extract(url, parts);
+            } else if (name == "port") {
+                return PortOperator::Extract(url, parts);
+            } else if (name == "path") {
+                return PathOperator::Extract(url, parts);
+            } else if (name == "query") {
+                return QueryStringOperator::Extract(url, parts);
+            } else if (name == "fragment") {
+                return FragmentOperator::Extract(url, parts);
+            }
+            mask.SetInvalid(idx);
+            return string_t();
+        });
+    StringVector::AddHeapReference(result, args.data[0]);
+}
+
+template <class OP>
+static void RegisterURLPart(DatabaseInstance &instance, const string &name) {
+    ExtensionUtil::RegisterFunction(
+        instance, ScalarFunction(name, {LogicalType::VARCHAR}, LogicalType::VARCHAR, URLPartFunction<OP>));
+}
+
+void RegisterURLFunctions(DatabaseInstance &instance) {
+    RegisterURLPart<ProtocolOperator>(instance, "protocol");
+    RegisterURLPart<DomainOperator>(instance, "domain");
+    RegisterURLPart<DomainWithoutWWWOperator>(instance, "domainWithoutWWW");
+    RegisterURLPart<TopLevelDomainOperator>(instance, "topLevelDomain");
+    RegisterURLPart<PathOperator>(instance, "path");
+    RegisterURLPart<PathFullOperator>(instance, "pathFull");
+    RegisterURLPart<QueryStringOperator>(instance, "queryString");
+    RegisterURLPart<FragmentOperator>(instance, "fragment");
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("cutQueryString", {LogicalType::VARCHAR},
+                                                             LogicalType::VARCHAR, CutQueryStringFunction));
+    ExtensionUtil::RegisterFunction(instance,
+                                    ScalarFunction("extractURLParameter", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                                                   LogicalType::VARCHAR, ExtractURLParameterFunction));
+    ExtensionUtil::RegisterFunction(instance, ScalarFunction("parseURL", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                                                             LogicalType::VARCHAR, ParseURLFunction));
+}
+
+} // namespace duckdb
@@ -1,11 +1,44 @@
 #ifndef DUCK_FLOCK_H
 #define DUCK_FLOCK_H
 #include "chsql_extension.hpp"
+#include "chsql_compression.hpp"
+#include "chsql_metrics.hpp"
+#include "chsql_query_log.hpp"
+#include "chsql_pool.hpp"
+#include "chsql_query_cache.hpp"
 
 namespace duckdb {
+    // The query running on one node, its response streamed if compression was negotiated
+    struct DuckFlockNode {
+        unique_ptr<RemoteConnectionLease> conn;
+        shared_ptr<RemoteStream> stream;
+        unique_ptr<QueryResult> result;
+
+        // the result reads the stream over the connection: gone before either
+        void Reset() {
+            result.reset();
+            stream.reset();
+            conn.reset();
+        }
+    };
+
     struct DuckFlockData : FunctionData {
-        vector<unique_ptr<Connection>> conn;
-        vector<unique_ptr<QueryResult>> results;
+        string query;
+        string nodes;
+        string cache_key;
+        shared_ptr<CachedRemoteResult> cached;
+        // the nodes read by the scan, from the first one answering at bind
+        vector<string> flock;
+        string statement;
+        string compression;
+        bool streamed = false;
+        vector<string> names;
+        vector<LogicalType> types;
+        // the first node, opened to bind the schema, which an execution in the
+        // same query goes on reading; EXECUTE of a prepared scan opens it anew
+        transaction_t bind_query = 0;
+        mutable mutex bind_node_lock;
+        mutable DuckFlockNode bind_node;
         
         unique_ptr<FunctionData> Copy() const override {
             throw std::runtime_error("not implemented");
@@ -16,6 +49,44 @@ namespace duckdb {
         };
     };
 
+    // Errors that leave a node out of the result rather than failing the query
+    static bool NodeUnavailable(ExceptionType type) {
+        return type == ExceptionType::IO || type == ExceptionType::HTTP || type == ExceptionType::CONNECTION;
+    }
+
+    // Runs the query on a node; false when the node cannot be reached or its
+    // request fails, other errors are thrown
+    static bool OpenNode(ClientContext &context, const DuckFlockData &data, const string &node, DuckFlockNode &out) {
+        try {
+            out.conn = RemoteConnectionPool::Get(context)->Acquire(context, node);
+            auto &req = out.conn->Prepare(data.statement);
+            if (data.streamed) {
+                auto url = node + "/?" + RemoteCompression::UrlParameters(data.compression, "JSONEachRow") +
+                           "default_format=JSONEachRow&query=" + StringUtil::URLEncode(data.query);
+                out.stream = RemoteCompression::Open(context, url, data.compression);
+                out.result = req.Execute(out.stream->GetPath());
+            } else {
+                out.result = req.Execute(data.query.c_str(), node);
+            }
+        } catch (std::exception &ex) {
+            ErrorData error(ex);
+            if (!NodeUnavailable(error.Type())) {
+                throw;
+            }
+            out.Reset();
+            return false;
+        }
+        ChMetrics::Increment(ChEvent::URL_FLOCK_REQUESTS);
+        if (out.result->HasError()) {
+            if (!NodeUnavailable(out.result->GetErrorType())) {
+                out.result->ThrowError();
+            }
+            out.Reset();
+            return false;
+        }
+        return true;
+    }
+
     unique_ptr<FunctionData> DuckFlockBind(ClientContext &context, TableFunctionBindInput &input,
                                          vector<LogicalType> &return_types, vector<string> &names) {
         auto data = make_uniq<DuckFlockData>();
@@ -35,83 +106,190 @@ namespace duckdb {
             return data;  // Return with default schema
         }
 
-        vector<string> flock;
         auto &raw_flock = ListValue::GetChildren(input.inputs[1]);
         if (raw_flock.empty()) {
             return data;  // Return with default schema
         }
 
-        // Process each connection
+        data->query = strQuery;
+        string compression;
+        auto entry = input.named_parameters.find("compression");
+        if (entry != input.named_parameters.end()) {
+            compression = RemoteCompression::Validate(entry->second.GetValue<string>(), "JSONEachRow");
+        }
+        auto parameters = RemoteCompression::UrlParameters(compression, "JSONEachRow");
+        // a negotiated Content-Encoding is streamed and decompressed into the reader
+        data->streamed = RemoteCompression::Streamed(compression, "JSONEachRow");
+        data->statement = data->streamed ? "SELECT * FROM read_json($1::VARCHAR, format='newline_delimited')"
+                                         : "SELECT * FROM read_json($2 || '/?" + parameters +
+                                               "default_format=JSONEachRow&query=' || url_encode($1::VARCHAR))";
+        data->compression = compression;
+
+        if (RemoteResultCache::Enabled(context)) {
+            vector<string> nodes;
+            for (auto &duck : raw_flock) {
+                nodes.push_back(duck.ToString());
+            }
+            data->nodes = StringUtil::Join(nodes, ",");
+            data->cache_key = RemoteResultCache::MakeKey(context, strQuery, nodes, "jsoneachrow");
+            data->cached = RemoteResultCache::Get(context).Lookup(context, data->cache_key);
+            if (data->cached) {
+                return_types = data->cached->types;
+                names = data->cached->names;
+                return std::move(data);
+            }
+        }
+
+        // The first node answering binds the schema, the others are read by the scan
         for (auto &duck : raw_flock) {
             if (duck.IsNull() || duck.ToString().empty()) {
                 continue;
             }
+            if (!data->flock.empty()) {
+                data->flock.push_back(duck.ToString());
+                continue;
+            }
+            if (OpenNode(context, *data, duck.ToString(), data->bind_node)) {
+                data->flock.push_back(duck.ToString());
+                data->bind_query = context.transaction.GetActiveQuery();
+                return_types = data->bind_node.result->types;
+                names = data->bind_node.result->names;
+            }
+        }
+        data->types = return_types;
+        data->names = names;
+        return std::move(data);
+    }
 
-            try {
-                auto conn = make_uniq<Connection>(*context.db);
-                if (!conn) {
-                    continue;
-                }
+    struct DuckFlockState : GlobalTableFunctionState {
+        ColumnDataScanState cache_scan;
+        mutex lock;
+        unique_ptr<ColumnDataCollection> collection;
+        idx_t nodes = 0;
+        atomic<idx_t> next_node {0};
+        atomic<idx_t> finished_nodes {0};
 
-                auto settingResult = conn->Query("SET autoload_known_extensions=1;SET autoinstall_known_extensions=1;");
-                if (settingResult->HasError()) {
-                    continue;
-                }
+        idx_t MaxThreads() const override {
+            return MaxValue<idx_t>(nodes, 1);
+        }
+    };
 
-                auto req = conn->Prepare("SELECT * FROM read_json($2 || '/?default_format=JSONEachRow&query=' || url_encode($1::VARCHAR))");
-                if (req->HasError()) {
-                    continue;
-                }
+    struct DuckFlockLocalState : LocalTableFunctionState {
+        DuckFlockNode node;
+    };
 
-                auto queryResult = req->Execute(strQuery.c_str(), duck.ToString());
-                if (!queryResult || queryResult->HasError()) {
-                    continue;
-                }
+    unique_ptr<GlobalTableFunctionState> DuckFlockInitGlobal(ClientContext &context, TableFunctionInitInput &input) {
+        auto &data = input.bind_data->Cast<DuckFlockData>();
+        auto state = make_uniq<DuckFlockState>();
+        if (data.cached) {
+            data.cached->data->InitializeScan(state->cache_scan);
+            return std::move(state);
+        }
+        state->nodes = data.flock.size();
+        if (!data.cache_key.empty() && state->nodes > 0) {
+            state->collection = make_uniq<ColumnDataCollection>(Allocator::DefaultAllocator(), data.types);
+        }
+        return std::move(state);
+    }
 
-                data->conn.push_back(std::move(conn));
-                data->results.push_back(std::move(queryResult));
-            } catch (...) {
-                continue;
-            }
+    unique_ptr<LocalTableFunctionState> DuckFlockInitLocal(ExecutionContext &context, TableFunctionInitInput &input,
+                                                           GlobalTableFunctionState *global_state) {
+        return make_uniq<DuckFlockLocalState>();
+    }
+
+    // All nodes are drained: keep the combined result for the next refresh
+    static void FinishNode(ClientContext &context, const DuckFlockData &data, DuckFlockState &state,
+                           DuckFlockLocalState &local) {
+        local.node.Reset();
+        if (++state.finished_nodes < state.nodes) {
+            return;
         }
+        lock_guard<mutex> guard(state.lock);
+        if (!state.collection) {
+            return;
+        }
+        auto entry = make_shared_ptr<CachedRemoteResult>();
+        entry->query = data.query;
+        entry->server = data.nodes;
+        entry->format = "JSONEachRow";
+        entry->names = data.names;
+        entry->types = data.types;
+        entry->rows = state.collection->Count();
+        entry->bytes = state.collection->SizeInBytes();
+        entry->data = std::move(state.collection);
+        RemoteResultCache::Get(context).Insert(context, data.cache_key, std::move(entry));
+    }
 
-        // If we have valid results, use their schema instead of default
-        if (!data->results.empty() && !data->results[0]->HasError()) {
-            return_types.clear();
-            copy(data->results[0]->types.begin(), data->results[0]->types.end(), back_inserter(return_types));
-            names.clear();
-            copy(data->results[0]->names.begin(), data->results[0]->names.end(), back_inserter(names));
+    // Claims the next node that no thread is reading yet, skipping the ones that fail
+    static bool OpenNextNode(ClientContext &context, const DuckFlockData &data, DuckFlockState &state,
+                             DuckFlockLocalState &local) {
+        while (true) {
+            auto node = state.next_node++;
+            if (node >= state.nodes) {
+                return false;
+            }
+            if (node == 0) {
+                lock_guard<mutex> guard(data.bind_node_lock);
+                if (data.bind_node.result && data.bind_query == context.transaction.GetActiveQuery()) {
+                    local.node = std::move(data.bind_node);
+                    return true;
+                }
+                data.bind_node.Reset();
+            }
+            if (OpenNode(context, data, data.flock[node], local.node)) {
+                return true;
+            }
+            FinishNode(context, data, state, local);
         }
-        
-        return std::move(data);
     }
 
     void DuckFlockImplementation(ClientContext &context, TableFunctionInput &data_p,
                                DataChunk &output) {
         auto &data = data_p.bind_data->Cast<DuckFlockData>();
-        
-        if (data.results.empty()) {
+        auto &state = data_p.global_state->Cast<DuckFlockState>();
+        auto &local = data_p.local_state->Cast<DuckFlockLocalState>();
+
+        if (data.cached) {
+            data.cached->data->Scan(state.cache_scan, output);
             return;
         }
 
-        for (const auto &res : data.results) {
-            if (!res) {
+        while (true) {
+            if (!local.node.result && !OpenNextNode(context, data, state, local)) {
+                return;
+            }
+            // once rows came, a failing node would leave a partial result: its error is the query's
+            auto chunk = local.node.result->Fetch();
+            if (local.node.result->HasError()) {
+                local.node.result->ThrowError();
+            }
+            if (!chunk || chunk->size() == 0) {
+                FinishNode(context, data, state, local);
                 continue;
             }
-
-            ErrorData error_data;
-            unique_ptr<DataChunk> data_chunk = make_uniq<DataChunk>();
-            
-            try {
-                if (res->TryFetch(data_chunk, error_data)) {
-                    if (data_chunk && data_chunk->size() != 0) {
-                        output.Append(*data_chunk);
-                        return;
-                    }
+            ChMetrics::Increment(ChEvent::URL_FLOCK_ROWS_READ, chunk->size());
+            ChMetrics::Increment(ChEvent::URL_FLOCK_BYTES_READ, chunk->GetAllocationSize());
+            QueryLog::AddReadBytes(context, chunk->GetAllocationSize());
+            if (chunk->ColumnCount() != output.ColumnCount()) {
+                throw InvalidInputException("url_flock: a node returned %d columns where %d were bound",
+                                            chunk->ColumnCount(), output.ColumnCount());
+            }
+            // each node detects its own types, read them as the bound ones
+            if (chunk->GetTypes() == output.GetTypes()) {
+                output.Reference(*chunk);
+            } else {
+                for (idx_t col = 0; col < output.ColumnCount(); col++) {
+                    VectorOperations::Cast(context, chunk->data[col], output.data[col], chunk->size());
                 }
-            } catch (...) {
-                continue;
+                output.SetCardinality(chunk->size());
             }
+            if (state.collection) {
+                lock_guard<mutex> guard(state.lock);
+                if (state.collection) {
+                    state.collection->Append(output);
+                }
+            }
+            return;
         }
     }
 
@@ -121,9 +299,10 @@ namespace duckdb {
             {LogicalType::VARCHAR, LogicalType::LIST(LogicalType::VARCHAR)},
             DuckFlockImplementation,
             DuckFlockBind,
-            nullptr,
-            nullptr
+            DuckFlockInitGlobal,
+            DuckFlockInitLocal
         );
+        f.named_parameters["compression"] = LogicalType::VARCHAR;
         return f;
     }
 }
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/function/function_set.hpp"
+
+namespace duckdb {
+
+// Byte encoding of an aggregate state, field by field, so that -State can
+// store it in a BLOB and -Merge can read it back into a fresh state.
+struct AggregateStateCodec {
+    void (*serialize)(const_data_ptr_t state, string &target);
+    // the state is initialized before it is read into
+    void (*deserialize)(const char *data, idx_t size, data_ptr_t state);
+};
+
+// nullptr for aggregates without a codec
+const AggregateStateCodec *GetAggregateStateCodec(const AggregateFunction &function);
+
+// count, sum, avg, min and max over states whose layout the extension owns,
+// bound by -State and -Merge in place of DuckDB's builtins; empty otherwise
+AggregateFunctionSet GetSerializableAggregates(const string &name);
+
+void RegisterAggregateFunctions(DatabaseInstance &instance);
+void RegisterCombinatorFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
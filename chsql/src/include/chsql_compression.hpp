@@ -0,0 +1,91 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "chsql_pool.hpp"
+#include "duckdb/common/http_util.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace duckdb {
+
+// The user's http secret best matching a URL: its extra headers are sent
+// along, and its identity separates cached results fetched with different
+// credentials.
+struct RemoteHttpAuth {
+    case_insensitive_map_t<string> headers;
+    // empty without a matching secret, else its name and a hash of its values
+    string identity;
+
+    static RemoteHttpAuth Lookup(ClientContext &context, const string &url);
+};
+
+// A response body read while it arrives. A thread runs the request with a
+// kept-alive client of the host and fills a bounded buffer, which the file
+// handle of GetPath() drains, so the reader parses the first rows while the
+// rest is still on the wire. The path of a gzip or zstd body ends in .gz or
+// .zst, and DuckDB's compressed file systems decode it on the way in.
+class RemoteStream {
+public:
+    RemoteStream(ClientContext &context, const string &url, const string &codec);
+    ~RemoteStream();
+
+    const string &GetPath() const {
+        return path;
+    }
+    // Up to nr_bytes of the body, 0 at its end; throws what failed the request
+    idx_t Read(data_ptr_t buffer, idx_t nr_bytes);
+
+private:
+    friend struct RemoteCompression;
+
+    void Run();
+    bool Push(const_data_ptr_t data, idx_t length);
+    void Finish(unique_ptr<HTTPResponse> response, std::exception_ptr exception);
+
+    string url;
+    string path;
+    HTTPUtil &http;
+    unique_ptr<HTTPParams> params;
+    HTTPHeaders headers;
+    shared_ptr<RemoteHttpClientPool> clients;
+    unique_ptr<GetRequestInfo> request;
+    unique_ptr<HTTPClient> client;
+
+    mutex lock;
+    std::condition_variable changed;
+    std::deque<string> chunks;
+    // bytes of the front chunk already read
+    idx_t front_offset = 0;
+    idx_t buffered = 0;
+    bool success = false;
+    bool done = false;
+    bool cancelled = false;
+    // the start of an error response, which holds the message of ClickHouse
+    string error_head;
+    std::exception_ptr exception;
+    std::thread thread;
+};
+
+// Compressed transfer between ClickHouse HTTP endpoints and the local readers.
+// Parquet results are compressed inside the file. Text formats ask for an HTTP
+// Content-Encoding with the Accept-Encoding header of their request only, and
+// the body is decompressed as it streams into the reader.
+struct RemoteCompression {
+    // Lower-cased codec name, throws on codecs the format cannot be read back with
+    static string Validate(const string &codec, const string &format);
+    // URL parameters placed right after "/?"
+    static string UrlParameters(const string &codec, const string &format);
+    // Whether responses go through a RemoteStream rather than httpfs: text
+    // formats with a codec, whose readers take the body front to back
+    static bool Streamed(const string &codec, const string &format);
+    // GETs url with the headers of the user's http secret and, with a codec,
+    // Accept-Encoding: codec. Returns once the body has started.
+    static shared_ptr<RemoteStream> Open(ClientContext &context, const string &url, const string &codec);
+};
+
+// Serves the paths of open RemoteStreams to the readers
+void RegisterRemoteStreamFileSystem(DatabaseInstance &instance);
+
+} // namespace duckdb
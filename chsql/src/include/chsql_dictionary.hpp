@@ -0,0 +1,119 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/string_map_set.hpp"
+#include "duckdb/common/types/string_heap.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace duckdb {
+
+enum class DictionaryLayout : uint8_t { FLAT, HASHED, RANGE_HASHED };
+
+struct DictionaryDefinition {
+    string name;
+    string source;
+    string key;
+    DictionaryLayout layout = DictionaryLayout::HASHED;
+    string range_min;
+    string range_max;
+    // seconds between reloads, 0 never reloads
+    idx_t lifetime = 0;
+};
+
+struct DictionaryRange {
+    int64_t min;
+    int64_t max;
+    idx_t row;
+};
+
+// An immutable loaded version of a dictionary. Lookups hold a snapshot for
+// the duration of a query, reloads build a new one and swap it in, so a
+// lookup never waits for a load.
+struct DictionarySnapshot {
+    vector<string> names;
+    vector<LogicalType> types;
+    LogicalType key_type;
+    LogicalType range_type;
+    bool string_keys = false;
+
+    // flat: row by key, hashed: row by key, range_hashed: slot in ranges by key
+    vector<idx_t> flat;
+    unordered_map<int64_t, idx_t> int_index;
+    string_map_t<idx_t> string_index;
+    // owns the string keys of string_index
+    StringHeap key_heap;
+    vector<vector<DictionaryRange>> ranges;
+
+    // one vector per attribute holding every row
+    vector<unique_ptr<Vector>> attributes;
+    idx_t rows = 0;
+    idx_t bytes = 0;
+
+    optional_idx FindAttribute(const string &name) const;
+};
+
+class Dictionary {
+public:
+    explicit Dictionary(DictionaryDefinition definition);
+    // waits for a running background reload
+    ~Dictionary();
+
+    const DictionaryDefinition definition;
+
+    // the current snapshot; schedules a background reload once the lifetime expired
+    shared_ptr<const DictionarySnapshot> GetSnapshot(ClientContext &context);
+    // the current snapshot without scheduling anything, nullptr before the first load
+    shared_ptr<const DictionarySnapshot> CurrentSnapshot();
+    // synchronous (re)load, the previous snapshot stays in use if it fails
+    void Load(DatabaseInstance &db);
+
+    atomic<idx_t> query_count {0};
+    atomic<bool> loading {false};
+
+    struct Status {
+        string status;
+        string last_exception;
+        timestamp_t last_successful_update;
+        double loading_duration = 0;
+    };
+    Status GetStatus();
+
+private:
+    // guards snapshot and status, only held to copy or swap them
+    mutex lock;
+    shared_ptr<const DictionarySnapshot> snapshot;
+    Status status;
+    // steady clock ticks after which the next lookup schedules a reload
+    atomic<int64_t> expires {0};
+    // guards reload, the thread of the last background reload
+    mutex reload_lock;
+    std::thread reload;
+};
+
+// Dictionaries of a database, kept in its object cache
+class DictionaryRegistry : public ObjectCacheEntry {
+public:
+    static shared_ptr<DictionaryRegistry> Get(ClientContext &context);
+    static string ObjectType() {
+        return "chsql_dictionaries";
+    }
+    string GetObjectType() override {
+        return ObjectType();
+    }
+
+    shared_ptr<Dictionary> Find(const string &name);
+    void Add(shared_ptr<Dictionary> dictionary);
+    bool Remove(const string &name);
+    vector<shared_ptr<Dictionary>> GetDictionaries();
+
+private:
+    mutex lock;
+    case_insensitive_map_t<shared_ptr<Dictionary>> dictionaries;
+};
+
+void RegisterDictionaryFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -11,8 +11,22 @@ public:
         std::string Version() const override;
 };
 duckdb::TableFunction ReadParquetOrderedFunction();
+duckdb::TableFunction ReadParquetPartsFunction();
 static void RegisterSillyBTreeStore(DatabaseInstance &instance);
 
 TableFunction DuckFlockTableFunction();
+TableFunction ChScanTableFunction();
+TableFunction UrlTableFunction();
+TableFunction LimitByTableFunction();
+void RegisterNumbersFunctions(DatabaseInstance &instance);
+void RegisterConversionFunctions(DatabaseInstance &instance);
+void RegisterURLFunctions(DatabaseInstance &instance);
+void RegisterIPFunctions(DatabaseInstance &instance);
+void RegisterJSONFunctions(DatabaseInstance &instance);
+void RegisterDateTimeFunctions(DatabaseInstance &instance);
+void RegisterArrayFunctions(DatabaseInstance &instance);
+void RegisterSearchFunctions(DatabaseInstance &instance);
+void RegisterHashFunctions(DatabaseInstance &instance);
+void RegisterClickHouseParser(DatabaseInstance &instance);
 
 } // namespace duckdb
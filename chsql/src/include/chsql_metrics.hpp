@@ -0,0 +1,58 @@
+#pragma once
+
+#include "duckdb.hpp"
+
+namespace duckdb {
+
+// Monotonic counters listed by system.events
+enum class ChEvent : uint8_t {
+    QUERY,
+    PARQUET_MERGETREE_ROWS_READ,
+    PARQUET_MERGETREE_BYTES_READ,
+    PARQUET_MERGETREE_COMPARISONS,
+    PARQUET_PARTS_ROWS_READ,
+    PARQUET_PARTS_BYTES_READ,
+    URL_FLOCK_REQUESTS,
+    URL_FLOCK_ROWS_READ,
+    URL_FLOCK_BYTES_READ,
+    REMOTE_SCAN_REQUESTS,
+    REMOTE_SCAN_ROWS_READ,
+    REMOTE_SCAN_BYTES_READ,
+    QUERY_CACHE_HITS,
+    QUERY_CACHE_MISSES,
+    COUNT
+};
+
+// Gauges that the hot paths move up and down, listed by system.metrics
+enum class ChGauge : uint8_t { OPEN_PARQUET_READERS, COUNT };
+
+// Counters sharded per thread: a thread only ever writes its own shard, so
+// updates are plain relaxed loads and stores on a cache line no other thread
+// writes. Readers sum the shards, and the shard of a thread that exits is
+// folded into a retired total.
+class ChMetrics {
+public:
+    static void Increment(ChEvent event, idx_t amount = 1) {
+        auto &counter = LocalShard().events[static_cast<idx_t>(event)];
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    static void Add(ChGauge gauge, int64_t amount) {
+        auto &counter = LocalShard().gauges[static_cast<idx_t>(gauge)];
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static vector<idx_t> Events();
+    static vector<int64_t> Gauges();
+
+    struct alignas(64) Shard {
+        std::atomic<idx_t> events[static_cast<idx_t>(ChEvent::COUNT)] {};
+        std::atomic<int64_t> gauges[static_cast<idx_t>(ChGauge::COUNT)] {};
+    };
+
+private:
+    static Shard &LocalShard();
+};
+
+void RegisterMetricsFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
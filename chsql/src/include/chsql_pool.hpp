@@ -0,0 +1,133 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/http_util.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <chrono>
+
+namespace duckdb {
+
+// A DuckDB connection kept alive between remote scans, together with the
+// statements already prepared on it.
+struct PooledConnection {
+    unique_ptr<Connection> conn;
+    unordered_map<string, unique_ptr<PreparedStatement>> statements;
+    std::chrono::steady_clock::time_point last_used;
+
+    PreparedStatement &Prepare(const string &sql);
+};
+
+struct RemoteHostPool {
+    vector<unique_ptr<PooledConnection>> idle;
+    idx_t in_use = 0;
+    idx_t hits = 0;
+    idx_t misses = 0;
+    idx_t evictions = 0;
+};
+
+struct RemoteHostPoolStats {
+    string host;
+    idx_t idle;
+    idx_t in_use;
+    idx_t hits;
+    idx_t misses;
+    idx_t evictions;
+    idx_t http_idle;
+    idx_t http_hits;
+    idx_t http_misses;
+};
+
+struct PooledHttpClient {
+    unique_ptr<HTTPClient> client;
+    std::chrono::steady_clock::time_point last_used;
+};
+
+struct RemoteHttpHost {
+    vector<PooledHttpClient> idle;
+    idx_t hits = 0;
+    idx_t misses = 0;
+};
+
+// Keep-alive HTTP clients of a database, keyed by scheme://host:port. An idle
+// client keeps its socket open, so the next request of ch_scan, url or
+// url_flock to the same server, from any connection, skips the TCP and TLS
+// handshakes.
+class RemoteHttpClientPool : public ObjectCacheEntry {
+public:
+    static shared_ptr<RemoteHttpClientPool> Get(ClientContext &context);
+    static string ObjectType() {
+        return "chsql_http_clients";
+    }
+    string GetObjectType() override {
+        return ObjectType();
+    }
+
+    // An idle client of the host set up for params, else a new one
+    unique_ptr<HTTPClient> Acquire(ClientContext &context, HTTPUtil &http, HTTPParams &params,
+                                   const string &proto_host_port);
+    // Keeps a client whose last response was read to the end
+    void Release(const string &proto_host_port, unique_ptr<HTTPClient> client);
+    // Adds the client counts to the rows of their hosts
+    void AddStats(vector<RemoteHostPoolStats> &stats);
+
+private:
+    void EvictExpired(std::chrono::steady_clock::time_point now);
+
+    mutex lock;
+    unordered_map<string, RemoteHttpHost> hosts;
+    idx_t max_idle = 4;
+    std::chrono::seconds idle_timeout = std::chrono::seconds(60);
+};
+
+class RemoteConnectionLease;
+
+// Per-client pool of sub-connections used by url_flock and ch_scan, keyed by
+// remote host. Idle connections are reused for the next scan against the same
+// host, so extension autoloading and prepared statements survive between
+// queries. The pool belongs to the client: a database-wide one would keep the
+// database alive through the connections it holds. The sockets are pooled
+// database-wide by RemoteHttpClientPool.
+class RemoteConnectionPool : public ClientContextState, public enable_shared_from_this<RemoteConnectionPool> {
+public:
+    static shared_ptr<RemoteConnectionPool> Get(ClientContext &context);
+    static string HostKey(const string &url);
+
+    unique_ptr<RemoteConnectionLease> Acquire(ClientContext &context, const string &url);
+    void Release(const string &host, unique_ptr<PooledConnection> conn);
+    vector<RemoteHostPoolStats> GetStats();
+
+    void QueryEnd(ClientContext &context) override;
+
+private:
+    void EvictExpired(std::chrono::steady_clock::time_point now);
+
+    mutex lock;
+    unordered_map<string, RemoteHostPool> hosts;
+    idx_t max_idle = 4;
+    std::chrono::seconds idle_timeout = std::chrono::seconds(60);
+};
+
+// Exclusive use of a pooled connection; hands it back to the pool on destruction.
+class RemoteConnectionLease {
+public:
+    RemoteConnectionLease(shared_ptr<RemoteConnectionPool> pool, string host, unique_ptr<PooledConnection> conn);
+    ~RemoteConnectionLease();
+
+    Connection &GetConnection() {
+        return *conn->conn;
+    }
+    PreparedStatement &Prepare(const string &sql) {
+        return conn->Prepare(sql);
+    }
+
+private:
+    shared_ptr<RemoteConnectionPool> pool;
+    string host;
+    unique_ptr<PooledConnection> conn;
+};
+
+void RegisterConnectionPoolFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/common/types/column/column_data_collection.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <chrono>
+#include <list>
+
+namespace duckdb {
+
+// A remote result kept by the query cache, either in memory or spilled to a
+// local Parquet file.
+struct CachedRemoteResult {
+    string query;
+    string server;
+    string format;
+    vector<string> names;
+    vector<LogicalType> types;
+    unique_ptr<ColumnDataCollection> data;
+    string spill_path;
+    idx_t rows = 0;
+    idx_t bytes = 0;
+    std::chrono::system_clock::time_point created;
+    std::chrono::system_clock::time_point expires;
+    atomic<idx_t> hits {0};
+};
+
+struct RemoteResultCacheStats {
+    idx_t entries = 0;
+    idx_t bytes = 0;
+    idx_t hits = 0;
+    idx_t misses = 0;
+    idx_t evictions = 0;
+    idx_t spills = 0;
+};
+
+// Opt-in TTL cache for ch_scan, url and url_flock results of one database,
+// keyed by normalized query text, server, format and the http secret the
+// server is queried with. Entries are evicted LRU once the memory limit is
+// reached and optionally spilled to Parquet, from where a hit brings them back
+// into memory.
+class RemoteResultCache : public ObjectCacheEntry {
+public:
+    static RemoteResultCache &Get(ClientContext &context);
+    static string ObjectType() {
+        return "chsql_query_cache";
+    }
+    string GetObjectType() override {
+        return ObjectType();
+    }
+
+    static bool Enabled(ClientContext &context);
+    static string NormalizeQuery(const string &query);
+    static string MakeKey(ClientContext &context, const string &query, const vector<string> &servers,
+                          const string &format);
+
+    // The entry with its rows in memory, counting a hit or a miss
+    shared_ptr<CachedRemoteResult> Lookup(ClientContext &context, const string &key);
+    // The entry if it has not expired, without counting it or reading back spilled rows
+    shared_ptr<CachedRemoteResult> Peek(const string &key);
+    void Insert(ClientContext &context, const string &key, shared_ptr<CachedRemoteResult> entry);
+    vector<shared_ptr<CachedRemoteResult>> GetEntries();
+    RemoteResultCacheStats GetStats();
+    idx_t MemoryLimit(ClientContext &context);
+
+private:
+    void SpillEntries(ClientContext &context, vector<pair<string, shared_ptr<CachedRemoteResult>>> &evicted);
+    void RemoveSpillFile(ClientContext &context, const CachedRemoteResult &entry);
+    shared_ptr<CachedRemoteResult> ReadSpilled(ClientContext &context, const string &key,
+                                               shared_ptr<CachedRemoteResult> entry);
+
+    std::mutex lock;
+    // most recently used key at the front
+    std::list<string> lru;
+    unordered_map<string, pair<shared_ptr<CachedRemoteResult>, std::list<string>::iterator>> entries;
+    RemoteResultCacheStats stats;
+};
+
+void RegisterQueryCacheFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
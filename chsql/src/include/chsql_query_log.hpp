@@ -0,0 +1,87 @@
+#pragma once
+
+#include "duckdb.hpp"
+#include "duckdb/main/client_context_state.hpp"
+#include "duckdb/storage/object_cache.hpp"
+
+#include <chrono>
+#include <deque>
+
+namespace duckdb {
+
+// A finished query, as listed by system.query_log. The rows, bytes and
+// memory come from DuckDB's query profiler and stay 0 unless profiling is
+// enabled, e.g. with SET enable_profiling = 'no_output'.
+struct QueryLogEntry {
+    idx_t query_id = 0;
+    idx_t connection_id = 0;
+    string query;
+    hash_t normalized_query_hash = 0;
+    std::chrono::system_clock::time_point start_time;
+    std::chrono::system_clock::time_point end_time;
+    double duration_ms = 0;
+    idx_t read_rows = 0;
+    idx_t read_bytes = 0;
+    idx_t written_bytes = 0;
+    idx_t result_rows = 0;
+    idx_t peak_memory = 0;
+};
+
+// A query that is still running, as listed by system.processes
+struct RunningQuery {
+    idx_t query_id = 0;
+    idx_t connection_id = 0;
+    string query;
+    std::chrono::system_clock::time_point start_time;
+    std::chrono::steady_clock::time_point started;
+    weak_ptr<ClientContext> context;
+};
+
+// The queries of all connections of one database: the running ones, and a
+// bounded ring of the finished ones whose size is the chsql_query_log_size
+// setting.
+class QueryLog : public ObjectCacheEntry {
+public:
+    static QueryLog &Get(ClientContext &context);
+    static string ObjectType() {
+        return "chsql_query_log";
+    }
+    string GetObjectType() override {
+        return ObjectType();
+    }
+
+    // Counts bytes that the extension's scans produced for the running query
+    // of the connection, listed as read_bytes by system.processes
+    static void AddReadBytes(ClientContext &context, idx_t bytes);
+    // ClickHouse's normalized_query_hash: literals and whitespace do not count
+    static hash_t NormalizedQueryHash(const string &query);
+
+    idx_t Begin(ClientContext &context);
+    void Finish(ClientContext &context, idx_t query_id);
+    vector<QueryLogEntry> GetEntries();
+    vector<RunningQuery> GetRunning();
+
+private:
+    std::mutex lock;
+    idx_t next_query_id = 1;
+    unordered_map<idx_t, RunningQuery> running;
+    // oldest first
+    std::deque<QueryLogEntry> entries;
+};
+
+// Reports the queries of one connection to the log
+class QueryLogState : public ClientContextState {
+public:
+    void QueryBegin(ClientContext &context) override;
+    void QueryEnd(ClientContext &context) override;
+
+    // bytes read by the extension's scans since the query began
+    atomic<idx_t> read_bytes {0};
+
+private:
+    idx_t query_id = DConstants::INVALID_INDEX;
+};
+
+void RegisterQueryLogFunctions(DatabaseInstance &instance);
+
+} // namespace duckdb
@@ -2,8 +2,16 @@
 #include "duckdb/common/exception.hpp"
 #include <parquet_reader.hpp>
 #include "chsql_extension.hpp"
+#include "chsql_metrics.hpp"
+#include "chsql_query_log.hpp"
 #include <duckdb/common/multi_file/multi_file_list.hpp>
 #include "chsql_parquet_types.h"
+#include "duckdb/parser/parser.hpp"
+#include "duckdb/parser/expression/list.hpp"
+#include "duckdb/planner/filter/conjunction_filter.hpp"
+#include "duckdb/planner/filter/constant_filter.hpp"
+#include "duckdb/planner/filter/in_filter.hpp"
+#include "duckdb/planner/filter/null_filter.hpp"
 
 namespace duckdb {
 
@@ -21,6 +29,11 @@ namespace duckdb {
 		vector<int64_t> columnMap;
 		idx_t result_idx;
 		bool haveAbsentColumns;
+		~ReaderSet() {
+			if (reader) {
+				ChMetrics::Add(ChGauge::OPEN_PARQUET_READERS, -1);
+			}
+		}
 		void populateColumnInfo(const vector<ReturnColumn>& returnCols, const string& order_by_column) {
 			this->returnColumns = returnCols;
 			columnMap.clear();
@@ -70,10 +83,320 @@ namespace duckdb {
 		}
 	};
 
+	// SAMPLE k OFFSET m keeps whole row groups, picked by the hash of the
+	// smallest sampling key each one holds, so the same data always yields the
+	// same sample. A k above 1 is a number of rows rather than a ratio.
+	struct SampleOptions {
+		double ratio = 1;
+		double offset = 0;
+		string key;
+
+		bool Enabled() const {
+			return ratio < 1;
+		}
+		bool operator==(const SampleOptions &other) const {
+			return ratio == other.ratio && offset == other.offset && key == other.key;
+		}
+	};
+
+	static hash_t RowGroupSampleHash(ParquetReader &reader, const string &key, idx_t row_group) {
+		auto &schema = reader.metadata->metadata->schema;
+		auto &group = reader.metadata->metadata->row_groups[row_group];
+		auto key_column = find_if(schema.begin(), schema.end(),
+			[&](const SchemaElement &column) { return column.name == key; });
+		if (key_column != schema.end()) {
+			auto column = static_cast<idx_t>(key_column - schema.begin() - 1);
+			if (column < group.columns.size()) {
+				auto &stats = group.columns[column].meta_data.statistics;
+				if (stats.__isset.min_value) {
+					return Hash(stats.min_value.c_str(), stats.min_value.size());
+				}
+				if (stats.__isset.min) {
+					return Hash(stats.min.c_str(), stats.min.size());
+				}
+			}
+		}
+		// without key statistics the row group is sampled by its place in the file
+		return CombineHash(Hash(reader.GetFileName().c_str()), Hash(row_group));
+	}
+
+	static vector<idx_t> SampleRowGroups(ParquetReader &reader, const SampleOptions &sample) {
+		vector<idx_t> result;
+		auto row_groups = reader.metadata->metadata->row_groups.size();
+		for (idx_t i = 0; i < row_groups; i++) {
+			if (sample.Enabled()) {
+				auto point = static_cast<double>(RowGroupSampleHash(reader, sample.key, i)) / 18446744073709551616.0;
+				if (point < sample.offset || point >= sample.offset + sample.ratio) {
+					continue;
+				}
+			}
+			result.push_back(i);
+		}
+		return result;
+	}
+
+	static SampleOptions BindSampleOptions(const named_parameter_map_t &parameters, const string &default_key,
+		const vector<unique_ptr<ReaderSet>> &sets) {
+		SampleOptions sample;
+		sample.key = default_key;
+		for (auto &kv : parameters) {
+			if (kv.second.IsNull()) {
+				continue;
+			}
+			if (kv.first == "sample") {
+				sample.ratio = kv.second.GetValue<double>();
+				if (!(sample.ratio > 0)) {
+					throw BinderException("sample must be greater than 0");
+				}
+			} else if (kv.first == "sample_offset") {
+				sample.offset = kv.second.GetValue<double>();
+				if (sample.offset < 0 || sample.offset >= 1) {
+					throw BinderException("sample_offset must be in [0, 1)");
+				}
+			} else if (kv.first == "sample_key") {
+				sample.key = kv.second.GetValue<string>();
+			}
+		}
+		if (sample.ratio > 1) {
+			idx_t rows = 0;
+			for (auto &set : sets) {
+				rows += set->reader->NumRows();
+			}
+			sample.ratio = rows == 0 ? 1 : MinValue<double>(sample.ratio / static_cast<double>(rows), 1);
+		}
+		return sample;
+	}
+
+	// PREWHERE conditions become table filters on the ParquetReader, which
+	// decodes the filtered columns first, skips row groups their statistics
+	// rule out, and reads the other columns only for the rows that pass.
+	// Supported are comparisons of a column with a constant, IN lists, BETWEEN
+	// and IS [NOT] NULL, joined with AND, or with OR on a single column.
+	struct PrewhereFilters {
+		string condition;
+		// keyed by output column
+		map<idx_t, unique_ptr<TableFilter>> filters;
+	};
+
+	static Value PrewhereConstant(const ParsedExpression &expr) {
+		switch (expr.GetExpressionClass()) {
+		case ExpressionClass::CONSTANT:
+			return expr.Cast<ConstantExpression>().value;
+		case ExpressionClass::CAST: {
+			auto &cast = expr.Cast<CastExpression>();
+			return PrewhereConstant(*cast.child).DefaultCastAs(cast.cast_type);
+		}
+		case ExpressionClass::FUNCTION: {
+			auto &function = expr.Cast<FunctionExpression>();
+			if (function.function_name == "-" && function.children.size() == 1) {
+				// cast to the column type later
+				return Value("-" + PrewhereConstant(*function.children[0]).ToString());
+			}
+			break;
+		}
+		default:
+			break;
+		}
+		throw BinderException("prewhere: expected a constant, got %s", expr.ToString());
+	}
+
+	static idx_t PrewhereColumn(const ParsedExpression &expr, const vector<ReturnColumn> &columns) {
+		if (expr.GetExpressionClass() != ExpressionClass::COLUMN_REF) {
+			throw BinderException("prewhere: expected a column, got %s", expr.ToString());
+		}
+		auto &name = expr.Cast<ColumnRefExpression>().GetColumnName();
+		for (idx_t i = 0; i < columns.size(); i++) {
+			if (StringUtil::CIEquals(columns[i].name, name)) {
+				return i;
+			}
+		}
+		throw BinderException("prewhere: column \"%s\" not found", name);
+	}
+
+	static Value PrewhereValue(const ParsedExpression &expr, const ReturnColumn &column) {
+		auto value = PrewhereConstant(expr);
+		if (value.IsNull()) {
+			throw BinderException("prewhere: compare with NULL using IS NULL");
+		}
+		return value.DefaultCastAs(column.type);
+	}
+
+	// The filter for a condition on one column, which is stored in column
+	static unique_ptr<TableFilter> PrewhereFilter(const ParsedExpression &expr, const vector<ReturnColumn> &columns,
+		idx_t &column) {
+		switch (expr.GetExpressionClass()) {
+		case ExpressionClass::COMPARISON: {
+			auto &comparison = expr.Cast<ComparisonExpression>();
+			auto type = comparison.GetExpressionType();
+			auto left = comparison.left.get();
+			auto right = comparison.right.get();
+			if (left->GetExpressionClass() != ExpressionClass::COLUMN_REF) {
+				std::swap(left, right);
+				type = FlipComparisonExpression(type);
+			}
+			switch (type) {
+			case ExpressionType::COMPARE_EQUAL:
+			case ExpressionType::COMPARE_NOTEQUAL:
+			case ExpressionType::COMPARE_LESSTHAN:
+			case ExpressionType::COMPARE_GREATERTHAN:
+			case ExpressionType::COMPARE_LESSTHANOREQUALTO:
+			case ExpressionType::COMPARE_GREATERTHANOREQUALTO:
+				break;
+			default:
+				throw BinderException("prewhere: unsupported comparison %s", expr.ToString());
+			}
+			column = PrewhereColumn(*left, columns);
+			return make_uniq<ConstantFilter>(type, PrewhereValue(*right, columns[column]));
+		}
+		case ExpressionClass::BETWEEN: {
+			auto &between = expr.Cast<BetweenExpression>();
+			column = PrewhereColumn(*between.input, columns);
+			auto result = make_uniq<ConjunctionAndFilter>();
+			result->child_filters.push_back(make_uniq<ConstantFilter>(ExpressionType::COMPARE_GREATERTHANOREQUALTO,
+				PrewhereValue(*between.lower, columns[column])));
+			result->child_filters.push_back(make_uniq<ConstantFilter>(ExpressionType::COMPARE_LESSTHANOREQUALTO,
+				PrewhereValue(*between.upper, columns[column])));
+			return std::move(result);
+		}
+		case ExpressionClass::OPERATOR: {
+			auto &op = expr.Cast<OperatorExpression>();
+			switch (op.GetExpressionType()) {
+			case ExpressionType::OPERATOR_IS_NULL:
+				column = PrewhereColumn(*op.children[0], columns);
+				return make_uniq<IsNullFilter>();
+			case ExpressionType::OPERATOR_IS_NOT_NULL:
+				column = PrewhereColumn(*op.children[0], columns);
+				return make_uniq<IsNotNullFilter>();
+			case ExpressionType::COMPARE_IN: {
+				column = PrewhereColumn(*op.children[0], columns);
+				vector<Value> values;
+				for (idx_t i = 1; i < op.children.size(); i++) {
+					auto value = PrewhereValue(*op.children[i], columns[column]);
+					if (std::find(values.begin(), values.end(), value) == values.end()) {
+						values.push_back(std::move(value));
+					}
+				}
+				return make_uniq<InFilter>(std::move(values));
+			}
+			default:
+				break;
+			}
+			break;
+		}
+		case ExpressionClass::CONJUNCTION: {
+			auto &conjunction = expr.Cast<ConjunctionExpression>();
+			if (conjunction.GetExpressionType() != ExpressionType::CONJUNCTION_OR) {
+				break;
+			}
+			auto result = make_uniq<ConjunctionOrFilter>();
+			for (idx_t i = 0; i < conjunction.children.size(); i++) {
+				idx_t child_column;
+				result->child_filters.push_back(PrewhereFilter(*conjunction.children[i], columns, child_column));
+				if (i > 0 && child_column != column) {
+					throw BinderException("prewhere: OR must compare a single column, got %s", expr.ToString());
+				}
+				column = child_column;
+			}
+			return std::move(result);
+		}
+		default:
+			break;
+		}
+		throw BinderException("prewhere: unsupported condition %s", expr.ToString());
+	}
+
+	static void AddPrewhereFilters(const ParsedExpression &expr, const vector<ReturnColumn> &columns,
+		PrewhereFilters &prewhere) {
+		if (expr.GetExpressionType() == ExpressionType::CONJUNCTION_AND) {
+			for (auto &child : expr.Cast<ConjunctionExpression>().children) {
+				AddPrewhereFilters(*child, columns, prewhere);
+			}
+			return;
+		}
+		idx_t column;
+		auto filter = PrewhereFilter(expr, columns, column);
+		auto &entry = prewhere.filters[column];
+		if (!entry) {
+			entry = std::move(filter);
+			return;
+		}
+		if (entry->filter_type != TableFilterType::CONJUNCTION_AND) {
+			auto conjunction = make_uniq<ConjunctionAndFilter>();
+			conjunction->child_filters.push_back(std::move(entry));
+			entry = std::move(conjunction);
+		}
+		entry->Cast<ConjunctionAndFilter>().child_filters.push_back(std::move(filter));
+	}
+
+	static void BindPrewhere(const named_parameter_map_t &parameters, const vector<ReturnColumn> &columns,
+		PrewhereFilters &prewhere) {
+		auto entry = parameters.find("prewhere");
+		if (entry == parameters.end() || entry->second.IsNull()) {
+			return;
+		}
+		prewhere.condition = entry->second.GetValue<string>();
+		auto expressions = Parser::ParseExpressionList(prewhere.condition);
+		if (expressions.size() != 1) {
+			throw BinderException("prewhere: expected a single condition");
+		}
+		AddPrewhereFilters(*expressions[0], columns, prewhere);
+	}
+
+	// Whether a column a file lacks, and so reads as NULL, passes the filter
+	static bool FilterAcceptsNull(const TableFilter &filter) {
+		switch (filter.filter_type) {
+		case TableFilterType::IS_NULL:
+			return true;
+		case TableFilterType::CONJUNCTION_AND:
+			for (auto &child : filter.Cast<ConjunctionAndFilter>().child_filters) {
+				if (!FilterAcceptsNull(*child)) {
+					return false;
+				}
+			}
+			return true;
+		case TableFilterType::CONJUNCTION_OR:
+			for (auto &child : filter.Cast<ConjunctionOrFilter>().child_filters) {
+				if (FilterAcceptsNull(*child)) {
+					return true;
+				}
+			}
+			return false;
+		default:
+			return false;
+		}
+	}
+
+	// Hands the filters to the reader, keyed by the position of their column
+	// among the ones it reads. Returns false when no row of the file can pass.
+	static bool ApplyPrewhere(ReaderSet &set, const PrewhereFilters &prewhere) {
+		if (prewhere.filters.empty()) {
+			return true;
+		}
+		auto filters = make_uniq<TableFilterSet>();
+		for (auto &entry : prewhere.filters) {
+			auto column = entry.first;
+			if (set.columnMap[column] == -1) {
+				if (!FilterAcceptsNull(*entry.second)) {
+					return false;
+				}
+				continue;
+			}
+			idx_t local = 0;
+			for (idx_t i = 0; i < column; i++) {
+				local += set.columnMap[i] != -1;
+			}
+			filters->filters[local] = entry.second->Copy();
+		}
+		set.reader->filters = std::move(filters);
+		return true;
+	}
+
 	struct OrderedReadFunctionData : FunctionData {
 		string orderBy;
 		vector<string> files;
 		vector<ReturnColumn> returnCols;
+		SampleOptions sample;
+		PrewhereFilters prewhere;
 		unique_ptr<FunctionData> Copy() const override {
 			throw std::runtime_error("not implemented");
 		}
@@ -93,7 +416,7 @@ namespace duckdb {
 			if (!EqualStrArrays(o.files, files)) {
 				return false;
 			}
-			return this->orderBy ==  o.orderBy;
+			return this->orderBy ==  o.orderBy && sample == o.sample && prewhere.condition == o.prewhere.condition;
 		};
 	};
 
@@ -179,13 +502,15 @@ namespace duckdb {
 			ParquetOptions po;
 			po.binary_as_string = true;
 			set->reader = make_uniq<ParquetReader>(context, file, po, nullptr);
+			ChMetrics::Add(ChGauge::OPEN_PARQUET_READERS, 1);
 			res.push_back(std::move(set));
 		}
 	}
 
-	static unique_ptr<FunctionData> OrderedParquetScanBind(ClientContext &context, TableFunctionBindInput &input,
-														vector<LogicalType> &return_types, vector<string> &names) {
-		Connection conn(*context.db);
+	// Expands the file globs and reads the union of the schemas; also used by
+	// read_parquet_parts
+	static unique_ptr<OrderedReadFunctionData> BindParquetFiles(ClientContext &context, TableFunctionBindInput &input,
+		const string &order_by, vector<LogicalType> &return_types, vector<string> &names) {
 		auto res = make_uniq<OrderedReadFunctionData>();
 		auto files = ListValue::GetChildren(input.inputs[0]);
 		vector<OpenFileInfo> fileInfoList;
@@ -212,8 +537,15 @@ namespace duckdb {
 		std::transform(res->returnCols.begin(), res->returnCols.end(), std::back_inserter(return_types),
 			[](const ReturnColumn &c) { return c.type; });
 
-		res->orderBy = input.inputs[1].GetValue<string>();
-		return std::move(res);
+		res->orderBy = order_by;
+		res->sample = BindSampleOptions(input.named_parameters, res->orderBy, sets);
+		BindPrewhere(input.named_parameters, res->returnCols, res->prewhere);
+		return res;
+	}
+
+	static unique_ptr<FunctionData> OrderedParquetScanBind(ClientContext &context, TableFunctionBindInput &input,
+														vector<LogicalType> &return_types, vector<string> &names) {
+		return BindParquetFiles(context, input, input.inputs[1].GetValue<string>(), return_types, names);
 	}
 
 	static unique_ptr<LocalTableFunctionState>
@@ -225,9 +557,9 @@ namespace duckdb {
 		for (auto &set : res->sets) {
 			set->populateColumnInfo(bindData.returnCols, bindData.orderBy);
 			set->scanState = make_uniq<ParquetReaderScanState>();
-			vector<idx_t> rgs(set->reader->metadata->metadata->row_groups.size(), 0);
-			for (idx_t i = 0; i < rgs.size(); i++) {
-				rgs[i] = i;
+			vector<idx_t> rgs;
+			if (ApplyPrewhere(*set, bindData.prewhere)) {
+				rgs = SampleRowGroups(*set->reader, bindData.sample);
 			}
 			set->reader->InitializeScan(context.client, *set->scanState, rgs);
 			set->chunk = make_uniq<DataChunk>();
@@ -238,6 +570,12 @@ namespace duckdb {
 			set->chunk->Initialize(context.client, ltypes);
 			set->Scan(context.client);
 		}
+		// files with nothing left after sampling and prewhere take no part in the merge
+		for (idx_t i = res->sets.size(); i > 0; i--) {
+			if (res->sets[i - 1]->chunk->size() == 0) {
+				res->RemoveSetGracefully(i - 1);
+			}
+		}
 		res->RecalculateWinnerGroup();
 		return std::move(res);
 	}
@@ -276,6 +614,9 @@ namespace duckdb {
 			output.Append(*set->chunk, true);
 			output.SetCardinality(set->chunk->size());
 			set->result_idx = set->chunk->size();
+			ChMetrics::Increment(ChEvent::PARQUET_MERGETREE_ROWS_READ, output.size());
+			ChMetrics::Increment(ChEvent::PARQUET_MERGETREE_BYTES_READ, output.GetAllocationSize());
+			QueryLog::AddReadBytes(context, output.GetAllocationSize());
 			return;
 		}
 		while(true) {
@@ -300,6 +641,10 @@ namespace duckdb {
 			(*winnerSet)->result_idx++;
 			if ((*winnerSet)->result_idx >= (*winnerSet)->chunk->size() || j >= 2048) {
 				output.SetCardinality(j);
+				ChMetrics::Increment(ChEvent::PARQUET_MERGETREE_ROWS_READ, j);
+				ChMetrics::Increment(ChEvent::PARQUET_MERGETREE_BYTES_READ, output.GetAllocationSize());
+				QueryLog::AddReadBytes(context, output.GetAllocationSize());
+				ChMetrics::Increment(ChEvent::PARQUET_MERGETREE_COMPARISONS, j * (loc_state.winner_group.size() - 1));
 				return;
 			}
 			if (j >= cap) {
@@ -318,6 +663,118 @@ namespace duckdb {
 			nullptr,
 			ParquetScanInitLocal
 			);
+		tf.named_parameters["sample"] = LogicalType::DOUBLE;
+		tf.named_parameters["sample_offset"] = LogicalType::DOUBLE;
+		tf.named_parameters["sample_key"] = LogicalType::VARCHAR;
+		tf.named_parameters["prewhere"] = LogicalType::VARCHAR;
+		return tf;
+	}
+
+	// read_parquet_parts scans the same files without merging them: every row
+	// group is a task, and the threads share one reader per file
+	struct PartsGlobalState : GlobalTableFunctionState {
+		vector<unique_ptr<ReaderSet>> sets;
+		// (file, row group)
+		vector<std::pair<idx_t, idx_t>> tasks;
+		atomic<idx_t> next_task {0};
+
+		idx_t MaxThreads() const override {
+			return MaxValue<idx_t>(tasks.size(), 1);
+		}
+	};
+
+	struct PartsLocalState : LocalTableFunctionState {
+		// also the batch index
+		idx_t task = DConstants::INVALID_INDEX;
+		unique_ptr<ParquetReaderScanState> scanState;
+	};
+
+	static unique_ptr<FunctionData> ParquetPartsBind(ClientContext &context, TableFunctionBindInput &input,
+		vector<LogicalType> &return_types, vector<string> &names) {
+		return BindParquetFiles(context, input, "", return_types, names);
+	}
+
+	static unique_ptr<GlobalTableFunctionState> ParquetPartsInitGlobal(ClientContext &context,
+		TableFunctionInitInput &input) {
+		auto res = make_uniq<PartsGlobalState>();
+		const auto &bindData = input.bind_data->Cast<OrderedReadFunctionData>();
+		OpenParquetFiles(context, bindData.files, res->sets);
+		for (idx_t i = 0; i < res->sets.size(); i++) {
+			auto &set = res->sets[i];
+			set->populateColumnInfo(bindData.returnCols, "");
+			if (!ApplyPrewhere(*set, bindData.prewhere)) {
+				continue;
+			}
+			for (auto rg : SampleRowGroups(*set->reader, bindData.sample)) {
+				res->tasks.emplace_back(i, rg);
+			}
+		}
+		return std::move(res);
+	}
+
+	static unique_ptr<LocalTableFunctionState> ParquetPartsInitLocal(ExecutionContext &context,
+		TableFunctionInitInput &input, GlobalTableFunctionState *gstate_p) {
+		return make_uniq<PartsLocalState>();
+	}
+
+	static void ParquetPartsImplementation(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+		auto &gstate = data_p.global_state->Cast<PartsGlobalState>();
+		auto &lstate = data_p.local_state->Cast<PartsLocalState>();
+		while (true) {
+			if (!lstate.scanState) {
+				auto task = gstate.next_task++;
+				if (task >= gstate.tasks.size()) {
+					return;
+				}
+				lstate.task = task;
+				lstate.scanState = make_uniq<ParquetReaderScanState>();
+				auto &set = gstate.sets[gstate.tasks[task].first];
+				set->reader->InitializeScan(context, *lstate.scanState, {gstate.tasks[task].second});
+			}
+			auto &set = gstate.sets[gstate.tasks[lstate.task].first];
+			output.Reset();
+			set->reader->Scan(context, *lstate.scanState, output);
+			if (output.size() == 0) {
+				lstate.scanState.reset();
+				continue;
+			}
+			if (set->haveAbsentColumns) {
+				for (idx_t i = 0; i < set->columnMap.size(); i++) {
+					if (set->columnMap[i] == -1) {
+						output.data[i].SetVectorType(VectorType::CONSTANT_VECTOR);
+						ConstantVector::SetNull(output.data[i], true);
+					}
+				}
+			}
+			ChMetrics::Increment(ChEvent::PARQUET_PARTS_ROWS_READ, output.size());
+			ChMetrics::Increment(ChEvent::PARQUET_PARTS_BYTES_READ, output.GetAllocationSize());
+			QueryLog::AddReadBytes(context, output.GetAllocationSize());
+			return;
+		}
+	}
+
+	static OperatorPartitionData ParquetPartsPartitionData(ClientContext &context,
+		TableFunctionGetPartitionInput &input) {
+		if (input.partition_info.RequiresPartitionColumns()) {
+			throw InternalException("read_parquet_parts: partition columns are not supported");
+		}
+		return OperatorPartitionData(input.local_state->Cast<PartsLocalState>().task);
+	}
+
+	TableFunction ReadParquetPartsFunction() {
+		TableFunction tf = duckdb::TableFunction(
+			"read_parquet_parts",
+			{LogicalType::LIST(LogicalType::VARCHAR)},
+			ParquetPartsImplementation,
+			ParquetPartsBind,
+			ParquetPartsInitGlobal,
+			ParquetPartsInitLocal
+			);
+		tf.get_partition_data = ParquetPartsPartitionData;
+		tf.named_parameters["sample"] = LogicalType::DOUBLE;
+		tf.named_parameters["sample_offset"] = LogicalType::DOUBLE;
+		tf.named_parameters["sample_key"] = LogicalType::VARCHAR;
+		tf.named_parameters["prewhere"] = LogicalType::VARCHAR;
 		return tf;
 	}
 }
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Benchmarks ch_scan and url_flock against the mock ClickHouse server.
+
+Reports rows/s and p50/p99/max latency for url_flock fan-out widths from 1 to 64
+nodes, and for ch_scan per format, compression and parallel slices. Needs
+the duckdb Python module and a built chsql extension:
+
+    python3 chsql/test/bench_remote.py \\
+        --extension build/release/extension/chsql/chsql.duckdb_extension \\
+        --latency-ms 5 --bandwidth-mbps 1000
+"""
+
+import argparse
+import os
+import statistics
+import sys
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import mock_clickhouse  # noqa: E402
+
+
+def percentile(samples, fraction):
+    ordered = sorted(samples)
+    index = min(len(ordered) - 1, max(0, int(round(fraction * (len(ordered) - 1)))))
+    return ordered[index]
+
+
+def measure(con, sql, iterations, warmup):
+    for _ in range(warmup):
+        con.execute(sql).fetchall()
+    latencies = []
+    rows = 0
+    for _ in range(iterations):
+        start = time.perf_counter()
+        rows = con.execute(sql).fetchone()[0]
+        latencies.append(time.perf_counter() - start)
+    return rows, latencies
+
+
+def report(out, label, rows, latencies):
+    mean = statistics.mean(latencies)
+    line = "%-44s %10d rows %14.0f rows/s  p50 %8.2f ms  p99 %8.2f ms  max %8.2f ms" % (
+        label,
+        rows,
+        rows / mean if mean > 0 else 0,
+        percentile(latencies, 0.50) * 1000,
+        percentile(latencies, 0.99) * 1000,
+        max(latencies) * 1000,
+    )
+    print(line, flush=True)
+    out.append(line)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--extension", default="build/release/extension/chsql/chsql.duckdb_extension")
+    parser.add_argument("--rows", type=int, default=100000, help="rows returned by each node")
+    parser.add_argument("--widths", default="1,2,4,8,16,32,64", help="url_flock fan-out widths")
+    # p99 needs at least 100 samples to differ from the maximum.
+    parser.add_argument("--iterations", type=int, default=200)
+    parser.add_argument("--warmup", type=int, default=2)
+    parser.add_argument("--latency-ms", type=float, default=0.0)
+    parser.add_argument("--bandwidth-mbps", type=float, default=0.0)
+    parser.add_argument("--fail-rate", type=float, default=0.0)
+    parser.add_argument("--output", default=None, help="also write the report to this file")
+    args = parser.parse_args()
+
+    import duckdb
+
+    widths = [int(width) for width in args.widths.split(",")]
+    settings = mock_clickhouse.MockSettings(args.rows, args.latency_ms, args.bandwidth_mbps, args.fail_rate)
+    servers, urls = mock_clickhouse.start_nodes("127.0.0.1", 0, max(widths), settings)
+
+    con = duckdb.connect(config={"allow_unsigned_extensions": "true"})
+    con.execute("LOAD '%s'" % args.extension)
+    query = "SELECT * FROM numbers(%d)" % args.rows
+    out = []
+
+    for width in widths:
+        nodes = "[%s]" % ", ".join("'%s'" % url for url in urls[:width])
+        sql = "SELECT count(*) FROM url_flock('%s', %s)" % (query, nodes)
+        rows, latencies = measure(con, sql, args.iterations, args.warmup)
+        report(out, "url_flock width=%d" % width, rows, latencies)
+
+    scans = [("JSONEachRow", None, None), ("CSV", None, None), ("JSONEachRow", "gzip", None)]
+    if mock_clickhouse.zstandard is not None:
+        scans.append(("JSONEachRow", "zstd", None))
+    if mock_clickhouse.pyarrow is not None:
+        scans.append(("Parquet", None, None))
+    scans += [("JSONEachRow", None, 4), ("JSONEachRow", None, 16)]
+    for fmt, compression, parallel in scans:
+        options = ", format := '%s'" % fmt
+        if compression:
+            options += ", compression := '%s'" % compression
+        if parallel:
+            options += ", split_column := 'number', parallel := %d" % parallel
+        sql = "SELECT count(*) FROM ch_scan('%s', '%s'%s)" % (query, urls[0], options)
+        rows, latencies = measure(con, sql, args.iterations, args.warmup)
+        label = "ch_scan %s%s%s" % (
+            fmt,
+            " " + compression if compression else "",
+            " parallel=%d" % parallel if parallel else "",
+        )
+        report(out, label, rows, latencies)
+
+    print("requests %d, injected failures %d" % (settings.requests, settings.failures))
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write("\n".join(out) + "\n")
+    for server in servers:
+        server.shutdown()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
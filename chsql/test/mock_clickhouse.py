@@ -0,0 +1,304 @@
+#!/usr/bin/env python3
+"""Stand-in ClickHouse HTTP server for testing and benchmarking remote scans.
+
+Answers the subset of the ClickHouse HTTP interface used by ch_scan, url and
+url_flock. Any query returns rows of (number UInt64, name String, value
+Float64); the row count is taken from numbers(N) in the query text, or
+--rows. Slices requested by ch_scan's parallel mode are honoured, both the
+`% N = i` split predicate and the {slice}/{slices} query parameters.
+
+Formats: JSONEachRow, CSV, TSV, RowBinary and Parquet (Parquet needs pyarrow).
+Responses are compressed when enable_http_compression=1 and Accept-Encoding
+asks for gzip, deflate or zstd (zstd needs the zstandard module). Unlike
+ClickHouse, the mock rejects enable_http_compression=1 without an
+Accept-Encoding header, so that tests notice a codec that was not negotiated.
+
+    python3 mock_clickhouse.py --port 8123 --nodes 4 --latency-ms 20 \\
+        --bandwidth-mbps 100 --fail-rate 0.01
+"""
+
+import argparse
+import functools
+import gzip
+import io
+import json
+import random
+import re
+import struct
+import sys
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+try:
+    import pyarrow
+    import pyarrow.parquet
+except ImportError:
+    pyarrow = None
+
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
+NUMBERS_RE = re.compile(r"numbers(?:_mt)?\s*\(\s*(\d+)\s*\)", re.IGNORECASE)
+LIMIT_RE = re.compile(r"\blimit\s+(\d+)\s*;?\s*$", re.IGNORECASE)
+SPLIT_RE = re.compile(r"%\s*(\d+)\s*=\s*(\d+)\s*$")
+FORMAT_RE = re.compile(r"\bformat\s+(\w+)\s*;?\s*$", re.IGNORECASE)
+
+CONTENT_TYPES = {
+    "jsoneachrow": "application/x-ndjson; charset=UTF-8",
+    "csv": "text/csv; charset=UTF-8; header=absent",
+    "tsv": "text/tab-separated-values; charset=UTF-8",
+    "tabseparated": "text/tab-separated-values; charset=UTF-8",
+    "rowbinary": "application/octet-stream",
+    "parquet": "application/octet-stream",
+}
+
+
+class MockError(Exception):
+    def __init__(self, code, message, status=500):
+        super().__init__(message)
+        self.code = code
+        self.status = status
+
+
+class MockSettings:
+    def __init__(self, rows=1000, latency_ms=0.0, bandwidth_mbps=0.0, fail_rate=0.0, seed=None):
+        self.rows = rows
+        self.latency_ms = latency_ms
+        self.bandwidth_mbps = bandwidth_mbps
+        self.fail_rate = fail_rate
+        self.random = random.Random(seed)
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.failures = 0
+
+    def should_fail(self):
+        with self.lock:
+            self.requests += 1
+            if self.fail_rate > 0 and self.random.random() < self.fail_rate:
+                self.failures += 1
+                return True
+            return False
+
+
+def select_rows(query, params, default_rows):
+    match = NUMBERS_RE.search(query)
+    count = int(match.group(1)) if match else default_rows
+    match = LIMIT_RE.search(query)
+    if match:
+        count = min(count, int(match.group(1)))
+    rows = range(count)
+    # ch_scan split_column: SELECT * FROM (q) WHERE cityHash64(col) % N = i
+    match = SPLIT_RE.search(query)
+    if match:
+        slices, index = int(match.group(1)), int(match.group(2))
+        rows = range(index, count, slices)
+    # ch_scan query parameters: {slice:UInt32} / {slices:UInt32}
+    for name in ("slice", "slices"):
+        if "{%s:" % name in query and "param_" + name not in params:
+            raise MockError(456, "Substitution `%s` is not set" % name, status=400)
+    if "param_slice" in params and "param_slices" in params:
+        slices, index = int(params["param_slices"]), int(params["param_slice"])
+        rows = range(index, count, slices)
+    return rows
+
+
+def encode_rows(rows, fmt):
+    if fmt == "jsoneachrow":
+        return "".join(
+            json.dumps({"number": n, "name": "row%d" % n, "value": n * 0.5}) + "\n" for n in rows
+        ).encode()
+    if fmt == "csv":
+        return "".join('%d,"row%d",%s\n' % (n, n, repr(n * 0.5)) for n in rows).encode()
+    if fmt in ("tsv", "tabseparated"):
+        return "".join("%d\trow%d\t%s\n" % (n, n, repr(n * 0.5)) for n in rows).encode()
+    if fmt == "rowbinary":
+        out = io.BytesIO()
+        for n in rows:
+            name = ("row%d" % n).encode()
+            # UInt64, String (LEB128 length + bytes), Float64
+            out.write(struct.pack("<Q", n))
+            out.write(bytes([len(name)]))
+            out.write(name)
+            out.write(struct.pack("<d", n * 0.5))
+        return out.getvalue()
+    if fmt == "parquet":
+        if pyarrow is None:
+            raise MockError(73, "Parquet output needs pyarrow on the mock server", status=501)
+        rows = list(rows)
+        table = pyarrow.table(
+            {
+                "number": pyarrow.array(rows, type=pyarrow.uint64()),
+                "name": ["row%d" % n for n in rows],
+                "value": [n * 0.5 for n in rows],
+            }
+        )
+        out = io.BytesIO()
+        pyarrow.parquet.write_table(table, out)
+        return out.getvalue()
+    raise MockError(73, "Unknown format %s" % fmt)
+
+
+def encode_body(body, encoding):
+    if encoding == "gzip":
+        return gzip.compress(body)
+    if encoding == "deflate":
+        return zlib.compress(body)
+    if encoding == "zstd":
+        return zstandard.ZstdCompressor().compress(body)
+    return body
+
+
+@functools.lru_cache(maxsize=64)
+def render(query, params_key, fmt, encoding, default_rows):
+    params = dict(params_key)
+    body = encode_rows(select_rows(query, params, default_rows), fmt)
+    return encode_body(body, encoding)
+
+
+def negotiate_encoding(params, accept):
+    if params.get("enable_http_compression") != "1":
+        return ""
+    if not accept:
+        raise MockError(115, "enable_http_compression=1 without an Accept-Encoding header", 400)
+    offered = [item.split(";")[0].strip().lower() for item in accept.split(",")]
+    for encoding in offered:
+        if encoding in ("gzip", "deflate") or (encoding == "zstd" and zstandard is not None):
+            return encoding
+    return ""
+
+
+class MockClickHouseHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "ClickHouse"
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+    def do_HEAD(self):
+        self.respond(send_body=False)
+
+    def do_GET(self):
+        self.respond(send_body=True)
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length") or 0)
+        self.respond(send_body=True, post_body=self.rfile.read(length).decode() if length else "")
+
+    def respond(self, send_body, post_body=""):
+        # One handler serves every request of a keep-alive connection, so the
+        # POST body is passed along rather than kept on the handler.
+        settings = self.server.settings
+        url = urlparse(self.path)
+        if url.path == "/ping":
+            self.extra_headers = {}
+            return self.send_payload(200, b"Ok.\n", "text/plain; charset=UTF-8", send_body)
+        params = {key: values[-1] for key, values in parse_qs(url.query).items()}
+        query = params.get("query", "") + post_body
+        try:
+            if settings.latency_ms > 0:
+                time.sleep(settings.latency_ms / 1000.0)
+            if settings.should_fail():
+                raise MockError(1002, "Injected failure")
+            fmt = params.get("default_format", "TabSeparated")
+            match = FORMAT_RE.search(query)
+            if match:
+                fmt = match.group(1)
+            fmt = fmt.lower()
+            encoding = negotiate_encoding(params, self.headers.get("Accept-Encoding"))
+            params_key = tuple(sorted((k, v) for k, v in params.items() if k.startswith("param_")))
+            body = render(query, params_key, fmt, encoding, settings.rows)
+        except MockError as error:
+            message = "Code: %d. DB::Exception: %s. (MOCK)\n" % (error.code, error)
+            self.extra_headers = {"X-ClickHouse-Exception-Code": str(error.code)}
+            return self.send_payload(error.status, message.encode(), "text/plain; charset=UTF-8", send_body)
+        self.extra_headers = {"X-ClickHouse-Format": fmt}
+        if encoding:
+            self.extra_headers["Content-Encoding"] = encoding
+        self.send_payload(200, body, CONTENT_TYPES.get(fmt, "text/plain; charset=UTF-8"), send_body)
+
+    def send_payload(self, status, body, content_type, send_body):
+        start, end = 0, len(body)
+        range_header = self.headers.get("Range")
+        match = re.match(r"bytes=(\d+)-(\d*)", range_header or "")
+        if status == 200 and match:
+            start = int(match.group(1))
+            end = min(int(match.group(2)) + 1 if match.group(2) else end, end)
+            status = 206
+        self.send_response(status)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(end - start))
+        self.send_header("Accept-Ranges", "bytes")
+        if status == 206:
+            self.send_header("Content-Range", "bytes %d-%d/%d" % (start, end - 1, len(body)))
+        for key, value in getattr(self, "extra_headers", {}).items():
+            self.send_header(key, value)
+        self.end_headers()
+        if send_body:
+            self.write_throttled(body[start:end])
+
+    def write_throttled(self, payload):
+        bandwidth = self.server.settings.bandwidth_mbps
+        if bandwidth <= 0:
+            self.wfile.write(payload)
+            return
+        chunk = 64 * 1024
+        bytes_per_second = bandwidth * 1000 * 1000 / 8
+        for offset in range(0, len(payload), chunk):
+            piece = payload[offset : offset + chunk]
+            self.wfile.write(piece)
+            time.sleep(len(piece) / bytes_per_second)
+
+
+class MockClickHouseServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, settings, verbose=False):
+        super().__init__(address, MockClickHouseHandler)
+        self.settings = settings
+        self.verbose = verbose
+
+
+def start_nodes(host, port, nodes, settings, verbose=False):
+    """Starts `nodes` servers on consecutive ports, returns them with their URLs."""
+    servers = []
+    for i in range(nodes):
+        server = MockClickHouseServer((host, port + i if port else 0), settings, verbose)
+        threading.Thread(target=server.serve_forever, daemon=True).start()
+        servers.append(server)
+    urls = ["http://%s:%d" % (host, server.server_address[1]) for server in servers]
+    return servers, urls
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8123)
+    parser.add_argument("--nodes", type=int, default=1, help="servers on consecutive ports")
+    parser.add_argument("--rows", type=int, default=1000, help="rows returned without numbers(N)")
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="delay before each response")
+    parser.add_argument("--bandwidth-mbps", type=float, default=0.0, help="response throughput limit, 0 is unlimited")
+    parser.add_argument("--fail-rate", type=float, default=0.0, help="fraction of requests answered with an error")
+    parser.add_argument("--seed", type=int, default=None)
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    settings = MockSettings(args.rows, args.latency_ms, args.bandwidth_mbps, args.fail_rate, args.seed)
+    servers, urls = start_nodes(args.host, args.port, args.nodes, settings, args.verbose)
+    for url in urls:
+        print(url, flush=True)
+    try:
+        threading.Event().wait()
+    except KeyboardInterrupt:
+        for server in servers:
+            server.shutdown()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())